@@ -304,6 +304,40 @@ tu_static CFG_TUD_MEM_SECTION struct {
 } int_ep_buf[CFG_TUD_AUDIO];
 #endif
 
+#define AUDIOD_RESAMPLE_RX (CFG_TUD_AUDIO_ENABLE_RESAMPLING && CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING)
+#define AUDIOD_RESAMPLE_TX (CFG_TUD_AUDIO_ENABLE_RESAMPLING && CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_ENCODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING && CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL)
+
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLING
+enum {
+  RESAMPLE_FRAC_BITS = 20,                      // fractional bits of position and step, ~1ppm resolution
+  RESAMPLE_ONE       = 1ul << RESAMPLE_FRAC_BITS,
+  RESAMPLE_COEF_BITS = 15,                      // interpolation coefficients are Q15
+  RESAMPLE_HIST      = 3,                       // cubic interpolation needs 4 source frames, 3 are kept from previous packet
+  RESAMPLE_LVL_SHIFT = 5,                       // FIFO level smoothing factor 1/32
+};
+
+typedef struct {
+  uint32_t pos;      // position of next output frame in source stream including history frames (Q20)
+  uint32_t step;     // source frames per output frame (Q20)
+  int32_t ppm;       // current deviation of step from 1, set by application if fixed
+  int32_t lvl_avg;   // smoothed support FIFO level in bytes (Q8)
+  uint32_t vfp_acc;  // TX: accumulated frames per packet remainder
+  int32_t hist[RESAMPLE_HIST][CFG_TUD_AUDIO_RESAMPLING_CHANNEL_MAX];
+
+  bool active;       // set if current alternate setting can be resampled
+  bool fixed;        // ratio is set by application instead of FIFO level control
+} audiod_resampler_t;
+
+// Source or sink of a resampling run: either an interleaved linear buffer or the support FIFOs (one buffer info per FIFO)
+typedef struct {
+  uint8_t *lin;
+  tu_fifo_buffer_info_t const *info;
+  uint8_t n_channels;
+  uint8_t n_channels_per_ff;
+  uint8_t n_bytes_per_sample;
+} audiod_resample_io_t;
+#endif
+
 typedef struct
 {
   uint8_t rhport;
@@ -395,6 +429,14 @@ typedef struct
   #endif
 #endif
 
+#if AUDIOD_RESAMPLE_RX
+  audiod_resampler_t resampler_rx;
+#endif
+
+#if AUDIOD_RESAMPLE_TX
+  audiod_resampler_t resampler_tx;
+#endif
+
   /*------------- From this point, data is not cleared by bus reset -------------*/
 
   // Buffer for control requests
@@ -623,7 +665,7 @@ static bool audiod_get_AS_interface_index_global(uint8_t itf, uint8_t *func_id,
 static bool audiod_get_AS_interface_index(uint8_t itf, audiod_function_t *audio, uint8_t *idxItf, uint8_t const **pp_desc_int);
 static bool audiod_verify_entity_exists(uint8_t itf, uint8_t entityID, uint8_t *func_id);
 static bool audiod_verify_itf_exists(uint8_t itf, uint8_t *func_id);
-static bool audiod_verify_ep_exists(uint8_t ep, uint8_t *func_id);
+static bool audiod_verify_ep_exists(uint8_t rhport, uint8_t ep, uint8_t *func_id);
 static uint8_t audiod_get_audio_fct_idx(audiod_function_t *audio);
 
 #if (CFG_TUD_AUDIO_ENABLE_EP_IN && (CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL || CFG_TUD_AUDIO_ENABLE_ENCODING)) || (CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING)
@@ -634,6 +676,18 @@ static inline uint8_t tu_desc_subtype(void const *desc) {
 }
 #endif
 
+#if AUDIOD_RESAMPLE_RX || AUDIOD_RESAMPLE_TX
+static void audiod_resampler_reset(audiod_resampler_t *rs, uint8_t n_channels, uint8_t n_bytes_per_sample);
+#endif
+
+#if AUDIOD_RESAMPLE_RX
+static bool audiod_resample_decode_type_I_pcm(uint8_t rhport, audiod_function_t *audio, uint16_t n_bytes_received);
+#endif
+
+#if AUDIOD_RESAMPLE_TX
+static uint16_t audiod_resample_encode_type_I_pcm(uint8_t rhport, audiod_function_t *audio);
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL
 static bool audiod_calc_tx_packet_sz(audiod_function_t *audio);
 static uint16_t audiod_tx_packet_size(const uint16_t *norminal_size, uint16_t data_count, uint16_t fifo_depth, uint16_t max_size);
@@ -731,6 +785,12 @@ static bool audiod_rx_done_cb(uint8_t rhport, audiod_function_t *audio, uint16_t
 
       switch (audio->format_type_I_rx) {
         case AUDIO_DATA_FORMAT_TYPE_I_PCM:
+    #if AUDIOD_RESAMPLE_RX
+          if (audio->resampler_rx.active) {
+            TU_VERIFY(audiod_resample_decode_type_I_pcm(rhport, audio, n_bytes_received));
+            break;
+          }
+    #endif
           TU_VERIFY(audiod_decode_type_I_pcm(rhport, audio, n_bytes_received));
           break;
 
@@ -1002,7 +1062,12 @@ static bool audiod_tx_done_cb(uint8_t rhport, audiod_function_t *audio) {
 
       switch (audio->format_type_I_tx) {
         case AUDIO_DATA_FORMAT_TYPE_I_PCM:
-
+    #if AUDIOD_RESAMPLE_TX
+          if (audio->resampler_tx.active) {
+            n_bytes_tx = audiod_resample_encode_type_I_pcm(rhport, audio);
+            break;
+          }
+    #endif
           n_bytes_tx = audiod_encode_type_I_pcm(rhport, audio);
           break;
 
@@ -1180,6 +1245,313 @@ static uint16_t audiod_encode_type_I_pcm(uint8_t rhport, audiod_function_t *audi
 }
 #endif//CFG_TUD_AUDIO_ENABLE_ENCODING
 
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLING
+//--------------------------------------------------------------------+
+// Sample rate conversion
+//--------------------------------------------------------------------+
+// Converts between the USB stream and the support FIFOs with a ratio close to 1 to compensate for drift between host and codec clock.
+// Every output frame is interpolated from 4 source frames by a Catmull-Rom cubic, i.e. a 4 tap polyphase filter whose coefficients
+// are computed from the fractional position instead of being looked up in a table. Coefficients are shared by all channels of a frame.
+// Source frames are indexed including RESAMPLE_HIST frames kept from the previous packet: output frame at pos = i + t is interpolated
+// from frames [i, i+3] at fraction t between i+1 and i+2.
+
+  #if AUDIOD_RESAMPLE_RX || AUDIOD_RESAMPLE_TX
+static void audiod_resampler_reset(audiod_resampler_t *rs, uint8_t n_channels, uint8_t n_bytes_per_sample) {
+  // Only full 16 or 32 bit containers are resampled, everything else is passed through
+  rs->active = (n_bytes_per_sample == 2 || n_bytes_per_sample == 4) && n_channels > 0 &&
+               n_channels <= CFG_TUD_AUDIO_RESAMPLING_CHANNEL_MAX;
+  rs->pos = 0;
+  rs->vfp_acc = 0;
+  rs->lvl_avg = -1;
+  tu_memclr(rs->hist, sizeof(rs->hist));
+
+  if (!rs->fixed) rs->ppm = 0;
+  rs->step = RESAMPLE_ONE + (uint32_t) (((int64_t) rs->ppm << RESAMPLE_FRAC_BITS) / 1000000);
+}
+
+// Steer ratio such that support FIFO converges to half fill. For both directions a FIFO level above target means
+// more source frames need to be consumed per output frame.
+static void audiod_resampler_adapt(audiod_resampler_t *rs, uint16_t lvl, uint16_t depth) {
+  if (rs->fixed || depth == 0) return;
+
+  int32_t const lvl_q8 = (int32_t) lvl << 8;
+  if (rs->lvl_avg < 0) {
+    rs->lvl_avg = lvl_q8;
+  } else {
+    rs->lvl_avg += (lvl_q8 - rs->lvl_avg) >> RESAMPLE_LVL_SHIFT;
+  }
+
+  // Proportional control, full deviation is applied at empty or full FIFO
+  int32_t const target = (int32_t) depth << 7;
+  int64_t ppm = ((int64_t) (rs->lvl_avg - target) * CFG_TUD_AUDIO_RESAMPLING_MAX_PPM) / target;
+  if (ppm > CFG_TUD_AUDIO_RESAMPLING_MAX_PPM) ppm = CFG_TUD_AUDIO_RESAMPLING_MAX_PPM;
+  if (ppm < -CFG_TUD_AUDIO_RESAMPLING_MAX_PPM) ppm = -CFG_TUD_AUDIO_RESAMPLING_MAX_PPM;
+
+  rs->ppm = (int32_t) ppm;
+  rs->step = RESAMPLE_ONE + (uint32_t) ((ppm << RESAMPLE_FRAC_BITS) / 1000000);
+}
+
+// Pointer to sample of channel ch in frame k of an io buffer
+TU_ATTR_ALWAYS_INLINE static inline uint8_t *audiod_resample_sample_ptr(audiod_resample_io_t const *io, uint16_t k, uint8_t ch) {
+  uint32_t const frame = k;
+  uint32_t const n_bytes = io->n_bytes_per_sample;
+
+  if (io->lin) {
+    return io->lin + (frame * io->n_channels + ch) * n_bytes;
+  }
+
+  // Support FIFOs hold n_channels_per_ff interleaved channels each, samples are never split by a wrap
+  uint32_t const n_ch_ff = io->n_channels_per_ff;
+  tu_fifo_buffer_info_t const *info = &io->info[ch / n_ch_ff];
+  uint32_t const offset = (frame * n_ch_ff + ch % n_ch_ff) * n_bytes;
+  if (offset < info->len_lin) {
+    return (uint8_t *) info->ptr_lin + offset;
+  }
+  return (uint8_t *) info->ptr_wrap + (offset - info->len_lin);
+}
+
+// Load all channels of source frame k (including history frames)
+static void audiod_resample_load(audiod_resampler_t const *rs, audiod_resample_io_t const *src, uint16_t k, int32_t *frame) {
+  uint8_t const n_ch = src->n_channels;
+
+  if (k < RESAMPLE_HIST) {
+    memcpy(frame, rs->hist[k], n_ch * sizeof(int32_t));
+    return;
+  }
+
+  k -= RESAMPLE_HIST;
+  if (src->n_bytes_per_sample == 2) {
+    for (uint8_t ch = 0; ch < n_ch; ch++) {
+      int16_t v;
+      memcpy(&v, audiod_resample_sample_ptr(src, k, ch), 2);
+      frame[ch] = v;
+    }
+  } else {
+    for (uint8_t ch = 0; ch < n_ch; ch++) {
+      memcpy(&frame[ch], audiod_resample_sample_ptr(src, k, ch), 4);
+    }
+  }
+}
+
+// Resample up to n_src source frames into at most n_dst_max frames, returns number of frames written into dst.
+// Number of consumed source frames is returned in n_consumed. If consume_all is set, source frames which could not be
+// converted due to lack of space in dst are dropped (RX: linear buffer is reused for the next packet).
+static uint16_t audiod_resample_run(audiod_resampler_t *rs, audiod_resample_io_t const *src, uint16_t n_src,
+                                    audiod_resample_io_t const *dst, uint16_t n_dst_max, bool consume_all, uint16_t *n_consumed) {
+  uint8_t const n_ch = src->n_channels;
+  uint8_t const n_bytes_per_sample = dst->n_bytes_per_sample;
+
+  int32_t win[4][CFG_TUD_AUDIO_RESAMPLING_CHANNEL_MAX];
+  uint16_t win_idx = 0;
+  bool win_valid = false;
+  uint16_t n_dst = 0;
+
+  while (n_dst < n_dst_max) {
+    uint16_t const i = (uint16_t) (rs->pos >> RESAMPLE_FRAC_BITS);
+    if (i >= n_src) break; // frame i+3 is not available yet
+
+    // Slide window to frames [i, i+3], frames already in window are moved instead of loaded again
+    if (!win_valid || i != win_idx) {
+      for (uint16_t j = 0; j < 4; j++) {
+        if (win_valid && i + j < win_idx + 4) {
+          memcpy(win[j], win[i + j - win_idx], n_ch * sizeof(int32_t));
+        } else {
+          audiod_resample_load(rs, src, i + j, win[j]);
+        }
+      }
+      win_idx = i;
+      win_valid = true;
+    }
+
+    // Catmull-Rom coefficients (Q15) for fraction t
+    int32_t const t = (int32_t) ((rs->pos & (RESAMPLE_ONE - 1)) >> (RESAMPLE_FRAC_BITS - RESAMPLE_COEF_BITS));
+    int32_t const t2 = (t * t) >> RESAMPLE_COEF_BITS;
+    int32_t const t3 = (t2 * t) >> RESAMPLE_COEF_BITS;
+    int32_t const c0 = (-t3 + 2 * t2 - t) / 2;
+    int32_t const c1 = (3 * t3 - 5 * t2 + (2 << RESAMPLE_COEF_BITS)) / 2;
+    int32_t const c2 = (-3 * t3 + 4 * t2 + t) / 2;
+    int32_t const c3 = (t3 - t2) / 2;
+
+    for (uint8_t ch = 0; ch < n_ch; ch++) {
+      int64_t v = ((int64_t) c0 * win[0][ch] + (int64_t) c1 * win[1][ch] +
+                   (int64_t) c2 * win[2][ch] + (int64_t) c3 * win[3][ch]) >> RESAMPLE_COEF_BITS;
+      uint8_t *p = audiod_resample_sample_ptr(dst, n_dst, ch);
+
+      if (n_bytes_per_sample == 2) {
+        int16_t const v16 = (int16_t) (v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+        memcpy(p, &v16, 2);
+      } else {
+        int32_t const v32 = (int32_t) (v > INT32_MAX ? INT32_MAX : (v < INT32_MIN ? INT32_MIN : v));
+        memcpy(p, &v32, 4);
+      }
+    }
+
+    n_dst++;
+    rs->pos += rs->step;
+  }
+
+  // Consume source frames which are not needed anymore and keep the last ones as history
+  uint16_t consumed = (uint16_t) tu_min32(rs->pos >> RESAMPLE_FRAC_BITS, n_src);
+  if (consume_all && consumed < n_src) {
+    TU_LOG2("  Resampler: %u frames dropped\r\n", (unsigned) (n_src - consumed));
+    rs->pos &= RESAMPLE_ONE - 1;
+    consumed = n_src;
+  } else {
+    rs->pos -= (uint32_t) consumed << RESAMPLE_FRAC_BITS;
+  }
+
+  int32_t hist[RESAMPLE_HIST][CFG_TUD_AUDIO_RESAMPLING_CHANNEL_MAX];
+  for (uint16_t j = 0; j < RESAMPLE_HIST; j++) {
+    audiod_resample_load(rs, src, consumed + j, hist[j]);
+  }
+  memcpy(rs->hist, hist, sizeof(hist));
+
+  *n_consumed = consumed;
+  return n_dst;
+}
+  #endif
+
+  #if AUDIOD_RESAMPLE_RX
+// Resample interleaved stream in linear buffer directly into support FIFOs
+static bool audiod_resample_decode_type_I_pcm(uint8_t rhport, audiod_function_t *audio, uint16_t n_bytes_received) {
+  (void) rhport;
+
+  audiod_resampler_t *rs = &audio->resampler_rx;
+  uint8_t const n_ff_used = audio->n_ff_used_rx;
+  uint16_t const n_bytes_per_frame_ff = audio->n_channels_per_ff_rx * audio->n_bytes_per_sample_rx;
+
+  tu_fifo_buffer_info_t info[CFG_TUD_AUDIO_RESAMPLING_CHANNEL_MAX];
+  uint16_t n_dst_max = UINT16_MAX;
+  for (uint8_t cnt_ff = 0; cnt_ff < n_ff_used; cnt_ff++) {
+    tu_fifo_get_write_info(&audio->rx_supp_ff[cnt_ff], &info[cnt_ff]);
+    n_dst_max = tu_min16(n_dst_max, (uint16_t) ((info[cnt_ff].len_lin + info[cnt_ff].len_wrap) / n_bytes_per_frame_ff));
+  }
+
+  audiod_resampler_adapt(rs, tu_fifo_count(&audio->rx_supp_ff[0]), audio->rx_supp_ff[0].depth);
+
+  audiod_resample_io_t const src = {
+      .lin = audio->lin_buf_out,
+      .info = NULL,
+      .n_channels = audio->n_channels_rx,
+      .n_channels_per_ff = audio->n_channels_rx,
+      .n_bytes_per_sample = audio->n_bytes_per_sample_rx};
+  audiod_resample_io_t const dst = {
+      .lin = NULL,
+      .info = info,
+      .n_channels = audio->n_channels_rx,
+      .n_channels_per_ff = audio->n_channels_per_ff_rx,
+      .n_bytes_per_sample = audio->n_bytes_per_sample_rx};
+
+  uint16_t const n_src = (uint16_t) (n_bytes_received / (audio->n_channels_rx * audio->n_bytes_per_sample_rx));
+  uint16_t n_consumed;
+  uint16_t const n_dst = audiod_resample_run(rs, &src, n_src, &dst, n_dst_max, true, &n_consumed);
+
+  for (uint8_t cnt_ff = 0; cnt_ff < n_ff_used; cnt_ff++) {
+    tu_fifo_advance_write_pointer(&audio->rx_supp_ff[cnt_ff], n_dst * n_bytes_per_frame_ff);
+  }
+
+    #if CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
+  if (audio->feedback.compute_method == AUDIO_FEEDBACK_METHOD_FIFO_COUNT) {
+    audiod_fb_fifo_count_update(audio, tu_fifo_count(&audio->rx_supp_ff[0]));
+  }
+    #endif
+
+  return true;
+}
+  #endif
+
+  #if AUDIOD_RESAMPLE_TX
+// Resample support FIFOs into interleaved stream in linear buffer. Packet size follows the nominal sample rate exactly,
+// drift is absorbed by the number of frames taken from the support FIFOs.
+// Returns number of bytes written into linear buffer
+static uint16_t audiod_resample_encode_type_I_pcm(uint8_t rhport, audiod_function_t *audio) {
+  // We encode directly into IN EP's linear buffer - abort if previous transfer not complete
+  TU_VERIFY(!usbd_edpt_busy(rhport, audio->ep_in), 0);
+
+  audiod_resampler_t *rs = &audio->resampler_tx;
+  uint8_t const n_ff_used = audio->n_ff_used_tx;
+  uint16_t const n_bytes_per_frame = audio->n_channels_tx * audio->n_bytes_per_sample_tx;
+  uint16_t const n_bytes_per_frame_ff = audio->n_channels_per_ff_tx * audio->n_bytes_per_sample_tx;
+
+  tu_fifo_buffer_info_t info[CFG_TUD_AUDIO_RESAMPLING_CHANNEL_MAX];
+  uint16_t n_src = UINT16_MAX;
+  for (uint8_t cnt_ff = 0; cnt_ff < n_ff_used; cnt_ff++) {
+    tu_fifo_get_read_info(&audio->tx_supp_ff[cnt_ff], &info[cnt_ff]);
+    n_src = tu_min16(n_src, (uint16_t) ((info[cnt_ff].len_lin + info[cnt_ff].len_wrap) / n_bytes_per_frame_ff));
+  }
+
+  audiod_resampler_adapt(rs, tu_fifo_count(&audio->tx_supp_ff[0]), audio->tx_supp_ff[0].depth);
+
+  // Frames per packet at nominal sample rate, remainder is carried to next packet e.g. 44.1kHz -> 9 x 44 + 1 x 45
+  bool const is_fs = (tud_speed_get() == TUSB_SPEED_FULL);
+  uint32_t const frames_per_second = is_fs ? 1000 : 8000;
+  uint32_t const interval = is_fs ? audio->interval_tx : (1u << (audio->interval_tx - 1));
+  rs->vfp_acc += audio->sample_rate_tx * interval;
+  uint16_t n_dst = (uint16_t) tu_min32(rs->vfp_acc / frames_per_second, audio->ep_in_sz / n_bytes_per_frame);
+  rs->vfp_acc %= frames_per_second;
+
+  audiod_resample_io_t const src = {
+      .lin = NULL,
+      .info = info,
+      .n_channels = audio->n_channels_tx,
+      .n_channels_per_ff = audio->n_channels_per_ff_tx,
+      .n_bytes_per_sample = audio->n_bytes_per_sample_tx};
+  audiod_resample_io_t const dst = {
+      .lin = audio->lin_buf_in,
+      .info = NULL,
+      .n_channels = audio->n_channels_tx,
+      .n_channels_per_ff = audio->n_channels_tx,
+      .n_bytes_per_sample = audio->n_bytes_per_sample_tx};
+
+  uint16_t n_consumed;
+  n_dst = audiod_resample_run(rs, &src, n_src, &dst, n_dst, false, &n_consumed);
+
+  for (uint8_t cnt_ff = 0; cnt_ff < n_ff_used; cnt_ff++) {
+    tu_fifo_advance_read_pointer(&audio->tx_supp_ff[cnt_ff], n_consumed * n_bytes_per_frame_ff);
+  }
+
+  return n_dst * n_bytes_per_frame;
+}
+  #endif
+
+static audiod_resampler_t *audiod_get_resampler(uint8_t func_id, tusb_dir_t dir) {
+  TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL, NULL);
+  #if AUDIOD_RESAMPLE_RX
+  if (dir == TUSB_DIR_OUT) return &_audiod_fct[func_id].resampler_rx;
+  #endif
+  #if AUDIOD_RESAMPLE_TX
+  if (dir == TUSB_DIR_IN) return &_audiod_fct[func_id].resampler_tx;
+  #endif
+  (void) dir;
+  return NULL;
+}
+
+int32_t tud_audio_n_resampler_ppm_get(uint8_t func_id, tusb_dir_t dir) {
+  audiod_resampler_t const *rs = audiod_get_resampler(func_id, dir);
+  return rs ? rs->ppm : 0;
+}
+
+bool tud_audio_n_resampler_ppm_set(uint8_t func_id, tusb_dir_t dir, int32_t ppm) {
+  audiod_resampler_t *rs = audiod_get_resampler(func_id, dir);
+  TU_VERIFY(rs);
+  TU_VERIFY(ppm > -1000000 && ppm < 1000000);
+
+  rs->fixed = true;
+  rs->ppm = ppm;
+  rs->step = RESAMPLE_ONE + (uint32_t) (((int64_t) ppm << RESAMPLE_FRAC_BITS) / 1000000);
+  return true;
+}
+
+bool tud_audio_n_resampler_auto(uint8_t func_id, tusb_dir_t dir) {
+  audiod_resampler_t *rs = audiod_get_resampler(func_id, dir);
+  TU_VERIFY(rs);
+
+  rs->fixed = false;
+  rs->lvl_avg = -1;
+  return true;
+}
+#endif// CFG_TUD_AUDIO_ENABLE_RESAMPLING
+
 // This function is called once a transmit of a feedback packet was successfully completed. Here, we get the next feedback value to be sent
 
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
@@ -1716,6 +2088,7 @@ uint16_t audiod_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint
               // Store endpoint number and open endpoint
               _audiod_fct[i].ep_int = ep_addr;
               TU_ASSERT(usbd_edpt_open(_audiod_fct[i].rhport, desc_ep));
+              usbd_edpt_set_instance(_audiod_fct[i].rhport, ep_addr, i);
             }
           }
           p_desc = tu_desc_next(p_desc);
@@ -1867,6 +2240,7 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
           TU_ASSERT(usbd_edpt_open(rhport, desc_ep));
 #endif
           uint8_t const ep_addr = desc_ep->bEndpointAddress;
+          usbd_edpt_set_instance(rhport, ep_addr, func_id);
 
           //TODO: We need to set EP non busy since this is not taken care of right now in ep_close() - THIS IS A WORKAROUND!
           usbd_edpt_clear_stall(rhport, ep_addr);
@@ -1892,6 +2266,9 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
             audio->n_ff_used_tx = audio->n_channels_tx / audio->n_channels_per_ff_tx;
             TU_ASSERT(audio->n_ff_used_tx <= audio->n_tx_supp_ff);
     #endif
+    #if AUDIOD_RESAMPLE_TX
+            audiod_resampler_reset(&audio->resampler_tx, audio->n_channels_tx, audio->n_bytes_per_sample_tx);
+    #endif
   #endif
 
             // Schedule first transmit if alternate interface is not zero i.e. streaming is disabled - in case no sample data is available a ZLP is loaded
@@ -1921,6 +2298,9 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *p
             audio->n_ff_used_rx = audio->n_channels_rx / audio->n_channels_per_ff_rx;
             TU_ASSERT(audio->n_ff_used_rx <= audio->n_rx_supp_ff);
     #endif
+    #if AUDIOD_RESAMPLE_RX
+            audiod_resampler_reset(&audio->resampler_rx, audio->n_channels_rx, audio->n_bytes_per_sample_rx);
+    #endif
   #endif
 
             // Prepare for incoming data
@@ -2072,7 +2452,7 @@ static bool audiod_control_complete(uint8_t rhport, tusb_control_request_t const
         uint8_t ep = TU_U16_LOW(p_request->wIndex);
 
         // Check if entity is present and get corresponding driver index
-        TU_VERIFY(audiod_verify_ep_exists(ep, &func_id));
+        TU_VERIFY(audiod_verify_ep_exists(rhport, ep, &func_id));
 
         // Invoke callback
         return tud_audio_set_req_ep_cb(rhport, p_request, _audiod_fct[func_id].ctrl_buf);
@@ -2144,7 +2524,7 @@ static bool audiod_control_request(uint8_t rhport, tusb_control_request_t const
         uint8_t ep = TU_U16_LOW(p_request->wIndex);
 
         // Find index of audio driver structure and verify EP really exists
-        TU_VERIFY(audiod_verify_ep_exists(ep, &func_id));
+        TU_VERIFY(audiod_verify_ep_exists(rhport, ep, &func_id));
 
         // In case we got a get request invoke callback - callback needs to answer as defined in UAC2 specification page 89 - 5. Requests
         if (p_request->bmRequestType_bit.direction == TUSB_DIR_IN) {
@@ -2183,70 +2563,70 @@ bool audiod_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint3
   (void) result;
   (void) xferred_bytes;
 
-  // Search for interface belonging to given end point address and proceed as required
-  for (uint8_t func_id = 0; func_id < CFG_TUD_AUDIO; func_id++) {
-    audiod_function_t *audio = &_audiod_fct[func_id];
+  // Find audio function belonging to given end point address and proceed as required
+  uint8_t const func_id = usbd_edpt_get_instance(rhport, ep_addr);
+  TU_VERIFY(func_id < CFG_TUD_AUDIO);
+  audiod_function_t *audio = &_audiod_fct[func_id];
 
 #if CFG_TUD_AUDIO_ENABLE_INTERRUPT_EP
 
-    // Data transmission of control interrupt finished
-    if (audio->ep_int == ep_addr) {
-      // According to USB2 specification, maximum payload of interrupt EP is 8 bytes on low speed, 64 bytes on full speed, and 1024 bytes on high speed (but only if an alternate interface other than 0 is used - see specification p. 49)
-      // In case there is nothing to send we have to return a NAK - this is taken care of by PHY ???
-      // In case of an erroneous transmission a retransmission is conducted - this is taken care of by PHY ???
+  // Data transmission of control interrupt finished
+  if (audio->ep_int == ep_addr) {
+    // According to USB2 specification, maximum payload of interrupt EP is 8 bytes on low speed, 64 bytes on full speed, and 1024 bytes on high speed (but only if an alternate interface other than 0 is used - see specification p. 49)
+    // In case there is nothing to send we have to return a NAK - this is taken care of by PHY ???
+    // In case of an erroneous transmission a retransmission is conducted - this is taken care of by PHY ???
 
-      // I assume here, that things above are handled by PHY
-      // All transmission is done - what remains to do is to inform job was completed
+    // I assume here, that things above are handled by PHY
+    // All transmission is done - what remains to do is to inform job was completed
 
-      tud_audio_int_done_cb(rhport);
-      return true;
-    }
+    tud_audio_int_done_cb(rhport);
+    return true;
+  }
 
 #endif
 
 #if CFG_TUD_AUDIO_ENABLE_EP_IN
 
-    // Data transmission of audio packet finished
-    if (audio->ep_in == ep_addr && audio->alt_setting != 0) {
-      // USB 2.0, section 5.6.4, third paragraph, states "An isochronous endpoint must specify its required bus access period. However, an isochronous endpoint must be prepared to handle poll rates faster than the one specified."
-      // That paragraph goes on to say "An isochronous IN endpoint must return a zero-length packet whenever data is requested at a faster interval than the specified interval and data is not available."
-      // This can only be solved reliably if we load a ZLP after every IN transmission since we can not say if the host requests samples earlier than we declared! Once all samples are collected we overwrite the loaded ZLP.
+  // Data transmission of audio packet finished
+  if (audio->ep_in == ep_addr && audio->alt_setting != 0) {
+    // USB 2.0, section 5.6.4, third paragraph, states "An isochronous endpoint must specify its required bus access period. However, an isochronous endpoint must be prepared to handle poll rates faster than the one specified."
+    // That paragraph goes on to say "An isochronous IN endpoint must return a zero-length packet whenever data is requested at a faster interval than the specified interval and data is not available."
+    // This can only be solved reliably if we load a ZLP after every IN transmission since we can not say if the host requests samples earlier than we declared! Once all samples are collected we overwrite the loaded ZLP.
 
-      // Check if there is data to load into EPs buffer - if not load it with ZLP
-      // Be aware - we as a device are not able to know if the host polls for data with a faster rate as we stated this in the descriptors. Therefore we always have to put something into the EPs buffer. However, once we did that, there is no way of aborting this or replacing what we put into the buffer before!
-      // This is the only place where we can fill something into the EPs buffer!
+    // Check if there is data to load into EPs buffer - if not load it with ZLP
+    // Be aware - we as a device are not able to know if the host polls for data with a faster rate as we stated this in the descriptors. Therefore we always have to put something into the EPs buffer. However, once we did that, there is no way of aborting this or replacing what we put into the buffer before!
+    // This is the only place where we can fill something into the EPs buffer!
 
-      // Load new data
-      TU_VERIFY(audiod_tx_done_cb(rhport, audio));
+    // Load new data
+    TU_VERIFY(audiod_tx_done_cb(rhport, audio));
 
-      // Transmission of ZLP is done by audiod_tx_done_cb()
-      return true;
-    }
+    // Transmission of ZLP is done by audiod_tx_done_cb()
+    return true;
+  }
 #endif
 
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT
 
-    // New audio packet received
-    if (audio->ep_out == ep_addr) {
-      TU_VERIFY(audiod_rx_done_cb(rhport, audio, (uint16_t) xferred_bytes));
-      return true;
-    }
+  // New audio packet received
+  if (audio->ep_out == ep_addr) {
+    TU_VERIFY(audiod_rx_done_cb(rhport, audio, (uint16_t) xferred_bytes));
+    return true;
+  }
 
 
   #if CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
-    // Transmission of feedback EP finished
-    if (audio->ep_fb == ep_addr) {
-      tud_audio_fb_done_cb(func_id);
-
-      // Schedule a transmit with the new value if EP is not busy
-      if (usbd_edpt_claim(rhport, audio->ep_fb)) {
-        // Schedule next transmission - value is changed bytud_audio_n_fb_set() in the meantime or the old value gets sent
-        return audiod_fb_send(audio);
-      }
+  // Transmission of feedback EP finished
+  if (audio->ep_fb == ep_addr) {
+    tud_audio_fb_done_cb(func_id);
+
+    // Schedule a transmit with the new value if EP is not busy
+    if (usbd_edpt_claim(rhport, audio->ep_fb)) {
+      // Schedule next transmission - value is changed bytud_audio_n_fb_set() in the meantime or the old value gets sent
+      return audiod_fb_send(audio);
     }
+  }
   #endif
 #endif
-  }
 
   return false;
 }
@@ -2412,7 +2792,7 @@ bool tud_audio_buffer_and_schedule_control_xfer(uint8_t rhport, tusb_control_req
       uint8_t ep = TU_U16_LOW(p_request->wIndex);
 
       // Find index of audio driver structure and verify EP really exists
-      TU_VERIFY(audiod_verify_ep_exists(ep, &func_id));
+      TU_VERIFY(audiod_verify_ep_exists(rhport, ep, &func_id));
     } break;
 
     // Unknown/Unsupported recipient
@@ -2535,8 +2915,15 @@ static bool audiod_verify_itf_exists(uint8_t itf, uint8_t *func_id) {
   return false;
 }
 
-static bool audiod_verify_ep_exists(uint8_t ep, uint8_t *func_id) {
-  uint8_t i;
+static bool audiod_verify_ep_exists(uint8_t rhport, uint8_t ep, uint8_t *func_id) {
+  // Endpoints of active alternate settings are bound to their function
+  uint8_t i = usbd_edpt_get_instance(rhport, ep);
+  if (i < CFG_TUD_AUDIO) {
+    *func_id = i;
+    return true;
+  }
+
+  // Otherwise search descriptors e.g request to endpoint of an inactive alternate setting
   for (i = 0; i < CFG_TUD_AUDIO; i++) {
     if (_audiod_fct[i].p_desc) {
       // Get pointer at end
@@ -270,6 +270,25 @@
 #define CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING                0
 #endif
 
+// Adaptive sample rate conversion between the USB stream and the support FIFOs. Type I PCM with 2 or 4 bytes per sample is resampled by
+// cubic interpolation, other formats are passed through unchanged. The conversion ratio is steered such that the support FIFO
+// converges to half fill, which compensates for clock drift between host and codec even if the host ignores the feedback EP (RX)
+// or if the device is not allowed to vary the packet size (TX). Resampling of the TX stream requires CFG_TUD_AUDIO_EP_IN_FLOW_CONTROL
+// since the nominal sample rate is needed to determine the packet size. See tud_audio_n_resampler_ppm_set().
+#ifndef CFG_TUD_AUDIO_ENABLE_RESAMPLING
+#define CFG_TUD_AUDIO_ENABLE_RESAMPLING                     0
+#endif
+
+// Maximum number of channels of a resampled stream (all support FIFOs together)
+#ifndef CFG_TUD_AUDIO_RESAMPLING_CHANNEL_MAX
+#define CFG_TUD_AUDIO_RESAMPLING_CHANNEL_MAX                2
+#endif
+
+// Maximum deviation of the conversion ratio from 1 in ppm the FIFO level control may apply
+#ifndef CFG_TUD_AUDIO_RESAMPLING_MAX_PPM
+#define CFG_TUD_AUDIO_RESAMPLING_MAX_PPM                    1000
+#endif
+
 // Type I Coding parameters not given within UAC2 descriptors
 // It would be possible to allow for a more flexible setting and not fix this parameter as done below. However, this is most often not needed and kept for later if really necessary. The more flexible setting could be implemented within set_interface(), however, how the values are saved per alternate setting is to be determined!
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_ENCODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING
@@ -395,6 +414,14 @@ uint16_t tud_audio_n_write_support_ff             (uint8_t func_id, uint8_t ff_i
 tu_fifo_t* tud_audio_n_get_tx_support_ff          (uint8_t func_id, uint8_t ff_idx);
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLING
+// Resampler of the OUT (RX) or IN (TX) stream. Ratio is given as deviation from 1 in ppm, positive values consume more samples
+// from the source than are produced i.e. the RX support FIFO fills slower resp. the TX support FIFO drains faster.
+int32_t  tud_audio_n_resampler_ppm_get            (uint8_t func_id, tusb_dir_t dir);
+bool     tud_audio_n_resampler_ppm_set            (uint8_t func_id, tusb_dir_t dir, int32_t ppm);   // Fix ratio, disables FIFO level control
+bool     tud_audio_n_resampler_auto               (uint8_t func_id, tusb_dir_t dir);                // Ratio is controlled by support FIFO level (default)
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_INTERRUPT_EP
 bool    tud_audio_int_n_write                     (uint8_t func_id, const audio_interrupt_data_t * data);
 #endif
@@ -437,6 +464,12 @@ static inline uint16_t tud_audio_write_support_ff           (uint8_t ff_idx, con
 static inline tu_fifo_t* tud_audio_get_tx_support_ff        (uint8_t ff_idx);
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLING
+static inline int32_t tud_audio_resampler_ppm_get           (tusb_dir_t dir);
+static inline bool tud_audio_resampler_ppm_set              (tusb_dir_t dir, int32_t ppm);
+static inline bool tud_audio_resampler_auto                 (tusb_dir_t dir);
+#endif
+
 // INT CTR API
 
 #if CFG_TUD_AUDIO_ENABLE_INTERRUPT_EP
@@ -686,6 +719,23 @@ static inline tu_fifo_t* tud_audio_get_tx_support_ff(uint8_t ff_idx)
 
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_RESAMPLING
+static inline int32_t tud_audio_resampler_ppm_get(tusb_dir_t dir)
+{
+  return tud_audio_n_resampler_ppm_get(0, dir);
+}
+
+static inline bool tud_audio_resampler_ppm_set(tusb_dir_t dir, int32_t ppm)
+{
+  return tud_audio_n_resampler_ppm_set(0, dir, ppm);
+}
+
+static inline bool tud_audio_resampler_auto(tusb_dir_t dir)
+{
+  return tud_audio_n_resampler_auto(0, dir);
+}
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_INTERRUPT_EP
 static inline bool tud_audio_int_write(const audio_interrupt_data_t * data)
 {
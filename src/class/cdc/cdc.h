@@ -222,6 +222,19 @@ typedef enum {
   CDC_NOTIF_MDLM_SEMANTIC_MODEL_NOTIFICATION = 0x40,
 }cdc_notification_request_t;
 
+/// 6.5.4 SerialState notification bitmap
+enum {
+  CDC_SERIAL_STATE_RX_CARRIER = 0x0001, ///< DCD
+  CDC_SERIAL_STATE_TX_CARRIER = 0x0002, ///< DSR
+  CDC_SERIAL_STATE_BREAK      = 0x0004,
+  CDC_SERIAL_STATE_RING       = 0x0008,
+  CDC_SERIAL_STATE_FRAMING    = 0x0010,
+  CDC_SERIAL_STATE_PARITY     = 0x0020,
+  CDC_SERIAL_STATE_OVERRUN    = 0x0040,
+  CDC_SERIAL_STATE_CTS        = 0x0100, ///< not defined by CDC, reported by vendor serial adapters
+  CDC_SERIAL_STATE_ERRORS     = CDC_SERIAL_STATE_BREAK | CDC_SERIAL_STATE_FRAMING | CDC_SERIAL_STATE_PARITY | CDC_SERIAL_STATE_OVERRUN,
+};
+
 //--------------------------------------------------------------------+
 // Class Specific Functional Descriptor (Communication Interface)
 //--------------------------------------------------------------------+
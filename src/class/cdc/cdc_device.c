@@ -54,8 +54,15 @@ typedef struct {
   // Bit 0:  DTR (Data Terminal Ready), Bit 1: RTS (Request to Send)
   uint8_t line_state;
 
+  // Timed TX flush: frames elapsed since first unsent byte was written
+  volatile bool tx_pending;
+  volatile uint16_t tx_age;
+
   /*------------- From this point, data is not cleared by bus reset -------------*/
   char wanted_char;
+  uint16_t tx_flush_delay;
+  uint16_t tx_min_fill;
+  tu_frame_t rx_frame;
   TU_ATTR_ALIGNED(4) cdc_line_coding_t line_coding;
 
   // FIFO
@@ -84,6 +91,8 @@ CFG_TUD_MEM_SECTION static cdcd_epbuf_t _cdcd_epbuf[CFG_TUD_CDC];
 
 static tud_cdc_configure_fifo_t _cdcd_fifo_cfg;
 
+static volatile bool _cdcd_tx_flush_deferred;
+
 static bool _prep_out_transaction(uint8_t itf) {
   const uint8_t rhport = 0;
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
@@ -156,6 +165,7 @@ uint32_t tud_cdc_n_available(uint8_t itf) {
 uint32_t tud_cdc_n_read(uint8_t itf, void* buffer, uint32_t bufsize) {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
   uint32_t num_read = tu_fifo_read_n(&p_cdc->rx_ff, buffer, (uint16_t) TU_MIN(bufsize, UINT16_MAX));
+  tu_frame_reset(&p_cdc->rx_frame);
   _prep_out_transaction(itf);
   return num_read;
 }
@@ -167,9 +177,37 @@ bool tud_cdc_n_peek(uint8_t itf, uint8_t* chr) {
 void tud_cdc_n_read_flush(uint8_t itf) {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
   tu_fifo_clear(&p_cdc->rx_ff);
+  tu_frame_reset(&p_cdc->rx_frame);
   _prep_out_transaction(itf);
 }
 
+//--------------------------------------------------------------------+
+// FRAMED READ API
+//--------------------------------------------------------------------+
+void tud_cdc_n_set_rx_frame(uint8_t itf, tusb_frame_mode_t mode, uint8_t delimiter) {
+  tu_frame_config(&_cdcd_itf[itf].rx_frame, (uint8_t) mode, delimiter);
+}
+
+uint32_t tud_cdc_n_frame_available(uint8_t itf) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  TU_VERIFY(p_cdc->rx_frame.mode != TUSB_FRAME_NONE, 0);
+  return tu_frame_find(&p_cdc->rx_frame, &p_cdc->rx_ff);
+}
+
+uint32_t tud_cdc_n_read_frame(uint8_t itf, void* buffer, uint32_t bufsize) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  TU_VERIFY(p_cdc->rx_frame.mode != TUSB_FRAME_NONE, 0);
+  uint32_t const num_read = tu_frame_read(&p_cdc->rx_frame, &p_cdc->rx_ff, buffer, bufsize);
+  _prep_out_transaction(itf);
+  return num_read;
+}
+
+bool tud_cdc_n_peek_frame(uint8_t itf, tu_fifo_buffer_info_t* info) {
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  TU_VERIFY(p_cdc->rx_frame.mode != TUSB_FRAME_NONE);
+  return tu_frame_peek(&p_cdc->rx_frame, &p_cdc->rx_ff, info);
+}
+
 //--------------------------------------------------------------------+
 // WRITE API
 //--------------------------------------------------------------------+
@@ -177,13 +215,14 @@ uint32_t tud_cdc_n_write(uint8_t itf, const void* buffer, uint32_t bufsize) {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
   uint16_t ret = tu_fifo_write_n(&p_cdc->tx_ff, buffer, (uint16_t) TU_MIN(bufsize, UINT16_MAX));
 
-  // flush if queue more than packet size
-  if (tu_fifo_count(&p_cdc->tx_ff) >= BULK_PACKET_SIZE
-      #if CFG_TUD_CDC_TX_BUFSIZE < BULK_PACKET_SIZE
-      || tu_fifo_full(&p_cdc->tx_ff) // check full if fifo size is less than packet size
-      #endif
-      ) {
+  // flush if queue reaches min fill (packet size by default), otherwise start flush timer if enabled
+  uint16_t const count = tu_fifo_count(&p_cdc->tx_ff);
+  if (count >= p_cdc->tx_min_fill) {
     tud_cdc_n_write_flush(itf);
+  } else if (count && p_cdc->tx_flush_delay && !p_cdc->tx_pending) {
+    p_cdc->tx_age = 0;
+    p_cdc->tx_pending = true;
+    usbd_sof_enable(0, SOF_CONSUMER_CDC, true);
   }
 
   return ret;
@@ -196,6 +235,9 @@ uint32_t tud_cdc_n_write_flush(uint8_t itf) {
   // Skip if usb is not ready yet
   TU_VERIFY(tud_ready(), 0);
 
+  // Either sent now or by xfer_cb() of ongoing transfer
+  p_cdc->tx_pending = false;
+
   // No data to send
   if (!tu_fifo_count(&p_cdc->tx_ff)) {
     return 0;
@@ -228,6 +270,49 @@ bool tud_cdc_n_write_clear(uint8_t itf) {
   return tu_fifo_clear(&_cdcd_itf[itf].tx_ff);
 }
 
+bool tud_cdc_n_set_tx_flush(uint8_t itf, uint16_t delay_ms, uint16_t min_fill) {
+  TU_VERIFY(itf < CFG_TUD_CDC);
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+
+  if (min_fill == 0) {
+    min_fill = BULK_PACKET_SIZE;
+  }
+
+  p_cdc->tx_flush_delay = delay_ms;
+  p_cdc->tx_min_fill = tu_min16(min_fill, CFG_TUD_CDC_TX_BUFSIZE); // flush when full if fifo is smaller
+  return true;
+}
+
+// Flush interfaces whose flush delay is expired, deferred from SOF ISR
+static void _tx_flush_expired(void* param) {
+  (void) param;
+  _cdcd_tx_flush_deferred = false;
+
+  bool pending = false;
+  for (uint8_t itf = 0; itf < CFG_TUD_CDC; itf++) {
+    cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+    if (p_cdc->tx_pending) {
+      if (p_cdc->tx_age >= p_cdc->tx_flush_delay) {
+        tud_cdc_n_write_flush(itf);
+      } else {
+        pending = true;
+      }
+    }
+  }
+
+  if (!pending) {
+    usbd_sof_enable(0, SOF_CONSUMER_CDC, false);
+
+    // tud_cdc_n_write() may start a timer from another thread in the meantime
+    for (uint8_t itf = 0; itf < CFG_TUD_CDC; itf++) {
+      if (_cdcd_itf[itf].tx_pending) {
+        usbd_sof_enable(0, SOF_CONSUMER_CDC, true);
+        break;
+      }
+    }
+  }
+}
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
@@ -239,6 +324,8 @@ void cdcd_init(void) {
     cdcd_interface_t* p_cdc = &_cdcd_itf[i];
 
     p_cdc->wanted_char = (char) -1;
+    tu_frame_config(&p_cdc->rx_frame, TUSB_FRAME_NONE, 0);
+    tud_cdc_n_set_tx_flush(i, CFG_TUD_CDC_TX_FLUSH_DELAY, CFG_TUD_CDC_TX_FLUSH_MIN);
 
     // default line coding is : stop bit = 1, parity = none, data bits = 8
     p_cdc->line_coding.bit_rate = 115200;
@@ -290,12 +377,14 @@ bool cdcd_deinit(void) {
 void cdcd_reset(uint8_t rhport) {
   (void) rhport;
 
+  _cdcd_tx_flush_deferred = false;
   for (uint8_t i = 0; i < CFG_TUD_CDC; i++) {
     cdcd_interface_t* p_cdc = &_cdcd_itf[i];
 
     tu_memclr(p_cdc, ITF_MEM_RESET_SIZE);
     if (!_cdcd_fifo_cfg.rx_persistent) {
       tu_fifo_clear(&p_cdc->rx_ff);
+      tu_frame_reset(&p_cdc->rx_frame);
     }
     if (!_cdcd_fifo_cfg.tx_persistent) {
       tu_fifo_clear(&p_cdc->tx_ff);
@@ -352,6 +441,8 @@ uint16_t cdcd_open(uint8_t rhport, const tusb_desc_interface_t* itf_desc, uint16
 
     // Open endpoint pair
     TU_ASSERT(usbd_open_edpt_pair(rhport, p_desc, 2, TUSB_XFER_BULK, &p_cdc->ep_out, &p_cdc->ep_in), 0);
+    usbd_edpt_set_instance(rhport, p_cdc->ep_out, cdc_id);
+    usbd_edpt_set_instance(rhport, p_cdc->ep_in, cdc_id);
 
     drv_len += 2 * sizeof(tusb_desc_endpoint_t);
   }
@@ -447,17 +538,10 @@ bool cdcd_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control_requ
 bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
   (void) result;
 
-  uint8_t itf;
-  cdcd_interface_t* p_cdc;
-
   // Identify which interface to use
-  for (itf = 0; itf < CFG_TUD_CDC; itf++) {
-    p_cdc = &_cdcd_itf[itf];
-    if ((ep_addr == p_cdc->ep_out) || (ep_addr == p_cdc->ep_in)) {
-      break;
-    }
-  }
+  uint8_t const itf = usbd_edpt_get_instance(rhport, ep_addr);
   TU_ASSERT(itf < CFG_TUD_CDC);
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
   cdcd_epbuf_t* p_epbuf = &_cdcd_epbuf[itf];
 
   // Received new data
@@ -466,10 +550,19 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
 
     // Check for wanted char and invoke callback if needed
     if (tud_cdc_rx_wanted_cb && (((signed char) p_cdc->wanted_char) != -1)) {
-      for (uint32_t i = 0; i < xferred_bytes; i++) {
-        if ((p_cdc->wanted_char == p_epbuf->epout[i]) && !tu_fifo_empty(&p_cdc->rx_ff)) {
-          tud_cdc_rx_wanted_cb(itf, p_cdc->wanted_char);
-        }
+      uint8_t const wanted = (uint8_t) p_cdc->wanted_char;
+      uint32_t i = tu_mem_find_byte(p_epbuf->epout, xferred_bytes, wanted);
+      while (i < xferred_bytes && !tu_fifo_empty(&p_cdc->rx_ff)) {
+        tud_cdc_rx_wanted_cb(itf, p_cdc->wanted_char);
+        i++;
+        i += tu_mem_find_byte(p_epbuf->epout + i, xferred_bytes - i, wanted);
+      }
+    }
+
+    // Search received data for a complete frame, each byte is searched once
+    if (p_cdc->rx_frame.mode != TUSB_FRAME_NONE) {
+      if (tu_frame_received(&p_cdc->rx_frame, &p_cdc->rx_ff, CFG_TUD_CDC_EP_BUFSIZE) && tud_cdc_rx_frame_cb) {
+        tud_cdc_rx_frame_cb(itf);
       }
     }
 
@@ -507,4 +600,27 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
   return true;
 }
 
+// Age pending TX data of each interface by one frame, flushing is deferred to usbd task.
+// Note: frame_count is not used since some DCDs signal SOF without it.
+TU_ATTR_FAST_FUNC void cdcd_sof_isr(uint8_t rhport, uint32_t frame_count) {
+  (void) rhport;
+  (void) frame_count;
+
+  bool expired = false;
+  for (uint8_t itf = 0; itf < CFG_TUD_CDC; itf++) {
+    cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+    if (p_cdc->tx_pending && p_cdc->tx_age < p_cdc->tx_flush_delay) {
+      p_cdc->tx_age++;
+      if (p_cdc->tx_age == p_cdc->tx_flush_delay) {
+        expired = true;
+      }
+    }
+  }
+
+  if (expired && !_cdcd_tx_flush_deferred) {
+    _cdcd_tx_flush_deferred = true;
+    usbd_defer_func(_tx_flush_expired, NULL, true);
+  }
+}
+
 #endif
@@ -41,6 +41,17 @@
   #define CFG_TUD_CDC_EP_BUFSIZE    (TUD_OPT_HIGH_SPEED ? 512 : 64)
 #endif
 
+// Default max time (ms) written data less than CFG_TUD_CDC_TX_FLUSH_MIN may wait in TX FIFO before being sent.
+// 0 disables timed flush i.e application must call tud_cdc_n_write_flush()
+#ifndef CFG_TUD_CDC_TX_FLUSH_DELAY
+  #define CFG_TUD_CDC_TX_FLUSH_DELAY  0
+#endif
+
+// Default TX FIFO level that is sent immediately by tud_cdc_n_write()
+#ifndef CFG_TUD_CDC_TX_FLUSH_MIN
+  #define CFG_TUD_CDC_TX_FLUSH_MIN    (TUD_OPT_HIGH_SPEED ? 512 : 64)
+#endif
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -94,6 +105,22 @@ void tud_cdc_n_read_flush(uint8_t itf);
 // Get a byte from FIFO without removing it
 bool tud_cdc_n_peek(uint8_t itf, uint8_t* ui8);
 
+// Set framing of received data (TUSB_FRAME_NONE to disable). Complete frames are reported by tud_cdc_rx_frame_cb()
+// and read with tud_cdc_n_read_frame(). Largest frame must fit into RX FIFO with CFG_TUD_CDC_EP_BUFSIZE to spare.
+// A larger frame is dropped up to its end (next terminator or its declared length).
+// Frame API should be called from the same task as tud_task() and must not be mixed with byte read.
+void tud_cdc_n_set_rx_frame(uint8_t itf, tusb_frame_mode_t mode, uint8_t delimiter);
+
+// Get raw length of the complete frame at head of RX FIFO, 0 if there is none
+uint32_t tud_cdc_n_frame_available(uint8_t itf);
+
+// Read and decode a complete frame (without terminator/length prefix), truncated to bufsize. Return payload length
+uint32_t tud_cdc_n_read_frame(uint8_t itf, void* buffer, uint32_t bufsize);
+
+// Zero-copy access to raw payload of the complete frame in up to 2 linear parts, COBS and SLIP are not decoded.
+// Release with tud_cdc_n_read_frame(itf, NULL, 0)
+bool tud_cdc_n_peek_frame(uint8_t itf, tu_fifo_buffer_info_t* info);
+
 // Write bytes to TX FIFO, data may remain in the FIFO for a while
 uint32_t tud_cdc_n_write(uint8_t itf, void const* buffer, uint32_t bufsize);
 
@@ -116,6 +143,10 @@ uint32_t tud_cdc_n_write_available(uint8_t itf);
 // Clear the transmit FIFO
 bool tud_cdc_n_write_clear(uint8_t itf);
 
+// Configure TX flush policy: written data is sent as soon as TX FIFO holds min_fill bytes, otherwise at most
+// delay_ms after the first unsent byte was written (using SOF). delay_ms = 0 disables timed flush.
+bool tud_cdc_n_set_tx_flush(uint8_t itf, uint16_t delay_ms, uint16_t min_fill);
+
 //--------------------------------------------------------------------+
 // Application API (Single Port)
 //--------------------------------------------------------------------+
@@ -160,6 +191,22 @@ TU_ATTR_ALWAYS_INLINE static inline bool tud_cdc_peek(uint8_t* ui8) {
   return tud_cdc_n_peek(0, ui8);
 }
 
+TU_ATTR_ALWAYS_INLINE static inline void tud_cdc_set_rx_frame(tusb_frame_mode_t mode, uint8_t delimiter) {
+  tud_cdc_n_set_rx_frame(0, mode, delimiter);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_frame_available(void) {
+  return tud_cdc_n_frame_available(0);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_read_frame(void* buffer, uint32_t bufsize) {
+  return tud_cdc_n_read_frame(0, buffer, bufsize);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline bool tud_cdc_peek_frame(tu_fifo_buffer_info_t* info) {
+  return tud_cdc_n_peek_frame(0, info);
+}
+
 TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_cdc_write_char(char ch) {
   return tud_cdc_n_write_char(0, ch);
 }
@@ -184,6 +231,10 @@ TU_ATTR_ALWAYS_INLINE static inline bool tud_cdc_write_clear(void) {
   return tud_cdc_n_write_clear(0);
 }
 
+TU_ATTR_ALWAYS_INLINE static inline bool tud_cdc_set_tx_flush(uint16_t delay_ms, uint16_t min_fill) {
+  return tud_cdc_n_set_tx_flush(0, delay_ms, min_fill);
+}
+
 //--------------------------------------------------------------------+
 // Application Callback API (weak is optional)
 //--------------------------------------------------------------------+
@@ -194,6 +245,9 @@ TU_ATTR_WEAK void tud_cdc_rx_cb(uint8_t itf);
 // Invoked when received `wanted_char`
 TU_ATTR_WEAK void tud_cdc_rx_wanted_cb(uint8_t itf, char wanted_char);
 
+// Invoked when a complete frame is received, see tud_cdc_n_set_rx_frame()
+TU_ATTR_WEAK void tud_cdc_rx_frame_cb(uint8_t itf);
+
 // Invoked when a TX is complete and therefore space becomes available in TX buffer
 TU_ATTR_WEAK void tud_cdc_tx_complete_cb(uint8_t itf);
 
@@ -218,6 +272,7 @@ void     cdcd_reset           (uint8_t rhport);
 uint16_t cdcd_open            (uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len);
 bool     cdcd_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 bool     cdcd_xfer_cb         (uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+void     cdcd_sof_isr         (uint8_t rhport, uint32_t frame_count);
 
 #ifdef __cplusplus
  }
@@ -54,12 +54,14 @@ typedef struct {
   uint8_t bInterfaceProtocol;
 
   uint8_t ep_notif;
+  uint8_t ep_notif_size;
   uint8_t serial_drid; // Serial Driver ID
   bool mounted;        // Enumeration is complete
   cdc_acm_capability_t acm_capability;
 
   TU_ATTR_ALIGNED(4) cdc_line_coding_t line_coding; // Baudrate, stop bits, parity, data width
   uint8_t line_state;                               // DTR (bit0), RTS (bit1)
+  uint16_t serial_state;                            // CDC_SERIAL_STATE_* reported by device
 
   #if CFG_TUH_CDC_FTDI || CFG_TUH_CDC_CP210X || CFG_TUH_CDC_CH34X
   cdc_line_coding_t requested_line_coding;
@@ -73,13 +75,14 @@ typedef struct {
     tu_edpt_stream_t rx;
 
     uint8_t tx_ff_buf[CFG_TUH_CDC_TX_BUFSIZE];
-    uint8_t rx_ff_buf[CFG_TUH_CDC_TX_BUFSIZE];
+    uint8_t rx_ff_buf[CFG_TUH_CDC_RX_BUFSIZE];
   } stream;
 } cdch_interface_t;
 
 typedef struct {
   TUH_EPBUF_DEF(tx, CFG_TUH_CDC_TX_EPSIZE);
-  TUH_EPBUF_DEF(rx, CFG_TUH_CDC_TX_EPSIZE);
+  TUH_EPBUF_DEF(rx, CFG_TUH_CDC_RX_EPSIZE);
+  TUH_EPBUF_DEF(notif, 64);
 } cdch_epbuf_t;
 
 static cdch_interface_t cdch_data[CFG_TUH_CDC];
@@ -111,6 +114,7 @@ static bool ftdi_sio_set_baudrate(cdch_interface_t* p_cdc, uint32_t baudrate, tu
 static bool ftdi_set_data_format(cdch_interface_t* p_cdc, uint8_t stop_bits, uint8_t parity, uint8_t data_bits, tuh_xfer_cb_t complete_cb, uintptr_t user_data);
 static bool ftdi_set_line_coding(cdch_interface_t* p_cdc, cdc_line_coding_t const* line_coding, tuh_xfer_cb_t complete_cb, uintptr_t user_data);
 static bool ftdi_sio_set_modem_ctrl(cdch_interface_t* p_cdc, uint16_t line_state, tuh_xfer_cb_t complete_cb, uintptr_t user_data);
+static uint32_t ftdi_rx_xfer_complete(cdch_interface_t* p_cdc, uint8_t idx, uint32_t xferred_bytes);
 #endif
 
 //------------- CP210X prototypes -------------//
@@ -260,6 +264,7 @@ static cdch_interface_t* make_new_itf(uint8_t daddr, tusb_desc_interface_t const
       p_cdc->bInterfaceSubClass = itf_desc->bInterfaceSubClass;
       p_cdc->bInterfaceProtocol = itf_desc->bInterfaceProtocol;
       p_cdc->line_state         = 0;
+      p_cdc->serial_state       = 0;
       return p_cdc;
     }
   }
@@ -326,6 +331,13 @@ bool tuh_cdc_get_rts(uint8_t idx) {
   return (p_cdc->line_state & CDC_CONTROL_LINE_STATE_RTS) ? true : false;
 }
 
+uint16_t tuh_cdc_get_serial_state(uint8_t idx) {
+  cdch_interface_t* p_cdc = get_itf(idx);
+  TU_VERIFY(p_cdc, 0);
+
+  return p_cdc->serial_state;
+}
+
 bool tuh_cdc_get_local_line_coding(uint8_t idx, cdc_line_coding_t* line_coding) {
   cdch_interface_t* p_cdc = get_itf(idx);
   TU_VERIFY(p_cdc);
@@ -335,6 +347,55 @@ bool tuh_cdc_get_local_line_coding(uint8_t idx, cdc_line_coding_t* line_coding)
   return true;
 }
 
+//--------------------------------------------------------------------+
+// Buffer
+//--------------------------------------------------------------------+
+
+// Restore built-in fifo and endpoint buffers
+static void stream_buffer_reset(cdch_interface_t* p_cdc, uint8_t idx) {
+  cdch_epbuf_t* epbuf = &cdch_epbuf[idx];
+  tu_edpt_stream_set_buffer(&p_cdc->stream.tx, p_cdc->stream.tx_ff_buf, CFG_TUH_CDC_TX_BUFSIZE,
+                            epbuf->tx, CFG_TUH_CDC_TX_EPSIZE);
+  tu_edpt_stream_set_buffer(&p_cdc->stream.rx, p_cdc->stream.rx_ff_buf, CFG_TUH_CDC_RX_BUFSIZE,
+                            epbuf->rx, CFG_TUH_CDC_RX_EPSIZE);
+}
+
+static bool stream_set_buffer(uint8_t daddr, tu_edpt_stream_t* s, void* ff_buf, uint16_t ff_bufsize,
+                              uint8_t* ep_buf, uint16_t ep_bufsize) {
+  // endpoint buffer must hold whole packets
+  uint16_t const mps = s->is_mps512 ? TUSB_EPSIZE_BULK_HS : TUSB_EPSIZE_BULK_FS;
+  TU_VERIFY(ff_buf && ff_bufsize);
+  TU_VERIFY(ep_buf == NULL || (ep_bufsize >= mps && 0 == (ep_bufsize & (mps - 1))));
+  TU_VERIFY(!usbh_edpt_busy(daddr, s->ep_addr));
+
+  if (ep_buf == NULL) {
+    ep_buf = s->ep_buf;
+    ep_bufsize = s->ep_bufsize;
+  }
+
+  return tu_edpt_stream_set_buffer(s, ff_buf, ff_bufsize, ep_buf, ep_bufsize);
+}
+
+bool tuh_cdc_set_rx_buffer(uint8_t idx, void* ff_buf, uint16_t ff_bufsize, uint8_t* ep_buf, uint16_t ep_bufsize) {
+  cdch_interface_t* p_cdc = get_itf(idx);
+  TU_VERIFY(p_cdc);
+
+  TU_VERIFY(stream_set_buffer(p_cdc->daddr, &p_cdc->stream.rx, ff_buf, ff_bufsize, ep_buf, ep_bufsize));
+
+  // re-arm if interface is already receiving
+  if (p_cdc->mounted) {
+    tu_edpt_stream_read_xfer(p_cdc->daddr, &p_cdc->stream.rx);
+  }
+  return true;
+}
+
+bool tuh_cdc_set_tx_buffer(uint8_t idx, void* ff_buf, uint16_t ff_bufsize, uint8_t* ep_buf, uint16_t ep_bufsize) {
+  cdch_interface_t* p_cdc = get_itf(idx);
+  TU_VERIFY(p_cdc);
+
+  return stream_set_buffer(p_cdc->daddr, &p_cdc->stream.tx, ff_buf, ff_bufsize, ep_buf, ep_bufsize);
+}
+
 //--------------------------------------------------------------------+
 // Write
 //--------------------------------------------------------------------+
@@ -619,6 +680,69 @@ bool tuh_cdc_set_line_coding(uint8_t idx, cdc_line_coding_t const* line_coding,
   }
 }
 
+//--------------------------------------------------------------------+
+// Serial State
+//--------------------------------------------------------------------+
+
+static void serial_state_update(cdch_interface_t* p_cdc, uint8_t idx, uint16_t serial_state) {
+  // line errors are events and always reported, modem lines only on change
+  bool const changed = (serial_state != p_cdc->serial_state) || (serial_state & CDC_SERIAL_STATE_ERRORS);
+  p_cdc->serial_state = serial_state;
+
+  if (changed && tuh_cdc_serial_state_cb) {
+    tuh_cdc_serial_state_cb(idx, serial_state);
+  }
+}
+
+static bool notif_xfer(cdch_interface_t* p_cdc, uint8_t idx) {
+  TU_VERIFY(p_cdc->ep_notif);
+  TU_VERIFY(usbh_edpt_claim(p_cdc->daddr, p_cdc->ep_notif));
+  if (!usbh_edpt_xfer(p_cdc->daddr, p_cdc->ep_notif, cdch_epbuf[idx].notif, p_cdc->ep_notif_size)) {
+    usbh_edpt_release(p_cdc->daddr, p_cdc->ep_notif);
+    return false;
+  }
+  return true;
+}
+
+static void notif_xfer_complete(cdch_interface_t* p_cdc, uint8_t idx, uint32_t xferred_bytes) {
+  uint8_t const* buf = cdch_epbuf[idx].notif;
+
+  switch (p_cdc->serial_drid) {
+    #if CFG_TUH_CDC_CH34X
+    case SERIAL_DRIVER_CH34X:
+      if (xferred_bytes >= 4) {
+        uint8_t const modem = (uint8_t) (~buf[2] & CH34X_BITS_MODEM_STAT);
+        uint16_t state = 0;
+        if (modem & CH34X_BIT_CTS) state |= CDC_SERIAL_STATE_CTS;
+        if (modem & CH34X_BIT_DSR) state |= CDC_SERIAL_STATE_TX_CARRIER;
+        if (modem & CH34X_BIT_RI)  state |= CDC_SERIAL_STATE_RING;
+        if (modem & CH34X_BIT_DCD) state |= CDC_SERIAL_STATE_RX_CARRIER;
+        serial_state_update(p_cdc, idx, state);
+      }
+      break;
+    #endif
+
+    case SERIAL_DRIVER_ACM: {
+      // 8-byte notification header followed by wLength bytes of data (2-byte bitmap for SerialState).
+      // Notifications sized a multiple of packet size are not terminated, walk all of them in the transfer
+      uint32_t pos = 0;
+      while (pos + 8 <= xferred_bytes) {
+        uint8_t const* notif = buf + pos;
+        uint16_t const len = tu_u16(notif[7], notif[6]);
+        if (pos + 8 + len > xferred_bytes) break;
+
+        if (notif[1] == CDC_NOTIF_SERIAL_STATE && len >= 2) {
+          serial_state_update(p_cdc, idx, tu_u16(notif[9], notif[8]));
+        }
+        pos += 8u + len;
+      }
+      break;
+    }
+
+    default: break;
+  }
+}
+
 //--------------------------------------------------------------------+
 // CLASS-USBH API
 //--------------------------------------------------------------------+
@@ -663,9 +787,11 @@ void cdch_close(uint8_t daddr) {
 
       p_cdc->daddr = 0;
       p_cdc->bInterfaceNumber = 0;
+      p_cdc->ep_notif = 0;
       p_cdc->mounted = false;
       tu_edpt_stream_close(&p_cdc->stream.tx);
       tu_edpt_stream_close(&p_cdc->stream.rx);
+      stream_buffer_reset(p_cdc, idx);
     }
   }
 }
@@ -690,26 +816,27 @@ bool cdch_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t
       tu_edpt_stream_write_zlp_if_needed(daddr, &p_cdc->stream.tx, xferred_bytes);
     }
   } else if ( ep_addr == p_cdc->stream.rx.ep_addr ) {
+    uint32_t rx_count = xferred_bytes;
+
     #if CFG_TUH_CDC_FTDI
     if (p_cdc->serial_drid == SERIAL_DRIVER_FTDI) {
-      // FTDI reserve 2 bytes for status
-      // uint8_t status[2] = {p_cdc->stream.rx.ep_buf[0], p_cdc->stream.rx.ep_buf[1]};
-      tu_edpt_stream_read_xfer_complete_offset(&p_cdc->stream.rx, xferred_bytes, 2);
+      rx_count = ftdi_rx_xfer_complete(p_cdc, idx, xferred_bytes);
     }else
     #endif
     {
       tu_edpt_stream_read_xfer_complete(&p_cdc->stream.rx, xferred_bytes);
     }
 
-    // invoke receive callback
-    if (tuh_cdc_rx_cb) {
+    // invoke receive callback, FTDI sends status-only packets periodically when there is no data
+    if (rx_count && tuh_cdc_rx_cb) {
       tuh_cdc_rx_cb(idx);
     }
 
     // prepare for next transfer if needed
     tu_edpt_stream_read_xfer(daddr, &p_cdc->stream.rx);
   }else if ( ep_addr == p_cdc->ep_notif ) {
-    // TODO handle notification endpoint
+    notif_xfer_complete(p_cdc, idx, xferred_bytes);
+    notif_xfer(p_cdc, idx);
   }else {
     TU_ASSERT(false);
   }
@@ -772,8 +899,11 @@ static void set_config_complete(cdch_interface_t * p_cdc, uint8_t idx, uint8_t i
     tuh_cdc_mount_cb(idx);
   }
 
-  // Prepare for incoming data
+  // Prepare for incoming data and serial state notification
   tu_edpt_stream_read_xfer(p_cdc->daddr, &p_cdc->stream.rx);
+  if (p_cdc->ep_notif) {
+    notif_xfer(p_cdc, idx);
+  }
 
   // notify usbh that driver enumeration is complete
   usbh_driver_set_config_complete(p_cdc->daddr, itf_num);
@@ -835,6 +965,9 @@ static bool acm_open(uint8_t daddr, tusb_desc_interface_t const* itf_desc, uint1
 
     TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
     p_cdc->ep_notif = desc_ep->bEndpointAddress;
+    // SerialState (10 bytes) can span several packets on small endpoints: request the whole buffer
+    // and let the short packet end the transfer
+    p_cdc->ep_notif_size = (uint8_t) sizeof(cdch_epbuf[0].notif);
 
     p_desc = tu_desc_next(p_desc);
   }
@@ -986,6 +1119,68 @@ enum {
   CONFIG_FTDI_COMPLETE
 };
 
+// Every packet starts with 2 status bytes (modem, line) followed by data. Data of all packets in the transfer is
+// written to the fifo's linear/wrapped segments in a single pass, write pointer is advanced once at the end.
+// Return number of data bytes written to fifo
+static uint32_t ftdi_rx_xfer_complete(cdch_interface_t* p_cdc, uint8_t idx, uint32_t xferred_bytes) {
+  tu_edpt_stream_t* s = &p_cdc->stream.rx;
+  uint16_t const mps = s->is_mps512 ? TUSB_EPSIZE_BULK_HS : TUSB_EPSIZE_BULK_FS;
+  uint8_t const* ep_buf = s->ep_buf;
+
+  tu_fifo_buffer_info_t info;
+  tu_fifo_get_write_info(&s->ff, &info);
+  uint8_t* dst = (uint8_t*) info.ptr_lin;
+  uint16_t dst_len = info.len_lin;
+
+  uint16_t count = 0;
+  uint8_t modem_status = 0;
+  uint8_t line_errors = 0;
+
+  for (uint32_t offset = 0; offset + 2 <= xferred_bytes; offset += mps) {
+    uint16_t data_len = (uint16_t) (tu_min32(xferred_bytes - offset, mps) - 2);
+    uint8_t const* src = ep_buf + offset + 2;
+
+    modem_status = ep_buf[offset];
+    line_errors |= ep_buf[offset + 1];
+
+    while (data_len) {
+      if (dst_len == 0) {
+        if (info.len_wrap == 0) break; // fifo full, drop
+        dst = (uint8_t*) info.ptr_wrap;
+        dst_len = info.len_wrap;
+        info.len_wrap = 0;
+      }
+
+      uint16_t const n = tu_min16(data_len, dst_len);
+      memcpy(dst, src, n);
+      dst += n;
+      dst_len = (uint16_t) (dst_len - n);
+      src += n;
+      data_len = (uint16_t) (data_len - n);
+      count = (uint16_t) (count + n);
+    }
+  }
+
+  if (count) {
+    tu_fifo_advance_write_pointer(&s->ff, count);
+  }
+
+  if (xferred_bytes >= 2) {
+    uint16_t state = 0;
+    if (modem_status & FTDI_RS0_CTS)  state |= CDC_SERIAL_STATE_CTS;
+    if (modem_status & FTDI_RS0_DSR)  state |= CDC_SERIAL_STATE_TX_CARRIER;
+    if (modem_status & FTDI_RS0_RI)   state |= CDC_SERIAL_STATE_RING;
+    if (modem_status & FTDI_RS0_RLSD) state |= CDC_SERIAL_STATE_RX_CARRIER;
+    if (line_errors & FTDI_RS_OE)     state |= CDC_SERIAL_STATE_OVERRUN;
+    if (line_errors & FTDI_RS_PE)     state |= CDC_SERIAL_STATE_PARITY;
+    if (line_errors & FTDI_RS_FE)     state |= CDC_SERIAL_STATE_FRAMING;
+    if (line_errors & FTDI_RS_BI)     state |= CDC_SERIAL_STATE_BREAK;
+    serial_state_update(p_cdc, idx, state);
+  }
+
+  return count;
+}
+
 static bool ftdi_open(uint8_t daddr, const tusb_desc_interface_t *itf_desc, uint16_t max_len) {
   // FTDI Interface includes 1 vendor interface + 2 bulk endpoints
   TU_VERIFY(itf_desc->bInterfaceSubClass == 0xff && itf_desc->bInterfaceProtocol == 0xff && itf_desc->bNumEndpoints == 2);
@@ -1517,11 +1712,12 @@ static bool ch34x_open(uint8_t daddr, tusb_desc_interface_t const* itf_desc, uin
   TU_ASSERT(open_ep_stream_pair(p_cdc, desc_ep));
   desc_ep += 2;
 
-  // Interrupt endpoint: not used for now
+  // Interrupt endpoint: modem status
   TU_ASSERT(TUSB_DESC_ENDPOINT == tu_desc_type(desc_ep) &&
             TUSB_XFER_INTERRUPT == desc_ep->bmAttributes.xfer);
   TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
   p_cdc->ep_notif = desc_ep->bEndpointAddress;
+  p_cdc->ep_notif_size = (uint8_t) tu_min16(tu_edpt_packet_size(desc_ep), sizeof(cdch_epbuf[0].notif));
 
   return true;
 }
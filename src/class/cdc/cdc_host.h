@@ -52,7 +52,7 @@
 #define CFG_TUH_CDC_RX_BUFSIZE USBH_EPSIZE_BULK_MAX
 #endif
 
-// RX Endpoint size
+// RX Endpoint size, a multiple of packet size allows to receive several packets per transfer when FIFO has room
 #ifndef CFG_TUH_CDC_RX_EPSIZE
 #define CFG_TUH_CDC_RX_EPSIZE  USBH_EPSIZE_BULK_MAX
 #endif
@@ -88,6 +88,10 @@ bool tuh_cdc_get_dtr(uint8_t idx);
 // Get current RTS status
 bool tuh_cdc_get_rts(uint8_t idx);
 
+// Get last serial state reported by device: modem lines and line errors (CDC_SERIAL_STATE_*).
+// Reported by ACM SerialState notification, FTDI status bytes and CH34x interrupt endpoint
+uint16_t tuh_cdc_get_serial_state(uint8_t idx);
+
 // Check if interface is connected (DTR active)
 TU_ATTR_ALWAYS_INLINE static inline bool tuh_cdc_connected(uint8_t idx) {
   return tuh_cdc_get_dtr(idx);
@@ -99,6 +103,18 @@ TU_ATTR_ALWAYS_INLINE static inline bool tuh_cdc_connected(uint8_t idx) {
 // NOTE: This function does not make any USB transfer request to device.
 bool tuh_cdc_get_local_line_coding(uint8_t idx, cdc_line_coding_t* line_coding);
 
+//--------------------------------------------------------------------+
+// Buffer API
+// Replace built-in FIFO (CFG_TUH_CDC_RX/TX_BUFSIZE) and endpoint buffer (CFG_TUH_CDC_RX/TX_EPSIZE) of an interface
+// so that e.g high baudrate adapters get larger buffers than others. Should be called in tuh_cdc_mount_cb().
+// - Data in the replaced FIFO is discarded, fails if endpoint is busy
+// - ep_buf = NULL keeps current endpoint buffer, otherwise ep_bufsize must be multiple of packet size and ep_buf
+//   must be placed in CFG_TUH_MEM_SECTION aligned to CFG_TUH_MEM_ALIGN
+// - Buffers must stay valid until tuh_cdc_umount_cb(), built-in buffers are restored when interface is closed
+//--------------------------------------------------------------------+
+bool tuh_cdc_set_rx_buffer(uint8_t idx, void* ff_buf, uint16_t ff_bufsize, uint8_t* ep_buf, uint16_t ep_bufsize);
+bool tuh_cdc_set_tx_buffer(uint8_t idx, void* ff_buf, uint16_t ff_bufsize, uint8_t* ep_buf, uint16_t ep_bufsize);
+
 //--------------------------------------------------------------------+
 // Write API
 //--------------------------------------------------------------------+
@@ -188,6 +204,9 @@ TU_ATTR_WEAK extern void tuh_cdc_rx_cb(uint8_t idx);
 // Invoked when a TX is complete and therefore space becomes available in TX buffer
 TU_ATTR_WEAK extern void tuh_cdc_tx_complete_cb(uint8_t idx);
 
+// Invoked when serial state (CDC_SERIAL_STATE_*) changes or device reports line errors
+TU_ATTR_WEAK extern void tuh_cdc_serial_state_cb(uint8_t idx, uint16_t serial_state);
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
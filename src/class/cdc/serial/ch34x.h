@@ -67,6 +67,13 @@
 #define CH34X_BIT_RTS ( 1 << 6 )
 #define CH34X_BIT_DTR ( 1 << 5 )
 
+// modem status bits (active low) in byte 2 of interrupt endpoint packet
+#define CH34X_BIT_CTS ( 1 << 0 )
+#define CH34X_BIT_DSR ( 1 << 1 )
+#define CH34X_BIT_RI  ( 1 << 2 )
+#define CH34X_BIT_DCD ( 1 << 3 )
+#define CH34X_BITS_MODEM_STAT 0x0f
+
 // line control bits
 #define CH34X_LCR_ENABLE_RX    0x80
 #define CH34X_LCR_ENABLE_TX    0x40
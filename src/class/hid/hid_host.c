@@ -761,4 +761,283 @@ uint8_t tuh_hid_parse_report_descriptor(tuh_hid_report_info_t* report_info_arr,
   return report_num;
 }
 
+//--------------------------------------------------------------------+
+// Report Field Parser
+//--------------------------------------------------------------------+
+enum {
+  HID_FIELD_USAGE_MAX = 16, // local usages kept per Main item
+  HID_FIELD_STACK_MAX = 4   // Push/Pop depth
+};
+
+typedef struct {
+  uint16_t usage_page;
+  uint8_t report_id;
+  uint8_t report_size;
+  uint16_t report_count;
+  int32_t logical_min;
+  int32_t logical_max;
+} hid_field_global_t;
+
+typedef struct {
+  uint32_t usages[HID_FIELD_USAGE_MAX]; // extended usage: page in high 16 bits, 0 for global page
+  uint8_t usage_count;
+  uint32_t usage_min;
+  uint32_t usage_max;
+} hid_field_local_t;
+
+static uint32_t item_unsigned(uint8_t const* data, uint8_t size) {
+  switch (size) {
+    case 1: return data[0];
+    case 2: return tu_u16(data[1], data[0]);
+    case 4: return tu_u32(data[3], data[2], data[1], data[0]);
+    default: return 0;
+  }
+}
+
+static int32_t item_signed(uint8_t const* data, uint8_t size) {
+  switch (size) {
+    case 1: return (int8_t) data[0];
+    case 2: return (int16_t) tu_u16(data[1], data[0]);
+    case 4: return (int32_t) tu_u32(data[3], data[2], data[1], data[0]);
+    default: return 0;
+  }
+}
+
+// bit position where next field of the same report starts
+static uint16_t field_bit_end(tuh_hid_report_field_t const* fields, uint16_t count, uint8_t report_id, uint8_t report_type) {
+  uint16_t bit_end = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    tuh_hid_report_field_t const* f = &fields[i];
+    if (f->report_id == report_id && f->report_type == report_type) {
+      bit_end = tu_max16(bit_end, (uint16_t) (f->bit_offset + f->bit_size * f->count));
+    }
+  }
+  return bit_end;
+}
+
+static bool field_add(tuh_hid_report_field_t* fields, uint16_t* p_count, uint16_t max_fields,
+                      hid_field_global_t const* global, uint8_t report_type, uint8_t flags,
+                      uint16_t elem_count, uint32_t usage_min, uint32_t usage_max) {
+  TU_VERIFY(*p_count < max_fields);
+  tuh_hid_report_field_t* f = &fields[*p_count];
+
+  f->report_id = global->report_id;
+  f->report_type = report_type;
+  f->flags = flags;
+  f->bit_size = global->report_size;
+  f->bit_offset = field_bit_end(fields, *p_count, global->report_id, report_type);
+  f->count = elem_count;
+  f->usage_page = (usage_min >> 16) ? (uint16_t) (usage_min >> 16) : global->usage_page;
+  f->usage_min = (uint16_t) usage_min;
+  f->usage_max = (uint16_t) usage_max;
+  f->logical_min = global->logical_min;
+  f->logical_max = global->logical_max;
+
+  (*p_count)++;
+  return true;
+}
+
+uint16_t tuh_hid_parse_report_fields(tuh_hid_report_field_t* fields, uint16_t max_fields,
+                                     uint8_t const* desc_report, uint16_t desc_len) {
+  hid_field_global_t global_stack[HID_FIELD_STACK_MAX];
+  uint8_t stack_depth = 0;
+
+  hid_field_global_t global;
+  hid_field_local_t local;
+  tu_varclr(&global);
+  tu_varclr(&local);
+
+  uint16_t field_count = 0;
+
+  while (desc_len) {
+    uint8_t const header = *desc_report++;
+    desc_len--;
+
+    // Long item: skip, no tag is defined for it
+    if (header == 0xFE) {
+      TU_VERIFY(desc_len >= 2, field_count);
+      uint16_t const long_size = (uint16_t) (desc_report[0] + 2);
+      TU_VERIFY(desc_len >= long_size, field_count);
+      desc_report += long_size;
+      desc_len = (uint16_t) (desc_len - long_size);
+      continue;
+    }
+
+    uint8_t const tag = header >> 4;
+    uint8_t const type = (header >> 2) & 0x03u;
+    uint8_t const size = (header & 0x03u) == 3 ? 4 : (header & 0x03u);
+    TU_VERIFY(desc_len >= size, field_count);
+
+    uint32_t const udata = item_unsigned(desc_report, size);
+
+    switch (type) {
+      case RI_TYPE_MAIN: {
+        uint8_t report_type = HID_REPORT_TYPE_INVALID;
+        if (tag == RI_MAIN_INPUT) {
+          report_type = HID_REPORT_TYPE_INPUT;
+        } else if (tag == RI_MAIN_OUTPUT) {
+          report_type = HID_REPORT_TYPE_OUTPUT;
+        } else if (tag == RI_MAIN_FEATURE) {
+          report_type = HID_REPORT_TYPE_FEATURE;
+        }
+
+        if (report_type != HID_REPORT_TYPE_INVALID && global.report_size && global.report_count) {
+          uint8_t const flags = (uint8_t) udata;
+
+          if ((flags & HID_VARIABLE) && local.usage_count > 1) {
+            // each usage of the list applies to one element, the last one to the rest
+            uint16_t remaining = global.report_count;
+            for (uint8_t i = 0; i < local.usage_count && remaining; i++) {
+              uint16_t const n = (i + 1u == local.usage_count) ? remaining : 1;
+              (void) field_add(fields, &field_count, max_fields, &global, report_type, flags, n,
+                               local.usages[i], local.usages[i]);
+              remaining = (uint16_t) (remaining - n);
+            }
+          } else {
+            uint32_t usage_min = local.usage_min;
+            uint32_t usage_max = local.usage_max;
+            if (local.usage_count) {
+              // Array selects from its usage list, assumed contiguous
+              usage_min = local.usages[0];
+              usage_max = local.usages[local.usage_count - 1];
+            }
+            (void) field_add(fields, &field_count, max_fields, &global, report_type, flags, global.report_count,
+                             usage_min, usage_max);
+          }
+        }
+
+        // Local items only apply to the next Main item
+        tu_varclr(&local);
+        break;
+      }
+
+      case RI_TYPE_GLOBAL:
+        switch (tag) {
+          case RI_GLOBAL_USAGE_PAGE: global.usage_page = (uint16_t) udata; break;
+          case RI_GLOBAL_LOGICAL_MIN: global.logical_min = item_signed(desc_report, size); break;
+          case RI_GLOBAL_LOGICAL_MAX:
+            // Logical Maximum is unsigned if Logical Minimum is not negative
+            global.logical_max = (global.logical_min < 0) ? item_signed(desc_report, size) : (int32_t) udata;
+            break;
+          case RI_GLOBAL_REPORT_SIZE: global.report_size = (uint8_t) tu_min32(udata, 32); break;
+          case RI_GLOBAL_REPORT_ID: global.report_id = (uint8_t) udata; break;
+          case RI_GLOBAL_REPORT_COUNT: global.report_count = (uint16_t) udata; break;
+
+          case RI_GLOBAL_PUSH:
+            TU_VERIFY(stack_depth < HID_FIELD_STACK_MAX, field_count);
+            global_stack[stack_depth++] = global;
+            break;
+
+          case RI_GLOBAL_POP:
+            TU_VERIFY(stack_depth > 0, field_count);
+            global = global_stack[--stack_depth];
+            break;
+
+          default: break;
+        }
+        break;
+
+      case RI_TYPE_LOCAL: {
+        // 4-byte usage carries its own usage page in high 16 bits
+        switch (tag) {
+          case RI_LOCAL_USAGE:
+            if (local.usage_count < HID_FIELD_USAGE_MAX) {
+              local.usages[local.usage_count++] = udata;
+            }
+            break;
+          case RI_LOCAL_USAGE_MIN: local.usage_min = udata; break;
+          case RI_LOCAL_USAGE_MAX: local.usage_max = udata; break;
+          default: break;
+        }
+        break;
+      }
+
+      default: break;
+    }
+
+    desc_report += size;
+    desc_len = (uint16_t) (desc_len - size);
+  }
+
+  for (uint16_t i = 0; i < field_count; i++) {
+    TU_LOG_DRV("%u: id = %u, type = %u, offset = %u, size = %u x %u, usage = %04X:%04X-%04X\r\n", i,
+               fields[i].report_id, fields[i].report_type, fields[i].bit_offset, fields[i].bit_size, fields[i].count,
+               fields[i].usage_page, fields[i].usage_min, fields[i].usage_max);
+  }
+
+  return field_count;
+}
+
+// read little-endian bit field, caller makes sure it is within buffer
+static uint32_t report_get_bits(uint8_t const* data, uint32_t bit_offset, uint8_t bit_size) {
+  uint8_t const* p = data + (bit_offset >> 3);
+  uint8_t shift = (uint8_t) (bit_offset & 7u);
+
+  // byte aligned whole bytes: common case for axes and buttons bitmap
+  if (shift == 0 && (bit_size & 7u) == 0) {
+    switch (bit_size) {
+      case 8: return p[0];
+      case 16: return tu_u16(p[1], p[0]);
+      case 32: return tu_u32(p[3], p[2], p[1], p[0]);
+      default: break;
+    }
+  }
+
+  uint32_t value = 0;
+  uint8_t got = 0;
+  while (got < bit_size) {
+    uint8_t const take = tu_min8((uint8_t) (8u - shift), (uint8_t) (bit_size - got));
+    uint32_t const bits = ((uint32_t) (*p++) >> shift) & ((1u << take) - 1u);
+    value |= bits << got;
+    got = (uint8_t) (got + take);
+    shift = 0;
+  }
+
+  return value;
+}
+
+uint16_t tuh_hid_extract_report_fields(tuh_hid_report_field_t const* fields, uint16_t field_count, uint8_t report_type,
+                                       uint8_t const* report, uint16_t len, int32_t* values, uint16_t max_values) {
+  TU_VERIFY(field_count && len, 0);
+
+  // Report ID is declared before the first Main item if descriptor uses it
+  uint8_t report_id = 0;
+  if (fields[0].report_id) {
+    report_id = report[0];
+    report++;
+    len--;
+  }
+
+  uint32_t const bit_len = 8u * len;
+  uint16_t value_count = 0;
+
+  for (uint16_t i = 0; i < field_count; i++) {
+    tuh_hid_report_field_t const* f = &fields[i];
+    if (f->report_id != report_id || f->report_type != report_type || (f->flags & HID_CONSTANT)) {
+      continue;
+    }
+
+    bool const is_signed = (f->logical_min < 0) && (f->bit_size < 32);
+    uint32_t const sign_bit = TU_BIT(f->bit_size - 1);
+    uint32_t bit_offset = f->bit_offset;
+
+    for (uint16_t e = 0; e < f->count; e++) {
+      // short report or full output
+      if (bit_offset + f->bit_size > bit_len || value_count >= max_values) {
+        return value_count;
+      }
+
+      uint32_t value = report_get_bits(report, bit_offset, f->bit_size);
+      if (is_signed && (value & sign_bit)) {
+        value |= ~(TU_BIT(f->bit_size) - 1u);
+      }
+
+      values[value_count++] = (int32_t) value;
+      bit_offset += f->bit_size;
+    }
+  }
+
+  return value_count;
+}
+
 #endif
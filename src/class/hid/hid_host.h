@@ -57,6 +57,22 @@ typedef struct {
 //  uint8_t out_len;     // length of OUT report
 } tuh_hid_report_info_t;
 
+// Report field compiled from report descriptor: one Main item (Input, Output, Feature) of a report.
+// Variable item with a usage list is split so that each field has contiguous usages.
+typedef struct {
+  uint8_t  report_id;     // 0 if descriptor has no Report ID
+  uint8_t  report_type;   // hid_report_type_t
+  uint8_t  flags;         // Main item data bits: HID_CONSTANT, HID_VARIABLE, HID_RELATIVE etc ...
+  uint8_t  bit_size;      // Report Size of each element (up to 32)
+  uint16_t bit_offset;    // from start of report data (after Report ID byte)
+  uint16_t count;         // Report Count: number of elements
+  uint16_t usage_page;
+  uint16_t usage_min;     // Variable: usage of first element, next ones are incremented up to usage_max
+  uint16_t usage_max;     // Array: range of usages selected by element value
+  int32_t  logical_min;
+  int32_t  logical_max;
+} tuh_hid_report_field_t;
+
 //--------------------------------------------------------------------+
 // Interface API
 //--------------------------------------------------------------------+
@@ -88,6 +104,18 @@ bool tuh_hid_mounted(uint8_t dev_addr, uint8_t idx);
 TU_ATTR_UNUSED uint8_t tuh_hid_parse_report_descriptor(tuh_hid_report_info_t* reports_info_arr, uint8_t arr_count,
                                                        uint8_t const* desc_report, uint16_t desc_len);
 
+// Compile report descriptor into a table of report fields with bit offset, size, logical range and usages.
+// Return number of fields, fields that do not fit into the table are dropped.
+uint16_t tuh_hid_parse_report_fields(tuh_hid_report_field_t* fields, uint16_t max_fields,
+                                     uint8_t const* desc_report, uint16_t desc_len);
+
+// Decode all elements of a report in one pass using field table from tuh_hid_parse_report_fields().
+// Report includes Report ID byte if descriptor has one (as received by tuh_hid_report_received_cb()).
+// One value per element of non-constant fields is written in table order, sign-extended if logical minimum is
+// negative. Return number of values written.
+uint16_t tuh_hid_extract_report_fields(tuh_hid_report_field_t const* fields, uint16_t field_count, uint8_t report_type,
+                                       uint8_t const* report, uint16_t len, int32_t* values, uint16_t max_values);
+
 //--------------------------------------------------------------------+
 // Control Endpoint API
 //--------------------------------------------------------------------+
@@ -52,9 +52,60 @@ typedef enum
 
 typedef enum
 {
-  MIDI_CS_ENDPOINT_GENERAL = 0x01
+  MIDI_CS_ENDPOINT_GENERAL     = 0x01,
+  MIDI_CS_ENDPOINT_GENERAL_2_0 = 0x02, // MIDI 2.0: Group Terminal Blocks associated to endpoint
 } midi_cs_endpoint_subtype_t;
 
+//------------- MIDI 2.0 -------------//
+
+// Descriptor type of Group Terminal Block, requested with GET_DESCRIPTOR to MIDI Streaming interface
+#define MIDI_CS_GR_TRM_BLOCK  0x26
+
+typedef enum
+{
+  MIDI_GR_TRM_BLOCK_HEADER = 0x01,
+  MIDI_GR_TRM_BLOCK        = 0x02,
+} midi_gr_trm_block_subtype_t;
+
+typedef enum
+{
+  MIDI_GR_TRM_BLOCK_TYPE_BIDIRECTIONAL = 0x00,
+  MIDI_GR_TRM_BLOCK_TYPE_IN_ONLY       = 0x01,
+  MIDI_GR_TRM_BLOCK_TYPE_OUT_ONLY      = 0x02,
+} midi_gr_trm_block_type_t;
+
+typedef enum
+{
+  MIDI_GR_TRM_PROTOCOL_UNKNOWN     = 0x00, // use Endpoint Discovery
+  MIDI_GR_TRM_PROTOCOL_MIDI1_64    = 0x01, // MIDI 1.0, up to 64 bits
+  MIDI_GR_TRM_PROTOCOL_MIDI1_64_JR = 0x02,
+  MIDI_GR_TRM_PROTOCOL_MIDI1_128   = 0x03, // MIDI 1.0, up to 128 bits
+  MIDI_GR_TRM_PROTOCOL_MIDI2       = 0x11,
+  MIDI_GR_TRM_PROTOCOL_MIDI2_JR    = 0x12,
+} midi_gr_trm_protocol_t;
+
+// Universal MIDI Packet message type, upper nibble of first word
+typedef enum
+{
+  MIDI_UMP_MT_UTILITY     = 0x0,
+  MIDI_UMP_MT_SYSTEM      = 0x1, // System Common & Real Time, 32 bits
+  MIDI_UMP_MT_MIDI1_CV    = 0x2, // MIDI 1.0 Channel Voice, 32 bits
+  MIDI_UMP_MT_DATA64      = 0x3, // SysEx 7-bit, 64 bits
+  MIDI_UMP_MT_MIDI2_CV    = 0x4, // MIDI 2.0 Channel Voice, 64 bits
+  MIDI_UMP_MT_DATA128     = 0x5, // SysEx 8-bit & Mixed Data Set, 128 bits
+  MIDI_UMP_MT_FLEX_DATA   = 0xD,
+  MIDI_UMP_MT_STREAM      = 0xF,
+} midi_ump_message_type_t;
+
+// Status of UMP SysEx 7-bit (data 64) message
+typedef enum
+{
+  MIDI_UMP_SYSEX_COMPLETE = 0x0,
+  MIDI_UMP_SYSEX_START    = 0x1,
+  MIDI_UMP_SYSEX_CONTINUE = 0x2,
+  MIDI_UMP_SYSEX_END      = 0x3,
+} midi_ump_sysex_status_t;
+
 typedef enum
 {
   MIDI_JACK_EMBEDDED = 0x01,
@@ -201,6 +252,34 @@ typedef struct TU_ATTR_PACKED
     uint8_t  iElement;          \
  }
 
+/// MIDI 2.0 Group Terminal Block Header Descriptor
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  bLength            ; ///< Size of this descriptor in bytes: 5
+  uint8_t  bDescriptorType    ; ///< MIDI_CS_GR_TRM_BLOCK
+  uint8_t  bDescriptorSubType ; ///< MIDI_GR_TRM_BLOCK_HEADER
+  uint16_t wTotalLength       ; ///< Total size of header and all Group Terminal Block descriptors
+} midi_desc_gtb_header_t;
+
+/// MIDI 2.0 Group Terminal Block Descriptor
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  bLength            ; ///< Size of this descriptor in bytes: 13
+  uint8_t  bDescriptorType    ; ///< MIDI_CS_GR_TRM_BLOCK
+  uint8_t  bDescriptorSubType ; ///< MIDI_GR_TRM_BLOCK
+  uint8_t  bGrpTrmBlkID       ; ///< ID of this block, start from 1
+  uint8_t  bGrpTrmBlkType     ; ///< midi_gr_trm_block_type_t
+  uint8_t  nGroupTrm          ; ///< First group of this block, start from 0
+  uint8_t  nNumGroupTrm       ; ///< Number of groups in this block
+  uint8_t  iBlockItem         ; ///< string descriptor
+  uint8_t  bMIDIProtocol      ; ///< midi_gr_trm_protocol_t
+  uint16_t wMaxInputBandwidth ; ///< 4KB/s unit, 0 is unknown
+  uint16_t wMaxOutputBandwidth; ///< 4KB/s unit, 0 is unknown
+} midi_desc_gtb_t;
+
+TU_VERIFY_STATIC(sizeof(midi_desc_gtb_header_t) == 5, "size is not correct");
+TU_VERIFY_STATIC(sizeof(midi_desc_gtb_t) == 13, "size is not correct");
+
 /** @} */
 
 #ifdef __cplusplus
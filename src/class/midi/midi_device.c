@@ -44,13 +44,43 @@ typedef struct {
   uint8_t buffer[4];
   uint8_t index;
   uint8_t total;
+  uint8_t running_status; // last channel voice status, write only
 } midid_stream_t;
 
+// MIDI 1.0 Table 4-1: number of MIDI bytes in event packet for each Code Index Number, 0 if reserved
+static const uint8_t _cin_msg_len[16] = {
+  0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1
+};
+
+// Code Index Number for System status 0xF0 - 0xF7. Real-Time 0xF8 - 0xFF is sent as single byte
+static const uint8_t _syscom_cin[8] = {
+  MIDI_CIN_SYSEX_START,     // 0xF0 SysEx start
+  MIDI_CIN_SYSCOM_2BYTE,    // 0xF1 MTC quarter frame
+  MIDI_CIN_SYSCOM_3BYTE,    // 0xF2 Song position pointer
+  MIDI_CIN_SYSCOM_2BYTE,    // 0xF3 Song select
+  MIDI_CIN_SYSEX_END_1BYTE, // 0xF4 undefined
+  MIDI_CIN_SYSEX_END_1BYTE, // 0xF5 undefined
+  MIDI_CIN_SYSEX_END_1BYTE, // 0xF6 Tune request
+  MIDI_CIN_SYSEX_END_1BYTE, // 0xF7 SysEx end without start
+};
+
+// Number of 32-bit words of Universal MIDI Packet for each message type
+static const uint8_t _ump_word_count[16] = {
+  1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4
+};
+
 typedef struct {
   uint8_t itf_num;
   uint8_t ep_in;
   uint8_t ep_out;
 
+  uint8_t ump_supported; // MIDI 2.0 alternate setting 1 is present
+  uint8_t alt;           // current alternate: 0 is MIDI 1.0 event packet, 1 is UMP
+
+  // SysEx bytes of UMP not yet sent as MIDI 1.0 event packet (legacy host)
+  uint8_t sysex_carry[3];
+  uint8_t sysex_carry_count;
+
   // For Stream read()/write() API
   // Messages are always 4 bytes long, queue them for reading and writing so the
   // callers can use the Stream interface with single-byte read/write calls.
@@ -58,7 +88,7 @@ typedef struct {
   midid_stream_t stream_read;
 
   /*------------- From this point, data is not cleared by bus reset -------------*/
-  // FIFO
+  // FIFO of 32-bit items: MIDI 1.0 event packets or UMP words
   tu_fifo_t rx_ff;
   tu_fifo_t tx_ff;
   uint8_t rx_ff_buf[CFG_TUD_MIDI_RX_BUFSIZE];
@@ -72,6 +102,9 @@ typedef struct {
 
 #define ITF_MEM_RESET_SIZE   offsetof(midid_interface_t, rx_ff)
 
+TU_VERIFY_STATIC((CFG_TUD_MIDI_RX_BUFSIZE % 4) == 0 && (CFG_TUD_MIDI_TX_BUFSIZE % 4) == 0, "MIDI FIFO must be multiple of 4 bytes");
+TU_VERIFY_STATIC(CFG_TUD_MIDI_TX_BUFSIZE >= 16, "MIDI TX FIFO must hold at least 4 event packets");
+
 // Endpoint Transfer buffer
 CFG_TUD_MEM_SECTION static struct {
   TUD_EPBUF_DEF(epin, CFG_TUD_MIDI_EP_BUFSIZE);
@@ -91,7 +124,7 @@ bool tud_midi_n_mounted (uint8_t itf) {
 static void _prep_out_transaction(uint8_t idx) {
   const uint8_t rhport = 0;
   midid_interface_t* p_midi = &_midid_itf[idx];
-  uint16_t available = tu_fifo_remaining(&p_midi->rx_ff);
+  uint32_t available = 4u * tu_fifo_remaining(&p_midi->rx_ff);
 
   // Prepare for incoming data but only allow what we can store in the ring buffer.
   // TODO Actually we can still carry out the transfer, keeping count of received bytes
@@ -103,7 +136,7 @@ static void _prep_out_transaction(uint8_t idx) {
   TU_VERIFY(usbd_edpt_claim(rhport, p_midi->ep_out), );
 
   // fifo can be changed before endpoint is claimed
-  available = tu_fifo_remaining(&p_midi->rx_ff);
+  available = 4u * tu_fifo_remaining(&p_midi->rx_ff);
 
   if ( available >= CFG_TUD_MIDI_EP_BUFSIZE )  {
     usbd_edpt_xfer(rhport, p_midi->ep_out, _midid_epbuf[idx].epout, CFG_TUD_MIDI_EP_BUFSIZE);
@@ -125,7 +158,7 @@ uint32_t tud_midi_n_available(uint8_t itf, uint8_t cable_num)
   const midid_stream_t* stream = &midi->stream_read;
 
   // when using with packet API stream total & index are both zero
-  return tu_fifo_count(&midi->rx_ff) + (uint8_t) (stream->total - stream->index);
+  return 4u * tu_fifo_count(&midi->rx_ff) + (uint8_t) (stream->total - stream->index);
 }
 
 uint32_t tud_midi_n_stream_read(uint8_t itf, uint8_t cable_num, void* buffer, uint32_t bufsize)
@@ -137,6 +170,7 @@ uint32_t tud_midi_n_stream_read(uint8_t itf, uint8_t cable_num, void* buffer, ui
 
   midid_interface_t* midi = &_midid_itf[itf];
   midid_stream_t* stream = &midi->stream_read;
+  TU_VERIFY(midi->ep_out && !midi->alt, 0);
 
   uint32_t total_read = 0;
   while( bufsize )
@@ -144,36 +178,12 @@ uint32_t tud_midi_n_stream_read(uint8_t itf, uint8_t cable_num, void* buffer, ui
     // Get new packet from fifo, then set packet expected bytes
     if ( stream->total == 0 )
     {
-      // return if there is no more data from fifo
-      if ( !tud_midi_n_packet_read(itf, stream->buffer) ) return total_read;
-
-      uint8_t const code_index = stream->buffer[0] & 0x0f;
-
-      // MIDI 1.0 Table 4-1: Code Index Number Classifications
-      switch(code_index)
-      {
-        case MIDI_CIN_MISC:
-        case MIDI_CIN_CABLE_EVENT:
-          // These are reserved and unused, possibly issue somewhere, skip this packet
-          return 0;
-        break;
-
-        case MIDI_CIN_SYSEX_END_1BYTE:
-        case MIDI_CIN_1BYTE_DATA:
-          stream->total = 1;
-        break;
-
-        case MIDI_CIN_SYSCOM_2BYTE     :
-        case MIDI_CIN_SYSEX_END_2BYTE  :
-        case MIDI_CIN_PROGRAM_CHANGE   :
-        case MIDI_CIN_CHANNEL_PRESSURE :
-          stream->total = 2;
-        break;
+      // stop if there is no more data from fifo
+      if ( !tu_fifo_read(&midi->rx_ff, stream->buffer) ) break;
 
-        default:
-          stream->total = 3;
-        break;
-      }
+      // Reserved/unused code index, possibly issue somewhere, skip this packet
+      stream->total = _cin_msg_len[stream->buffer[0] & 0x0f];
+      if ( stream->total == 0 ) continue;
     }
 
     // Copy data up to bufsize
@@ -195,17 +205,31 @@ uint32_t tud_midi_n_stream_read(uint8_t itf, uint8_t cable_num, void* buffer, ui
     }
   }
 
+  // Re-arm OUT endpoint once for all packets read
+  _prep_out_transaction(itf);
+
   return total_read;
 }
 
 bool tud_midi_n_packet_read (uint8_t itf, uint8_t packet[4])
 {
   midid_interface_t* midi = &_midid_itf[itf];
-  TU_VERIFY(midi->ep_out);
+  TU_VERIFY(midi->ep_out && !midi->alt);
+
+  const bool ret = tu_fifo_read(&midi->rx_ff, packet);
+  _prep_out_transaction(itf);
+  return ret;
+}
+
+uint32_t tud_midi_n_packet_read_n(uint8_t itf, uint8_t packets[][4], uint32_t count)
+{
+  midid_interface_t* midi = &_midid_itf[itf];
+  TU_VERIFY(midi->ep_out && !midi->alt, 0);
+
+  uint16_t const num_read = tu_fifo_read_n(&midi->rx_ff, packets, (uint16_t) tu_min32(count, UINT16_MAX));
 
-  const uint32_t num_read = tu_fifo_read_n(&midi->rx_ff, packet, 4);
   _prep_out_transaction(itf);
-  return (num_read == 4);
+  return num_read;
 }
 
 //--------------------------------------------------------------------+
@@ -224,7 +248,7 @@ static uint32_t write_flush(uint8_t idx) {
   // skip if previous transfer not complete
   TU_VERIFY( usbd_edpt_claim(rhport, midi->ep_in), 0 );
 
-  uint16_t count = tu_fifo_read_n(&midi->tx_ff, _midid_epbuf[idx].epin, CFG_TUD_MIDI_EP_BUFSIZE);
+  uint16_t const count = (uint16_t) (4u * tu_fifo_read_n(&midi->tx_ff, _midid_epbuf[idx].epin, CFG_TUD_MIDI_EP_BUFSIZE / 4));
 
   if (count) {
     TU_ASSERT( usbd_edpt_xfer(rhport, midi->ep_in, _midid_epbuf[idx].epin, count), 0 );
@@ -239,83 +263,74 @@ static uint32_t write_flush(uint8_t idx) {
 uint32_t tud_midi_n_stream_write(uint8_t itf, uint8_t cable_num, const uint8_t* buffer, uint32_t bufsize)
 {
   midid_interface_t* midi = &_midid_itf[itf];
-  TU_VERIFY(midi->ep_in, 0);
+  TU_VERIFY(midi->ep_in && !midi->alt, 0);
 
   midid_stream_t* stream = &midi->stream_write;
+  uint8_t const cable_bits = (uint8_t) (cable_num << 4);
 
   uint32_t i = 0;
-  while ( (i < bufsize) && (tu_fifo_remaining(&midi->tx_ff) >= 4) )
+  while ( (i < bufsize) && !tu_fifo_full(&midi->tx_ff) )
   {
     const uint8_t data = buffer[i];
     i++;
 
+    // System Real-Time can be interleaved anywhere, even within SysEx: send in its own packet
+    if ( data >= MIDI_STATUS_SYSREAL_TIMING_CLOCK )
+    {
+      const uint8_t packet[4] = { (uint8_t) (cable_bits | MIDI_CIN_1BYTE_DATA), data, 0, 0 };
+      tu_fifo_write(&midi->tx_ff, packet);
+      continue;
+    }
+
+    const bool in_sysex = ((stream->buffer[0] & 0xF) == MIDI_CIN_SYSEX_START);
+
     if ( stream->index == 0 )
     {
       //------------- New event packet -------------//
-      const uint8_t msg = data >> 4;
-
+      uint8_t cin;
       stream->index = 2;
       stream->buffer[1] = data;
 
-      // Check to see if we're still in a SysEx transmit.
-      if ( ((stream->buffer[0]) & 0xF) == MIDI_CIN_SYSEX_START )
+      if ( data < 0x80 )
       {
-        if ( data == MIDI_STATUS_SYSEX_END )
+        if ( in_sysex )
+        {
+          // SysEx continues
+          cin = MIDI_CIN_SYSEX_START;
+        }
+        else if ( stream->running_status )
         {
-          stream->buffer[0] = (uint8_t) ((cable_num << 4) | MIDI_CIN_SYSEX_END_1BYTE);
-          stream->total = 2;
+          // Running status: re-insert last channel status
+          stream->buffer[1] = stream->running_status;
+          stream->buffer[2] = data;
+          stream->index = 3;
+          cin = stream->running_status >> 4;
         }
         else
         {
-          stream->total = 4;
+          // Pack individual bytes if we don't support packing them into words.
+          cin = MIDI_CIN_1BYTE_DATA;
         }
       }
-      else if ( (msg >= 0x8 && msg <= 0xB) || msg == 0xE )
+      else if ( data < MIDI_STATUS_SYSEX_START )
       {
         // Channel Voice Messages
-        stream->buffer[0] = (uint8_t) ((cable_num << 4) | msg);
-        stream->total = 4;
-      }
-      else if ( msg == 0xC || msg == 0xD)
-      {
-        // Channel Voice Messages, two-byte variants (Program Change and Channel Pressure)
-        stream->buffer[0] = (uint8_t) ((cable_num << 4) | msg);
-        stream->total = 3;
+        cin = data >> 4;
+        stream->running_status = data;
       }
-      else if ( msg == 0xf )
+      else if ( data == MIDI_STATUS_SYSEX_END && in_sysex )
       {
-        // System message
-        if ( data == MIDI_STATUS_SYSEX_START )
-        {
-          stream->buffer[0] = MIDI_CIN_SYSEX_START;
-          stream->total = 4;
-        }
-        else if ( data == MIDI_STATUS_SYSCOM_TIME_CODE_QUARTER_FRAME || data == MIDI_STATUS_SYSCOM_SONG_SELECT )
-        {
-          stream->buffer[0] = MIDI_CIN_SYSCOM_2BYTE;
-          stream->total = 3;
-        }
-        else if ( data == MIDI_STATUS_SYSCOM_SONG_POSITION_POINTER )
-        {
-          stream->buffer[0] = MIDI_CIN_SYSCOM_3BYTE;
-          stream->total = 4;
-        }
-        else
-        {
-          stream->buffer[0] = MIDI_CIN_SYSEX_END_1BYTE;
-          stream->total = 2;
-        }
-        stream->buffer[0] |= (uint8_t)(cable_num << 4);
+        cin = MIDI_CIN_SYSEX_END_1BYTE;
       }
       else
       {
-        // Pack individual bytes if we don't support packing them into words.
-        stream->buffer[0] = (uint8_t) (cable_num << 4 | 0xf);
-        stream->buffer[2] = 0;
-        stream->buffer[3] = 0;
-        stream->index = 2;
-        stream->total = 2;
+        // SysEx start and System Common messages, both cancel running status
+        cin = _syscom_cin[data & 0x07];
+        stream->running_status = 0;
       }
+
+      stream->buffer[0] = (uint8_t) (cable_bits | cin);
+      stream->total = (uint8_t) (1 + _cin_msg_len[cin]);
     }
     else
     {
@@ -326,9 +341,9 @@ uint32_t tud_midi_n_stream_write(uint8_t itf, uint8_t cable_num, const uint8_t*
       stream->index++;
 
       // See if this byte ends a SysEx.
-      if ( (stream->buffer[0] & 0xF) == MIDI_CIN_SYSEX_START && data == MIDI_STATUS_SYSEX_END )
+      if ( in_sysex && data == MIDI_STATUS_SYSEX_END )
       {
-        stream->buffer[0] = (uint8_t) ((cable_num << 4) | (MIDI_CIN_SYSEX_START + (stream->index - 1)));
+        stream->buffer[0] = (uint8_t) (cable_bits | (MIDI_CIN_SYSEX_START + (stream->index - 1)));
         stream->total = stream->index;
       }
     }
@@ -341,13 +356,13 @@ uint32_t tud_midi_n_stream_write(uint8_t itf, uint8_t cable_num, const uint8_t*
         stream->buffer[idx] = 0;
       }
 
-      const uint16_t count = tu_fifo_write_n(&midi->tx_ff, stream->buffer, 4);
+      const bool written = tu_fifo_write(&midi->tx_ff, stream->buffer);
 
       // complete current event packet, reset stream
       stream->index = stream->total = 0;
 
       // FIFO overflown, since we already check fifo remaining. It is probably race condition
-      TU_ASSERT(count == 4, i);
+      TU_ASSERT(written, i);
     }
   }
 
@@ -358,18 +373,329 @@ uint32_t tud_midi_n_stream_write(uint8_t itf, uint8_t cable_num, const uint8_t*
 
 bool tud_midi_n_packet_write (uint8_t itf, const uint8_t packet[4]) {
   midid_interface_t* midi = &_midid_itf[itf];
-  TU_VERIFY(midi->ep_in);
+  TU_VERIFY(midi->ep_in && !midi->alt);
 
-  if (tu_fifo_remaining(&midi->tx_ff) < 4) {
+  if (!tu_fifo_write(&midi->tx_ff, packet)) {
     return false;
   }
 
-  tu_fifo_write_n(&midi->tx_ff, packet, 4);
   write_flush(itf);
 
   return true;
 }
 
+uint32_t tud_midi_n_packet_write_n(uint8_t itf, const uint8_t packets[][4], uint32_t count) {
+  midid_interface_t* midi = &_midid_itf[itf];
+  TU_VERIFY(midi->ep_in && !midi->alt, 0);
+
+  uint16_t const len = (uint16_t) tu_min32(count, tu_fifo_remaining(&midi->tx_ff));
+  uint16_t const num_written = tu_fifo_write_n(&midi->tx_ff, packets, len);
+
+  write_flush(itf);
+  return num_written;
+}
+
+//--------------------------------------------------------------------+
+// MIDI 2.0 UMP API
+//--------------------------------------------------------------------+
+
+// Translate MIDI 1.0 event packet (from legacy host) to UMP, return number of words, 0 if not translatable
+static uint8_t packet_to_ump(const uint8_t packet[4], uint32_t ump[2]) {
+  uint32_t const group = ((uint32_t) (packet[0] >> 4)) << 24;
+  uint8_t const cin = packet[0] & 0x0F;
+  uint8_t const status = packet[1];
+  uint32_t const payload = ((uint32_t) status << 16) | ((uint32_t) packet[2] << 8) | packet[3];
+
+  switch (cin) {
+    case MIDI_CIN_MISC:
+    case MIDI_CIN_CABLE_EVENT:
+      return 0;
+
+    case MIDI_CIN_SYSCOM_2BYTE:
+    case MIDI_CIN_SYSCOM_3BYTE:
+      ump[0] = ((uint32_t) MIDI_UMP_MT_SYSTEM << 28) | group | payload;
+      return 1;
+
+    case MIDI_CIN_1BYTE_DATA:
+      // only Real-Time is meaningful as a single byte
+      if (status < MIDI_STATUS_SYSREAL_TIMING_CLOCK) {
+        return 0;
+      }
+      ump[0] = ((uint32_t) MIDI_UMP_MT_SYSTEM << 28) | group | ((uint32_t) status << 16);
+      return 1;
+
+    case MIDI_CIN_SYSEX_START:
+    case MIDI_CIN_SYSEX_END_1BYTE:
+    case MIDI_CIN_SYSEX_END_2BYTE:
+    case MIDI_CIN_SYSEX_END_3BYTE: {
+      // CIN 5 is also used by 1-byte System Common e.g Tune Request
+      if (cin == MIDI_CIN_SYSEX_END_1BYTE && status > MIDI_STATUS_SYSEX_START && status < MIDI_STATUS_SYSEX_END) {
+        ump[0] = ((uint32_t) MIDI_UMP_MT_SYSTEM << 28) | group | ((uint32_t) status << 16);
+        return 1;
+      }
+
+      // each event packet becomes one UMP SysEx7 without the 0xF0/0xF7 framing bytes
+      bool const end = (cin != MIDI_CIN_SYSEX_START);
+      const uint8_t* data = packet + 1;
+      uint8_t len = end ? (uint8_t) (cin - MIDI_CIN_SYSEX_START) : 3;
+      bool const start = (data[0] == MIDI_STATUS_SYSEX_START);
+
+      if (start) {
+        data++;
+        len--;
+      }
+      if (end && len && data[len - 1] == MIDI_STATUS_SYSEX_END) {
+        len--;
+      }
+
+      uint8_t bytes[3] = { 0, 0, 0 };
+      for (uint8_t i = 0; i < len; i++) {
+        bytes[i] = data[i];
+      }
+
+      uint8_t const sx_status = start ? (end ? MIDI_UMP_SYSEX_COMPLETE : MIDI_UMP_SYSEX_START)
+                                      : (end ? MIDI_UMP_SYSEX_END : MIDI_UMP_SYSEX_CONTINUE);
+      ump[0] = ((uint32_t) MIDI_UMP_MT_DATA64 << 28) | group | ((uint32_t) sx_status << 20) | ((uint32_t) len << 16) |
+               ((uint32_t) bytes[0] << 8) | bytes[1];
+      ump[1] = (uint32_t) bytes[2] << 24;
+      return 2;
+    }
+
+    default:
+      // Channel Voice
+      ump[0] = ((uint32_t) MIDI_UMP_MT_MIDI1_CV << 28) | group | payload;
+      return 1;
+  }
+}
+
+static void put_packet(midid_interface_t* midi, uint8_t cable, uint8_t cin, uint8_t b1, uint8_t b2, uint8_t b3) {
+  const uint8_t packet[4] = { (uint8_t) ((cable << 4) | cin), b1, b2, b3 };
+  tu_fifo_write(&midi->tx_ff, packet);
+}
+
+// Queue UMP SysEx7 bytes as MIDI 1.0 SysEx event packets, bytes not filling a packet are carried to the next UMP
+static void ump_sysex_to_packets(midid_interface_t* midi, uint8_t cable, const uint32_t ump[2]) {
+  uint8_t const sx_status = (uint8_t) ((ump[0] >> 20) & 0x0F);
+  uint8_t const num = (uint8_t) tu_min32((ump[0] >> 16) & 0x0F, 6);
+  uint8_t const data[6] = {
+    (uint8_t) (ump[0] >> 8), (uint8_t) ump[0],
+    (uint8_t) (ump[1] >> 24), (uint8_t) (ump[1] >> 16), (uint8_t) (ump[1] >> 8), (uint8_t) ump[1]
+  };
+  bool const start = (sx_status == MIDI_UMP_SYSEX_COMPLETE || sx_status == MIDI_UMP_SYSEX_START);
+  bool const end = (sx_status == MIDI_UMP_SYSEX_COMPLETE || sx_status == MIDI_UMP_SYSEX_END);
+
+  uint8_t bytes[8];
+  uint8_t count = 0;
+  if (start) {
+    midi->sysex_carry_count = 0; // drop unfinished SysEx
+    bytes[count++] = MIDI_STATUS_SYSEX_START;
+  }
+  for (uint8_t i = 0; i < num; i++) {
+    bytes[count++] = data[i] & 0x7F;
+  }
+  if (end) {
+    bytes[count++] = MIDI_STATUS_SYSEX_END;
+  }
+
+  uint8_t* carry = midi->sysex_carry;
+  for (uint8_t i = 0; i < count; i++) {
+    carry[midi->sysex_carry_count++] = bytes[i];
+    if (midi->sysex_carry_count == 3) {
+      uint8_t const cin = (bytes[i] == MIDI_STATUS_SYSEX_END) ? MIDI_CIN_SYSEX_END_3BYTE : MIDI_CIN_SYSEX_START;
+      put_packet(midi, cable, cin, carry[0], carry[1], carry[2]);
+      midi->sysex_carry_count = 0;
+    }
+  }
+
+  if (end && midi->sysex_carry_count) {
+    // 1 or 2 remaining bytes, ending with 0xF7
+    uint8_t const n = midi->sysex_carry_count;
+    put_packet(midi, cable, (uint8_t) (MIDI_CIN_SYSEX_START + n), carry[0], n > 1 ? carry[1] : 0, 0);
+    midi->sysex_carry_count = 0;
+  }
+}
+
+// Translate MIDI 2.0 Channel Voice to MIDI 1.0 with default translation of MIDI 2.0 specs: scale down resolution
+static void ump_midi2_cv_to_packets(midid_interface_t* midi, uint8_t cable, const uint32_t ump[2]) {
+  uint8_t const status = (uint8_t) (ump[0] >> 16);
+  uint8_t const channel = status & 0x0F;
+  uint8_t const index1 = (uint8_t) ((ump[0] >> 8) & 0x7F); // note, controller or bank
+  uint8_t const index2 = (uint8_t) (ump[0] & 0x7F);
+  uint32_t const data = ump[1];
+  uint8_t const data7 = (uint8_t) (data >> 25);
+  uint8_t const cc = (uint8_t) (0xB0 | channel);
+
+  switch (status >> 4) {
+    case 0x2: // Registered Controller (RPN)
+    case 0x3: { // Assignable Controller (NRPN)
+      bool const rpn = ((status >> 4) == 0x2);
+      put_packet(midi, cable, MIDI_CIN_CONTROL_CHANGE, cc, rpn ? 101 : 99, index1);
+      put_packet(midi, cable, MIDI_CIN_CONTROL_CHANGE, cc, rpn ? 100 : 98, index2);
+      put_packet(midi, cable, MIDI_CIN_CONTROL_CHANGE, cc, 6, data7);
+      put_packet(midi, cable, MIDI_CIN_CONTROL_CHANGE, cc, 38, (uint8_t) ((data >> 18) & 0x7F));
+      break;
+    }
+
+    case MIDI_CIN_NOTE_OFF:
+      put_packet(midi, cable, MIDI_CIN_NOTE_OFF, status, index1, data7);
+      break;
+
+    case MIDI_CIN_NOTE_ON: {
+      // non-zero velocity must not become Note Off
+      uint8_t const velocity = (data7 == 0 && (data >> 16)) ? 1 : data7;
+      put_packet(midi, cable, MIDI_CIN_NOTE_ON, status, index1, velocity);
+      break;
+    }
+
+    case MIDI_CIN_POLY_KEYPRESS:
+    case MIDI_CIN_CONTROL_CHANGE:
+      put_packet(midi, cable, (uint8_t) (status >> 4), status, index1, data7);
+      break;
+
+    case MIDI_CIN_PROGRAM_CHANGE:
+      if (ump[0] & 0x01) {
+        // bank valid: Bank Select MSB & LSB
+        put_packet(midi, cable, MIDI_CIN_CONTROL_CHANGE, cc, 0, (uint8_t) ((data >> 8) & 0x7F));
+        put_packet(midi, cable, MIDI_CIN_CONTROL_CHANGE, cc, 32, (uint8_t) (data & 0x7F));
+      }
+      put_packet(midi, cable, MIDI_CIN_PROGRAM_CHANGE, status, (uint8_t) ((data >> 24) & 0x7F), 0);
+      break;
+
+    case MIDI_CIN_CHANNEL_PRESSURE:
+      put_packet(midi, cable, MIDI_CIN_CHANNEL_PRESSURE, status, data7, 0);
+      break;
+
+    case MIDI_CIN_PITCH_BEND_CHANGE: {
+      uint16_t const bend = (uint16_t) (data >> 18);
+      put_packet(midi, cable, MIDI_CIN_PITCH_BEND_CHANGE, status, bend & 0x7F, (uint8_t) (bend >> 7));
+      break;
+    }
+
+    default: break; // per-note messages have no MIDI 1.0 equivalent
+  }
+}
+
+// Translate UMP to MIDI 1.0 event packets (for legacy host) into TX FIFO, caller must ensure room for 4 packets.
+// Group is mapped to cable number, messages without MIDI 1.0 equivalent are dropped
+static void ump_to_packets(midid_interface_t* midi, const uint32_t* ump) {
+  uint8_t const cable = (uint8_t) ((ump[0] >> 24) & 0x0F);
+  uint8_t const status = (uint8_t) (ump[0] >> 16);
+  uint8_t const d1 = (uint8_t) ((ump[0] >> 8) & 0x7F);
+  uint8_t const d2 = (uint8_t) (ump[0] & 0x7F);
+
+  switch (ump[0] >> 28) {
+    case MIDI_UMP_MT_SYSTEM: {
+      if (status >= MIDI_STATUS_SYSREAL_TIMING_CLOCK) {
+        put_packet(midi, cable, MIDI_CIN_1BYTE_DATA, status, 0, 0);
+      } else if (status > MIDI_STATUS_SYSEX_START && status < MIDI_STATUS_SYSEX_END) {
+        uint8_t const cin = _syscom_cin[status & 0x07];
+        uint8_t const len = _cin_msg_len[cin];
+        put_packet(midi, cable, cin, status, len > 1 ? d1 : 0, len > 2 ? d2 : 0);
+      }
+      break;
+    }
+
+    case MIDI_UMP_MT_MIDI1_CV:
+      if (status >= 0x80 && status < MIDI_STATUS_SYSEX_START) {
+        uint8_t const cin = status >> 4;
+        put_packet(midi, cable, cin, status, d1, _cin_msg_len[cin] > 2 ? d2 : 0);
+      }
+      break;
+
+    case MIDI_UMP_MT_DATA64:
+      ump_sysex_to_packets(midi, cable, ump);
+      break;
+
+    case MIDI_UMP_MT_MIDI2_CV:
+      ump_midi2_cv_to_packets(midi, cable, ump);
+      break;
+
+    default: break;
+  }
+}
+
+bool tud_midi_n_ump_mode(uint8_t itf) {
+  return _midid_itf[itf].alt == 1;
+}
+
+uint32_t tud_midi_n_ump_read(uint8_t itf, uint32_t* words, uint32_t max_words) {
+  midid_interface_t* midi = &_midid_itf[itf];
+  TU_VERIFY(midi->ep_out, 0);
+
+  uint32_t count = 0;
+  if (midi->alt) {
+    // UMP from host: read whole packets only
+    uint32_t word0;
+    while (tu_fifo_peek(&midi->rx_ff, &word0)) {
+      uint8_t const n = _ump_word_count[tu_le32toh(word0) >> 28];
+      if (count + n > max_words || tu_fifo_count(&midi->rx_ff) < n) {
+        break;
+      }
+
+      tu_fifo_read_n(&midi->rx_ff, words + count, n);
+      for (uint8_t i = 0; i < n; i++) {
+        words[count + i] = tu_le32toh(words[count + i]);
+      }
+      count += n;
+    }
+  } else {
+    // MIDI 1.0 event packets from legacy host
+    uint8_t packet[4];
+    while (tu_fifo_peek(&midi->rx_ff, packet)) {
+      uint32_t ump[2];
+      uint8_t const n = packet_to_ump(packet, ump);
+      if (count + n > max_words) {
+        break;
+      }
+
+      tu_fifo_read(&midi->rx_ff, packet);
+      for (uint8_t i = 0; i < n; i++) {
+        words[count + i] = ump[i];
+      }
+      count += n;
+    }
+  }
+
+  _prep_out_transaction(itf);
+  return count;
+}
+
+uint32_t tud_midi_n_ump_write(uint8_t itf, const uint32_t* words, uint32_t count) {
+  midid_interface_t* midi = &_midid_itf[itf];
+  TU_VERIFY(midi->ep_in, 0);
+
+  uint32_t i = 0;
+  while (i < count) {
+    uint8_t const n = _ump_word_count[words[i] >> 28];
+    if (i + n > count) {
+      break; // incomplete UMP
+    }
+
+    if (midi->alt) {
+      if (tu_fifo_remaining(&midi->tx_ff) < n) {
+        break;
+      }
+
+      uint32_t ump[4];
+      for (uint8_t j = 0; j < n; j++) {
+        ump[j] = tu_htole32(words[i + j]);
+      }
+      tu_fifo_write_n(&midi->tx_ff, ump, n);
+    } else {
+      // a UMP translates to at most 4 event packets
+      if (tu_fifo_remaining(&midi->tx_ff) < 4) {
+        break;
+      }
+      ump_to_packets(midi, words + i);
+    }
+
+    i += n;
+  }
+
+  write_flush(itf);
+  return i;
+}
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
@@ -380,8 +706,8 @@ void midid_init(void) {
     midid_interface_t* midi = &_midid_itf[i];
 
     // config fifo
-    tu_fifo_config(&midi->rx_ff, midi->rx_ff_buf, CFG_TUD_MIDI_RX_BUFSIZE, 1, false); // true, true
-    tu_fifo_config(&midi->tx_ff, midi->tx_ff_buf, CFG_TUD_MIDI_TX_BUFSIZE, 1, false); // OBVS.
+    tu_fifo_config(&midi->rx_ff, midi->rx_ff_buf, CFG_TUD_MIDI_RX_BUFSIZE / 4, 4, false);
+    tu_fifo_config(&midi->tx_ff, midi->tx_ff_buf, CFG_TUD_MIDI_TX_BUFSIZE / 4, 4, false);
 
     #if CFG_FIFO_MUTEX
     osal_mutex_t mutex_rd = osal_mutex_create(&midi->rx_ff_mutex);
@@ -466,7 +792,6 @@ uint16_t midid_open(uint8_t rhport, const tusb_desc_interface_t* desc_itf, uint1
   TU_ASSERT(p_midi);
 
   p_midi->itf_num = desc_midi->bInterfaceNumber;
-  (void) p_midi->itf_num;
 
   // next descriptor
   drv_len += tu_desc_len(p_desc);
@@ -480,6 +805,7 @@ uint16_t midid_open(uint8_t rhport, const tusb_desc_interface_t* desc_itf, uint1
     {
       TU_ASSERT(usbd_edpt_open(rhport, (const tusb_desc_endpoint_t*) p_desc), 0);
       uint8_t ep_addr = ((const tusb_desc_endpoint_t*) p_desc)->bEndpointAddress;
+      usbd_edpt_set_instance(rhport, ep_addr, idx);
 
       if (tu_edpt_dir(ep_addr) == TUSB_DIR_IN)
       {
@@ -499,40 +825,119 @@ uint16_t midid_open(uint8_t rhport, const tusb_desc_interface_t* desc_itf, uint1
     p_desc   = tu_desc_next(p_desc);
   }
 
+  // MIDI 2.0: alternate setting 1 for UMP, must use same endpoints as alternate 0
+  while ( drv_len < max_len )
+  {
+    uint8_t const desc_type = tu_desc_type(p_desc);
+    if ( TUSB_DESC_INTERFACE == desc_type )
+    {
+      const tusb_desc_interface_t* desc_alt = (const tusb_desc_interface_t*) p_desc;
+      if ( desc_alt->bInterfaceNumber != desc_midi->bInterfaceNumber ) break;
+      if ( desc_alt->bAlternateSetting == 1 ) p_midi->ump_supported = 1;
+    }
+    else if ( TUSB_DESC_ENDPOINT == desc_type )
+    {
+      uint8_t const ep_addr = ((const tusb_desc_endpoint_t*) p_desc)->bEndpointAddress;
+      TU_ASSERT(ep_addr == p_midi->ep_in || ep_addr == p_midi->ep_out, 0);
+    }
+    else if ( TUSB_DESC_INTERFACE_ASSOCIATION == desc_type )
+    {
+      break;
+    }
+
+    drv_len += tu_desc_len(p_desc);
+    p_desc   = tu_desc_next(p_desc);
+  }
+
   // Prepare for incoming data
   _prep_out_transaction(idx);
 
   return drv_len;
 }
 
+// Endpoints are shared by all alternate settings and stay open: drop transfer in flight and reset data toggle.
+// Note: closing and re-opening them does not work with DCDs allocating endpoint buffer on open.
+static void reset_endpoint(uint8_t rhport, uint8_t ep_addr) {
+  if (ep_addr) {
+    usbd_edpt_stall(rhport, ep_addr);
+    usbd_edpt_clear_stall(rhport, ep_addr);
+  }
+}
+
 // Invoked when a control transfer occurred on an interface of this class
 // Driver response accordingly to the request and the transfer stage (setup/data/ack)
 // return false to stall control endpoint (e.g unsupported request)
 bool midid_control_xfer_cb(uint8_t rhport, uint8_t stage, const tusb_control_request_t* request) {
-  (void) rhport; (void) stage; (void) request;
-  return false; // driver doesn't support any request yet
+  // Only standard requests to MIDI Streaming interface are supported: alternate setting and Group Terminal Block
+  TU_VERIFY(request->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD &&
+            request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_INTERFACE);
+  if (stage != CONTROL_STAGE_SETUP) {
+    return true;
+  }
+
+  uint8_t const itf_num = tu_u16_low(request->wIndex);
+  uint8_t idx;
+  for (idx = 0; idx < CFG_TUD_MIDI; idx++) {
+    if (_midid_itf[idx].ep_in && _midid_itf[idx].itf_num == itf_num) {
+      break;
+    }
+  }
+  TU_VERIFY(idx < CFG_TUD_MIDI);
+  midid_interface_t* midi = &_midid_itf[idx];
+
+  switch (request->bRequest) {
+    case TUSB_REQ_GET_INTERFACE:
+      return tud_control_xfer(rhport, request, &midi->alt, 1);
+
+    case TUSB_REQ_SET_INTERFACE: {
+      uint8_t const alt = tu_u16_low(request->wValue);
+      TU_VERIFY(alt == 0 || (alt == 1 && midi->ump_supported));
+
+      // Switch between MIDI 1.0 event packets and UMP: pending data is dropped
+      midi->alt = alt;
+      midi->sysex_carry_count = 0;
+      tu_memclr(&midi->stream_read, sizeof(midid_stream_t));
+      tu_memclr(&midi->stream_write, sizeof(midid_stream_t));
+      tu_fifo_clear(&midi->rx_ff);
+      tu_fifo_clear(&midi->tx_ff);
+      reset_endpoint(rhport, midi->ep_in);
+      reset_endpoint(rhport, midi->ep_out);
+
+      TU_VERIFY(tud_control_status(rhport, request));
+      _prep_out_transaction(idx);
+
+      if (tud_midi_alt_setting_cb) {
+        tud_midi_alt_setting_cb(idx, alt);
+      }
+      return true;
+    }
+
+    case TUSB_REQ_GET_DESCRIPTOR: {
+      TU_VERIFY(tu_u16_high(request->wValue) == MIDI_CS_GR_TRM_BLOCK && midi->ump_supported && tud_midi_descriptor_gtb_cb);
+
+      uint8_t const* desc = tud_midi_descriptor_gtb_cb(idx);
+      TU_VERIFY(desc);
+      uint16_t const total_len = tu_le16toh(((const midi_desc_gtb_header_t*) desc)->wTotalLength);
+      return tud_control_xfer(rhport, request, (void*) (uintptr_t) desc, total_len);
+    }
+
+    default: return false;
+  }
 }
 
 bool midid_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
 {
   (void) result;
-  (void) rhport;
-
-  uint8_t idx;
-  midid_interface_t* p_midi;
 
   // Identify which interface to use
-  for (idx = 0; idx < CFG_TUD_MIDI; idx++) {
-    p_midi = &_midid_itf[idx];
-    if ((ep_addr == p_midi->ep_out) || (ep_addr == p_midi->ep_in)) {
-      break;
-    }
-  }
+  uint8_t const idx = usbd_edpt_get_instance(rhport, ep_addr);
   TU_ASSERT(idx < CFG_TUD_MIDI);
+  midid_interface_t* p_midi = &_midid_itf[idx];
 
   // receive new data
   if (ep_addr == p_midi->ep_out) {
-    tu_fifo_write_n(&p_midi->rx_ff, _midid_epbuf[idx].epout, (uint16_t)xferred_bytes);
+    // whole 32-bit event packets/UMP words only
+    tu_fifo_write_n(&p_midi->rx_ff, _midid_epbuf[idx].epout, (uint16_t) (xferred_bytes / 4));
 
     // invoke receive callback if available
     if (tud_midi_rx_cb) {
@@ -75,6 +75,26 @@ bool     tud_midi_n_packet_read  (uint8_t itf, uint8_t packet[4]);
 // Write event packet            (4 bytes)
 bool     tud_midi_n_packet_write (uint8_t itf, uint8_t const packet[4]);
 
+// Read up to count event packets, return number of packets read
+uint32_t tud_midi_n_packet_read_n  (uint8_t itf, uint8_t packets[][4], uint32_t count);
+
+// Write up to count event packets, return number of packets written
+uint32_t tud_midi_n_packet_write_n (uint8_t itf, uint8_t const packets[][4], uint32_t count);
+
+//------------- MIDI 2.0 -------------//
+// Universal MIDI Packet (UMP) API works with both alternate settings: UMP is translated to/from MIDI 1.0 event packets
+// when host selects alternate 0 (legacy host), group is mapped to cable number. MIDI 1.0 event packet/stream API
+// is only available with alternate 0.
+
+// Check if host selected UMP alternate setting (1)
+bool     tud_midi_n_ump_mode       (uint8_t itf);
+
+// Read whole UMPs, up to max_words 32-bit words. Return number of words read
+uint32_t tud_midi_n_ump_read       (uint8_t itf, uint32_t* words, uint32_t max_words);
+
+// Write whole UMPs from count 32-bit words. Return number of words written
+uint32_t tud_midi_n_ump_write      (uint8_t itf, uint32_t const* words, uint32_t count);
+
 //--------------------------------------------------------------------+
 // Application API (Single Interface)
 //--------------------------------------------------------------------+
@@ -87,6 +107,13 @@ static inline uint32_t tud_midi_stream_write (uint8_t cable_num, uint8_t const*
 static inline bool     tud_midi_packet_read  (uint8_t packet[4]);
 static inline bool     tud_midi_packet_write (uint8_t const packet[4]);
 
+static inline uint32_t tud_midi_packet_read_n  (uint8_t packets[][4], uint32_t count);
+static inline uint32_t tud_midi_packet_write_n (uint8_t const packets[][4], uint32_t count);
+
+static inline bool     tud_midi_ump_mode     (void);
+static inline uint32_t tud_midi_ump_read     (uint32_t* words, uint32_t max_words);
+static inline uint32_t tud_midi_ump_write    (uint32_t const* words, uint32_t count);
+
 //------------- Deprecated API name  -------------//
 // TODO remove after 0.10.0 release
 
@@ -120,6 +147,14 @@ static inline bool tud_midi_receive(uint8_t packet[4])
 //--------------------------------------------------------------------+
 TU_ATTR_WEAK void tud_midi_rx_cb(uint8_t itf);
 
+// Invoked when host selects alternate setting: 0 is MIDI 1.0, 1 is MIDI 2.0 UMP
+TU_ATTR_WEAK void tud_midi_alt_setting_cb(uint8_t itf, uint8_t alt);
+
+// Invoked when received GET Group Terminal Block descriptor request (MIDI 2.0)
+// Application return pointer to descriptors starting with header e.g TUD_MIDI2_DESC_GTB(), whose contents must
+// exist long enough for transfer to complete
+TU_ATTR_WEAK uint8_t const* tud_midi_descriptor_gtb_cb(uint8_t itf);
+
 //--------------------------------------------------------------------+
 // Inline Functions
 //--------------------------------------------------------------------+
@@ -154,6 +189,31 @@ static inline bool tud_midi_packet_write (uint8_t const packet[4])
   return tud_midi_n_packet_write(0, packet);
 }
 
+static inline uint32_t tud_midi_packet_read_n (uint8_t packets[][4], uint32_t count)
+{
+  return tud_midi_n_packet_read_n(0, packets, count);
+}
+
+static inline uint32_t tud_midi_packet_write_n (uint8_t const packets[][4], uint32_t count)
+{
+  return tud_midi_n_packet_write_n(0, packets, count);
+}
+
+static inline bool tud_midi_ump_mode (void)
+{
+  return tud_midi_n_ump_mode(0);
+}
+
+static inline uint32_t tud_midi_ump_read (uint32_t* words, uint32_t max_words)
+{
+  return tud_midi_n_ump_read(0, words, max_words);
+}
+
+static inline uint32_t tud_midi_ump_write (uint32_t const* words, uint32_t count)
+{
+  return tud_midi_n_ump_write(0, words, count);
+}
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
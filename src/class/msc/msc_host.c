@@ -48,22 +48,39 @@ enum {
   MSC_STAGE_CMD,
   MSC_STAGE_DATA,
   MSC_STAGE_STATUS,
+  MSC_STAGE_COMPLETE, // invoking complete callbacks, newly submitted commands are queued
 };
 
+TU_VERIFY_STATIC(CFG_TUH_MSC_QUEUE_SIZE > 0 && CFG_TUH_MSC_QUEUE_SIZE < 256, "invalid CFG_TUH_MSC_QUEUE_SIZE");
+
+// Submitted SCSI command
+typedef struct {
+  msc_cbw_t cbw;
+  uint16_t block_count; // READ10/WRITE10 only to merge adjacent commands, 0 otherwise
+  uint32_t lba;
+  void* buffer;
+  tuh_msc_complete_cb_t complete_cb;
+  uintptr_t complete_arg;
+} msch_request_t;
+
 typedef struct {
   uint8_t itf_num;
   uint8_t ep_in;
   uint8_t ep_out;
   uint8_t max_lun;
+  uint16_t ep_size;
 
   volatile bool configured; // Receive SET_CONFIGURE
   volatile bool mounted;    // Enumeration is complete
 
-  // SCSI command data
+  // SCSI command queue, current command is made of active_count requests at head
   uint8_t stage;
-  void* buffer;
-  tuh_msc_complete_cb_t complete_cb;
-  uintptr_t complete_arg;
+  uint8_t q_rd;
+  uint8_t q_count;
+  uint8_t active_count;
+  uint8_t data_idx;   // request whose buffer transfer completes next in data stage
+  uint8_t data_count; // request buffers submitted in data stage
+  msch_request_t queue[CFG_TUH_MSC_QUEUE_SIZE];
 
   struct {
     uint32_t block_size;
@@ -79,6 +96,14 @@ typedef struct {
 static msch_interface_t _msch_itf[CFG_TUH_DEVICE_MAX];
 CFG_TUH_MEM_SECTION static msch_epbuf_t _msch_epbuf[CFG_TUH_DEVICE_MAX];
 
+// Command queue is pushed by application and popped by usbh task
+#if OSAL_MUTEX_REQUIRED
+static osal_mutex_def_t _msch_mutexdef;
+static osal_mutex_t _msch_mutex;
+#else
+#define _msch_mutex NULL
+#endif
+
 TU_ATTR_ALWAYS_INLINE static inline msch_interface_t* get_itf(uint8_t daddr) {
   return &_msch_itf[daddr - 1];
 }
@@ -87,6 +112,11 @@ TU_ATTR_ALWAYS_INLINE static inline msch_epbuf_t* get_epbuf(uint8_t daddr) {
   return &_msch_epbuf[daddr - 1];
 }
 
+// Get n-th request from head of queue
+TU_ATTR_ALWAYS_INLINE static inline msch_request_t* queue_at(msch_interface_t* p_msc, uint8_t n) {
+  return &p_msc->queue[(p_msc->q_rd + n) % CFG_TUH_MSC_QUEUE_SIZE];
+}
+
 //--------------------------------------------------------------------+
 // PUBLIC API
 //--------------------------------------------------------------------+
@@ -112,35 +142,66 @@ bool tuh_msc_mounted(uint8_t dev_addr) {
 
 bool tuh_msc_ready(uint8_t dev_addr) {
   msch_interface_t* p_msc = get_itf(dev_addr);
-  return p_msc->mounted && !usbh_edpt_busy(dev_addr, p_msc->ep_in) && !usbh_edpt_busy(dev_addr, p_msc->ep_out);
+  return p_msc->mounted && p_msc->q_count == 0 &&
+         !usbh_edpt_busy(dev_addr, p_msc->ep_in) && !usbh_edpt_busy(dev_addr, p_msc->ep_out);
+}
+
+uint8_t tuh_msc_queue_available(uint8_t dev_addr) {
+  msch_interface_t* p_msc = get_itf(dev_addr);
+  return p_msc->mounted ? (uint8_t) (CFG_TUH_MSC_QUEUE_SIZE - p_msc->q_count) : 0;
 }
 
 //--------------------------------------------------------------------+
-// PUBLIC API: SCSI COMMAND
+// Command Queue
 //--------------------------------------------------------------------+
-static inline void cbw_init(msc_cbw_t* cbw, uint8_t lun) {
-  tu_memclr(cbw, sizeof(msc_cbw_t));
-  cbw->signature = MSC_CBW_SIGNATURE;
-  cbw->tag       = 0x54555342; // TUSB
-  cbw->lun       = lun;
+
+// Check if next READ10/WRITE10 continues where prev ends so that both can be carried out by one command.
+// Data stage is split into one transfer per request buffer, all but the last must be multiple of packet size
+static bool request_can_merge(msch_interface_t const* p_msc, msch_request_t const* prev, msch_request_t const* next,
+                              uint32_t merged_blocks) {
+  return next->block_count && prev->block_count &&
+         next->cbw.lun == prev->cbw.lun && next->cbw.command[0] == prev->cbw.command[0] &&
+         next->lba == prev->lba + prev->block_count &&
+         merged_blocks + next->block_count <= UINT16_MAX &&
+         prev->buffer && next->buffer && 0 == (prev->cbw.total_bytes % p_msc->ep_size);
 }
 
-bool tuh_msc_scsi_command(uint8_t daddr, msc_cbw_t const* cbw, void* data,
-                          tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
-  msch_interface_t* p_msc = get_itf(daddr);
-  TU_VERIFY(p_msc->configured);
+// Start command for request(s) at head of queue
+static bool command_start(uint8_t daddr, msch_interface_t* p_msc) {
+  TU_VERIFY(p_msc->stage == MSC_STAGE_IDLE && p_msc->q_count);
 
   // claim endpoint
   TU_VERIFY(usbh_edpt_claim(daddr, p_msc->ep_out));
   msch_epbuf_t* epbuf = get_epbuf(daddr);
 
-  epbuf->cbw = *cbw;
-  p_msc->buffer = data;
-  p_msc->complete_cb = complete_cb;
-  p_msc->complete_arg = arg;
+  msch_request_t const* head = queue_at(p_msc, 0);
+  epbuf->cbw = head->cbw;
+
+  // merge queued READ10/WRITE10 with adjacent LBA
+  uint8_t count = 1;
+  uint32_t merged_blocks = head->block_count;
+  while (count < p_msc->q_count &&
+         request_can_merge(p_msc, queue_at(p_msc, (uint8_t) (count - 1)), queue_at(p_msc, count), merged_blocks)) {
+    msch_request_t const* next = queue_at(p_msc, count);
+    merged_blocks += next->block_count;
+    epbuf->cbw.total_bytes += next->cbw.total_bytes;
+    count++;
+  }
+
+  if (count > 1) {
+    // READ10 and WRITE10 share the same layout
+    scsi_read10_t* cmd = (scsi_read10_t*) (uintptr_t) epbuf->cbw.command;
+    cmd->block_count = tu_htons((uint16_t) merged_blocks);
+    TU_LOG_DRV("  MSCh merged %u commands, LBA %lu + %lu\r\n", count, (unsigned long) head->lba, (unsigned long) merged_blocks);
+  }
+
+  p_msc->active_count = count;
+  p_msc->data_idx = 0;
+  p_msc->data_count = 0;
   p_msc->stage = MSC_STAGE_CMD;
 
   if (!usbh_edpt_xfer(daddr, p_msc->ep_out, (uint8_t*) &epbuf->cbw, sizeof(msc_cbw_t))) {
+    p_msc->stage = MSC_STAGE_IDLE;
     usbh_edpt_release(daddr, p_msc->ep_out);
     return false;
   }
@@ -148,6 +209,129 @@ bool tuh_msc_scsi_command(uint8_t daddr, msc_cbw_t const* cbw, void* data,
   return true;
 }
 
+static bool request_submit(uint8_t daddr, msc_cbw_t const* cbw, void* data, uint32_t lba, uint16_t block_count,
+                           tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  msch_interface_t* p_msc = get_itf(daddr);
+  (void) osal_mutex_lock(_msch_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+
+  // checked with lock held since msch_close() can run in between
+  bool ret = false;
+  if (p_msc->configured && p_msc->q_count < CFG_TUH_MSC_QUEUE_SIZE) {
+    msch_request_t* req = queue_at(p_msc, p_msc->q_count);
+    req->cbw = *cbw;
+    req->lba = lba;
+    req->block_count = block_count;
+    req->buffer = data;
+    req->complete_cb = complete_cb;
+    req->complete_arg = arg;
+    p_msc->q_count++;
+
+    // device is idle: start right away, otherwise it is started when previous commands complete
+    ret = (p_msc->stage != MSC_STAGE_IDLE) || command_start(daddr, p_msc);
+    if (!ret) {
+      p_msc->q_count--;
+    }
+  }
+
+  (void) osal_mutex_unlock(_msch_mutex);
+  return ret;
+}
+
+static bool data_xfer(uint8_t daddr, msch_interface_t* p_msc) {
+  msch_request_t const* req = queue_at(p_msc, p_msc->data_count);
+  uint8_t const ep_data = (req->cbw.dir & TUSB_DIR_IN_MASK) ? p_msc->ep_in : p_msc->ep_out;
+  TU_VERIFY(usbh_edpt_xfer(daddr, ep_data, req->buffer, (uint16_t) req->cbw.total_bytes));
+  p_msc->data_count++;
+  return true;
+}
+
+// Write buffers of merged requests back to back: queue them behind the active one if HCD supports it, otherwise
+// each is submitted when the previous completes. Not used for IN since a transfer ending early with short packet
+// would let the following ones receive the CSW.
+static void data_queue(uint8_t daddr, msch_interface_t* p_msc) {
+  while (p_msc->data_count < p_msc->active_count) {
+    msch_request_t const* req = queue_at(p_msc, p_msc->data_count);
+    if (!usbh_edpt_xfer_queue(daddr, p_msc->ep_out, req->buffer, (uint16_t) req->cbw.total_bytes)) {
+      break;
+    }
+    p_msc->data_count++;
+  }
+}
+
+// Remove count requests from head of queue and invoke their complete callback with csw (NULL for failed status).
+// Callback is invoked without lock since it can submit new command, which is queued until stage is back to idle
+static void request_complete(uint8_t daddr, msch_interface_t* p_msc, uint8_t count, msc_csw_t const* csw) {
+  for (uint8_t i = 0; i < count; i++) {
+    (void) osal_mutex_lock(_msch_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+    msch_request_t const req = *queue_at(p_msc, 0);
+    p_msc->q_rd = (uint8_t) ((p_msc->q_rd + 1) % CFG_TUH_MSC_QUEUE_SIZE);
+    p_msc->q_count--;
+    (void) osal_mutex_unlock(_msch_mutex);
+
+    if (req.complete_cb) {
+      msc_csw_t const failed_csw = {
+          .signature = MSC_CSW_SIGNATURE,
+          .tag = req.cbw.tag,
+          .data_residue = req.cbw.total_bytes,
+          .status = MSC_CSW_STATUS_FAILED
+      };
+      tuh_msc_complete_data_t const cb_data = {
+          .cbw = &req.cbw,
+          .csw = csw ? csw : &failed_csw,
+          .scsi_data = req.buffer,
+          .user_arg = req.complete_arg
+      };
+      req.complete_cb(daddr, &cb_data);
+    }
+  }
+}
+
+// Invoke complete callback of each request carried out by current command then start next one
+static void command_complete(uint8_t daddr, msch_interface_t* p_msc) {
+  // callback can submit new command before all requests are notified, keep a copy of status
+  msc_csw_t const csw = get_epbuf(daddr)->csw;
+  uint8_t const count = p_msc->active_count;
+  p_msc->stage = MSC_STAGE_COMPLETE;
+
+  request_complete(daddr, p_msc, count, &csw);
+
+  // start queued requests, fail them if command can not be started so that none is left without callback.
+  // Requests submitted by their callbacks get another attempt
+  while (1) {
+    (void) osal_mutex_lock(_msch_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+    p_msc->active_count = 0;
+    p_msc->stage = MSC_STAGE_IDLE;
+    uint8_t const queued = p_msc->q_count;
+    bool const started = (queued == 0) || command_start(daddr, p_msc);
+    if (!started) {
+      p_msc->stage = MSC_STAGE_COMPLETE;
+    }
+    (void) osal_mutex_unlock(_msch_mutex);
+
+    if (started) {
+      break;
+    }
+
+    TU_LOG_DRV("  MSCh failed to start next command, %u requests failed\r\n", queued);
+    request_complete(daddr, p_msc, queued, NULL);
+  }
+}
+
+//--------------------------------------------------------------------+
+// PUBLIC API: SCSI COMMAND
+//--------------------------------------------------------------------+
+static inline void cbw_init(msc_cbw_t* cbw, uint8_t lun) {
+  tu_memclr(cbw, sizeof(msc_cbw_t));
+  cbw->signature = MSC_CBW_SIGNATURE;
+  cbw->tag       = 0x54555342; // TUSB
+  cbw->lun       = lun;
+}
+
+bool tuh_msc_scsi_command(uint8_t daddr, msc_cbw_t const* cbw, void* data,
+                          tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
+  return request_submit(daddr, cbw, data, 0, 0, complete_cb, arg);
+}
+
 bool tuh_msc_read_capacity(uint8_t dev_addr, uint8_t lun, scsi_read_capacity10_resp_t* response,
                            tuh_msc_complete_cb_t complete_cb, uintptr_t arg) {
   msch_interface_t* p_msc = get_itf(dev_addr);
@@ -238,7 +422,7 @@ bool tuh_msc_read10(uint8_t dev_addr, uint8_t lun, void* buffer, uint32_t lba, u
   };
   memcpy(cbw.command, &cmd_read10, cbw.cmd_len);
 
-  return tuh_msc_scsi_command(dev_addr, &cbw, buffer, complete_cb, arg);
+  return request_submit(dev_addr, &cbw, buffer, lba, block_count, complete_cb, arg);
 }
 
 bool tuh_msc_write10(uint8_t dev_addr, uint8_t lun, void const* buffer, uint32_t lba, uint16_t block_count,
@@ -260,7 +444,7 @@ bool tuh_msc_write10(uint8_t dev_addr, uint8_t lun, void const* buffer, uint32_t
   };
   memcpy(cbw.command, &cmd_write10, cbw.cmd_len);
 
-  return tuh_msc_scsi_command(dev_addr, &cbw, (void*) (uintptr_t) buffer, complete_cb, arg);
+  return request_submit(dev_addr, &cbw, (void*) (uintptr_t) buffer, lba, block_count, complete_cb, arg);
 }
 
 #if 0
@@ -288,10 +472,23 @@ bool msch_init(void) {
   TU_LOG_DRV("sizeof(msch_interface_t) = %u\r\n", sizeof(msch_interface_t));
   TU_LOG_DRV("sizeof(msch_epbuf_t) = %u\r\n", sizeof(msch_epbuf_t));
   tu_memclr(_msch_itf, sizeof(_msch_itf));
+
+  #if OSAL_MUTEX_REQUIRED
+  _msch_mutex = osal_mutex_create(&_msch_mutexdef);
+  TU_ASSERT(_msch_mutex);
+  #endif
+
   return true;
 }
 
 bool msch_deinit(void) {
+  #if OSAL_MUTEX_REQUIRED
+  if (_msch_mutex) {
+    osal_mutex_delete(_msch_mutex);
+    _msch_mutex = NULL;
+  }
+  #endif
+
   return true;
 }
 
@@ -302,6 +499,14 @@ void msch_close(uint8_t dev_addr) {
 
   TU_LOG_DRV("  MSCh close addr = %d\r\n", dev_addr);
 
+  // reject new requests, then fail pending ones so that none is left without callback
+  (void) osal_mutex_lock(_msch_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+  p_msc->configured = false;
+  uint8_t const queued = p_msc->q_count;
+  (void) osal_mutex_unlock(_msch_mutex);
+
+  request_complete(dev_addr, p_msc, queued, NULL);
+
   // invoke Application Callback
   if (p_msc->mounted) {
     if (tuh_msc_umount_cb) {
@@ -322,17 +527,36 @@ bool msch_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32
     case MSC_STAGE_CMD:
       // Must be Command Block
       TU_ASSERT(ep_addr == p_msc->ep_out && event == XFER_RESULT_SUCCESS && xferred_bytes == sizeof(msc_cbw_t));
-      if (cbw->total_bytes && p_msc->buffer) {
+      if (cbw->total_bytes && queue_at(p_msc, 0)->buffer) {
         // Data stage if any
         p_msc->stage = MSC_STAGE_DATA;
-        uint8_t const ep_data = (cbw->dir & TUSB_DIR_IN_MASK) ? p_msc->ep_in : p_msc->ep_out;
-        TU_ASSERT(usbh_edpt_xfer(dev_addr, ep_data, p_msc->buffer, (uint16_t) cbw->total_bytes));
+        TU_ASSERT(data_xfer(dev_addr, p_msc));
+        if (!(cbw->dir & TUSB_DIR_IN_MASK)) {
+          data_queue(dev_addr, p_msc);
+        }
         break;
       }
 
       TU_ATTR_FALLTHROUGH; // fallthrough to status stage
 
     case MSC_STAGE_DATA:
+      if (p_msc->stage == MSC_STAGE_DATA) {
+        // continue with buffer of next merged request (unless already queued), unless device ended data stage early
+        msch_request_t const* req = queue_at(p_msc, p_msc->data_idx);
+        p_msc->data_idx++;
+        if (xferred_bytes == req->cbw.total_bytes && p_msc->data_idx < p_msc->active_count) {
+          if (p_msc->data_idx == p_msc->data_count) {
+            TU_ASSERT(data_xfer(dev_addr, p_msc));
+          }
+          break;
+        }
+
+        // drop buffers queued behind
+        if (p_msc->data_count > p_msc->data_idx) {
+          tuh_edpt_abort_xfer(dev_addr, ep_addr);
+        }
+      }
+
       // Status stage
       p_msc->stage = MSC_STAGE_STATUS;
       TU_ASSERT(usbh_edpt_xfer(dev_addr, p_msc->ep_in, (uint8_t*) csw, (uint16_t) sizeof(msc_csw_t)));
@@ -340,17 +564,7 @@ bool msch_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32
 
     case MSC_STAGE_STATUS:
       // SCSI op is complete
-      p_msc->stage = MSC_STAGE_IDLE;
-
-      if (p_msc->complete_cb) {
-        tuh_msc_complete_data_t const cb_data = {
-            .cbw = cbw,
-            .csw = csw,
-            .scsi_data = p_msc->buffer,
-            .user_arg = p_msc->complete_arg
-        };
-        p_msc->complete_cb(dev_addr, &cb_data);
-      }
+      command_complete(dev_addr, p_msc);
       break;
 
       // unknown state
@@ -391,6 +605,7 @@ bool msch_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const* de
     } else {
       p_msc->ep_out = ep_desc->bEndpointAddress;
     }
+    p_msc->ep_size = tu_edpt_packet_size(ep_desc);
 
     ep_desc = (tusb_desc_endpoint_t const*) tu_desc_next(ep_desc);
   }
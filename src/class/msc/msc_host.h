@@ -41,6 +41,13 @@
 #define CFG_TUH_MSC_MAXLUN  4
 #endif
 
+// Number of SCSI commands per device that can be submitted before previous ones complete. Queued commands are
+// issued back-to-back as soon as status of the previous one is received, queued READ10/WRITE10 with adjacent
+// LBAs on the same LUN are merged into one command. 1 means a command can only be submitted when device is idle
+#ifndef CFG_TUH_MSC_QUEUE_SIZE
+#define CFG_TUH_MSC_QUEUE_SIZE  1
+#endif
+
 typedef struct {
   msc_cbw_t const* cbw; // SCSI command
   msc_csw_t const* csw; // SCSI status
@@ -61,6 +68,9 @@ bool tuh_msc_mounted(uint8_t dev_addr);
 // Check if the interface is currently ready or busy transferring data
 bool tuh_msc_ready(uint8_t dev_addr);
 
+// Number of SCSI commands that can still be submitted (queued) without failing
+uint8_t tuh_msc_queue_available(uint8_t dev_addr);
+
 // Get Max Lun
 uint8_t tuh_msc_get_maxlun(uint8_t dev_addr);
 
@@ -71,8 +81,10 @@ uint32_t tuh_msc_get_block_count(uint8_t dev_addr, uint8_t lun);
 uint32_t tuh_msc_get_block_size(uint8_t dev_addr, uint8_t lun);
 
 // Perform a full SCSI command (cbw, data, csw) in non-blocking manner.
-// Complete callback is invoked when SCSI op is complete.
-// return true if success, false if there is already pending operation.
+// Complete callback is invoked when SCSI op is complete, in submission order. For merged READ10/WRITE10 callback
+// data has the command as submitted while csw is the status of the merged command. If a queued command can not be
+// started, its callback is invoked with failed csw status. Commands can be submitted from any task.
+// return true if success, false if queue is full (or there is already pending operation if CFG_TUH_MSC_QUEUE_SIZE = 1).
 // NOTE: buffer must be accessible by USB/DMA controller, aligned correctly and multiple of cache line if enabled
 bool tuh_msc_scsi_command(uint8_t daddr, msc_cbw_t const* cbw, void* data, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
 
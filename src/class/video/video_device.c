@@ -818,6 +818,7 @@ static bool _open_vs_itf(uint8_t rhport, videod_streaming_interface_t *stm, uint
       TU_VERIFY(TUSB_XFER_BULK == ep->bmAttributes.xfer);
       TU_ASSERT(usbd_edpt_open(rhport, ep));
     }
+    usbd_edpt_set_instance(rhport, ep->bEndpointAddress, (uint8_t) (stm - _videod_streaming_itf));
     stm->desc.ep[i] = (uint16_t) (cur - desc);
     TU_LOG_DRV("    open EP%02x\r\n", _desc_ep_addr(cur));
   }
@@ -1396,18 +1397,9 @@ bool videod_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint3
   (void)result; (void)xferred_bytes;
 
   /* find streaming handle */
-  uint_fast8_t itf;
-  videod_interface_t *ctl;
-  videod_streaming_interface_t *stm;
-  for (itf = 0; itf < CFG_TUD_VIDEO_STREAMING; ++itf) {
-    stm = &_videod_streaming_itf[itf];
-    uint_fast16_t const ep_ofs = stm->desc.ep[0];
-    if (!ep_ofs) continue;
-    ctl = &_videod_itf[stm->index_vc];
-    uint8_t const *desc = ctl->beg;
-    if (ep_addr == _desc_ep_addr(desc + ep_ofs)) break;
-  }
+  uint_fast8_t const itf = usbd_edpt_get_instance(rhport, ep_addr);
   TU_ASSERT(itf < CFG_TUD_VIDEO_STREAMING);
+  videod_streaming_interface_t *stm = &_videod_streaming_itf[itf];
   videod_streaming_epbuf_t *stm_epbuf = &_videod_streaming_epbuf[itf];
 
   if (stm->offset < stm->bufsize) {
@@ -62,6 +62,16 @@ typedef struct {
 
 }tu_edpt_stream_t;
 
+// Framed receive on top of a rx fifo
+typedef struct {
+  uint8_t mode;       // tusb_frame_mode_t
+  uint8_t delimiter;  // for TUSB_FRAME_DELIMITER
+  uint8_t skipping;   // dropping rest of an oversized frame: until next terminator, or skip_len bytes for LENGTH16
+  uint16_t scanned;   // bytes at head of fifo already searched without finding frame end
+  uint16_t found_len; // raw length of complete frame at head of fifo, 0 if not found yet
+  uint32_t skip_len;  // LENGTH16: raw bytes of oversized frame still to drop
+} tu_frame_t;
+
 //--------------------------------------------------------------------+
 // Endpoint
 //--------------------------------------------------------------------+
@@ -105,6 +115,15 @@ void tu_edpt_stream_close(tu_edpt_stream_t* s) {
   s->ep_addr = 0;
 }
 
+// Replace fifo and endpoint buffer of a stream, must be called when endpoint is idle. Data in fifo is discarded
+TU_ATTR_ALWAYS_INLINE static inline
+bool tu_edpt_stream_set_buffer(tu_edpt_stream_t* s, void* ff_buf, uint16_t ff_bufsize, uint8_t* ep_buf, uint16_t ep_bufsize) {
+  TU_VERIFY(tu_fifo_config(&s->ff, ff_buf, ff_bufsize, 1, s->ff.overwritable));
+  s->ep_buf = ep_buf;
+  s->ep_bufsize = ep_bufsize;
+  return true;
+}
+
 // Clear fifo
 TU_ATTR_ALWAYS_INLINE static inline
 bool tu_edpt_stream_clear(tu_edpt_stream_t* s) {
@@ -165,6 +184,50 @@ bool tu_edpt_stream_peek(tu_edpt_stream_t* s, uint8_t* ch) {
   return tu_fifo_peek(&s->ff, ch);
 }
 
+//--------------------------------------------------------------------+
+// Framed Receive
+//--------------------------------------------------------------------+
+
+// Find first occurrence of a byte, word at a time. Return its index or len if not found
+uint32_t tu_mem_find_byte(void const* buf, uint32_t len, uint8_t byte);
+
+// Set frame mode and restart searching
+TU_ATTR_ALWAYS_INLINE static inline
+void tu_frame_config(tu_frame_t* fr, uint8_t mode, uint8_t delimiter) {
+  fr->mode = mode;
+  fr->delimiter = delimiter;
+  fr->skipping = 0;
+  fr->scanned = 0;
+  fr->found_len = 0;
+  fr->skip_len = 0;
+}
+
+// Forget search state e.g when fifo is cleared or read as byte stream
+TU_ATTR_ALWAYS_INLINE static inline
+void tu_frame_reset(tu_frame_t* fr) {
+  fr->skipping = 0;
+  fr->scanned = 0;
+  fr->found_len = 0;
+  fr->skip_len = 0;
+}
+
+// Get raw length (including terminator or length prefix) of the complete frame at head of fifo, 0 if none yet.
+// Each byte is searched only once across calls
+uint16_t tu_frame_find(tu_frame_t* fr, tu_fifo_t* ff);
+
+// Update frame state after new data is written to fifo, rx_size is the size of next receive transfer.
+// A frame that can not fit into fifo is dropped up to its end (next terminator or its declared length), partly
+// now and the rest as it arrives. Return true if a complete frame is at head of fifo
+bool tu_frame_received(tu_frame_t* fr, tu_fifo_t* ff, uint16_t rx_size);
+
+// Remove frame at head of fifo, decode its payload into buffer (truncated to bufsize, NULL to discard).
+// Return number of bytes written to buffer
+uint32_t tu_frame_read(tu_frame_t* fr, tu_fifo_t* ff, void* buffer, uint32_t bufsize);
+
+// Zero-copy access to raw payload (without terminator or length prefix) of frame at head of fifo, in up to 2
+// linear parts. COBS and SLIP payload is still encoded. Discard with tu_frame_read(fr, ff, NULL, 0) when done
+bool tu_frame_peek(tu_frame_t* fr, tu_fifo_t* ff, tu_fifo_buffer_info_t* info);
+
 #ifdef __cplusplus
  }
 #endif
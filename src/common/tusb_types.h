@@ -82,6 +82,15 @@ typedef enum {
   TUSB_ROLE_HOST    = 0x2,
 } tusb_role_t;
 
+/// Framing of a received byte stream (CDC, Vendor)
+typedef enum {
+  TUSB_FRAME_NONE = 0,   ///< plain byte stream
+  TUSB_FRAME_DELIMITER,  ///< frame is terminated by a delimiter byte
+  TUSB_FRAME_COBS,       ///< Consistent Overhead Byte Stuffing, terminated by 0x00
+  TUSB_FRAME_SLIP,       ///< RFC 1055 SLIP, terminated by END (0xC0)
+  TUSB_FRAME_LENGTH16,   ///< payload prefixed by its 16-bit little endian length
+} tusb_frame_mode_t;
+
 /// defined base on EHCI specs value for Endpoint Speed
 typedef enum {
   TUSB_SPEED_FULL = 0,
@@ -149,6 +149,10 @@ void dcd_enter_test_mode(uint8_t rhport, tusb_feature_test_mode_t test_selector)
 // May help DCD to prepare for next control transfer, this API is optional.
 void dcd_edpt0_status_complete(uint8_t rhport, tusb_control_request_t const * request);
 
+// Invoked on SET_CONFIGURATION with the selected configuration descriptor, before any of its endpoints is opened.
+// Allows ports with shared packet memory to plan its partitioning for all endpoints. This API is optional.
+void dcd_edpt_config_plan     (uint8_t rhport, tusb_desc_configuration_t const * desc_cfg);
+
 // Configure endpoint's registers according to descriptor
 bool dcd_edpt_open            (uint8_t rhport, tusb_desc_endpoint_t const * desc_ep);
 
@@ -157,13 +161,23 @@ bool dcd_edpt_open            (uint8_t rhport, tusb_desc_endpoint_t const * desc
 // required for multiple configuration support.
 void dcd_edpt_close_all       (uint8_t rhport);
 
-// Submit a transfer, When complete dcd_event_xfer_complete() is invoked to notify the stack
-bool dcd_edpt_xfer            (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes);
+// Submit a transfer, When complete dcd_event_xfer_complete() is invoked to notify the stack.
+// total_bytes is at most 64KB - 1 unless dcd_edpt_xfer_max() reports a larger limit for the endpoint
+bool dcd_edpt_xfer            (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes);
+
+// Largest transfer dcd_edpt_xfer() can handle on an opened endpoint. This API is optional, default is 64KB - 1
+uint32_t dcd_edpt_xfer_max    (uint8_t rhport, uint8_t ep_addr);
 
 // Submit an transfer using fifo, When complete dcd_event_xfer_complete() is invoked to notify the stack
 // This API is optional, may be useful for register-based for transferring data.
 bool dcd_edpt_xfer_fifo       (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16_t total_bytes) TU_ATTR_WEAK;
 
+// Append a transfer to an endpoint which may still be transferring, so that it is linked in hardware (e.g qTD or DMA descriptor list)
+// and started without software intervention once the current transfer completes. If endpoint is idle, transfer is started right away.
+// dcd_event_xfer_complete() is invoked once for each transfer in submission order. Return false if not supported, stack then
+// submits queued transfers with dcd_edpt_xfer() on completion. This API is optional, used when CFG_TUD_EDPT_XFER_QUEUE > 0.
+bool dcd_edpt_xfer_append     (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes);
+
 // Stall endpoint, any queuing transfer should be removed from endpoint
 void dcd_edpt_stall           (uint8_t rhport, uint8_t ep_addr);
 
@@ -97,6 +97,20 @@ TU_ATTR_WEAK void dcd_disconnect(uint8_t rhport) {
   (void) rhport;
 }
 
+TU_ATTR_WEAK void dcd_edpt_config_plan(uint8_t rhport, tusb_desc_configuration_t const* desc_cfg) {
+  (void) rhport; (void) desc_cfg;
+}
+
+TU_ATTR_WEAK uint32_t dcd_edpt_xfer_max(uint8_t rhport, uint8_t ep_addr) {
+  (void) rhport; (void) ep_addr;
+  return UINT16_MAX;
+}
+
+TU_ATTR_WEAK bool dcd_edpt_xfer_append(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
+  (void) rhport; (void) ep_addr; (void) buffer; (void) total_bytes;
+  return false;
+}
+
 TU_ATTR_WEAK bool dcd_dcache_clean(const void* addr, uint32_t data_size) {
   (void) addr; (void) data_size;
   return true;
@@ -119,6 +133,18 @@ TU_ATTR_WEAK bool dcd_dcache_clean_invalidate(const void* addr, uint32_t data_si
 // Invalid driver ID in itf2drv[] ep2drv[][] mapping
 enum { DRVID_INVALID = 0xFFu };
 
+#if CFG_TUD_EDPT_XFER_QUEUE
+// Transfers submitted by usbd_edpt_xfer_queue()
+typedef struct {
+  uint8_t* buffer[CFG_TUD_EDPT_XFER_QUEUE];
+  uint32_t len[CFG_TUD_EDPT_XFER_QUEUE];
+  volatile uint8_t rd_idx;
+  volatile uint8_t count;     // queued, not yet submitted to DCD
+  volatile uint8_t submitted; // submitted to DCD, xfer_cb() not yet invoked
+  volatile uint8_t completed; // completed by DCD, not yet counted off by usbd task
+} usbd_xfer_queue_t;
+#endif
+
 typedef struct {
   struct TU_ATTR_PACKED {
     volatile uint8_t connected    : 1;
@@ -135,14 +161,65 @@ typedef struct {
 
   uint8_t itf2drv[CFG_TUD_INTERFACE_MAX];   // map interface number to driver (0xff is invalid)
   uint8_t ep2drv[CFG_TUD_ENDPPOINT_MAX][2]; // map endpoint to driver ( 0xff is invalid ), can use only 4-bit each
+  uint8_t ep2inst[CFG_TUD_ENDPPOINT_MAX][2]; // map endpoint to driver's instance ( 0xff is invalid )
 
   tu_edpt_state_t ep_status[CFG_TUD_ENDPPOINT_MAX][2];
 
+#if CFG_TUD_EDPT_XFER_QUEUE
+  usbd_xfer_queue_t ep_queue[CFG_TUD_ENDPPOINT_MAX][2];
+#endif
 }usbd_device_t;
 
 tu_static usbd_device_t _usbd_dev;
 static volatile uint8_t _usbd_queued_setup;
 
+#if CFG_TUD_EDPT_XFER_QUEUE
+// Submit oldest queued transfer to DCD. Called from ISR or with DCD interrupt disabled.
+// DCD is only re-primed when nothing is outstanding, otherwise transfer is linked behind the outstanding ones
+static bool edpt_queue_submit(uint8_t rhport, uint8_t ep_addr) {
+  usbd_xfer_queue_t* q = &_usbd_dev.ep_queue[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+  if (q->count == 0) return false;
+
+  uint8_t const idx = q->rd_idx;
+
+  if (q->submitted > q->completed) {
+    // keep it queued if DCD can't link it, it is submitted when outstanding transfers are counted off by usbd task
+    TU_VERIFY(dcd_edpt_xfer_append(rhport, ep_addr, q->buffer[idx], q->len[idx]));
+    q->rd_idx = (uint8_t) ((idx + 1) % CFG_TUD_EDPT_XFER_QUEUE);
+    q->count--;
+    q->submitted++;
+    return true;
+  }
+
+  q->rd_idx = (uint8_t) ((idx + 1) % CFG_TUD_EDPT_XFER_QUEUE);
+  q->count--;
+  q->submitted++;
+
+  if (!dcd_edpt_xfer(rhport, ep_addr, q->buffer[idx], q->len[idx])) {
+    q->submitted--;
+    return false;
+  }
+  return true;
+}
+
+// Invoked by usbd task on transfer complete, return true if endpoint is still busy with a queued transfer
+static bool edpt_queue_complete(uint8_t rhport, uint8_t ep_addr) {
+  usbd_xfer_queue_t* q = &_usbd_dev.ep_queue[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+
+  dcd_int_disable(rhport);
+  if (q->submitted) q->submitted--;
+  if (q->completed) q->completed--;
+
+  // Transfers are normally started from ISR, but not if previous one failed
+  if (q->submitted == 0) edpt_queue_submit(rhport, ep_addr);
+
+  bool const busy = (q->submitted > 0);
+  dcd_int_enable(rhport);
+
+  return busy;
+}
+#endif
+
 //--------------------------------------------------------------------+
 // Class Driver
 //--------------------------------------------------------------------+
@@ -163,7 +240,7 @@ tu_static usbd_class_driver_t const _usbd_driver[] = {
         .open             = cdcd_open,
         .control_xfer_cb  = cdcd_control_xfer_cb,
         .xfer_cb          = cdcd_xfer_cb,
-        .sof              = NULL
+        .sof              = cdcd_sof_isr
     },
     #endif
 
@@ -553,6 +630,7 @@ static void configuration_reset(uint8_t rhport) {
   tu_varclr(&_usbd_dev);
   memset(_usbd_dev.itf2drv, DRVID_INVALID, sizeof(_usbd_dev.itf2drv)); // invalid mapping
   memset(_usbd_dev.ep2drv, DRVID_INVALID, sizeof(_usbd_dev.ep2drv)); // invalid mapping
+  memset(_usbd_dev.ep2inst, DRVID_INVALID, sizeof(_usbd_dev.ep2inst)); // invalid mapping
 }
 
 static void usbd_reset(uint8_t rhport) {
@@ -645,7 +723,11 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr) {
 
         TU_LOG_USBD("on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) event.xfer_complete.len);
 
+#if CFG_TUD_EDPT_XFER_QUEUE
+        _usbd_dev.ep_status[epnum][ep_dir].busy = edpt_queue_complete(event.rhport, ep_addr) ? 1 : 0;
+#else
         _usbd_dev.ep_status[epnum][ep_dir].busy = 0;
+#endif
         _usbd_dev.ep_status[epnum][ep_dir].claimed = 0;
 
         if (0 == epnum) {
@@ -985,6 +1067,9 @@ static bool process_set_config(uint8_t rhport, uint8_t cfg_num)
   _usbd_dev.remote_wakeup_support = (desc_cfg->bmAttributes & TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP) ? 1u : 0u;
   _usbd_dev.self_powered          = (desc_cfg->bmAttributes & TUSB_DESC_CONFIG_ATT_SELF_POWERED ) ? 1u : 0u;
 
+  // Let dcd plan its packet memory for all endpoints of this configuration
+  dcd_edpt_config_plan(rhport, desc_cfg);
+
   // Parse interface descriptor
   uint8_t const * p_desc   = ((uint8_t const*) desc_cfg) + sizeof(tusb_desc_configuration_t);
   uint8_t const * desc_end = ((uint8_t const*) desc_cfg) + tu_le16toh(desc_cfg->wTotalLength);
@@ -1220,6 +1305,21 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const* event, bool in_isr)
       send = true;
       break;
 
+#if CFG_TUD_EDPT_XFER_QUEUE
+    case DCD_EVENT_XFER_COMPLETE: {
+      uint8_t const ep_addr = event->xfer_complete.ep_addr;
+      usbd_xfer_queue_t* q = &_usbd_dev.ep_queue[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+      if (q->completed < q->submitted) q->completed++;
+
+      // Start next queued transfer right away, endpoint would otherwise idle until usbd task and class driver re-arm it
+      if (event->xfer_complete.result == XFER_RESULT_SUCCESS) {
+        edpt_queue_submit(event->rhport, ep_addr);
+      }
+      send = true;
+      break;
+    }
+#endif
+
     default:
       send = true;
       break;
@@ -1317,7 +1417,17 @@ bool usbd_edpt_release(uint8_t rhport, uint8_t ep_addr) {
   return tu_edpt_release(ep_state, _usbd_mutex);
 }
 
-bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+uint32_t usbd_edpt_xfer_max(uint8_t rhport, uint8_t ep_addr) {
+  (void) rhport;
+  return tu_max32(UINT16_MAX, dcd_edpt_xfer_max(_usbd_rhport, ep_addr));
+}
+
+// only query dcd when transfer does not fit the 64KB - 1 every port supports
+static inline bool xfer_len_supported(uint8_t rhport, uint8_t ep_addr, uint32_t total_bytes) {
+  return (total_bytes <= UINT16_MAX) || (total_bytes <= usbd_edpt_xfer_max(rhport, ep_addr));
+}
+
+bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
   rhport = _usbd_rhport;
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
@@ -1326,7 +1436,10 @@ bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t t
   // TODO skip ready() check for now since enumeration also use this API
   // TU_VERIFY(tud_ready());
 
-  TU_LOG_USBD("  Queue EP %02X with %u bytes ...\r\n", ep_addr, total_bytes);
+  TU_LOG_USBD("  Queue EP %02X with %lu bytes ...\r\n", ep_addr, (unsigned long) total_bytes);
+
+  // Transfer larger than 64KB requires support from dcd
+  TU_ASSERT(xfer_len_supported(rhport, ep_addr, total_bytes));
 #if CFG_TUD_LOG_LEVEL >= 3
   if(dir == TUSB_DIR_IN) {
     TU_LOG_MEM(CFG_TUD_LOG_LEVEL, buffer, total_bytes, 2);
@@ -1339,11 +1452,19 @@ bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t t
   // Set busy first since the actual transfer can be complete before dcd_edpt_xfer()
   // could return and USBD task can preempt and clear the busy
   _usbd_dev.ep_status[epnum][dir].busy = 1;
+#if CFG_TUD_EDPT_XFER_QUEUE
+  // account for it so that queued transfers are linked behind instead of re-priming the endpoint
+  usbd_xfer_queue_t* q = &_usbd_dev.ep_queue[epnum][dir];
+  if (epnum) q->submitted++;
+#endif
 
   if (dcd_edpt_xfer(rhport, ep_addr, buffer, total_bytes)) {
     return true;
   } else {
     // DCD error, mark endpoint as ready to allow next transfer
+#if CFG_TUD_EDPT_XFER_QUEUE
+    if (epnum) q->submitted--;
+#endif
     _usbd_dev.ep_status[epnum][dir].busy = 0;
     _usbd_dev.ep_status[epnum][dir].claimed = 0;
     TU_LOG_USBD("FAILED\r\n");
@@ -1352,6 +1473,57 @@ bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t t
   }
 }
 
+#if CFG_TUD_EDPT_XFER_QUEUE
+bool usbd_edpt_xfer_queue(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
+  rhport = _usbd_rhport;
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir = tu_edpt_dir(ep_addr);
+  tu_edpt_state_t* ep_state = &_usbd_dev.ep_status[epnum][dir];
+  usbd_xfer_queue_t* q = &_usbd_dev.ep_queue[epnum][dir];
+
+  TU_ASSERT(epnum > 0);
+  TU_ASSERT(xfer_len_supported(rhport, ep_addr, total_bytes));
+  TU_LOG_USBD("  Queue EP %02X with %lu bytes (%u pending) ...\r\n", ep_addr, (unsigned long) total_bytes, q->submitted + q->count);
+
+  bool ret = true;
+  dcd_int_disable(rhport);
+
+  if (!ep_state->busy) {
+    // Endpoint is idle, submit right away. Set busy first since transfer can complete before dcd_edpt_xfer() returns
+    ep_state->busy = 1;
+    q->submitted++;
+    if (!dcd_edpt_xfer(rhport, ep_addr, buffer, total_bytes)) {
+      q->submitted--;
+      ep_state->busy = 0;
+      ep_state->claimed = 0;
+      ret = false;
+    }
+  } else if (q->count == 0 && dcd_edpt_xfer_append(rhport, ep_addr, buffer, total_bytes)) {
+    // Linked in hardware behind the active transfer
+    q->submitted++;
+  } else if (q->count < CFG_TUD_EDPT_XFER_QUEUE) {
+    uint8_t const idx = (uint8_t) ((q->rd_idx + q->count) % CFG_TUD_EDPT_XFER_QUEUE);
+    q->buffer[idx] = buffer;
+    q->len[idx] = total_bytes;
+    q->count++;
+  } else {
+    ret = false; // queue full
+  }
+
+  dcd_int_enable(rhport);
+
+  TU_VERIFY(ret);
+  return true;
+}
+
+uint8_t usbd_edpt_xfer_queue_count(uint8_t rhport, uint8_t ep_addr) {
+  (void) rhport;
+  usbd_xfer_queue_t const* q = &_usbd_dev.ep_queue[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+  return (uint8_t) (q->submitted + q->count);
+}
+#endif
+
 // The number of bytes has to be given explicitly to allow more flexible control of how many
 // bytes should be written and second to keep the return value free to give back a boolean
 // success message. If total_bytes is too big, the FIFO will copy only what is available
@@ -1404,6 +1576,9 @@ void usbd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
   dcd_edpt_stall(rhport, ep_addr);
   _usbd_dev.ep_status[epnum][dir].stalled = 1;
   _usbd_dev.ep_status[epnum][dir].busy = 1;
+#if CFG_TUD_EDPT_XFER_QUEUE
+  tu_memclr(&_usbd_dev.ep_queue[epnum][dir], sizeof(usbd_xfer_queue_t));
+#endif
 }
 
 void usbd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
@@ -1428,6 +1603,24 @@ bool usbd_edpt_stalled(uint8_t rhport, uint8_t ep_addr) {
   return _usbd_dev.ep_status[epnum][dir].stalled;
 }
 
+void usbd_edpt_set_instance(uint8_t rhport, uint8_t ep_addr, uint8_t instance) {
+  (void) rhport;
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  TU_VERIFY(epnum < CFG_TUD_ENDPPOINT_MAX,);
+
+  _usbd_dev.ep2inst[epnum][tu_edpt_dir(ep_addr)] = instance;
+}
+
+uint8_t usbd_edpt_get_instance(uint8_t rhport, uint8_t ep_addr) {
+  (void) rhport;
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  TU_VERIFY(epnum < CFG_TUD_ENDPPOINT_MAX, DRVID_INVALID);
+
+  return _usbd_dev.ep2inst[epnum][tu_edpt_dir(ep_addr)];
+}
+
 /**
  * usbd_edpt_close will disable an endpoint.
  * In progress transfers on this EP may be delivered after this call.
@@ -1448,6 +1641,10 @@ void usbd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
   _usbd_dev.ep_status[epnum][dir].stalled = 0;
   _usbd_dev.ep_status[epnum][dir].busy = 0;
   _usbd_dev.ep_status[epnum][dir].claimed = 0;
+  _usbd_dev.ep2inst[epnum][dir] = DRVID_INVALID;
+  #if CFG_TUD_EDPT_XFER_QUEUE
+  tu_memclr(&_usbd_dev.ep_queue[epnum][dir], sizeof(usbd_xfer_queue_t));
+  #endif
 #endif
 
   return;
@@ -1456,6 +1653,9 @@ void usbd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
 void usbd_sof_enable(uint8_t rhport, sof_consumer_t consumer, bool en) {
   rhport = _usbd_rhport;
 
+  // sof_consumer is also read by dcd_event_handler() in ISR
+  usbd_int_set(false);
+
   uint8_t consumer_old = _usbd_dev.sof_consumer;
   // Keep track how many class instances need the SOF interrupt
   if (en) {
@@ -1468,6 +1668,8 @@ void usbd_sof_enable(uint8_t rhport, sof_consumer_t consumer, bool en) {
   if(!_usbd_dev.sof_consumer != !consumer_old) {
     dcd_sof_enable(rhport, _usbd_dev.sof_consumer);
   }
+
+  usbd_int_set(true);
 }
 
 bool usbd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet_size) {
@@ -1495,6 +1697,9 @@ bool usbd_edpt_iso_activate(uint8_t rhport, tusb_desc_endpoint_t const* desc_ep)
   _usbd_dev.ep_status[epnum][dir].stalled = 0;
   _usbd_dev.ep_status[epnum][dir].busy = 0;
   _usbd_dev.ep_status[epnum][dir].claimed = 0;
+  #if CFG_TUD_EDPT_XFER_QUEUE
+  tu_memclr(&_usbd_dev.ep_queue[epnum][dir], sizeof(usbd_xfer_queue_t));
+  #endif
   return dcd_edpt_iso_activate(rhport, desc_ep);
 #else
   (void) rhport; (void) desc_ep;
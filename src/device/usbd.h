@@ -363,6 +363,42 @@ bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_requ
   TUD_MIDI_DESC_EP(_epin, _epsize, 1),\
   TUD_MIDI_JACKID_OUT_EMB(1)
 
+//------------- MIDI 2.0 -------------//
+
+// MIDI Streaming Alternate Setting 1 (UMP), appended right after a MIDI 1.0 descriptor (alternate 0) of same interface.
+// Both settings must use the same endpoints. Endpoints are associated to Group Terminal Block 1
+#define TUD_MIDI2_DESC_ALT1_LEN (9 + 7 + (7 + 5) * 2)
+#define TUD_MIDI2_DESC_ALT1(_itfnum, _epout, _epin, _epsize) \
+  /* MIDI Streaming (MS) Interface, Alternate 1 */\
+  9, TUSB_DESC_INTERFACE, (uint8_t)((_itfnum) + 1), 1, 2, TUSB_CLASS_AUDIO, AUDIO_SUBCLASS_MIDI_STREAMING, AUDIO_FUNC_PROTOCOL_CODE_UNDEF, 0,\
+  /* MS Header v2.0 */\
+  7, TUSB_DESC_CS_INTERFACE, MIDI_CS_INTERFACE_HEADER, U16_TO_U8S_LE(0x0200), U16_TO_U8S_LE(7),\
+  /* Endpoint Out */\
+  7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  /* MS Endpoint 2.0 with 1 Group Terminal Block */\
+  5, TUSB_DESC_CS_ENDPOINT, MIDI_CS_ENDPOINT_GENERAL_2_0, 1, 1,\
+  /* Endpoint In */\
+  7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  /* MS Endpoint 2.0 with 1 Group Terminal Block */\
+  5, TUSB_DESC_CS_ENDPOINT, MIDI_CS_ENDPOINT_GENERAL_2_0, 1, 1
+
+// Length of MIDI 1.0 + MIDI 2.0 template descriptor
+#define TUD_MIDI2_DESC_LEN (TUD_MIDI_DESC_LEN + TUD_MIDI2_DESC_ALT1_LEN)
+
+// MIDI 2.0 simple descriptor: MIDI 1.0 simple descriptor as alternate 0 for legacy host, UMP as alternate 1
+#define TUD_MIDI2_DESCRIPTOR(_itfnum, _stridx, _epout, _epin, _epsize) \
+  TUD_MIDI_DESCRIPTOR(_itfnum, _stridx, _epout, _epin, _epsize),\
+  TUD_MIDI2_DESC_ALT1(_itfnum, _epout, _epin, _epsize)
+
+// Group Terminal Block descriptors returned by tud_midi_descriptor_gtb_cb(): header + 1 bidirectional block
+#define TUD_MIDI2_DESC_GTB_LEN (5 + 13)
+#define TUD_MIDI2_DESC_GTB(_first_group, _num_groups, _stridx, _protocol) \
+  /* Group Terminal Block Header */\
+  5, MIDI_CS_GR_TRM_BLOCK, MIDI_GR_TRM_BLOCK_HEADER, U16_TO_U8S_LE(TUD_MIDI2_DESC_GTB_LEN),\
+  /* Group Terminal Block 1 */\
+  13, MIDI_CS_GR_TRM_BLOCK, MIDI_GR_TRM_BLOCK, 1, MIDI_GR_TRM_BLOCK_TYPE_BIDIRECTIONAL, _first_group, _num_groups, _stridx, _protocol,\
+  U16_TO_U8S_LE(0), U16_TO_U8S_LE(0)
+
 //--------------------------------------------------------------------+
 // Audio v2.0 Descriptor Templates
 //--------------------------------------------------------------------+
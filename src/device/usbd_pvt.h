@@ -43,6 +43,7 @@
 typedef enum {
   SOF_CONSUMER_USER = 0,
   SOF_CONSUMER_AUDIO,
+  SOF_CONSUMER_CDC,
 } sof_consumer_t;
 
 //--------------------------------------------------------------------+
@@ -80,12 +81,32 @@ bool usbd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * desc_ep);
 // Close an endpoint
 void usbd_edpt_close(uint8_t rhport, uint8_t ep_addr);
 
+// Bind an opened endpoint to a class driver instance (e.g interface index), so that xfer_cb()
+// can find its instance in constant time with usbd_edpt_get_instance(). Binding is cleared on close/bus reset
+void usbd_edpt_set_instance(uint8_t rhport, uint8_t ep_addr, uint8_t instance);
+
+// Get instance bound to endpoint with usbd_edpt_set_instance(), 0xFF if not bound
+uint8_t usbd_edpt_get_instance(uint8_t rhport, uint8_t ep_addr);
+
+// Largest number of bytes a single usbd_edpt_xfer() on this endpoint can carry, at least 64KB - 1
+uint32_t usbd_edpt_xfer_max(uint8_t rhport, uint8_t ep_addr);
+
 // Submit a usb transfer
-bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes);
+bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes);
 
 // Submit a usb ISO transfer by use of a FIFO (ring buffer) - all bytes in FIFO get transmitted
 bool usbd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16_t total_bytes);
 
+#if CFG_TUD_EDPT_XFER_QUEUE
+// Submit a usb transfer even if endpoint is busy, up to CFG_TUD_EDPT_XFER_QUEUE transfers are queued behind the active one
+// and started as soon as the previous one completes. xfer_cb() is invoked once per transfer in submission order.
+// Transfers submitted with usbd_edpt_xfer() are accounted for, usbd_edpt_xfer_fifo() should not be used on the same endpoint.
+bool usbd_edpt_xfer_queue(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes);
+
+// Number of transfers submitted with usbd_edpt_xfer_queue() whose xfer_cb() is not yet invoked (active + queued)
+uint8_t usbd_edpt_xfer_queue_count(uint8_t rhport, uint8_t ep_addr);
+#endif
+
 // Claim an endpoint before submitting a transfer.
 // If caller does not make any transfer, it must release endpoint for others.
 bool usbd_edpt_claim(uint8_t rhport, uint8_t ep_addr);
@@ -59,6 +59,11 @@ TU_ATTR_WEAK bool hcd_configure(uint8_t rhport, uint32_t cfg_id, const void* cfg
   return false;
 }
 
+TU_ATTR_WEAK bool hcd_edpt_xfer_append(uint8_t rhport, uint8_t daddr, uint8_t ep_addr, uint8_t* buffer, uint16_t buflen) {
+  (void) rhport; (void) daddr; (void) ep_addr; (void) buffer; (void) buflen;
+  return false;
+}
+
 TU_ATTR_WEAK void tuh_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr) {
   (void) rhport;
   (void) eventid;
@@ -131,6 +136,7 @@ typedef struct {
   uint8_t ep2drv[CFG_TUH_ENDPOINT_MAX][2]; // map endpoint to driver ( 0xff is invalid ), can use only 4-bit each
 
   tu_edpt_state_t ep_status[CFG_TUH_ENDPOINT_MAX][2];
+  uint8_t ep_queued[CFG_TUH_ENDPOINT_MAX][2]; // transfers submitted by usbh_edpt_xfer_queue() behind the active one
 
 #if CFG_TUH_API_EDPT_XFER
   // TODO array can be CFG_TUH_ENDPOINT_MAX-1
@@ -202,14 +208,14 @@ static usbh_class_driver_t const usbh_class_drivers[] = {
 
   #if CFG_TUH_VENDOR
   {
-    .name       = DRIVER_NAME("VENDOR"),
-    .init       = cush_init,
-    .deinit     = cush_deinit,
-    .open       = cush_open,
-    .set_config = cush_set_config,
-    .xfer_cb    = cush_isr,
-    .close      = cush_close
-  }
+      .name       = DRIVER_NAME("VENDOR"),
+      .init       = vendorh_init,
+      .deinit     = vendorh_deinit,
+      .open       = vendorh_open,
+      .set_config = vendorh_set_config,
+      .xfer_cb    = vendorh_xfer_cb,
+      .close      = vendorh_close
+  },
   #endif
 };
 
@@ -550,8 +556,12 @@ void tuh_task_ext(uint32_t timeout_ms, bool in_isr) {
           usbh_device_t* dev = get_device(event.dev_addr);
           TU_VERIFY(dev && dev->connected,);
 
-          dev->ep_status[epnum][ep_dir].busy = 0;
-          dev->ep_status[epnum][ep_dir].claimed = 0;
+          if (dev->ep_queued[epnum][ep_dir]) {
+            dev->ep_queued[epnum][ep_dir]--; // next queued transfer is now active
+          } else {
+            dev->ep_status[epnum][ep_dir].busy = 0;
+            dev->ep_status[epnum][ep_dir].claimed = 0;
+          }
 
           if (0 == epnum) {
             usbh_control_xfer_cb(event.dev_addr, ep_addr, (xfer_result_t) event.xfer_complete.result, event.xfer_complete.len);
@@ -819,6 +829,7 @@ bool tuh_edpt_abort_xfer(uint8_t daddr, uint8_t ep_addr) {
 
     // mark as ready and release endpoint if transfer is aborted
     dev->ep_status[epnum][dir].busy = false;
+    dev->ep_queued[epnum][dir] = 0;
     tu_edpt_release(&dev->ep_status[epnum][dir], _usbh_mutex);
   }
 
@@ -931,6 +942,28 @@ bool usbh_edpt_xfer_with_callback(uint8_t dev_addr, uint8_t ep_addr, uint8_t* bu
   }
 }
 
+bool usbh_edpt_xfer_queue(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+  usbh_device_t* dev = get_device(dev_addr);
+  TU_VERIFY(dev);
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir = tu_edpt_dir(ep_addr);
+  TU_VERIFY(epnum != 0 && dev->ep_status[epnum][dir].busy && dev->ep_queued[epnum][dir] < UINT8_MAX);
+
+  TU_LOG_USBH("  Queue EP %02X with %u bytes behind active transfer ... \r\n", ep_addr, total_bytes);
+
+  // Count it first since the active transfer can be complete before hcd_edpt_xfer_append() returns
+  dev->ep_queued[epnum][dir]++;
+  if (!hcd_edpt_xfer_append(dev->rhport, dev_addr, ep_addr, buffer, total_bytes)) {
+    dev->ep_queued[epnum][dir]--;
+    TU_LOG_USBH("Not supported\r\n");
+    return false;
+  }
+
+  TU_LOG_USBH("OK\r\n");
+  return true;
+}
+
 static bool usbh_edpt_control_open(uint8_t dev_addr, uint8_t max_packet_size) {
   TU_LOG_USBH("[%u:%u] Open EP0 with Size = %u\r\n", usbh_get_rhport(dev_addr), dev_addr, max_packet_size);
   tusb_desc_endpoint_t ep0_desc = {
@@ -88,6 +88,11 @@ static inline bool usbh_edpt_xfer(uint8_t dev_addr, uint8_t ep_addr, uint8_t * b
   return usbh_edpt_xfer_with_callback(dev_addr, ep_addr, buffer, total_bytes, NULL, 0);
 }
 
+// Submit a transfer behind the one(s) in flight on a busy endpoint, linked by HCD so that endpoint does not idle in
+// between. Must be called from usbh task e.g xfer_cb(). Return false if HCD does not support it, caller then submits
+// it with usbh_edpt_xfer() once the previous transfer completes.
+bool usbh_edpt_xfer_queue(uint8_t dev_addr, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes);
+
 // Claim an endpoint before submitting a transfer.
 // If caller does not make any transfer, it must release endpoint for others.
 bool usbh_edpt_claim(uint8_t dev_addr, uint8_t ep_addr);
@@ -256,6 +256,11 @@ static tuh_configure_max3421_t _tuh_cfg = {
 // API: SPI transfer with MAX3421E
 // - spi_cs_api(), spi_xfer_api(), int_api(): must be implemented by application
 // - reg_read(), reg_write(): is implemented by this driver, can be used by application
+//
+// Internally, SPI bus is locked once per batch (a transfer kick-off or a whole interrupt handling) with
+// max3421_spi_lock()/unlock(). Within a batch, each register/FIFO access is a single chip-select framed transaction
+// (MAX3421E takes only one command byte per CS assertion) and the HIRQ status byte clocked out with every command
+// byte is cached to save extra HIRQ reads.
 //--------------------------------------------------------------------+
 
 // API to control MAX3421 SPI CS
@@ -278,24 +283,16 @@ bool tuh_max3421_reg_write(uint8_t rhport, uint8_t reg, uint8_t data, bool in_is
 // SPI Commands and Helper
 //--------------------------------------------------------------------+
 
-#define reg_read  tuh_max3421_reg_read
-#define reg_write tuh_max3421_reg_write
-
+// Lock SPI bus for a batch of transactions
 static void max3421_spi_lock(uint8_t rhport, bool in_isr) {
   // disable interrupt and mutex lock (for pre-emptive RTOS) if not in_isr
   if (!in_isr) {
     (void) osal_mutex_lock(_hcd_data.spi_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
     tuh_max3421_int_api(rhport, false);
   }
-
-  // assert CS
-  tuh_max3421_spi_cs_api(rhport, true);
 }
 
 static void max3421_spi_unlock(uint8_t rhport, bool in_isr) {
-  // de-assert CS
-  tuh_max3421_spi_cs_api(rhport, false);
-
   // mutex unlock and re-enable interrupt
   if (!in_isr) {
     tuh_max3421_int_api(rhport, true);
@@ -303,107 +300,119 @@ static void max3421_spi_unlock(uint8_t rhport, bool in_isr) {
   }
 }
 
-uint8_t tuh_max3421_reg_read(uint8_t rhport, uint8_t reg, bool in_isr) {
+// Register read/write, SPI bus must be locked. Command byte also clocks out HIRQ since we are in full-duplex mode
+static uint8_t reg_read(uint8_t rhport, uint8_t reg) {
   uint8_t tx_buf[2] = {reg, 0};
   uint8_t rx_buf[2] = {0, 0};
 
-  max3421_spi_lock(rhport, in_isr);
+  tuh_max3421_spi_cs_api(rhport, true);
   bool ret = tuh_max3421_spi_xfer_api(rhport, tx_buf, rx_buf, 2);
-  max3421_spi_unlock(rhport, in_isr);
+  tuh_max3421_spi_cs_api(rhport, false);
 
   _hcd_data.hirq = rx_buf[0];
   return ret ? rx_buf[1] : 0;
 }
 
-bool tuh_max3421_reg_write(uint8_t rhport, uint8_t reg, uint8_t data, bool in_isr) {
+static bool reg_write(uint8_t rhport, uint8_t reg, uint8_t data) {
   uint8_t tx_buf[2] = {reg | CMDBYTE_WRITE, data};
   uint8_t rx_buf[2] = {0, 0};
 
-  max3421_spi_lock(rhport, in_isr);
+  tuh_max3421_spi_cs_api(rhport, true);
   bool ret = tuh_max3421_spi_xfer_api(rhport, tx_buf, rx_buf, 2);
-  max3421_spi_unlock(rhport, in_isr);
+  tuh_max3421_spi_cs_api(rhport, false);
 
-  // HIRQ register since we are in full-duplex mode
   _hcd_data.hirq = rx_buf[0];
+  return ret;
+}
+
+uint8_t tuh_max3421_reg_read(uint8_t rhport, uint8_t reg, bool in_isr) {
+  max3421_spi_lock(rhport, in_isr);
+  uint8_t const value = reg_read(rhport, reg);
+  max3421_spi_unlock(rhport, in_isr);
+  return value;
+}
 
+bool tuh_max3421_reg_write(uint8_t rhport, uint8_t reg, uint8_t data, bool in_isr) {
+  max3421_spi_lock(rhport, in_isr);
+  bool const ret = reg_write(rhport, reg, data);
+  max3421_spi_unlock(rhport, in_isr);
   return ret;
 }
 
 //--------------------------------------------------------------------
-// Register helper
+// Register helper, SPI bus must be locked
 //--------------------------------------------------------------------
-TU_ATTR_ALWAYS_INLINE static inline void hirq_write(uint8_t rhport, uint8_t data, bool in_isr) {
-  reg_write(rhport, HIRQ_ADDR, data, in_isr);
+TU_ATTR_ALWAYS_INLINE static inline void hirq_write(uint8_t rhport, uint8_t data) {
+  reg_write(rhport, HIRQ_ADDR, data);
   // HIRQ write 1 is clear
   _hcd_data.hirq &= (uint8_t) ~data;
 }
 
-TU_ATTR_ALWAYS_INLINE static inline void hien_write(uint8_t rhport, uint8_t data, bool in_isr) {
+TU_ATTR_ALWAYS_INLINE static inline void hien_write(uint8_t rhport, uint8_t data) {
   _hcd_data.hien = data;
-  reg_write(rhport, HIEN_ADDR, data, in_isr);
+  reg_write(rhport, HIEN_ADDR, data);
 }
 
-TU_ATTR_ALWAYS_INLINE static inline void mode_write(uint8_t rhport, uint8_t data, bool in_isr) {
+TU_ATTR_ALWAYS_INLINE static inline void mode_write(uint8_t rhport, uint8_t data) {
   _hcd_data.mode = data;
-  reg_write(rhport, MODE_ADDR, data, in_isr);
+  reg_write(rhport, MODE_ADDR, data);
 }
 
-TU_ATTR_ALWAYS_INLINE static inline void peraddr_write(uint8_t rhport, uint8_t data, bool in_isr) {
+TU_ATTR_ALWAYS_INLINE static inline void peraddr_write(uint8_t rhport, uint8_t data) {
   if ( _hcd_data.peraddr == data ) return; // no need to change address
 
   _hcd_data.peraddr = data;
-  reg_write(rhport, PERADDR_ADDR, data, in_isr);
+  reg_write(rhport, PERADDR_ADDR, data);
 }
 
-TU_ATTR_ALWAYS_INLINE static inline void hxfr_write(uint8_t rhport, uint8_t data, bool in_isr) {
+TU_ATTR_ALWAYS_INLINE static inline void hxfr_write(uint8_t rhport, uint8_t data) {
   _hcd_data.hxfr = data;
-  reg_write(rhport, HXFR_ADDR, data, in_isr);
+  reg_write(rhport, HXFR_ADDR, data);
 }
 
-TU_ATTR_ALWAYS_INLINE static inline void sndbc_write(uint8_t rhport, uint8_t data, bool in_isr) {
+TU_ATTR_ALWAYS_INLINE static inline void sndbc_write(uint8_t rhport, uint8_t data) {
   _hcd_data.sndbc = data;
-  reg_write(rhport, SNDBC_ADDR, data, in_isr);
+  reg_write(rhport, SNDBC_ADDR, data);
 }
 
 //--------------------------------------------------------------------
-// FIFO access (receive, send, setup)
+// FIFO access (receive, send, setup), SPI bus must be locked.
+// Command byte and data are sent in the same CS assertion, data is transferred directly from/to user buffer
 //--------------------------------------------------------------------
-static void hwfifo_write(uint8_t rhport, uint8_t reg, const uint8_t* buffer, uint8_t len, bool in_isr) {
+static void hwfifo_write(uint8_t rhport, uint8_t reg, const uint8_t* buffer, uint8_t len) {
   uint8_t hirq;
   reg |= CMDBYTE_WRITE;
 
-  max3421_spi_lock(rhport, in_isr);
-
+  tuh_max3421_spi_cs_api(rhport, true);
   tuh_max3421_spi_xfer_api(rhport, &reg, &hirq, 1);
-  _hcd_data.hirq = hirq;
   tuh_max3421_spi_xfer_api(rhport, buffer, NULL, len);
+  tuh_max3421_spi_cs_api(rhport, false);
 
-  max3421_spi_unlock(rhport, in_isr);
+  _hcd_data.hirq = hirq;
 }
 
 // Write to SNDFIFO if len > 0 and update SNDBC
-TU_ATTR_ALWAYS_INLINE static inline void hwfifo_send(uint8_t rhport, const uint8_t* buffer, uint8_t len, bool in_isr) {
+TU_ATTR_ALWAYS_INLINE static inline void hwfifo_send(uint8_t rhport, const uint8_t* buffer, uint8_t len) {
   if (len) {
-    hwfifo_write(rhport, SNDFIFO_ADDR, buffer, len, in_isr);
+    hwfifo_write(rhport, SNDFIFO_ADDR, buffer, len);
   }
-  sndbc_write(rhport, len, in_isr);
+  sndbc_write(rhport, len);
 }
 
-TU_ATTR_ALWAYS_INLINE static inline void hwfifo_setup(uint8_t rhport, const uint8_t* buffer, bool in_isr) {
-  hwfifo_write(rhport, SUDFIFO_ADDR, buffer, 8, in_isr);
+TU_ATTR_ALWAYS_INLINE static inline void hwfifo_setup(uint8_t rhport, const uint8_t* buffer) {
+  hwfifo_write(rhport, SUDFIFO_ADDR, buffer, 8);
 }
 
-static void hwfifo_receive(uint8_t rhport, uint8_t * buffer, uint16_t len, bool in_isr) {
+static void hwfifo_receive(uint8_t rhport, uint8_t * buffer, uint16_t len) {
   uint8_t hirq;
   uint8_t const reg = RCVVFIFO_ADDR;
 
-  max3421_spi_lock(rhport, in_isr);
-
+  tuh_max3421_spi_cs_api(rhport, true);
   tuh_max3421_spi_xfer_api(rhport, &reg, &hirq, 1);
-  _hcd_data.hirq = hirq;
   tuh_max3421_spi_xfer_api(rhport, NULL, buffer, len);
+  tuh_max3421_spi_cs_api(rhport, false);
 
-  max3421_spi_unlock(rhport, in_isr);
+  _hcd_data.hirq = hirq;
 }
 
 //--------------------------------------------------------------------+
@@ -512,38 +521,44 @@ bool hcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
 
   // NOTE: driver does not seem to work without nRST pin signal
 
+  max3421_spi_lock(rhport, false);
+
   // full duplex, interrupt negative edge
-  reg_write(rhport, PINCTL_ADDR, _tuh_cfg.pinctl | PINCTL_FDUPSPI, false);
+  reg_write(rhport, PINCTL_ADDR, _tuh_cfg.pinctl | PINCTL_FDUPSPI);
 
   // v1 is 0x01, v2 is 0x12, v3 is 0x13
   // Note: v1 and v2 has host OUT errata whose workaround is not implemented in this driver
-  uint8_t const revision = reg_read(rhport, REVISION_ADDR, false);
+  uint8_t const revision = reg_read(rhport, REVISION_ADDR);
   TU_LOG2_HEX(revision);
-  TU_ASSERT(revision == 0x01 || revision == 0x12 || revision == 0x13, false);
+  if (!(revision == 0x01 || revision == 0x12 || revision == 0x13)) {
+    max3421_spi_unlock(rhport, false);
+    TU_ASSERT(false);
+  }
 
   // reset
-  reg_write(rhport, USBCTL_ADDR, USBCTL_CHIPRES, false);
-  reg_write(rhport, USBCTL_ADDR, 0, false);
-  while( !(reg_read(rhport, USBIRQ_ADDR, false) & USBIRQ_OSCOK_IRQ) ) {
+  reg_write(rhport, USBCTL_ADDR, USBCTL_CHIPRES);
+  reg_write(rhport, USBCTL_ADDR, 0);
+  while( !(reg_read(rhport, USBIRQ_ADDR) & USBIRQ_OSCOK_IRQ) ) {
     // wait for oscillator to stabilize
   }
 
   // Mode: Host and DP/DM pull down
-  mode_write(rhport, MODE_DPPULLDN | MODE_DMPULLDN | MODE_HOST, false);
+  mode_write(rhport, MODE_DPPULLDN | MODE_DMPULLDN | MODE_HOST);
 
   // frame reset & bus reset, this will trigger CONDET IRQ if device is already connected
-  reg_write(rhport, HCTL_ADDR, HCTL_BUSRST | HCTL_FRMRST, false);
+  reg_write(rhport, HCTL_ADDR, HCTL_BUSRST | HCTL_FRMRST);
 
   // clear all previously pending IRQ
-  hirq_write(rhport, 0xff, false);
+  hirq_write(rhport, 0xff);
 
   // Enable IRQ
-  hien_write(rhport, DEFAULT_HIEN, false);
-
-  tuh_max3421_int_api(rhport, true);
+  hien_write(rhport, DEFAULT_HIEN);
 
   // Enable Interrupt pin
-  reg_write(rhport, CPUCTL_ADDR, _tuh_cfg.cpuctl | CPUCTL_IE, false);
+  reg_write(rhport, CPUCTL_ADDR, _tuh_cfg.cpuctl | CPUCTL_IE);
+
+  // unlock also enables interrupt
+  max3421_spi_unlock(rhport, false);
 
   return true;
 }
@@ -555,8 +570,8 @@ bool hcd_deinit(uint8_t rhport) {
   tuh_max3421_int_api(rhport, false);
 
   // reset max3421 and power down
-  reg_write(rhport, USBCTL_ADDR, USBCTL_CHIPRES, false);
-  reg_write(rhport, USBCTL_ADDR, USBCTL_PWRDOWN, false);
+  tuh_max3421_reg_write(rhport, USBCTL_ADDR, USBCTL_CHIPRES, false);
+  tuh_max3421_reg_write(rhport, USBCTL_ADDR, USBCTL_PWRDOWN, false);
 
   #if OSAL_MUTEX_REQUIRED
   osal_mutex_delete(_hcd_data.spi_mutex);
@@ -597,12 +612,12 @@ bool hcd_port_connect_status(uint8_t rhport) {
 // Reset USB bus on the port. Return immediately, bus reset sequence may not be complete.
 // Some port would require hcd_port_reset_end() to be invoked after 10ms to complete the reset sequence.
 void hcd_port_reset(uint8_t rhport) {
-  reg_write(rhport, HCTL_ADDR, HCTL_BUSRST, false);
+  tuh_max3421_reg_write(rhport, HCTL_ADDR, HCTL_BUSRST, false);
 }
 
 // Complete bus reset sequence, may be required by some controllers
 void hcd_port_reset_end(uint8_t rhport) {
-  reg_write(rhport, HCTL_ADDR, 0, false);
+  tuh_max3421_reg_write(rhport, HCTL_ADDR, 0, false);
 }
 
 // Get port link speed
@@ -665,67 +680,69 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t daddr, tusb_desc_endpoint_t const * e
                                                +-----------+
   Note: xact_out() is called when starting a new transfer, continue a transfer (isr) or retry a transfer (NAK)
         For NAK retry, we do not need to write to FIFO or SNDBC register again.
+
+  xact_*() issue the register writes + FIFO fill + HXFR kick of a transaction as one batch, SPI bus must be locked.
 */
-static void xact_out(uint8_t rhport, max3421_ep_t *ep, bool switch_ep, bool in_isr) {
+static void xact_out(uint8_t rhport, max3421_ep_t *ep, bool switch_ep) {
   // Page 12: Programming BULK-OUT Transfers
   // TODO: double buffering for ISO transfer
   if (switch_ep) {
-    peraddr_write(rhport, ep->daddr, in_isr);
+    peraddr_write(rhport, ep->daddr);
     const uint8_t hctl = (ep->data_toggle ? HCTL_SNDTOG1 : HCTL_SNDTOG0);
-    reg_write(rhport, HCTL_ADDR, hctl, in_isr);
+    reg_write(rhport, HCTL_ADDR, hctl);
   }
 
   // Only write to sndfifo and sdnbc register if it is not a NAKed retry
   if (!(ep->daddr == _hcd_data.sndfifo_owner.daddr && ep->hxfr == _hcd_data.sndfifo_owner.hxfr)) {
     // skip SNDBAV IRQ check, overwrite sndfifo if needed
     const uint8_t xact_len = (uint8_t) tu_min16(ep->total_len - ep->xferred_len, ep->packet_size);
-    hwfifo_send(rhport, ep->buf, xact_len, in_isr);
+    hwfifo_send(rhport, ep->buf, xact_len);
   }
   _hcd_data.sndfifo_owner.daddr = ep->daddr;
   _hcd_data.sndfifo_owner.hxfr = ep->hxfr;
 
-  hxfr_write(rhport, ep->hxfr, in_isr);
+  hxfr_write(rhport, ep->hxfr);
 }
 
-static void xact_in(uint8_t rhport, max3421_ep_t *ep, bool switch_ep, bool in_isr) {
+static void xact_in(uint8_t rhport, max3421_ep_t *ep, bool switch_ep) {
   // Page 13: Programming BULK-IN Transfers
   if (switch_ep) {
-    peraddr_write(rhport, ep->daddr, in_isr);
+    peraddr_write(rhport, ep->daddr);
 
     uint8_t const hctl = (ep->data_toggle ? HCTL_RCVTOG1 : HCTL_RCVTOG0);
-    reg_write(rhport, HCTL_ADDR, hctl, in_isr);
+    reg_write(rhport, HCTL_ADDR, hctl);
   }
 
-  hxfr_write(rhport, ep->hxfr, in_isr);
+  hxfr_write(rhport, ep->hxfr);
 }
 
-static void xact_setup(uint8_t rhport, max3421_ep_t *ep, bool in_isr) {
-  peraddr_write(rhport, ep->daddr, in_isr);
-  hwfifo_setup(rhport, ep->buf, in_isr);
-  hxfr_write(rhport, HXFR_SETUP, in_isr);
+static void xact_setup(uint8_t rhport, max3421_ep_t *ep) {
+  peraddr_write(rhport, ep->daddr);
+  hwfifo_setup(rhport, ep->buf);
+  hxfr_write(rhport, HXFR_SETUP);
 }
 
-static void xact_generic(uint8_t rhport, max3421_ep_t *ep, bool switch_ep, bool in_isr) {
+static void xact_generic(uint8_t rhport, max3421_ep_t *ep, bool switch_ep) {
   if (ep->hxfr_bm.ep_num == 0 ) {
     // setup
     if (ep->hxfr_bm.is_setup) {
-      xact_setup(rhport, ep, in_isr);
+      xact_setup(rhport, ep);
       return;
     }
 
     // status
     if (ep->buf == NULL || ep->total_len == 0) {
       const uint8_t hxfr = (uint8_t) (HXFR_HS | (ep->hxfr & HXFR_OUT_NIN));
-      peraddr_write(rhport, ep->daddr, in_isr);
-      hxfr_write(rhport, hxfr, in_isr);
+      peraddr_write(rhport, ep->daddr);
+      hxfr_write(rhport, hxfr);
       return;
     }
   }
 
   if (ep->hxfr_bm.is_out) {
-    xact_out(rhport, ep, switch_ep, in_isr);
+    xact_out(rhport, ep, switch_ep);
   }else {
-    xact_in(rhport, ep, switch_ep, in_isr);
+    xact_in(rhport, ep, switch_ep);
   }
 }
 
@@ -750,7 +767,9 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t daddr, uint8_t ep_addr, uint8_t * buf
 
   // carry out transfer if not busy
   if (!atomic_flag_test_and_set(&_hcd_data.busy)) {
-    xact_generic(rhport, ep, true, false);
+    max3421_spi_lock(rhport, false);
+    xact_generic(rhport, ep, true);
+    max3421_spi_unlock(rhport, false);
   }
 
   return true;
@@ -773,8 +792,6 @@ bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t daddr, uint8_t ep_addr) {
 
 // Submit a special transfer to send 8-byte Setup Packet, when complete hcd_event_xfer_complete() must be invoked
 bool hcd_setup_send(uint8_t rhport, uint8_t daddr, uint8_t const setup_packet[8]) {
-  (void) rhport;
-
   max3421_ep_t* ep = find_opened_ep(daddr, 0, 0);
   TU_ASSERT(ep);
 
@@ -787,7 +804,9 @@ bool hcd_setup_send(uint8_t rhport, uint8_t daddr, uint8_t const setup_packet[8]
 
   // carry out transfer if not busy
   if (!atomic_flag_test_and_set(&_hcd_data.busy)) {
-    xact_setup(rhport, ep, false);
+    max3421_spi_lock(rhport, false);
+    xact_setup(rhport, ep);
+    max3421_spi_unlock(rhport, false);
   }
 
   return true;
@@ -807,7 +826,7 @@ bool hcd_edpt_clear_stall(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
 //--------------------------------------------------------------------+
 
 static void handle_connect_irq(uint8_t rhport, bool in_isr) {
-  uint8_t const hrsl = reg_read(rhport, HRSL_ADDR, in_isr);
+  uint8_t const hrsl = reg_read(rhport, HRSL_ADDR);
   uint8_t const jk = hrsl & (HRSL_JSTATUS | HRSL_KSTATUS);
 
   uint8_t new_mode = MODE_DPPULLDN | MODE_DMPULLDN | MODE_HOST;
@@ -816,12 +835,12 @@ static void handle_connect_irq(uint8_t rhport, bool in_isr) {
   switch(jk) {
     case 0x00:                          // SEO is disconnected
     case (HRSL_JSTATUS | HRSL_KSTATUS): // SE1 is illegal
-      mode_write(rhport, new_mode, in_isr);
+      mode_write(rhport, new_mode);
 
       // port reset anyway, this will help to stable bus signal for next connection
-      reg_write(rhport, HCTL_ADDR, HCTL_BUSRST, in_isr);
+      reg_write(rhport, HCTL_ADDR, HCTL_BUSRST);
       hcd_event_device_remove(rhport, in_isr);
-      reg_write(rhport, HCTL_ADDR, 0, in_isr);
+      reg_write(rhport, HCTL_ADDR, 0);
       break;
 
     default: {
@@ -839,7 +858,7 @@ static void handle_connect_irq(uint8_t rhport, bool in_isr) {
         TU_LOG3("Full speed\r\n");
       }
       new_mode |= MODE_SOFKAENAB;
-      mode_write(rhport, new_mode, in_isr);
+      mode_write(rhport, new_mode);
 
       // FIXME multiple MAX3421 rootdevice address is not 1
       uint8_t const daddr = 1;
@@ -868,7 +887,7 @@ static void xfer_complete_isr(uint8_t rhport, max3421_ep_t *ep, xfer_result_t re
   // Find next pending endpoint
   max3421_ep_t * next_ep = find_next_pending_ep(ep);
   if (next_ep) {
-    xact_generic(rhport, next_ep, true, in_isr);
+    xact_generic(rhport, next_ep, true);
   }else {
     // no more pending
     atomic_flag_clear(&_hcd_data.busy);
@@ -876,7 +895,7 @@ static void xfer_complete_isr(uint8_t rhport, max3421_ep_t *ep, xfer_result_t re
 }
 
 static void handle_xfer_done(uint8_t rhport, bool in_isr) {
-  const uint8_t hrsl = reg_read(rhport, HRSL_ADDR, in_isr);
+  const uint8_t hrsl = reg_read(rhport, HRSL_ADDR);
   const uint8_t hresult = hrsl & HRSL_RESULT_MASK;
   const uint8_t ep_num = _hcd_data.hxfr_bm.ep_num;
   const uint8_t hxfr_type = _hcd_data.hxfr & 0xf0;
@@ -893,7 +912,7 @@ static void handle_xfer_done(uint8_t rhport, bool in_isr) {
       } else {
         if (ep_num == 0) {
           // control endpoint -> retry immediately and return
-          hxfr_write(rhport, _hcd_data.hxfr, in_isr);
+          hxfr_write(rhport, _hcd_data.hxfr);
           return;
         }
         if (EP_STATE_ATTEMPT_1 <= ep->state && ep->state < EP_STATE_ATTEMPT_MAX) {
@@ -904,10 +923,10 @@ static void handle_xfer_done(uint8_t rhport, bool in_isr) {
       max3421_ep_t * next_ep = find_next_pending_ep(ep);
       if (ep == next_ep) {
         // this endpoint is only one pending -> retry immediately
-        hxfr_write(rhport, _hcd_data.hxfr, in_isr);
+        hxfr_write(rhport, _hcd_data.hxfr);
       } else if (next_ep) {
         // switch to next pending endpoint
-        xact_generic(rhport, next_ep, true, in_isr);
+        xact_generic(rhport, next_ep, true);
       } else {
         // no more pending in this frame -> clear busy
         atomic_flag_clear(&_hcd_data.busy);
@@ -949,7 +968,7 @@ static void handle_xfer_done(uint8_t rhport, bool in_isr) {
     if (ep->state == EP_STATE_COMPLETE) {
       xfer_complete_isr(rhport, ep, xfer_result, hrsl, in_isr);
     }else {
-      hxfr_write(rhport, _hcd_data.hxfr, in_isr); // more to transfer
+      hxfr_write(rhport, _hcd_data.hxfr); // more to transfer
     }
   } else {
     // SETUP or OUT transfer
@@ -974,7 +993,7 @@ static void handle_xfer_done(uint8_t rhport, bool in_isr) {
     if (xact_len < ep->packet_size || ep->xferred_len >= ep->total_len) {
       xfer_complete_isr(rhport, ep, xfer_result, hrsl, in_isr);
     } else {
-      xact_out(rhport, ep, false, in_isr); // more to transfer
+      xact_out(rhport, ep, false); // more to transfer
     }
   }
 }
@@ -998,10 +1017,15 @@ void print_hirq(uint8_t hirq) {
   #define print_hirq(hirq)
 #endif
 
-// Interrupt handler
+// Interrupt handler: all SPI transactions are done within one lock
 void hcd_int_handler(uint8_t rhport, bool in_isr) {
-  uint8_t hirq = reg_read(rhport, HIRQ_ADDR, in_isr) & _hcd_data.hien;
-  if (!hirq) return;
+  max3421_spi_lock(rhport, in_isr);
+
+  uint8_t hirq = reg_read(rhport, HIRQ_ADDR) & _hcd_data.hien;
+  if (!hirq) {
+    max3421_spi_unlock(rhport, in_isr);
+    return;
+  }
 //  print_hirq(hirq);
 
   if (hirq & HIRQ_FRAME_IRQ) {
@@ -1022,7 +1046,7 @@ void hcd_int_handler(uint8_t rhport, bool in_isr) {
 
     // start usb transfer if not busy
     if (ep_retry != NULL && !atomic_flag_test_and_set(&_hcd_data.busy)) {
-      xact_generic(rhport, ep_retry, true, in_isr);
+      xact_generic(rhport, ep_retry, true);
     }
   }
 
@@ -1040,17 +1064,17 @@ void hcd_int_handler(uint8_t rhport, bool in_isr) {
 
       // RCVDAV_IRQ can trigger 2 times (dual buffered)
       while (hirq & HIRQ_RCVDAV_IRQ) {
-        const uint8_t rcvbc = reg_read(rhport, RCVBC_ADDR, in_isr);
+        const uint8_t rcvbc = reg_read(rhport, RCVBC_ADDR);
         xact_len = (uint8_t) tu_min16(rcvbc, ep->total_len - ep->xferred_len);
         if (xact_len) {
-          hwfifo_receive(rhport, ep->buf, xact_len, in_isr);
+          hwfifo_receive(rhport, ep->buf, xact_len);
           ep->buf += xact_len;
           ep->xferred_len += xact_len;
         }
 
-        // ack RCVDVAV IRQ
-        hirq_write(rhport, HIRQ_RCVDAV_IRQ, in_isr);
-        hirq = reg_read(rhport, HIRQ_ADDR, in_isr);
+        // ack RCVDVAV IRQ, read HIRQ again since 2nd buffer may re-assert RCVDAV right after clearing
+        hirq_write(rhport, HIRQ_RCVDAV_IRQ);
+        hirq = reg_read(rhport, HIRQ_ADDR);
       }
 
       if (xact_len < ep->packet_size || ep->xferred_len >= ep->total_len) {
@@ -1059,18 +1083,22 @@ void hcd_int_handler(uint8_t rhport, bool in_isr) {
     }
 
     if (hirq & HIRQ_HXFRDN_IRQ) {
-      hirq_write(rhport, HIRQ_HXFRDN_IRQ, in_isr);
+      hirq_write(rhport, HIRQ_HXFRDN_IRQ);
       handle_xfer_done(rhport, in_isr);
-    }
 
-    hirq = reg_read(rhport, HIRQ_ADDR, in_isr);
+      // next transaction may be kicked off and already done, read HIRQ again
+      hirq = reg_read(rhport, HIRQ_ADDR);
+    }
+    // else hirq is already up to date by the HIRQ read when handling RCVDAV
   }
 
   // clear all interrupt except SNDBAV_IRQ (never clear by us). Note RCVDAV_IRQ, HXFRDN_IRQ already clear while processing
   hirq &= (uint8_t) ~HIRQ_SNDBAV_IRQ;
   if (hirq) {
-    hirq_write(rhport, hirq, in_isr);
+    hirq_write(rhport, hirq);
   }
+
+  max3421_spi_unlock(rhport, in_isr);
 }
 
 #endif
@@ -807,7 +807,7 @@ void dcd_edpt_close_all(uint8_t rhport)
 }
 
 // Submit a transfer, When complete dcd_event_xfer_complete() is invoked to notify the stack
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint32_t total_bytes)
 {
   (void)rhport;
   uint8_t ep_number = tu_edpt_number(ep_addr);
@@ -825,8 +825,8 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
   // Transfer currently in progress.
   if (ep_xfer[ep_number].valid == 0)
   {
-    ep_xfer[ep_number].total_size = total_bytes;
-    ep_xfer[ep_number].remain_size = total_bytes;
+    ep_xfer[ep_number].total_size = (int16_t) total_bytes;
+    ep_xfer[ep_number].remain_size = (int16_t) total_bytes;
     ep_xfer[ep_number].buff_ptr = buffer;
 
     if (ep_number == USBD_EP_0)
@@ -844,7 +844,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
     {
       // For IN transfers send the first packet as a starter. Interrupt handler to complete
       // this if it is larger than one packet.
-      xfer_bytes = _ft9xx_edpt_xfer_in(ep_number, buffer, total_bytes);
+      xfer_bytes = _ft9xx_edpt_xfer_in(ep_number, buffer, (uint16_t) total_bytes);
 
       ep_xfer[ep_number].buff_ptr += xfer_bytes;
       ep_xfer[ep_number].remain_size -= xfer_bytes;
@@ -866,7 +866,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
         ep_xfer[ep_number].ready = 0;
 
         // Transfer incoming data from an OUT packet to the buffer.
-        xfer_bytes = _ft9xx_edpt_xfer_out(ep_number, buffer, total_bytes);
+        xfer_bytes = _ft9xx_edpt_xfer_out(ep_number, buffer, (uint16_t) total_bytes);
 
         // Report completion of the transfer.
         dcd_event_xfer_complete(BOARD_TUD_RHPORT, ep_number /*| TUSB_DIR_OUT_MASK */, xfer_bytes, XFER_RESULT_SUCCESS, false);
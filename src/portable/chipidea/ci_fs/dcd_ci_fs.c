@@ -419,7 +419,7 @@ void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr)
   dcd_int_enable(rhport);
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes)
 {
   const unsigned epn      = tu_edpt_number(ep_addr);
   const unsigned dir      = tu_edpt_dir(ep_addr);
@@ -429,8 +429,8 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
 
   dcd_int_disable(rhport);
 
-  ep->length    = total_bytes;
-  ep->remaining = total_bytes;
+  ep->length    = (uint16_t) total_bytes;
+  ep->remaining = (uint16_t) total_bytes;
 
   const unsigned mps = ep->max_packet_size;
   if (total_bytes > mps) {
@@ -114,7 +114,8 @@ typedef struct
   // Therefore there are 4 bytes padding that we can use.
   //--------------------------------------------------------------------+
   uint16_t expected_bytes;
-  uint8_t reserved[2];
+  uint8_t xfer_end; // last qTD of a transfer
+  uint8_t reserved;
 } dcd_qtd_t;
 
 TU_VERIFY_STATIC( sizeof(dcd_qtd_t) == 32, "size is not correct");
@@ -144,7 +145,10 @@ typedef struct
   // Therefore there are 16 bytes padding that we can use.
   //--------------------------------------------------------------------+
   tu_fifo_t * ff;
-  uint8_t reserved[12];
+  uint32_t xferred_bytes; // accumulated by retired qTDs of current transfer
+  uint8_t qtd_rd;         // oldest linked qTD
+  uint8_t qtd_count;      // number of linked qTDs not yet retired
+  uint8_t reserved[6];
 } dcd_qhd_t;
 
 TU_VERIFY_STATIC( sizeof(dcd_qhd_t) == 64, "size is not correct");
@@ -154,13 +158,17 @@ TU_VERIFY_STATIC( sizeof(dcd_qhd_t) == 64, "size is not correct");
 //--------------------------------------------------------------------+
 
 #define QTD_NEXT_INVALID 0x01
+#define QTD_PER_EP       CFG_TUD_CI_HS_QTD_PER_EP
+
+TU_VERIFY_STATIC(QTD_PER_EP > 0 && QTD_PER_EP < 256, "invalid qTD per endpoint");
 
 typedef struct {
   // Must be at 2K alignment
   // Each endpoint with direction (IN/OUT) occupies a queue head
-  // for portability, TinyUSB only queue 1 TD for each Qhd
+  // Each Qhd has a ring of qTDs, a transfer is split into multiple qTDs (linked together for IN), and more
+  // IN transfers can be linked behind while it is active.
   dcd_qhd_t qhd[TUP_DCD_ENDPOINT_MAX][2] TU_ATTR_ALIGNED(64);
-  dcd_qtd_t qtd[TUP_DCD_ENDPOINT_MAX][2] TU_ATTR_ALIGNED(32);
+  dcd_qtd_t qtd[TUP_DCD_ENDPOINT_MAX][2][QTD_PER_EP] TU_ATTR_ALIGNED(32);
 }dcd_data_t;
 
 CFG_TUD_MEM_SECTION TU_ATTR_ALIGNED(2048)
@@ -176,6 +184,21 @@ static inline uint8_t ci_ep_count(ci_hs_regs_t const* dcd_reg)
   return dcd_reg->DCCPARAMS & DCCPARAMS_DEN_MASK;
 }
 
+TU_ATTR_ALWAYS_INLINE
+static inline dcd_qtd_t* qtd_get(uint8_t epnum, uint8_t dir, uint8_t idx)
+{
+  return &_dcd_data.qtd[epnum][dir][idx % QTD_PER_EP];
+}
+
+// Drop all linked qTDs of an endpoint, used when its transfers are aborted
+TU_ATTR_ALWAYS_INLINE
+static inline void qhd_reset_qtd(dcd_qhd_t* p_qhd)
+{
+  p_qhd->qtd_rd        = 0;
+  p_qhd->qtd_count     = 0;
+  p_qhd->xferred_bytes = 0;
+}
+
 //--------------------------------------------------------------------+
 // Controller API
 //--------------------------------------------------------------------+
@@ -339,6 +362,67 @@ static void qtd_init(dcd_qtd_t* p_qtd, void * data_ptr, uint16_t total_bytes)
   }
 }
 
+// Largest number of bytes a qTD can hold when its buffer starts at page_offset within a 4K page. It is kept to
+// multiple of max packet size so that only the last qTD of a transfer can end with a short packet.
+static uint16_t qtd_max_bytes(uint32_t page_offset, uint16_t max_packet_size)
+{
+  uint32_t const len = 5*4096u - page_offset;
+  return (uint16_t) (len - (len % max_packet_size));
+}
+
+// Split a transfer into qTDs taken from the endpoint's ring. IN qTDs are linked together, OUT qTDs are primed
+// one at a time by process_edpt_complete_isr() since a short packet ends the transfer in any of them.
+// Return the first qTD or NULL if there is not enough free qTDs.
+static dcd_qtd_t* qtd_chain_xfer(uint8_t epnum, uint8_t dir, uint8_t* buffer, uint32_t total_bytes)
+{
+  dcd_qhd_t* p_qhd = &_dcd_data.qhd[epnum][dir];
+  uint16_t const mps = p_qhd->max_packet_size;
+
+  uint32_t remain = total_bytes;
+  uint8_t* data_ptr = buffer;
+  uint8_t qtd_num = 0;
+  do {
+    uint32_t const len = tu_min32(remain, qtd_max_bytes(tu_offset4k((uint32_t) data_ptr), mps));
+    remain -= len;
+    data_ptr += len;
+    qtd_num++;
+  } while (remain && qtd_num + p_qhd->qtd_count < QTD_PER_EP);
+
+  TU_VERIFY(remain == 0 && qtd_num + p_qhd->qtd_count <= QTD_PER_EP, NULL);
+
+  uint8_t idx = (uint8_t) (p_qhd->qtd_rd + p_qhd->qtd_count);
+  dcd_qtd_t* first = qtd_get(epnum, dir, idx);
+  dcd_qtd_t* prev = NULL;
+
+  remain = total_bytes;
+  data_ptr = buffer;
+  for (uint8_t i = 0; i < qtd_num; i++) {
+    dcd_qtd_t* p_qtd = qtd_get(epnum, dir, idx++);
+    uint16_t const len = (uint16_t) tu_min32(remain, qtd_max_bytes(tu_offset4k((uint32_t) data_ptr), mps));
+    bool const is_last = (i == qtd_num - 1);
+
+    qtd_init(p_qtd, data_ptr, len);
+    p_qtd->xfer_end = is_last ? 1 : 0;
+
+    // OUT transfer can end early with a short packet in any of its qTDs, we need to know when that happens
+    p_qtd->int_on_complete = (is_last || dir == TUSB_DIR_OUT) ? 1 : 0;
+
+    if (prev) {
+      if (dir == TUSB_DIR_IN) prev->next = (uint32_t) p_qtd;
+      dcd_dcache_clean_invalidate(prev, sizeof(dcd_qtd_t));
+    }
+    prev = p_qtd;
+
+    remain -= len;
+    data_ptr += len;
+  }
+  dcd_dcache_clean_invalidate(prev, sizeof(dcd_qtd_t));
+
+  p_qhd->qtd_count = (uint8_t) (p_qhd->qtd_count + qtd_num);
+
+  return first;
+}
+
 //--------------------------------------------------------------------+
 // DCD Endpoint Port
 //--------------------------------------------------------------------+
@@ -352,6 +436,7 @@ void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr)
 
   // flush to abort any primed buffer
   dcd_reg->ENDPTFLUSH = TU_BIT(epnum + (dir ? 16 : 0));
+  qhd_reset_qtd(&_dcd_data.qhd[epnum][dir]);
 }
 
 void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr)
@@ -388,7 +473,7 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * p_endpoint_desc)
 
   p_qhd->qtd_overlay.next        = QTD_NEXT_INVALID;
 
-  dcd_dcache_clean_invalidate(&_dcd_data, sizeof(dcd_data_t));
+  dcd_dcache_clean_invalidate(p_qhd, sizeof(dcd_qhd_t));
 
   // Enable EP Control
   uint32_t const epctrl = (p_endpoint_desc->bmAttributes.xfer << ENDPTCTRL_TYPE_POS) | ENDPTCTRL_ENABLE | ENDPTCTRL_TOGGLE_RESET;
@@ -414,6 +499,8 @@ void dcd_edpt_close_all (uint8_t rhport)
   {
     _dcd_data.qhd[epnum][TUSB_DIR_OUT].qtd_overlay.halted = 1;
     _dcd_data.qhd[epnum][TUSB_DIR_IN ].qtd_overlay.halted = 1;
+    qhd_reset_qtd(&_dcd_data.qhd[epnum][TUSB_DIR_OUT]);
+    qhd_reset_qtd(&_dcd_data.qhd[epnum][TUSB_DIR_IN]);
 
     dcd_reg->ENDPTFLUSH = TU_BIT(epnum) |  TU_BIT(epnum+16);
     dcd_reg->ENDPTCTRL[epnum] = (TUSB_XFER_BULK << ENDPTCTRL_TYPE_POS) | (TUSB_XFER_BULK << (16+ENDPTCTRL_TYPE_POS));
@@ -433,22 +520,22 @@ void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr)
   uint32_t const flush_mask = TU_BIT(epnum + (dir ? 16 : 0));
   dcd_reg->ENDPTFLUSH = flush_mask;
   while(dcd_reg->ENDPTFLUSH & flush_mask);
+  qhd_reset_qtd(&_dcd_data.qhd[epnum][dir]);
 
   // Clear EP enable
   dcd_reg->ENDPTCTRL[epnum] &=~(ENDPTCTRL_ENABLE << (dir ? 16 : 0));
 }
 
-static void qhd_start_xfer(uint8_t rhport, uint8_t epnum, uint8_t dir)
+static void qhd_start_xfer(uint8_t rhport, uint8_t epnum, uint8_t dir, dcd_qtd_t* p_qtd)
 {
   ci_hs_regs_t* dcd_reg = CI_HS_REG(rhport);
   dcd_qhd_t* p_qhd = &_dcd_data.qhd[epnum][dir];
-  dcd_qtd_t* p_qtd = &_dcd_data.qtd[epnum][dir];
 
   p_qhd->qtd_overlay.halted = false;            // clear any previous error
   p_qhd->qtd_overlay.next   = (uint32_t) p_qtd; // link qtd to qhd
 
-  // flush cache
-  dcd_dcache_clean_invalidate(&_dcd_data, sizeof(dcd_data_t));
+  // flush cache, qTDs are already cleaned when prepared
+  dcd_dcache_clean_invalidate(p_qhd, sizeof(dcd_qhd_t));
 
   if ( epnum == 0 )
   {
@@ -461,24 +548,84 @@ static void qhd_start_xfer(uint8_t rhport, uint8_t epnum, uint8_t dir)
   dcd_reg->ENDPTPRIME = TU_BIT(epnum + (dir ? 16 : 0));
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes)
+// Link qTDs behind the last one of an endpoint which may be still active.
+// Follows "Adding dTD to a non-empty list" using the Add dTD TripWire semaphore
+static void qhd_append_xfer(uint8_t rhport, uint8_t epnum, uint8_t dir, dcd_qtd_t* last, dcd_qtd_t* first)
+{
+  ci_hs_regs_t* dcd_reg = CI_HS_REG(rhport);
+  uint32_t const ep_bit = TU_BIT(epnum + (dir ? 16 : 0));
+
+  last->next = (uint32_t) first;
+  dcd_dcache_clean_invalidate(last, sizeof(dcd_qtd_t));
+
+  // still primed, controller will pick up the new qTDs
+  if (dcd_reg->ENDPTPRIME & ep_bit) return;
+
+  // Read endpoint status while tripwire is set, repeat if controller cleared it i.e qhd was updated in between
+  uint32_t ep_status;
+  do {
+    dcd_reg->USBCMD |= USBCMD_ADD_QTD_TRIPWIRE;
+    ep_status = dcd_reg->ENDPTSTAT & ep_bit;
+  } while (!(dcd_reg->USBCMD & USBCMD_ADD_QTD_TRIPWIRE));
+  dcd_reg->USBCMD &= ~USBCMD_ADD_QTD_TRIPWIRE;
+
+  // controller already reached the end of list before seeing the new qTDs, prime them
+  if (!ep_status) {
+    qhd_start_xfer(rhport, epnum, dir, first);
+  }
+}
+
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes)
 {
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
   dcd_qhd_t* p_qhd = &_dcd_data.qhd[epnum][dir];
-  dcd_qtd_t* p_qtd = &_dcd_data.qtd[epnum][dir];
 
-  // Prepare qtd
-  qtd_init(p_qtd, buffer, total_bytes);
+  // Control endpoint is never linked: a new setup packet aborts its previous stage
+  if (epnum == 0) {
+    qhd_reset_qtd(p_qhd);
+  }
+
+  // OUT transfer is not linked behind an active one, see dcd_edpt_xfer_append()
+  uint8_t const linked = p_qhd->qtd_count;
+  TU_VERIFY(linked == 0 || dir == TUSB_DIR_IN);
+  dcd_qtd_t* last = linked ? qtd_get(epnum, dir, (uint8_t) (p_qhd->qtd_rd + linked - 1)) : NULL;
+
+  // Prepare qtds
+  dcd_qtd_t* first = qtd_chain_xfer(epnum, dir, buffer, total_bytes);
+  TU_VERIFY(first);
 
-  // Start qhd transfer
   p_qhd->ff = NULL;
-  qhd_start_xfer(rhport, epnum, dir);
+  if (last) {
+    qhd_append_xfer(rhport, epnum, dir, last, first);
+  } else {
+    // Start qhd transfer
+    qhd_start_xfer(rhport, epnum, dir, first);
+  }
 
   return true;
 }
 
+// IN transfer is linked behind the active ones if there are enough free qTDs.
+// OUT transfer is not: a short packet ends the active transfer early and the controller moves on to the following
+// qTDs, data of the next transfer could then be received in the wrong buffer. Stack queues it instead.
+bool dcd_edpt_xfer_append(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes)
+{
+  TU_VERIFY(tu_edpt_number(ep_addr) != 0 && tu_edpt_dir(ep_addr) == TUSB_DIR_IN);
+  return dcd_edpt_xfer(rhport, ep_addr, buffer, total_bytes);
+}
+
+// A transfer can take all qTDs of the endpoint. Worst case each qTD buffer starts at the last byte of a 4K page.
+uint32_t dcd_edpt_xfer_max(uint8_t rhport, uint8_t ep_addr)
+{
+  (void) rhport;
+  uint16_t const mps = _dcd_data.qhd[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)].max_packet_size;
+  if (mps == 0) return UINT16_MAX;
+
+  return QTD_PER_EP * (uint32_t) qtd_max_bytes(4096u - 1, mps);
+}
+
 #if !CFG_TUD_MEM_DCACHE_ENABLE
 // fifo has to be aligned to 4k boundary
 // It's incompatible with dcache enabled transfer, since neither address nor size is aligned to cache line
@@ -488,7 +635,10 @@ bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
   dcd_qhd_t * p_qhd = &_dcd_data.qhd[epnum][dir];
-  dcd_qtd_t * p_qtd = &_dcd_data.qtd[epnum][dir];
+
+  // fifo transfer is not linked with other transfers
+  TU_VERIFY(p_qhd->qtd_count == 0);
+  dcd_qtd_t * p_qtd = qtd_get(epnum, dir, p_qhd->qtd_rd);
 
   tu_fifo_buffer_info_t fifo_info;
 
@@ -535,9 +685,13 @@ bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
     }
   }
 
+  p_qtd->xfer_end = 1;
+  p_qhd->qtd_count = 1;
+  dcd_dcache_clean_invalidate(p_qtd, sizeof(dcd_qtd_t));
+
   // Start qhd transfer
   p_qhd->ff = ff;
-  qhd_start_xfer(rhport, epnum, dir);
+  qhd_start_xfer(rhport, epnum, dir, p_qtd);
 
   return true;
 }
@@ -547,36 +701,92 @@ bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
 // ISR
 //--------------------------------------------------------------------+
 
+// Remove the oldest qTD from endpoint's ring
+TU_ATTR_ALWAYS_INLINE
+static inline void qhd_retire_qtd(dcd_qhd_t* p_qhd)
+{
+  p_qhd->qtd_rd = (uint8_t) ((p_qhd->qtd_rd + 1) % QTD_PER_EP);
+  p_qhd->qtd_count--;
+}
+
 static void process_edpt_complete_isr(uint8_t rhport, uint8_t epnum, uint8_t dir)
 {
   dcd_qhd_t * p_qhd = &_dcd_data.qhd[epnum][dir];
-  dcd_qtd_t * p_qtd = &_dcd_data.qtd[epnum][dir];
-
-  uint8_t result = p_qtd->halted ? XFER_RESULT_STALLED :
-      ( p_qtd->xact_err || p_qtd->buffer_err ) ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS;
 
-  if ( result != XFER_RESULT_SUCCESS )
+  // Retire qTDs in order. A transfer completes with its last qTD or earlier by an error or short packet (OUT).
+  // Note: dcd_edpt_xfer() can be invoked by dcd_event_xfer_complete() to link the next transfer.
+  while (p_qhd->qtd_count)
   {
-    ci_hs_regs_t* dcd_reg = CI_HS_REG(rhport);
-    // flush to abort error buffer
-    dcd_reg->ENDPTFLUSH = TU_BIT(epnum + (dir ? 16 : 0));
-  }
+    dcd_qtd_t * p_qtd = qtd_get(epnum, dir, p_qhd->qtd_rd);
+    if (p_qtd->active) break;
 
-  uint16_t const xferred_bytes = p_qtd->expected_bytes - p_qtd->total_bytes;
+    uint8_t const result = p_qtd->halted ? XFER_RESULT_STALLED :
+        ( p_qtd->xact_err || p_qtd->buffer_err ) ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS;
 
-  if (p_qhd->ff)
-  {
-    if (dir == TUSB_DIR_IN)
+    uint16_t const remain = (uint16_t) p_qtd->total_bytes;
+    bool const xfer_end = p_qtd->xfer_end;
+
+    p_qhd->xferred_bytes += (uint32_t) (p_qtd->expected_bytes - remain);
+    qhd_retire_qtd(p_qhd);
+
+    bool restart = false;
+    if ( !xfer_end )
     {
-      tu_fifo_advance_read_pointer(p_qhd->ff, xferred_bytes);
-    } else
+      // more qTDs of this transfer to go, OUT qTDs are not linked and primed one by one
+      if ( result == XFER_RESULT_SUCCESS && remain == 0 )
+      {
+        if (dir == TUSB_DIR_OUT) qhd_start_xfer(rhport, epnum, dir, qtd_get(epnum, dir, p_qhd->qtd_rd));
+        continue;
+      }
+
+      // Ended early by an error or a short packet (OUT). IN controller has moved on to the rest of this transfer's
+      // qTDs: abort them and prime transfers linked behind again. OUT remaining qTDs are not primed yet.
+      if (dir == TUSB_DIR_IN)
+      {
+        ci_hs_regs_t* dcd_reg = CI_HS_REG(rhport);
+        dcd_reg->ENDPTFLUSH = TU_BIT(epnum + (dir ? 16 : 0));
+        restart = true;
+      }
+      while (p_qhd->qtd_count)
+      {
+        bool const is_end = qtd_get(epnum, dir, p_qhd->qtd_rd)->xfer_end;
+        qhd_retire_qtd(p_qhd);
+        if (is_end) break;
+      }
+    }
+    else if ( result != XFER_RESULT_SUCCESS )
     {
-      tu_fifo_advance_write_pointer(p_qhd->ff, xferred_bytes);
+      ci_hs_regs_t* dcd_reg = CI_HS_REG(rhport);
+      // flush to abort error buffer
+      dcd_reg->ENDPTFLUSH = TU_BIT(epnum + (dir ? 16 : 0));
+      restart = true;
     }
-  }
 
-  // only number of bytes in the IOC qtd
-  dcd_event_xfer_complete(rhport, tu_edpt_addr(epnum, dir), xferred_bytes, result, true);
+    uint32_t const xferred_bytes = p_qhd->xferred_bytes;
+    p_qhd->xferred_bytes = 0;
+
+    if (p_qhd->ff)
+    {
+      if (dir == TUSB_DIR_IN)
+      {
+        tu_fifo_advance_read_pointer(p_qhd->ff, (uint16_t) xferred_bytes);
+      } else
+      {
+        tu_fifo_advance_write_pointer(p_qhd->ff, (uint16_t) xferred_bytes);
+      }
+    }
+
+    if ( restart && p_qhd->qtd_count )
+    {
+      ci_hs_regs_t* dcd_reg = CI_HS_REG(rhport);
+      while (dcd_reg->ENDPTFLUSH & TU_BIT(epnum + (dir ? 16 : 0))) {}
+
+      p_qhd->qtd_overlay.active = 0;
+      qhd_start_xfer(rhport, epnum, dir, qtd_get(epnum, dir, p_qhd->qtd_rd));
+    }
+
+    dcd_event_xfer_complete(rhport, tu_edpt_addr(epnum, dir), xferred_bytes, result, true);
+  }
 }
 
 void dcd_int_handler(uint8_t rhport)
@@ -664,6 +874,11 @@ void dcd_int_handler(uint8_t rhport)
     // in the same frame and we should handle previous status first.
     if (dcd_reg->ENDPTSETUPSTAT) {
       dcd_reg->ENDPTSETUPSTAT = dcd_reg->ENDPTSETUPSTAT;
+
+      // previous control transfer is over, drop its qTDs if any
+      qhd_reset_qtd(&_dcd_data.qhd[0][TUSB_DIR_OUT]);
+      qhd_reset_qtd(&_dcd_data.qhd[0][TUSB_DIR_IN]);
+
       dcd_event_setup_received(rhport, (uint8_t *) (uintptr_t) &_dcd_data.qhd[0][0].setup_request, true);
     }
   }
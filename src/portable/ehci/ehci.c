@@ -44,8 +44,19 @@
 // Debug level of EHCI
 #define EHCI_DBG     2
 
+// Isochronous endpoint and TD pools, isochronous support is disabled if CFG_TUH_EHCI_ISO_EP_MAX is 0.
+// Highspeed endpoint uses an iTD per frame, full-speed endpoint (with split transaction) uses a siTD per packet.
+#ifndef CFG_TUH_EHCI_ISO_EP_MAX
+  #define CFG_TUH_EHCI_ISO_EP_MAX  0
+#endif
+
 // Framelist size as small as possible to save SRAM
-#ifdef TUP_USBIP_CHIPIDEA_HS
+#if defined(TUP_USBIP_CHIPIDEA_HS) && CFG_TUH_EHCI_ISO_EP_MAX
+  // NXP Transdimension: 32 elements, isochronous transfers are scheduled ahead within frame list
+  #define FRAMELIST_SIZE_BIT_VALUE      5u
+  #define FRAMELIST_SIZE_USBCMD_VALUE   (((FRAMELIST_SIZE_BIT_VALUE &  3) << EHCI_USBCMD_FRAMELIST_SIZE_SHIFT) | \
+                                         ((FRAMELIST_SIZE_BIT_VALUE >> 2) << EHCI_USBCMD_CHIPIDEA_FRAMELIST_SIZE_MSB_SHIFT))
+#elif defined(TUP_USBIP_CHIPIDEA_HS)
   // NXP Transdimension: 8 elements
   #define FRAMELIST_SIZE_BIT_VALUE      7u
   #define FRAMELIST_SIZE_USBCMD_VALUE   (((FRAMELIST_SIZE_BIT_VALUE &  3) << EHCI_USBCMD_FRAMELIST_SIZE_SHIFT) | \
@@ -60,7 +71,31 @@
 
 // Total queue head pool. TODO should be user configurable and more optimize memory usage in the future
 #define QHD_MAX      (CFG_TUH_DEVICE_MAX*CFG_TUH_ENDPOINT_MAX + CFG_TUH_HUB)
-#define QTD_MAX      QHD_MAX
+
+// Total queue TD pool. A qTD covers at least 16KB, larger transfer is split into a chain of qTDs.
+// Transfers can also be queued back-to-back on the same queue head.
+#ifndef CFG_TUH_EHCI_QTD_MAX
+  #define CFG_TUH_EHCI_QTD_MAX  (2*QHD_MAX)
+#endif
+#define QTD_MAX      CFG_TUH_EHCI_QTD_MAX
+
+// Max bytes of a qTD with 5 page pointers
+#define QTD_PAGE_MAX_BYTES  (5*4096u)
+
+#ifndef CFG_TUH_EHCI_ITD_MAX
+  #define CFG_TUH_EHCI_ITD_MAX     EHCI_MAX_ITD
+#endif
+
+#ifndef CFG_TUH_EHCI_SITD_MAX
+  #define CFG_TUH_EHCI_SITD_MAX    EHCI_MAX_SITD
+#endif
+
+#define ISO_EP_MAX   CFG_TUH_EHCI_ISO_EP_MAX
+#define ITD_MAX      CFG_TUH_EHCI_ITD_MAX
+#define SITD_MAX     CFG_TUH_EHCI_SITD_MAX
+
+// Number of frames ahead of current frame to schedule isochronous TD, since HC may cache the frame list
+#define ISO_SCHEDULE_DELAY  2
 
 typedef struct
 {
@@ -80,6 +115,26 @@ typedef struct
   ehci_qhd_t qhd_pool[QHD_MAX];
   ehci_qtd_t qtd_pool[QTD_MAX] TU_ATTR_ALIGNED(32);
 
+  // Always inactive qTD, alternate pointer of chained IN qTD so that short packet stops the queue
+  ehci_qtd_t qtd_halt TU_ATTR_ALIGNED(32);
+
+  // extra data needed by TDs that can't fit in the TD struct
+  ehci_qtd_extra_t qtd_extra_control[CFG_TUH_DEVICE_MAX+CFG_TUH_HUB+1];
+  ehci_qtd_extra_t qtd_extra[QTD_MAX];
+
+  // Periodic bandwidth reserved in each micro-frame (highspeed) and each frame (full/low speed split)
+  // of the first EHCI_PERIOD_BW_FRAMES frames, schedule repeats afterward.
+  uint16_t period_bw[EHCI_PERIOD_BW_FRAMES][8];
+  uint16_t period_tt_bw[EHCI_PERIOD_BW_FRAMES];
+
+#if ISO_EP_MAX
+  ehci_itd_t  itd_pool[ITD_MAX];
+  ehci_sitd_t sitd_pool[SITD_MAX];
+  ehci_itd_extra_t itd_extra[ITD_MAX];
+
+  ehci_iso_ep_t iso_ep[ISO_EP_MAX];
+#endif
+
   ehci_registers_t* regs;         // operational register
   ehci_cap_registers_t* cap_regs; // capability register
 
@@ -137,12 +192,16 @@ TU_ATTR_ALWAYS_INLINE static inline ehci_qhd_t* qhd_next (ehci_qhd_t const * p_q
 TU_ATTR_ALWAYS_INLINE static inline ehci_qhd_t* qhd_find_free (void);
 static ehci_qhd_t* qhd_get_from_addr (uint8_t dev_addr, uint8_t ep_addr);
 static void qhd_init(ehci_qhd_t *p_qhd, uint8_t dev_addr, tusb_desc_endpoint_t const * ep_desc);
-static void qhd_attach_qtd(ehci_qhd_t *qhd, ehci_qtd_t *qtd);
-static void qhd_remove_qtd(ehci_qhd_t *qhd);
+static void qhd_attach_qtd(ehci_qhd_t *qhd, ehci_qtd_t *qtd, ehci_qtd_t *last);
+static void qhd_remove_qtd(ehci_qhd_t *qhd, ehci_qtd_t *last);
 
 TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t* qtd_control(uint8_t dev_addr);
 TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t* qtd_find_free (void);
+TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t* qtd_next(ehci_qtd_t const * qtd);
+TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_extra_t* qtd_get_extra(ehci_qtd_t const * qtd);
 static void qtd_init (ehci_qtd_t* qtd, void const* buffer, uint16_t total_bytes);
+static ehci_qtd_t* qtd_chain_init(ehci_qhd_t const* qhd, uint8_t* buffer, uint16_t total_bytes, ehci_qtd_t** last);
+static void qtd_chain_free(ehci_qtd_t* qtd, ehci_qtd_t const* last);
 
 TU_ATTR_ALWAYS_INLINE static inline ehci_link_t* list_get_period_head(uint8_t rhport, uint32_t interval_ms);
 TU_ATTR_ALWAYS_INLINE static inline ehci_qhd_t* list_get_async_head(uint8_t rhport);
@@ -150,6 +209,18 @@ TU_ATTR_ALWAYS_INLINE static inline void list_insert (ehci_link_t *current, ehci
 TU_ATTR_ALWAYS_INLINE static inline ehci_link_t* list_next (ehci_link_t const *p_link);
 static void list_remove_qhd_by_daddr(ehci_link_t* list_head, uint8_t dev_addr);
 
+static uint16_t period_bw_peak(bool highspeed, uint16_t frame_interval, uint8_t frame_phase, uint8_t smask);
+static void period_bw_update(bool highspeed, uint16_t frame_interval, uint8_t frame_phase, uint8_t smask, uint16_t bytes, bool reserve);
+static bool qhd_period_bw_update(ehci_qhd_t const* qhd, bool reserve);
+
+#if ISO_EP_MAX
+static ehci_iso_ep_t* iso_ep_get(uint8_t dev_addr, uint8_t ep_addr);
+static bool iso_edpt_open(uint8_t dev_addr, tusb_desc_endpoint_t const * ep_desc);
+static bool iso_edpt_xfer(uint8_t rhport, ehci_iso_ep_t* iso_ep, uint8_t * buffer, uint16_t buflen);
+static void iso_ep_remove_td(ehci_iso_ep_t* iso_ep);
+static void iso_xfer_isr(uint8_t rhport);
+#endif
+
 static void ehci_disable_schedule(ehci_registers_t* regs, bool is_period) {
   // maybe have a timeout for status
   if (is_period) {
@@ -249,6 +320,23 @@ void hcd_device_close(uint8_t rhport, uint8_t daddr)
     list_remove_qhd_by_daddr((ehci_link_t *) &ehci_data.period_head_arr[i], daddr);
   }
 
+#if ISO_EP_MAX
+  // Remove isochronous TDs from frame list and release bandwidth
+  for (uint8_t i = 0; i < ISO_EP_MAX; i++) {
+    ehci_iso_ep_t* iso_ep = &ehci_data.iso_ep[i];
+    if (iso_ep->used && iso_ep->dev_addr == daddr) {
+      if (iso_ep->xfer_count) {
+        ehci_disable_schedule(ehci_data.regs, true);
+        iso_ep_remove_td(iso_ep);
+        ehci_enable_schedule(ehci_data.regs, true);
+      }
+      period_bw_update(iso_ep->speed == TUSB_SPEED_HIGH, iso_ep->frame_interval, iso_ep->frame_phase,
+                       iso_ep->uframe_smask, iso_ep->bw_bytes, false);
+      iso_ep->used = 0;
+    }
+  }
+#endif
+
   // Async doorbell (EHCI 4.8.2 for operational details)
   ehci_data.regs->command_bm.async_adv_doorbell = 1;
 }
@@ -262,11 +350,10 @@ static void init_periodic_list(uint8_t rhport) {
     ehci_data.period_head_arr[i].qtd_overlay.halted = 1; // dummy node, always inactive
   }
 
-  // TODO EHCI_FRAMELIST_SIZE with other size than 8
   // all links --> period_head_arr[0] (1ms)
   // 0, 2, 4, 6 etc --> period_head_arr[1] (2ms)
-  // 1, 5 --> period_head_arr[2] (4ms)
-  // 3 --> period_head_arr[3] (8ms)
+  // 1, 5, 9 etc --> period_head_arr[2] (4ms)
+  // 3, 11, 19 etc --> period_head_arr[3] (8ms)
 
   ehci_link_t * const framelist  = ehci_data.period_framelist;
   ehci_link_t * const head_1ms = (ehci_link_t *) &ehci_data.period_head_arr[0];
@@ -287,7 +374,9 @@ static void init_periodic_list(uint8_t rhport) {
     list_insert(framelist + i, head_4ms, EHCI_QTYPE_QHD);
   }
 
-  list_insert(framelist + 3, head_8ms, EHCI_QTYPE_QHD);
+  for (uint32_t i = 3; i < FRAMELIST_SIZE; i += 8) {
+    list_insert(framelist + i, head_8ms, EHCI_QTYPE_QHD);
+  }
 
   head_1ms->terminate = 1;
 }
@@ -329,6 +418,10 @@ bool ehci_init(uint8_t rhport, uint32_t capability_reg, uint32_t operatial_reg)
 
   regs->async_list_addr = (uint32_t) async_head;
 
+  // inactive qTD to stop the queue when chained IN transfer receives a short packet
+  ehci_data.qtd_halt.next.terminate      = 1;
+  ehci_data.qtd_halt.alternate.terminate = 1;
+
   //------------- Periodic List -------------//
   init_periodic_list(rhport);
   regs->periodic_list_base = (uint32_t) ehci_data.period_framelist;
@@ -379,8 +472,14 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const
 {
   (void) rhport;
 
-  // TODO not support ISO yet
-  TU_ASSERT (ep_desc->bmAttributes.xfer != TUSB_XFER_ISOCHRONOUS);
+  if (ep_desc->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS) {
+  #if ISO_EP_MAX
+    return iso_edpt_open(dev_addr, ep_desc);
+  #else
+    TU_LOG1("EHCI: isochronous is disabled, set CFG_TUH_EHCI_ISO_EP_MAX to enable\r\n");
+    return false;
+  #endif
+  }
 
   //------------- Prepare Queue Head -------------//
   ehci_qhd_t *p_qhd = (ep_desc->bEndpointAddress == 0) ? qhd_control(dev_addr) : qhd_find_free();
@@ -402,13 +501,14 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const
     break;
 
     case TUSB_XFER_INTERRUPT:
+      if (!qhd_period_bw_update(p_qhd, true)) {
+        TU_LOG1("EHCI: not enough periodic bandwidth\r\n");
+        p_qhd->used = 0;
+        return false;
+      }
       list_head = list_get_period_head(rhport, p_qhd->interval_ms);
     break;
 
-    case TUSB_XFER_ISOCHRONOUS:
-      // TODO iso is not supported
-    break;
-
     default: break;
   }
   TU_ASSERT(list_head);
@@ -439,20 +539,26 @@ bool hcd_setup_send(uint8_t rhport, uint8_t dev_addr, uint8_t const setup_packet
   }
 
   // attach TD to QHD -> start transferring
-  qhd_attach_qtd(qhd, td);
+  qhd_attach_qtd(qhd, td, td);
 
   return true;
 }
 
 bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t * buffer, uint16_t buflen)
 {
-  (void) rhport;
-
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
+#if ISO_EP_MAX
+  ehci_iso_ep_t* iso_ep = iso_ep_get(dev_addr, ep_addr);
+  if (iso_ep) {
+    return iso_edpt_xfer(rhport, iso_ep, buffer, buflen);
+  }
+#endif
+
   ehci_qhd_t* qhd = qhd_get_from_addr(dev_addr, ep_addr);
   ehci_qtd_t* qtd;
+  ehci_qtd_t* last;
 
   if (epnum == 0) {
     // Control endpoint never be stalled. Skip reset Data Toggle since it is fixed per stage
@@ -466,15 +572,13 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
     // first data toggle is always 1 (data & setup stage)
     qtd->data_toggle = 1;
     qtd->pid = dir ? EHCI_PID_IN : EHCI_PID_OUT;
+    last = qtd;
   } else {
     // skip if endpoint is halted
     TU_VERIFY(!qhd->qtd_overlay.halted);
 
-    qtd = qtd_find_free();
+    qtd = qtd_chain_init(qhd, buffer, buflen, &last);
     TU_ASSERT(qtd);
-
-    qtd_init(qtd, buffer, buflen);
-    qtd->pid = qhd->pid;
   }
 
   // IN transfer: invalidate buffer, OUT transfer: clean buffer
@@ -484,22 +588,48 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
     hcd_dcache_clean(buffer, buflen);
   }
 
-  // attach TD to QHD -> start transferring
-  qhd_attach_qtd(qhd, qtd);
+  // attach TD chain to QHD -> start transferring or queued after previous transfers.
+  // ISR also modifies the attached list, disable it while linking
+  hcd_int_disable(rhport);
+  qhd_attach_qtd(qhd, qtd, last);
+  hcd_int_enable(rhport);
 
   return true;
 }
 
+// Transfer chain is linked behind the ones attached to queue head, or scheduled after queued isochronous transfers
+bool hcd_edpt_xfer_append(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t * buffer, uint16_t buflen) {
+  TU_VERIFY(tu_edpt_number(ep_addr) != 0);
+  return hcd_edpt_xfer(rhport, dev_addr, ep_addr, buffer, buflen);
+}
+
 bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
   (void) rhport;
 
-  // TODO ISO not supported yet
+#if ISO_EP_MAX
+  ehci_iso_ep_t* iso_ep = iso_ep_get(dev_addr, ep_addr);
+  if (iso_ep) {
+    TU_VERIFY(iso_ep->xfer_count);
+
+    ehci_disable_schedule(ehci_data.regs, true);
+    iso_ep_remove_td(iso_ep);
+    ehci_enable_schedule(ehci_data.regs, true);
+
+    return true;
+  }
+#endif
+
   ehci_qhd_t* qhd = qhd_get_from_addr(dev_addr, ep_addr);
   ehci_qtd_t * volatile qtd = qhd->attached_qtd;
   TU_VERIFY(qtd != NULL); // no queued transfer
 
-  hcd_dcache_invalidate(qtd, sizeof(ehci_qtd_t));
-  TU_VERIFY(qtd->active); // transfer is already complete
+  // transfer is already complete if its last qTD is inactive
+  ehci_qtd_t * volatile last = qtd;
+  while (!last->int_on_complete) {
+    last = qtd_next(last);
+  }
+  hcd_dcache_invalidate(last, sizeof(ehci_qtd_t));
+  TU_VERIFY(last->active);
 
   // HC is still processing, disable HC list schedule before making changes
   bool const is_period = (qhd->interval_ms > 0);
@@ -507,14 +637,14 @@ bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
   ehci_disable_schedule(ehci_data.regs, is_period);
 
   // check active bit again just in case HC has just processed the TD
-  bool const still_active = qtd->active;
+  bool const still_active = last->active;
   if (still_active) {
     // remove TD from QH overlay
     qhd->qtd_overlay.next.terminate = 1;
     hcd_dcache_clean(qhd, sizeof(ehci_qhd_t));
 
-    // remove TD from QH software list
-    qhd_remove_qtd(qhd);
+    // remove all queued TDs from QH software list
+    qhd_remove_qtd(qhd, qhd->tail_qtd);
   }
 
   ehci_enable_schedule(ehci_data.regs, is_period);
@@ -547,6 +677,10 @@ void async_advance_isr(uint8_t rhport)
   ehci_qhd_t *qhd_pool = ehci_data.qhd_pool;
   for (uint32_t i = 0; i < QHD_MAX; i++) {
     if (qhd_pool[i].removing) {
+      // HC no longer references this queue head and its TDs
+      if (qhd_pool[i].attached_qtd) {
+        qhd_remove_qtd(&qhd_pool[i], qhd_pool[i].tail_qtd);
+      }
       qhd_pool[i].removing = 0;
       qhd_pool[i].used = 0;
     }
@@ -571,43 +705,88 @@ void qhd_xfer_complete_isr(ehci_qhd_t * qhd) {
   hcd_dcache_invalidate(qhd, sizeof(ehci_qhd_t)); // HC may have updated the overlay
   volatile ehci_qtd_t *qtd_overlay = &qhd->qtd_overlay;
 
-  // process non-active (completed) QHD with attached (scheduled) TD
-  if ( !qtd_overlay->active && qhd->attached_qtd != NULL ) {
-    xfer_result_t xfer_result;
+  // Complete queued transfers in order, each is a chain of qTDs ended by one with int_on_complete
+  while (qhd->attached_qtd != NULL) {
+    ehci_qtd_t * volatile qtd = qhd->attached_qtd;
+    uint32_t xferred_bytes = 0;
+    xfer_result_t xfer_result = XFER_RESULT_SUCCESS;
+    bool stop_early = false;
+
+    while (1) {
+      hcd_dcache_invalidate(qtd, sizeof(ehci_qtd_t)); // HC may have written back TD
+      if (qtd->active) {
+        return; // transfer is still in progress
+      }
 
-    if ( qtd_overlay->halted ) {
-      if (qtd_overlay->xact_err || qtd_overlay->err_count == 0 || qtd_overlay->buffer_err || qtd_overlay->babble_err) {
-        // Error count = 0 often occurs when device disconnected, or other bus-related error
-        // clear halted bit if not caused by STALL to allow more transfer
-        xfer_result = XFER_RESULT_FAILED;
-        qtd_overlay->halted = false;
-        TU_LOG3("  QHD xfer err count: %d\r\n", qtd_overlay->err_count);
-        // TU_BREAKPOINT(); // TODO skip unplugged device
-      }else {
-        // no error bits are set, endpoint is halted due to STALL
-        xfer_result = XFER_RESULT_STALLED;
+      ehci_qtd_extra_t const* extra = qtd_get_extra(qtd);
+      uint32_t const qtd_xferred = extra->expected_bytes - qtd->total_bytes;
+      xferred_bytes += qtd_xferred;
+
+      // invalidate dcache if IN transfer with data
+      if (qtd->pid == EHCI_PID_IN && extra->buffer != 0 && qtd_xferred > 0) {
+        hcd_dcache_invalidate((void*) extra->buffer, qtd_xferred);
       }
-    } else {
-      xfer_result = XFER_RESULT_SUCCESS;
-    }
 
-    ehci_qtd_t * volatile qtd = qhd->attached_qtd;
-    hcd_dcache_invalidate(qtd, sizeof(ehci_qtd_t)); // HC may have written back TD
+      if (qtd->halted) {
+        if (qtd->xact_err || qtd->err_count == 0 || qtd->buffer_err || qtd->babble_err) {
+          // Error count = 0 often occurs when device disconnected, or other bus-related error
+          xfer_result = XFER_RESULT_FAILED;
+          TU_LOG3("  QHD xfer err count: %d\r\n", qtd->err_count);
+          // TU_BREAKPOINT(); // TODO skip unplugged device
+        } else {
+          // no error bits are set, endpoint is halted due to STALL
+          xfer_result = XFER_RESULT_STALLED;
+        }
+        stop_early = true;
+        break;
+      }
+
+      if (qtd->int_on_complete) {
+        break; // last qTD of the transfer
+      }
+
+      if (qtd->total_bytes > 0) {
+        // short packet in the middle of chain, HC has moved to the halt qTD via alternate pointer
+        stop_early = true;
+        break;
+      }
+
+      qtd = qtd_next(qtd);
+    }
 
     uint8_t const dir = (qtd->pid == EHCI_PID_IN) ? 1 : 0;
-    uint32_t const xferred_bytes = qtd->expected_bytes - qtd->total_bytes;
 
-    // invalidate dcache if IN transfer with data
-    if (dir == 1 && qhd->attached_buffer != 0 && xferred_bytes > 0) {
-      hcd_dcache_invalidate((void*) qhd->attached_buffer, xferred_bytes);
+    // find last qTD of this transfer
+    ehci_qtd_t * last = qtd;
+    while (!last->int_on_complete) {
+      last = qtd_next(last);
     }
 
-    // remove and free TD before invoking callback
-    qhd_remove_qtd(qhd);
+    if (stop_early) {
+      // HC stops in the middle of this transfer: point overlay to the next queued transfer (if any) and
+      // clear halted bit if not caused by STALL to allow more transfer.
+      // EHCI 4.10.2: when advancing the queue, HC follows alternate pointer if overlay still has bytes to transfer.
+      // Overlay of a short packet would keep it parked at the halt qTD, terminate alternate and clear the byte count
+      // so that next pointer is used.
+      qtd_overlay->alternate.terminate = 1;
+      qtd_overlay->total_bytes = 0;
+      qtd_overlay->next.address = last->next.address;
+      if (xfer_result != XFER_RESULT_STALLED) {
+        qtd_overlay->halted = false;
+      }
+      hcd_dcache_clean(qhd, sizeof(ehci_qhd_t));
+    }
+
+    // remove and free TDs before invoking callback
+    qhd_remove_qtd(qhd, last);
 
     // notify usbh
     uint8_t const ep_addr = tu_edpt_addr(qhd->ep_number, dir);
     hcd_event_xfer_complete(qhd->dev_addr, ep_addr, xferred_bytes, xfer_result, true);
+
+    if (xfer_result == XFER_RESULT_STALLED) {
+      break; // queued transfers resume after stall is cleared
+    }
   }
 }
 
@@ -698,6 +877,13 @@ void hcd_int_handler(uint8_t rhport, bool in_isr) {
     regs->status = usb_int; // Acknowledge
   }
 
+  #if ISO_EP_MAX
+  // also on frame list rollover: TD missed by HC does not raise completion interrupt
+  if (usb_int || (int_status & EHCI_INT_MASK_FRAMELIST_ROLLOVER)) {
+    iso_xfer_isr(rhport);
+  }
+  #endif
+
   //------------- There is some removed async previously -------------//
   // need to place after EHCI_INT_MASK_NXP_ASYNC
   if (int_status & EHCI_INT_MASK_ASYNC_ADVANCE) {
@@ -753,7 +939,12 @@ static void list_remove_qhd_by_daddr(ehci_link_t* list_head, uint8_t dev_addr) {
 
       if ( qhd->int_smask )
       {
+        qhd_period_bw_update(qhd, false);
+
         // period list queue element is guarantee to be free in the next frame (1 ms)
+        if (qhd->attached_qtd) {
+          qhd_remove_qtd(qhd, qhd->tail_qtd);
+        }
         qhd->used = 0;
       }else
       {
@@ -873,6 +1064,7 @@ static void qhd_init(ehci_qhd_t *p_qhd, uint8_t dev_addr, tusb_desc_endpoint_t c
   p_qhd->used         = 1;
   p_qhd->removing     = 0;
   p_qhd->attached_qtd = NULL;
+  p_qhd->tail_qtd     = NULL;
   p_qhd->pid = tu_edpt_dir(ep_desc->bEndpointAddress) ? EHCI_PID_IN : EHCI_PID_OUT; // PID for TD under this endpoint
 
   //------------- active, but no TD list -------------//
@@ -886,28 +1078,48 @@ static void qhd_init(ehci_qhd_t *p_qhd, uint8_t dev_addr, tusb_desc_endpoint_t c
   }
 }
 
-// Attach a TD to queue head
-static void qhd_attach_qtd(ehci_qhd_t *qhd, ehci_qtd_t *qtd) {
-  qhd->attached_qtd = qtd;
-  qhd->attached_buffer = qtd->buffer[0];
-
+// Attach a TD chain (qtd -> last) to queue head, appended after previously queued transfers
+static void qhd_attach_qtd(ehci_qhd_t *qhd, ehci_qtd_t *qtd, ehci_qtd_t *last) {
   // clean and invalidate cache before physically write
-  hcd_dcache_clean_invalidate(qtd, sizeof(ehci_qtd_t));
+  for (ehci_qtd_t* p = qtd; ; p = qtd_next(p)) {
+    hcd_dcache_clean_invalidate(p, sizeof(ehci_qtd_t));
+    if (p == last) break;
+  }
+
+  ehci_qtd_t * const tail = qhd->tail_qtd;
+  qhd->tail_qtd = last;
+
+  if (qhd->attached_qtd == NULL) {
+    qhd->attached_qtd = qtd;
+    qhd->qtd_overlay.next.address = (uint32_t) qtd;
+  } else {
+    tail->next.address = (uint32_t) qtd;
+    hcd_dcache_clean(tail, sizeof(ehci_qtd_t));
+
+    // HC copies next pointer into overlay when loading a qTD. If tail is already loaded (active or just
+    // retired), overlay must be updated as well for HC to advance to the new transfer.
+    hcd_dcache_invalidate(qhd, sizeof(ehci_qhd_t));
+    if (qhd->qtd_addr == (uint32_t) tail) {
+      qhd->qtd_overlay.next.address = (uint32_t) qtd;
+    }
+  }
 
-  qhd->qtd_overlay.next.address = (uint32_t) qtd;
   hcd_dcache_clean_invalidate(qhd, sizeof(ehci_qhd_t));
 }
 
-// Remove an attached TD from queue head
-static void qhd_remove_qtd(ehci_qhd_t *qhd) {
+// Remove attached TDs from queue head up to last (inclusive) which must be end of a transfer
+static void qhd_remove_qtd(ehci_qhd_t *qhd, ehci_qtd_t *last) {
   ehci_qtd_t * volatile qtd = qhd->attached_qtd;
 
-  qhd->attached_qtd = NULL;
-  qhd->attached_buffer = 0;
+  if (last == qhd->tail_qtd) {
+    qhd->attached_qtd = NULL;
+    qhd->tail_qtd = NULL;
+  } else {
+    qhd->attached_qtd = qtd_next(last);
+  }
   hcd_dcache_clean(qhd, sizeof(ehci_qhd_t));
 
-  qtd->used = 0; // free QTD
-  hcd_dcache_clean(qtd, sizeof(ehci_qtd_t));
+  qtd_chain_free(qtd, last); // free QTDs
 }
 
 //--------------------------------------------------------------------+
@@ -921,23 +1133,41 @@ TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t* qtd_control(uint8_t dev_addr) {
 
 TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t *qtd_find_free(void) {
   for (uint32_t i = 0; i < QTD_MAX; i++) {
-    if (!ehci_data.qtd_pool[i].used) return &ehci_data.qtd_pool[i];
+    if (!ehci_data.qtd_extra[i].used) return &ehci_data.qtd_pool[i];
   }
   return NULL;
 }
 
+TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_t *qtd_next(ehci_qtd_t const * qtd) {
+  return (ehci_qtd_t *) tu_align32(qtd->next.address);
+}
+
+// Get extra data of TD, check ehci_data_t for memory layout
+TU_ATTR_ALWAYS_INLINE static inline ehci_qtd_extra_t *qtd_get_extra(ehci_qtd_t const * qtd) {
+  if ( qtd >= ehci_data.qtd_pool && qtd < ehci_data.qtd_pool + QTD_MAX ) {
+    return &ehci_data.qtd_extra[qtd - ehci_data.qtd_pool];
+  }
+
+  // control TD
+  uint32_t const idx = ((uintptr_t) qtd - (uintptr_t) ehci_data.control) / sizeof(ehci_data.control[0]);
+  return &ehci_data.qtd_extra_control[idx];
+}
+
 static void qtd_init(ehci_qtd_t* qtd, void const* buffer, uint16_t total_bytes) {
   tu_memclr(qtd, sizeof(ehci_qtd_t));
-  qtd->used                = 1;
+
+  ehci_qtd_extra_t* extra = qtd_get_extra(qtd);
+  extra->used           = 1;
+  extra->buffer         = (uint32_t) buffer;
+  extra->expected_bytes = total_bytes;
 
   qtd->next.terminate      = 1; // init to null
-  qtd->alternate.terminate = 1; // not used, always set to terminated
+  qtd->alternate.terminate = 1; // only used by chained IN qTD
   qtd->active              = 1;
   qtd->err_count           = 3; // TODO 3 consecutive errors tolerance
   qtd->data_toggle         = 0;
   qtd->int_on_complete     = 1;
   qtd->total_bytes         = total_bytes;
-  qtd->expected_bytes      = total_bytes;
 
   qtd->buffer[0] = (uint32_t) buffer;
   for(uint8_t i=1; i<5; i++) {
@@ -945,4 +1175,571 @@ static void qtd_init(ehci_qtd_t* qtd, void const* buffer, uint16_t total_bytes)
   }
 }
 
+// Init a chain of TDs for a transfer of non-control endpoint. Each qTD except the last one covers
+// as many max packets as its 5 pages can hold. Return first qTD, last qTD is returned via parameter
+static ehci_qtd_t* qtd_chain_init(ehci_qhd_t const* qhd, uint8_t* buffer, uint16_t total_bytes, ehci_qtd_t** last) {
+  uint16_t const mps = qhd->max_packet_size;
+  ehci_qtd_t* head = NULL;
+  ehci_qtd_t* prev = NULL;
+  uint32_t remaining = total_bytes;
+
+  // zero-length transfer still needs one qTD
+  do {
+    ehci_qtd_t* qtd = qtd_find_free();
+    if (qtd == NULL) {
+      if (head) {
+        qtd_chain_free(head, prev);
+      }
+      return NULL;
+    }
+
+    uint32_t xact_len = remaining;
+    uint32_t const page_max = QTD_PAGE_MAX_BYTES - tu_offset4k((uint32_t) buffer);
+    if (xact_len > page_max) {
+      // qTD in the middle of chain must end at packet boundary
+      xact_len = page_max - (page_max % mps);
+    }
+
+    qtd_init(qtd, buffer, (uint16_t) xact_len);
+    qtd->pid = qhd->pid;
+
+    if (prev) {
+      prev->next.address = (uint32_t) qtd;
+      prev->int_on_complete = 0;
+      if (qhd->pid == EHCI_PID_IN) {
+        // short packet stops the queue instead of advancing to the next qTD of this transfer
+        prev->alternate.address = (uint32_t) &ehci_data.qtd_halt;
+      }
+    } else {
+      head = qtd;
+    }
+
+    prev = qtd;
+    buffer += xact_len;
+    remaining -= xact_len;
+  } while (remaining > 0);
+
+  *last = prev;
+  return head;
+}
+
+// Free TDs from qtd up to last (inclusive)
+static void qtd_chain_free(ehci_qtd_t* qtd, ehci_qtd_t const* last) {
+  while (1) {
+    ehci_qtd_t* next = qtd_next(qtd);
+    qtd_get_extra(qtd)->used = 0;
+    if (qtd == last) break;
+    qtd = next;
+  }
+}
+
+//--------------------------------------------------------------------+
+// Periodic Bandwidth
+//--------------------------------------------------------------------+
+
+// Estimated bus time in bytes of a periodic transaction: payload with worst case bit stuffing + protocol overhead
+static uint16_t period_xact_bytes(uint8_t speed, uint16_t packet_size) {
+  uint32_t const payload = (packet_size * 7u) / 6u;
+
+  switch (speed) {
+    case TUSB_SPEED_HIGH: return (uint16_t) (payload + 38);
+
+    // low speed is 8 times slower than full speed
+    case TUSB_SPEED_LOW: return (uint16_t) (8*(payload + 13));
+
+    case TUSB_SPEED_FULL:
+    default: return (uint16_t) (payload + 13);
+  }
+}
+
+// Most occupied bandwidth among frames (within bandwidth table) that are frame_phase mod frame_interval.
+// Highspeed checks micro-frames in smask, full/low speed checks frame budget of split transaction
+static uint16_t period_bw_peak(bool highspeed, uint16_t frame_interval, uint8_t frame_phase, uint8_t smask) {
+  uint16_t const step = tu_min16(frame_interval, EHCI_PERIOD_BW_FRAMES);
+  uint16_t peak = 0;
+
+  for (uint16_t f = frame_phase % step; f < EHCI_PERIOD_BW_FRAMES; f += step) {
+    if (highspeed) {
+      for (uint8_t u = 0; u < 8; u++) {
+        if (tu_bit_test(smask, u)) {
+          peak = tu_max16(peak, ehci_data.period_bw[f][u]);
+        }
+      }
+    } else {
+      peak = tu_max16(peak, ehci_data.period_tt_bw[f]);
+    }
+  }
+
+  return peak;
+}
+
+// Reserve or release bandwidth, availability must be checked with period_bw_peak() before reserving
+static void period_bw_update(bool highspeed, uint16_t frame_interval, uint8_t frame_phase, uint8_t smask, uint16_t bytes, bool reserve) {
+  uint16_t const step = tu_min16(frame_interval, EHCI_PERIOD_BW_FRAMES);
+
+  for (uint16_t f = frame_phase % step; f < EHCI_PERIOD_BW_FRAMES; f += step) {
+    if (highspeed) {
+      for (uint8_t u = 0; u < 8; u++) {
+        if (tu_bit_test(smask, u)) {
+          ehci_data.period_bw[f][u] = (uint16_t) (reserve ? (ehci_data.period_bw[f][u] + bytes) : (ehci_data.period_bw[f][u] - bytes));
+        }
+      }
+    } else {
+      ehci_data.period_tt_bw[f] = (uint16_t) (reserve ? (ehci_data.period_tt_bw[f] + bytes) : (ehci_data.period_tt_bw[f] - bytes));
+    }
+  }
+}
+
+// Reserve or release bandwidth of an interrupt queue head. Frames are fixed by the polling interval tree
+// built by init_periodic_list(): 1ms all frames, 2ms even frames, 4ms frame 1 & 5, 8ms frame 3
+static bool qhd_period_bw_update(ehci_qhd_t const* qhd, bool reserve) {
+  static uint8_t const tree_phase[] = { 0, 0, 1, 3 };
+  uint8_t const tree_idx = tu_log2( tu_min32(EHCI_PERIOD_BW_FRAMES, tu_max32(1, qhd->interval_ms)) );
+  uint16_t const frame_interval = (uint16_t) (1u << tree_idx);
+
+  bool const highspeed = (qhd->ep_speed == TUSB_SPEED_HIGH);
+  uint16_t const bytes = period_xact_bytes(qhd->ep_speed, qhd->max_packet_size);
+
+  if (reserve) {
+    uint16_t const peak = period_bw_peak(highspeed, frame_interval, tree_phase[tree_idx], qhd->int_smask);
+    TU_VERIFY(peak + bytes <= (highspeed ? EHCI_PERIOD_BW_UFRAME_MAX : EHCI_PERIOD_BW_FRAME_MAX));
+  }
+
+  period_bw_update(highspeed, frame_interval, tree_phase[tree_idx], qhd->int_smask, bytes, reserve);
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Isochronous
+//--------------------------------------------------------------------+
+#if ISO_EP_MAX
+
+// siTD transaction position: all data in one start-split or first of several start-splits
+enum {
+  SITD_TP_ALL   = 0,
+  SITD_TP_BEGIN = 1,
+};
+
+static ehci_iso_ep_t* iso_ep_get(uint8_t dev_addr, uint8_t ep_addr) {
+  for (uint8_t i = 0; i < ISO_EP_MAX; i++) {
+    ehci_iso_ep_t* iso_ep = &ehci_data.iso_ep[i];
+    if (iso_ep->used && iso_ep->dev_addr == dev_addr && iso_ep->ep_addr == ep_addr) {
+      return iso_ep;
+    }
+  }
+  return NULL;
+}
+
+// Open isochronous endpoint: reserve bandwidth with the least loaded (micro)frame schedule that fits
+static bool iso_edpt_open(uint8_t dev_addr, tusb_desc_endpoint_t const * ep_desc) {
+  ehci_iso_ep_t* iso_ep = NULL;
+  for (uint8_t i = 0; i < ISO_EP_MAX; i++) {
+    if (!ehci_data.iso_ep[i].used) {
+      iso_ep = &ehci_data.iso_ep[i];
+      break;
+    }
+  }
+  TU_ASSERT(iso_ep);
+  TU_ASSERT(ep_desc->bInterval >= 1 && ep_desc->bInterval <= 16);
+
+  hcd_devtree_info_t devtree_info;
+  hcd_devtree_get_info(dev_addr, &devtree_info);
+
+  bool const highspeed = (devtree_info.speed == TUSB_SPEED_HIGH);
+  uint16_t const mps = tu_edpt_packet_size(ep_desc);
+  uint16_t const interval = (uint16_t) (1u << (ep_desc->bInterval - 1));
+  // high-bandwidth endpoint: additional transactions per micro-frame in wMaxPacketSize bits 12..11
+  uint8_t const mult = highspeed ? (uint8_t) (((tu_le16toh(ep_desc->wMaxPacketSize) >> 11) & 0x03u) + 1) : 1;
+
+  tu_memclr(iso_ep, sizeof(ehci_iso_ep_t));
+  iso_ep->dev_addr        = dev_addr;
+  iso_ep->ep_addr         = ep_desc->bEndpointAddress;
+  iso_ep->speed           = devtree_info.speed;
+  iso_ep->max_packet_size = mps;
+  iso_ep->mult            = mult;
+  iso_ep->interval        = interval;
+  iso_ep->frame_interval  = highspeed ? tu_max16(1, interval / 8) : interval;
+  iso_ep->bw_bytes        = (uint16_t) (mult * period_xact_bytes(devtree_info.speed, mps));
+  iso_ep->hub_addr        = devtree_info.hub_addr;
+  iso_ep->hub_port        = devtree_info.hub_port;
+
+  uint16_t const bw_max = highspeed ? EHCI_PERIOD_BW_UFRAME_MAX : EHCI_PERIOD_BW_FRAME_MAX;
+  uint8_t smask_count;
+
+  if (highspeed) {
+    TU_ASSERT(mps <= 1024 && mult <= 3);
+    // interval shorter than a frame has several micro-frames per frame, otherwise a single micro-frame
+    smask_count = (uint8_t) tu_min16(interval, 8);
+  } else {
+    TU_ASSERT(mps <= 1023);
+    // Split transaction (EHCI 4.12.3): OUT data is sent in start-splits of 188 bytes each,
+    // IN is started in micro-frame 0 then polled by complete-splits from micro-frame 2
+    uint8_t const nsplit = (uint8_t) tu_div_ceil(tu_max16(mps, 1), 188);
+    if (tu_edpt_dir(ep_desc->bEndpointAddress) == TUSB_DIR_OUT) {
+      iso_ep->uframe_smask = (uint8_t) ((1u << nsplit) - 1);
+      iso_ep->fl_cmask     = 0;
+    } else {
+      iso_ep->uframe_smask = 0x01;
+      iso_ep->fl_cmask     = (uint8_t) (((1u << (nsplit + 1)) - 1) << 2);
+    }
+    smask_count = 1;
+  }
+
+  uint8_t const phase_count = (uint8_t) tu_min16(iso_ep->frame_interval, EHCI_PERIOD_BW_FRAMES);
+  uint16_t best_peak = UINT16_MAX;
+
+  for (uint8_t phase = 0; phase < phase_count; phase++) {
+    for (uint8_t k = 0; k < smask_count; k++) {
+      uint8_t smask = iso_ep->uframe_smask;
+      if (highspeed) {
+        smask = 0;
+        for (uint8_t u = k; u < 8; u += smask_count) {
+          smask |= (uint8_t) TU_BIT(u);
+        }
+      }
+
+      uint16_t const peak = period_bw_peak(highspeed, iso_ep->frame_interval, phase, smask);
+      if (peak + iso_ep->bw_bytes <= bw_max && peak < best_peak) {
+        best_peak = peak;
+        iso_ep->frame_phase  = phase;
+        iso_ep->uframe_smask = smask;
+      }
+    }
+  }
+
+  if (best_peak == UINT16_MAX) {
+    TU_LOG1("EHCI: not enough periodic bandwidth\r\n");
+    return false;
+  }
+
+  period_bw_update(highspeed, iso_ep->frame_interval, iso_ep->frame_phase, iso_ep->uframe_smask, iso_ep->bw_bytes, true);
+  iso_ep->used = 1;
+
+  return true;
+}
+
+// Link isochronous TD to the front of frame list entry, before all queue heads
+static void iso_td_link(uint8_t frame, ehci_link_t* td, uint8_t td_type, uint32_t td_size) {
+  ehci_link_t* framelist = &ehci_data.period_framelist[frame];
+
+  td->address = framelist->address;
+  hcd_dcache_clean(td, td_size);
+
+  framelist->address = ((uint32_t) td) | (td_type << 1);
+  hcd_dcache_clean(framelist, sizeof(ehci_link_t));
+}
+
+// Unlink isochronous TD from frame list entry
+static void iso_td_unlink(uint8_t frame, ehci_link_t const* td) {
+  ehci_link_t* prev = &ehci_data.period_framelist[frame];
+
+  // isochronous TDs are always linked before queue heads
+  while (!prev->terminate && prev->type != EHCI_QTYPE_QHD) {
+    ehci_link_t* next = list_next(prev);
+    if (next == td) {
+      prev->address = td->address;
+      hcd_dcache_clean(prev, sizeof(ehci_link_t));
+      return;
+    }
+    prev = next;
+  }
+}
+
+// Schedule a transfer: buffer is split into packets of max packet size (times mult for high-bandwidth), one per
+// service interval. Each packet keeps its position in buffer (packet i at offset i*packet size), xferred bytes is the
+// sum of all packets. Up to EHCI_ISO_XFER_MAX transfers can be queued, each one is scheduled right after the previous
+// one so that the stream is continuous if it is submitted in time.
+static bool iso_edpt_xfer(uint8_t rhport, ehci_iso_ep_t* iso_ep, uint8_t * buffer, uint16_t buflen) {
+  TU_VERIFY(iso_ep->xfer_count < EHCI_ISO_XFER_MAX);
+
+  bool const highspeed = (iso_ep->speed == TUSB_SPEED_HIGH);
+  uint8_t const ep_idx = (uint8_t) (iso_ep - ehci_data.iso_ep);
+  uint8_t const epnum = tu_edpt_number(iso_ep->ep_addr);
+  uint8_t const dir = tu_edpt_dir(iso_ep->ep_addr);
+  uint16_t const mps = iso_ep->max_packet_size;
+  uint16_t const xact_max = (uint16_t) (mps * iso_ep->mult); // bytes per (micro)frame
+  uint16_t const frame_interval = iso_ep->frame_interval;
+
+  uint8_t packet_per_td = 1;
+  if (highspeed) {
+    packet_per_td = 0;
+    for (uint8_t u = 0; u < 8; u++) {
+      if (tu_bit_test(iso_ep->uframe_smask, u)) {
+        packet_per_td++;
+      }
+    }
+  }
+
+  uint32_t const packet_count = buflen ? tu_div_ceil(buflen, xact_max) : 1;
+  uint16_t const td_count = (uint16_t) tu_div_ceil(packet_count, packet_per_td);
+
+  // count free TDs
+  uint16_t td_free = 0;
+  if (highspeed) {
+    for (uint8_t i = 0; i < ITD_MAX; i++) {
+      if (!ehci_data.itd_extra[i].used) td_free++;
+    }
+  } else {
+    for (uint8_t i = 0; i < SITD_MAX; i++) {
+      if (!ehci_data.sitd_pool[i].used) td_free++;
+    }
+  }
+  TU_ASSERT(td_count <= td_free);
+
+  // IN transfer: invalidate buffer, OUT transfer: clean buffer
+  if (dir) {
+    hcd_dcache_invalidate(buffer, buflen);
+  } else {
+    hcd_dcache_clean(buffer, buflen);
+  }
+
+  // ISR retires TDs, disable it while building and linking. Frame number is read afterward so that the schedule
+  // is anchored to the frame it is linked in.
+  hcd_int_disable(rhport);
+
+  // continue the stream if possible, otherwise start at the next frame in phase of reserved schedule
+  uint32_t const now = hcd_frame_number(rhport);
+  uint32_t frame = iso_ep->next_frame;
+  if ((int32_t) (frame - now) < ISO_SCHEDULE_DELAY) {
+    frame = now + ISO_SCHEDULE_DELAY;
+    frame += (iso_ep->frame_phase + frame_interval - (frame % frame_interval)) % frame_interval;
+  }
+
+  // all TDs must be within frame list before it wraps around
+  bool const in_framelist = (frame - now) + (uint32_t) (td_count - 1) * frame_interval < FRAMELIST_SIZE;
+  if (!in_framelist) {
+    hcd_int_enable(rhport);
+  }
+  TU_ASSERT(in_framelist);
+
+  uint8_t const xfer_idx = (uint8_t) ((iso_ep->xfer_rd + iso_ep->xfer_count) % EHCI_ISO_XFER_MAX);
+  iso_ep->xfer[xfer_idx].buffer        = buffer;
+  iso_ep->xfer[xfer_idx].total_bytes   = buflen;
+  iso_ep->xfer[xfer_idx].xferred_bytes = highspeed ? 0 : buflen; // siTD reports remaining bytes
+  iso_ep->xfer[xfer_idx].xfer_err      = 0;
+  iso_ep->xfer[xfer_idx].td_pending    = td_count;
+  iso_ep->xfer[xfer_idx].start_frame   = frame;
+  iso_ep->xfer_count++;
+
+  uint8_t* packet = buffer;
+  uint32_t remaining = buflen;
+
+  for (uint16_t t = 0; t < td_count; t++) {
+    uint8_t const frame_idx = (uint8_t) (frame & (FRAMELIST_SIZE - 1));
+
+    if (highspeed) {
+      uint8_t i;
+      for (i = 0; i < ITD_MAX && ehci_data.itd_extra[i].used; i++) {}
+
+      ehci_itd_t* itd = &ehci_data.itd_pool[i];
+      ehci_itd_extra_t* extra = &ehci_data.itd_extra[i];
+      tu_memclr(itd, sizeof(ehci_itd_t));
+
+      uint32_t const page_base = tu_align4k((uint32_t) packet);
+      uint8_t xact_mask = 0;
+      uint8_t last_u = 0;
+
+      for (uint8_t u = 0; u < 8; u++) {
+        if (!tu_bit_test(iso_ep->uframe_smask, u)) continue;
+
+        uint16_t const len = (uint16_t) tu_min32(remaining, xact_max);
+        uint32_t const offset = (uint32_t) packet - page_base;
+
+        itd->xact[u].offset      = offset & 0xFFFu;
+        itd->xact[u].page_select = offset >> 12;
+        itd->xact[u].length      = len;
+        itd->xact[u].active      = 1;
+
+        xact_mask |= (uint8_t) TU_BIT(u);
+        last_u = u;
+
+        packet += len;
+        remaining -= len;
+        if (remaining == 0) break;
+      }
+
+      // interrupt when the whole transfer is complete
+      if (remaining == 0) {
+        itd->xact[last_u].int_on_complete = 1;
+      }
+
+      for (uint8_t p = 0; p < 7; p++) {
+        itd->BufferPointer[p] = page_base + 4096u * p;
+      }
+      itd->BufferPointer[0] |= ((uint32_t) epnum << 8) | iso_ep->dev_addr;
+      itd->BufferPointer[1] |= ((uint32_t) dir << 11) | mps;
+      itd->BufferPointer[2] |= iso_ep->mult; // transactions per micro-frame
+
+      extra->used      = 1;
+      extra->ep_idx    = ep_idx;
+      extra->frame     = frame_idx;
+      extra->xact_mask = xact_mask;
+      extra->xfer_idx  = xfer_idx;
+
+      iso_td_link(frame_idx, &itd->next, EHCI_QTYPE_ITD, sizeof(ehci_itd_t));
+    } else {
+      uint8_t i;
+      for (i = 0; i < SITD_MAX && ehci_data.sitd_pool[i].used; i++) {}
+
+      ehci_sitd_t* sitd = &ehci_data.sitd_pool[i];
+      tu_memclr(sitd, sizeof(ehci_sitd_t));
+
+      uint16_t const len = (uint16_t) tu_min32(remaining, mps);
+
+      sitd->dev_addr     = iso_ep->dev_addr;
+      sitd->ep_number    = epnum;
+      sitd->hub_addr     = iso_ep->hub_addr;
+      sitd->port_number  = iso_ep->hub_port;
+      sitd->direction    = dir;
+      sitd->int_smask    = iso_ep->uframe_smask;
+      sitd->fl_int_cmask = iso_ep->fl_cmask;
+
+      sitd->total_bytes     = len;
+      sitd->active          = 1;
+      sitd->int_on_complete = (remaining == len) ? 1 : 0;
+
+      // OUT: number of start-splits and their position
+      uint8_t const tcount = dir ? 1 : (uint8_t) tu_div_ceil(tu_max16(len, 1), 188);
+      sitd->buffer[0] = (uint32_t) packet;
+      sitd->buffer[1] = (tu_align4k((uint32_t) packet) + 4096u) |
+                        ((uint32_t) (tcount > 1 ? SITD_TP_BEGIN : SITD_TP_ALL) << 3) | tcount;
+      sitd->back.terminate = 1;
+
+      sitd->used     = 1;
+      sitd->ep_idx   = ep_idx;
+      sitd->frame    = frame_idx;
+      sitd->xfer_idx = xfer_idx;
+
+      iso_td_link(frame_idx, &sitd->next, EHCI_QTYPE_SITD, sizeof(ehci_sitd_t));
+
+      packet += len;
+      remaining -= len;
+    }
+
+    frame += frame_interval;
+  }
+
+  iso_ep->next_frame = frame;
+
+  hcd_int_enable(rhport);
+
+  return true;
+}
+
+// Unlink and free all TDs of an endpoint, periodic schedule should be disabled
+static void iso_ep_remove_td(ehci_iso_ep_t* iso_ep) {
+  uint8_t const ep_idx = (uint8_t) (iso_ep - ehci_data.iso_ep);
+
+  for (uint8_t i = 0; i < ITD_MAX; i++) {
+    ehci_itd_extra_t* extra = &ehci_data.itd_extra[i];
+    if (extra->used && extra->ep_idx == ep_idx) {
+      iso_td_unlink(extra->frame, &ehci_data.itd_pool[i].next);
+      extra->used = 0;
+    }
+  }
+
+  for (uint8_t i = 0; i < SITD_MAX; i++) {
+    ehci_sitd_t* sitd = &ehci_data.sitd_pool[i];
+    if (sitd->used && sitd->ep_idx == ep_idx) {
+      iso_td_unlink(sitd->frame, &sitd->next);
+      sitd->used = 0;
+    }
+  }
+
+  iso_ep->xfer_rd = 0;
+  iso_ep->xfer_count = 0;
+}
+
+// TD frame is behind current frame but HC has not executed it e.g linked too late: it would otherwise run when
+// frame list wraps around. TDs of a transfer are within frame list size from its first one. Complete-split of
+// siTD can run in the frame following the scheduled one.
+static bool iso_td_missed(ehci_iso_ep_t const* iso_ep, uint8_t xfer_idx, uint8_t frame_idx, uint32_t now) {
+  uint32_t const start = iso_ep->xfer[xfer_idx].start_frame;
+  uint32_t const td_frame = start + ((frame_idx - start) & (FRAMELIST_SIZE - 1));
+  return (int32_t) (now - td_frame) > 1;
+}
+
+// Retire completed iTD/siTD then notify usbh for endpoints whose transfer is complete. TD missed by HC is retired
+// as failed.
+static void iso_xfer_isr(uint8_t rhport) {
+  uint32_t const now = hcd_frame_number(rhport);
+
+  for (uint8_t i = 0; i < ITD_MAX; i++) {
+    ehci_itd_extra_t* extra = &ehci_data.itd_extra[i];
+    if (!extra->used) continue;
+
+    ehci_itd_t* itd = &ehci_data.itd_pool[i];
+    hcd_dcache_invalidate(itd, sizeof(ehci_itd_t));
+
+    ehci_iso_ep_t* iso_ep = &ehci_data.iso_ep[extra->ep_idx];
+    bool active = false;
+    for (uint8_t u = 0; u < 8; u++) {
+      if (tu_bit_test(extra->xact_mask, u) && itd->xact[u].active) {
+        active = true;
+      }
+    }
+    bool const missed = active && iso_td_missed(iso_ep, extra->xfer_idx, extra->frame, now);
+    if (active && !missed) continue;
+
+    for (uint8_t u = 0; u < 8; u++) {
+      if (tu_bit_test(extra->xact_mask, u)) {
+        if (itd->xact[u].active) {
+          iso_ep->xfer[extra->xfer_idx].xfer_err = 1;
+          continue;
+        }
+        // IN: HC writes back actual received length
+        iso_ep->xfer[extra->xfer_idx].xferred_bytes += itd->xact[u].length;
+        if (itd->xact[u].error || itd->xact[u].babble_err || itd->xact[u].buffer_err) {
+          iso_ep->xfer[extra->xfer_idx].xfer_err = 1;
+        }
+      }
+    }
+
+    iso_td_unlink(extra->frame, &itd->next);
+    extra->used = 0;
+    iso_ep->xfer[extra->xfer_idx].td_pending--;
+  }
+
+  for (uint8_t i = 0; i < SITD_MAX; i++) {
+    ehci_sitd_t* sitd = &ehci_data.sitd_pool[i];
+    if (!sitd->used) continue;
+
+    hcd_dcache_invalidate(sitd, sizeof(ehci_sitd_t));
+
+    ehci_iso_ep_t* iso_ep = &ehci_data.iso_ep[sitd->ep_idx];
+    bool const missed = sitd->active && iso_td_missed(iso_ep, sitd->xfer_idx, sitd->frame, now);
+    if (sitd->active && !missed) continue;
+
+    iso_ep->xfer[sitd->xfer_idx].xferred_bytes -= sitd->total_bytes; // remaining bytes
+    if (missed || sitd->error || sitd->xact_err || sitd->babble_err || sitd->buffer_err || sitd->missed_uframe) {
+      iso_ep->xfer[sitd->xfer_idx].xfer_err = 1;
+    }
+
+    iso_td_unlink(sitd->frame, &sitd->next);
+    sitd->used = 0;
+    iso_ep->xfer[sitd->xfer_idx].td_pending--;
+  }
+
+  // complete queued transfers in order
+  for (uint8_t i = 0; i < ISO_EP_MAX; i++) {
+    ehci_iso_ep_t* iso_ep = &ehci_data.iso_ep[i];
+    if (!iso_ep->used) continue;
+
+    while (iso_ep->xfer_count && iso_ep->xfer[iso_ep->xfer_rd].td_pending == 0) {
+      uint8_t const rd = iso_ep->xfer_rd;
+      iso_ep->xfer_rd = (uint8_t) ((rd + 1) % EHCI_ISO_XFER_MAX);
+      iso_ep->xfer_count--;
+
+      if (tu_edpt_dir(iso_ep->ep_addr) == TUSB_DIR_IN && iso_ep->xfer[rd].total_bytes > 0) {
+        hcd_dcache_invalidate(iso_ep->xfer[rd].buffer, iso_ep->xfer[rd].total_bytes);
+      }
+
+      hcd_event_xfer_complete(iso_ep->dev_addr, iso_ep->ep_addr, iso_ep->xfer[rd].xferred_bytes,
+                              iso_ep->xfer[rd].xfer_err ? XFER_RESULT_FAILED : XFER_RESULT_SUCCESS, true);
+    }
+  }
+}
+
+#endif
+
 #endif
@@ -49,8 +49,17 @@
 
 // TODO merge OHCI with EHCI
 enum {
-  EHCI_MAX_ITD  = 4,
-  EHCI_MAX_SITD = 16
+  EHCI_MAX_ITD  = 8,
+  EHCI_MAX_SITD = 16,
+  EHCI_ISO_XFER_MAX = 2, ///< transfers queued per isochronous endpoint, next one is scheduled right after previous
+};
+
+// Periodic bandwidth budget (in bytes of bus time) as USB 2.0 section 5.6.4:
+// 80% of a highspeed micro-frame and 90% of a full-speed frame (for split transactions)
+enum {
+  EHCI_PERIOD_BW_FRAMES     = 8,
+  EHCI_PERIOD_BW_UFRAME_MAX = 6000,
+  EHCI_PERIOD_BW_FRAME_MAX  = 1350,
 };
 
 //--------------------------------------------------------------------+
@@ -90,16 +99,8 @@ typedef struct
 	// Word 0: Next QTD Pointer
 	ehci_link_t next;
 
-	// Word 1: Alternate Next QTD Pointer (not used)
-	union{
-	  ehci_link_t alternate;
-	  struct {
-	    uint32_t                : 5;
-	    uint32_t used           : 1;
-	    uint32_t                : 10;
-	    uint32_t expected_bytes : 16;
-	  };
-	};
+	// Word 1: Alternate Next QTD Pointer, only used by chained IN qTD to stop the queue on short packet
+	ehci_link_t alternate;
 
 	// Word 2: qTQ Token
 	volatile uint32_t ping_err             : 1  ; ///< For Highspeed: 0 Out, 1 Ping. Full/Slow used as error indicator
@@ -125,6 +126,15 @@ typedef struct
 
 TU_VERIFY_STATIC( sizeof(ehci_qtd_t) == 32, "size is not correct" );
 
+/// Extra data needed by qTD that can't fit in the TD struct: HC updates the current offset of the
+/// first buffer pointer and chained IN qTD uses its alternate pointer.
+typedef struct {
+  uint32_t buffer;         // initial buffer address
+  uint16_t expected_bytes; // bytes to transfer by this qTD
+  uint8_t  used;
+  uint8_t  TU_RESERVED;
+} ehci_qtd_extra_t;
+
 /// Queue Head
 typedef struct TU_ATTR_ALIGNED(32)
 {
@@ -166,10 +176,10 @@ typedef struct TU_ATTR_ALIGNED(32)
 
 	uint8_t TU_RESERVED[4];
 
-  // Attached TD management, note usbh will only queue 1 TD per QHD.
-  // buffer for dcache invalidate since td's buffer is modified by HC and finding initial buffer address is not trivial
-  uint32_t attached_buffer;
-	ehci_qtd_t * volatile attached_qtd;
+  // Attached TD management: list of queued qTDs linked by next pointer, each transfer is a chain of
+  // one or more qTDs where only the last one has int_on_complete set.
+  ehci_qtd_t * volatile attached_qtd; // first qTD of the oldest queued transfer
+	ehci_qtd_t * volatile tail_qtd;     // last qTD of the newest queued transfer
 } ehci_qhd_t;
 
 TU_VERIFY_STATIC( sizeof(ehci_qhd_t) == 64, "size is not correct" );
@@ -206,6 +216,15 @@ typedef struct TU_ATTR_ALIGNED(32) {
 
 TU_VERIFY_STATIC( sizeof(ehci_itd_t) == 64, "size is not correct" );
 
+/// Extra data needed by iTD that can't fit in the TD struct
+typedef struct {
+  uint8_t used;
+  uint8_t ep_idx;    ///< isochronous endpoint that owns this TD
+  uint8_t frame;     ///< frame list index this TD is linked to
+  uint8_t xact_mask; ///< transaction slots (micro-frames) in use
+  uint8_t xfer_idx;  ///< queued transfer of the endpoint this TD belongs to
+} ehci_itd_extra_t;
+
 /// Split (Full-Speed) Isochronous Transfer Descriptor
 typedef struct TU_ATTR_ALIGNED(32)
 {
@@ -253,12 +272,47 @@ typedef struct TU_ATTR_ALIGNED(32)
 
 	/// SITD is 32-byte aligned but occupies only 28 --> 4 bytes for storing extra data
 	uint8_t used;
-	uint8_t ihd_idx;
-	uint8_t reserved2[2];
+	uint8_t ep_idx; ///< isochronous endpoint that owns this TD
+	uint8_t frame;  ///< frame list index this TD is linked to
+	uint8_t xfer_idx; ///< queued transfer of the endpoint this TD belongs to
 } ehci_sitd_t;
 
 TU_VERIFY_STATIC( sizeof(ehci_sitd_t) == 32, "size is not correct" );
 
+/// Isochronous endpoint: highspeed uses iTD, full-speed behind a TT uses siTD
+typedef struct {
+  uint8_t  used;
+  uint8_t  dev_addr;
+  uint8_t  ep_addr;
+  uint8_t  speed;
+
+  uint16_t max_packet_size;
+  uint8_t  mult;           ///< highspeed: transactions per micro-frame (high-bandwidth), 1 otherwise
+  uint16_t interval;       ///< micro-frames for highspeed, frames for full-speed
+  uint16_t frame_interval; ///< interval in frames, at least 1
+  uint16_t bw_bytes;       ///< reserved bus time per transaction
+
+  uint8_t  frame_phase;    ///< scheduled frames are frame_phase mod frame_interval
+  uint8_t  uframe_smask;   ///< highspeed: micro-frames used within a frame, full-speed: start-split mask
+  uint8_t  fl_cmask;       ///< full-speed: complete-split mask
+  uint8_t  hub_addr;
+  uint8_t  hub_port;
+
+  // queued transfers, completed in order
+  struct {
+    volatile uint8_t  xfer_err;
+    volatile uint16_t td_pending;  ///< TDs linked to frame list but not yet retired
+    uint32_t start_frame;          ///< frame number of the first TD
+    uint8_t* buffer;
+    uint16_t total_bytes;
+    volatile uint32_t xferred_bytes;
+  } xfer[EHCI_ISO_XFER_MAX];
+
+  volatile uint8_t xfer_rd;        ///< oldest queued transfer
+  volatile uint8_t xfer_count;     ///< number of queued transfers
+  uint32_t next_frame;             ///< frame number to schedule next transfer, keeping the stream continuous
+} ehci_iso_ep_t;
+
 //--------------------------------------------------------------------+
 // EHCI Operational Register
 //--------------------------------------------------------------------+
@@ -361,7 +361,7 @@ void dcd_edpt_close_all(uint8_t rhport)
   _allocated_fifos = 1;
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint32_t total_bytes)
 {
   (void)rhport;
 
@@ -371,12 +371,12 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
   xfer_ctl_t * xfer = XFER_CTL_BASE(epnum, dir);
   xfer->buffer       = buffer;
   // xfer->ff           = NULL; // TODO support dcd_edpt_xfer_fifo API
-  xfer->total_len    = total_bytes;
+  xfer->total_len    = (uint16_t) total_bytes;
   xfer->queued_len   = 0;
   xfer->short_packet = false;
 
-  uint16_t num_packets = (total_bytes / xfer->max_size);
-  uint8_t short_packet_size = total_bytes % xfer->max_size;
+  uint16_t num_packets = (uint16_t) (total_bytes / xfer->max_size);
+  uint8_t short_packet_size = (uint8_t) (total_bytes % xfer->max_size);
 
   // Zero-size packet is special case.
   if (short_packet_size > 0 || (total_bytes == 0)) {
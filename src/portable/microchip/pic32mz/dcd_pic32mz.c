@@ -450,7 +450,7 @@ void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr)
   (void) ep_addr;
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes)
 {
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir   = tu_edpt_dir(ep_addr);
@@ -458,7 +458,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t t
   (void) rhport;
 
   xfer->buffer = buffer;
-  xfer->total_len = total_bytes;
+  xfer->total_len = (uint16_t) total_bytes;
   xfer->last_packet_size = 0;
   xfer->transferred = 0;
 
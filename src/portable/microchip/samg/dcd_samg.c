@@ -282,7 +282,7 @@ void dcd_edpt_close_all (uint8_t rhport)
 }
 
 // Submit a transfer, When complete dcd_event_xfer_complete() is invoked to notify the stack
-bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes)
 {
   (void) rhport;
 
@@ -290,7 +290,7 @@ bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
   xfer_desc_t* xfer = &_dcd_xfer[epnum];
-  xfer_begin(xfer, buffer, total_bytes);
+  xfer_begin(xfer, buffer, (uint16_t) total_bytes);
 
   if (dir == TUSB_DIR_OUT)
   {
@@ -605,7 +605,7 @@ static void dcd_transmit_packet(xfer_ctl_t * xfer, uint8_t ep_ix)
 }
 
 // Submit a transfer, When complete dcd_event_xfer_complete() is invoked to notify the stack
-bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes)
 {
   (void) rhport;
   uint8_t const epnum = tu_edpt_number(ep_addr);
@@ -614,7 +614,7 @@ bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t
   xfer_ctl_t * xfer = &xfer_status[epnum];
 
   xfer->buffer = buffer;
-  xfer->total_len = total_bytes;
+  xfer->total_len = (uint16_t) total_bytes;
   xfer->queued_len = 0;
   xfer->fifo = NULL;
 
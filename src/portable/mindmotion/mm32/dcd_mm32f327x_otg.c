@@ -381,7 +381,7 @@ void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr)
   bd->head            = 0;
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes)
 {
   (void) rhport;
   NVIC_DisableIRQ(USB_FS_IRQn);
@@ -394,8 +394,8 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
     TU_LOG1("DCD XFER fail %x %d %lx %lx\r\n", ep_addr, total_bytes, ep->state, bd->head);
     return false; /* The last transfer has not completed */
   }
-  ep->length    = total_bytes;
-  ep->remaining = total_bytes;
+  ep->length    = (uint16_t) total_bytes;
+  ep->remaining = (uint16_t) total_bytes;
 
   const unsigned mps = ep->max_packet_size;
   if (total_bytes > mps) {
@@ -28,8 +28,6 @@
 
 #if CFG_TUD_ENABLED && CFG_TUSB_MCU == OPT_MCU_NRF5X
 
-#include <stdatomic.h>
-
 // Suppress warning caused by nrfx driver
 #ifdef __GNUC__
 #pragma GCC diagnostic push
@@ -50,7 +48,6 @@
 
 // TODO remove later
 #include "device/usbd.h"
-#include "device/usbd_pvt.h" // to use defer function helper
 
 #if CFG_TUSB_OS == OPT_OS_MYNEWT
 #include "mcu/mcu.h"
@@ -94,6 +91,16 @@ enum {
   EP_CBI_COUNT = 8  // Control Bulk Interrupt endpoints count
 };
 
+// EasyDMA job: IN endpoint number, OUT endpoint number + 16, and EP0 tasks that also require EasyDMA
+enum {
+  DMA_JOB_OUT_OFFSET = 16,
+  DMA_JOB_EP0STATUS  = EP_ISO_NUM + 1,
+  DMA_JOB_EP0RCVOUT  = DMA_JOB_OUT_OFFSET + EP_ISO_NUM + 1,
+
+  DMA_JOB_ISO_MASK     = TU_BIT(EP_ISO_NUM) | TU_BIT(DMA_JOB_OUT_OFFSET + EP_ISO_NUM),
+  DMA_JOB_CONTROL_MASK = TU_BIT(0) | TU_BIT(DMA_JOB_OUT_OFFSET) | TU_BIT(DMA_JOB_EP0STATUS) | TU_BIT(DMA_JOB_EP0RCVOUT)
+};
+
 // Transfer Descriptor
 typedef struct {
   uint8_t* buffer;
@@ -118,8 +125,11 @@ static struct {
   // +1 for ISO endpoints
   xfer_td_t xfer[EP_CBI_COUNT + 1][2];
 
-  // nRF can only carry one DMA at a time, this is used to guard the access to EasyDMA
-  atomic_flag dma_running;
+  // nRF can only carry one DMA at a time: EasyDMA is busy, bitmap of jobs waiting for it
+  // and last bulk/interrupt job served for round-robin
+  volatile bool dma_running;
+  uint32_t dma_pending;
+  uint8_t dma_rr;
 
   // Track whether sof has been manually enabled
   bool sof_enabled;
@@ -134,72 +144,129 @@ TU_ATTR_ALWAYS_INLINE static inline bool is_in_isr(void) {
   return (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) ? true : false;
 }
 
+// helper getting td
+static inline xfer_td_t* get_td(uint8_t epnum, uint8_t dir) {
+  return &_dcd.xfer[epnum][dir];
+}
+
+/*------------------------------------------------------------------*/
+/* EasyDMA arbitration
+ * nRF can only carry one DMA at a time. Endpoints that need EasyDMA post a job to the pending bitmap, the job is
+ * started right away if EasyDMA is free, otherwise the END event of the running DMA starts the next one without
+ * leaving the ISR. ISO is served first since it must complete within the frame, then control, then bulk/interrupt
+ * in round-robin so that no endpoint can starve the others.
+ *------------------------------------------------------------------*/
+static void xact_out_dma(uint8_t epnum);
+static void xact_in_dma(uint8_t epnum);
+
 // helper to start DMA
 static void start_dma(volatile uint32_t* reg_startep) {
+  _dcd.dma_running = true;
+
   (*reg_startep) = 1;
   __ISB();
   __DSB();
 
   // TASKS_EP0STATUS, TASKS_EP0RCVOUT seem to need EasyDMA to be available
   // However these don't trigger any DMA transfer and got ENDED event subsequently
-  // Therefore dma_pending is corrected right away
+  // Therefore dma_running is corrected right away
   if ((reg_startep == &NRF_USBD->TASKS_EP0STATUS) || (reg_startep == &NRF_USBD->TASKS_EP0RCVOUT)) {
-    atomic_flag_clear(&_dcd.dma_running);
+    _dcd.dma_running = false;
   }
 }
 
-static void edpt_dma_start(volatile uint32_t* reg_startep) {
-  if (atomic_flag_test_and_set(&_dcd.dma_running)) {
-    usbd_defer_func((osal_task_func_t)(uintptr_t ) edpt_dma_start, (void*) (uintptr_t) reg_startep, is_in_isr());
+TU_ATTR_ALWAYS_INLINE static inline uint8_t dma_job_out(uint8_t epnum) {
+  return (uint8_t) (DMA_JOB_OUT_OFFSET + epnum);
+}
+
+static void dma_job_start(uint8_t job) {
+  if (job == DMA_JOB_EP0STATUS) {
+    start_dma(&NRF_USBD->TASKS_EP0STATUS);
+  } else if (job == DMA_JOB_EP0RCVOUT) {
+    start_dma(&NRF_USBD->TASKS_EP0RCVOUT);
+  } else if (job >= DMA_JOB_OUT_OFFSET) {
+    xact_out_dma((uint8_t) (job - DMA_JOB_OUT_OFFSET));
   } else {
-    start_dma(reg_startep);
+    xact_in_dma(job);
   }
 }
 
-// DMA is complete
-static void edpt_dma_end(void) {
-  atomic_flag_clear(&_dcd.dma_running);
+// pick next job: ISO, then control, then bulk/interrupt round-robin after the last served one
+static uint8_t dma_job_next(void) {
+  uint32_t const pending = _dcd.dma_pending;
+
+  uint32_t const prio = (pending & DMA_JOB_ISO_MASK) ? (pending & DMA_JOB_ISO_MASK) : (pending & DMA_JOB_CONTROL_MASK);
+  if (prio) {
+    return (uint8_t) __CLZ(__RBIT(prio)); // lowest set bit
+  }
+
+  uint8_t job = _dcd.dma_rr;
+  for (uint8_t i = 0; i < 32; i++) {
+    job = (uint8_t) ((job + 1) & 0x1fu);
+    if (tu_bit_test(pending, job)) {
+      break;
+    }
+  }
+
+  _dcd.dma_rr = job;
+  return job;
 }
 
-// helper getting td
-static inline xfer_td_t* get_td(uint8_t epnum, uint8_t dir) {
-  return &_dcd.xfer[epnum][dir];
+// start pending jobs until one of them occupies EasyDMA. Called from ISR or with USBD interrupt masked
+static void dma_schedule(void) {
+  while (!_dcd.dma_running && _dcd.dma_pending) {
+    uint8_t const job = dma_job_next();
+    _dcd.dma_pending &= ~TU_BIT(job);
+    dma_job_start(job);
+  }
 }
 
-static void xact_out_dma(uint8_t epnum);
+static void dma_update(uint32_t job_mask, bool request) {
+  // mask USBD interrupt (also fine within its own ISR) to update the queue, restore previous state after
+  bool const int_enabled = NVIC_GetEnableIRQ(USBD_IRQn) ? true : false;
+  NVIC_DisableIRQ(USBD_IRQn);
+
+  if (request) {
+    _dcd.dma_pending |= job_mask;
+    dma_schedule();
+  } else {
+    _dcd.dma_pending &= ~job_mask;
+  }
+
+  if (int_enabled) {
+    NVIC_EnableIRQ(USBD_IRQn);
+  }
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void dma_request(uint8_t job) {
+  dma_update(TU_BIT(job), true);
+}
 
-// Function wraps xact_out_dma which wants uint8_t while usbd_defer_func wants void (*)(void *)
-static void xact_out_dma_wrapper(void* epnum) {
-  xact_out_dma((uint8_t) ((uintptr_t) epnum));
+TU_ATTR_ALWAYS_INLINE static inline void dma_cancel(uint8_t job) {
+  dma_update(TU_BIT(job), false);
+}
+
+// DMA is complete, chain next pending job
+static void edpt_dma_end(void) {
+  _dcd.dma_running = false;
+  dma_schedule();
 }
 
-// Start DMA to move data from Endpoint -> RAM
+// Start DMA to move data from Endpoint -> RAM. EasyDMA must be free:
+// DMA can't be active during read of SIZE.EPOUT or SIZE.ISOOUT
 static void xact_out_dma(uint8_t epnum) {
   xfer_td_t* xfer = get_td(epnum, TUSB_DIR_OUT);
   uint32_t xact_len;
 
-  // DMA can't be active during read of SIZE.EPOUT or SIZE.ISOOUT, so try to lock,
-  // If already running defer call regardless if it was called from ISR or task,
-  if (atomic_flag_test_and_set(&_dcd.dma_running)) {
-    usbd_defer_func((osal_task_func_t) xact_out_dma_wrapper, (void*) (uint32_t) epnum, is_in_isr());
-    return;
-  }
   if (epnum == EP_ISO_NUM) {
     xact_len = NRF_USBD->SIZE.ISOOUT;
     // If ZERO bit is set, ignore ISOOUT length
-    if (xact_len & USBD_SIZE_ISOOUT_ZERO_Msk) {
-      xact_len = 0;
-      atomic_flag_clear(&_dcd.dma_running);
-    } else {
-      if (xfer->started) {
-        // Trigger DMA move data from Endpoint -> SRAM
-        NRF_USBD->ISOOUT.PTR = (uint32_t) xfer->buffer;
-        NRF_USBD->ISOOUT.MAXCNT = xact_len;
+    if ((xact_len & USBD_SIZE_ISOOUT_ZERO_Msk) == 0 && xfer->started) {
+      // Trigger DMA move data from Endpoint -> SRAM
+      NRF_USBD->ISOOUT.PTR = (uint32_t) xfer->buffer;
+      NRF_USBD->ISOOUT.MAXCNT = xact_len;
 
-        start_dma(&NRF_USBD->TASKS_STARTISOOUT);
-      } else {
-        atomic_flag_clear(&_dcd.dma_running);
-      }
+      start_dma(&NRF_USBD->TASKS_STARTISOOUT);
     }
   } else {
     // limit xact len to remaining length
@@ -214,7 +281,7 @@ static void xact_out_dma(uint8_t epnum) {
 }
 
 // Prepare for a CBI transaction IN, call at the start
-// it start DMA to transfer data from RAM -> Endpoint
+// it start DMA to transfer data from RAM -> Endpoint. EasyDMA must be free
 static void xact_in_dma(uint8_t epnum) {
   xfer_td_t* xfer = get_td(epnum, TUSB_DIR_IN);
 
@@ -224,7 +291,7 @@ static void xact_in_dma(uint8_t epnum) {
   NRF_USBD->EPIN[epnum].PTR = (uint32_t) xfer->buffer;
   NRF_USBD->EPIN[epnum].MAXCNT = xact_len;
 
-  edpt_dma_start(&NRF_USBD->TASKS_STARTEPIN[epnum]);
+  start_dma(&NRF_USBD->TASKS_STARTEPIN[epnum]);
 }
 
 //--------------------------------------------------------------------+
@@ -373,6 +440,9 @@ void dcd_edpt_close_all(uint8_t rhport) {
     tu_memclr(_dcd.xfer[ep], 2 * sizeof(xfer_td_t));
   }
 
+  // drop queued DMA jobs of non-control endpoints
+  dma_update(~((uint32_t) DMA_JOB_CONTROL_MASK), false);
+
   // disable both ISO
   NRF_USBD->INTENCLR = USBD_INTENCLR_SOF_Msk | USBD_INTENCLR_ENDISOOUT_Msk | USBD_INTENCLR_ENDISOIN_Msk;
   NRF_USBD->ISOSPLIT = USBD_ISOSPLIT_SPLIT_OneDir;
@@ -422,11 +492,12 @@ void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
       NRF_USBD->INTENCLR = USBD_INTENCLR_SOF_Msk;
   }
   _dcd.xfer[epnum][dir].started = false;
+  dma_cancel((dir == TUSB_DIR_IN) ? epnum : dma_job_out(epnum));
   __ISB();
   __DSB();
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
   (void) rhport;
 
   uint8_t const epnum = tu_edpt_number(ep_addr);
@@ -436,7 +507,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
 
   TU_ASSERT(!xfer->started);
   xfer->buffer = buffer;
-  xfer->total_len = total_bytes;
+  xfer->total_len = (uint16_t) total_bytes;
   xfer->actual_len = 0;
 
   // Control endpoint with zero-length packet and opposite direction to 1st request byte --> status stage
@@ -447,12 +518,12 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
     dcd_event_xfer_complete(0, ep_addr, 0, XFER_RESULT_SUCCESS, is_in_isr());
 
     // Status Phase also requires EasyDMA has to be available as well !!!!
-    edpt_dma_start(&NRF_USBD->TASKS_EP0STATUS);
+    dma_request(DMA_JOB_EP0STATUS);
   } else if (dir == TUSB_DIR_OUT) {
     xfer->started = true;
     if (epnum == 0) {
       // Accept next Control Out packet. TASKS_EP0RCVOUT also require EasyDMA
-      edpt_dma_start(&NRF_USBD->TASKS_EP0RCVOUT);
+      dma_request(DMA_JOB_EP0RCVOUT);
     } else {
       // started just set, it could start DMA transfer if interrupt was trigger after this line
       // code only needs to start transfer (from Endpoint to RAM) when data_received was set
@@ -465,7 +536,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
         // Data is already received previously
         // start DMA to copy to SRAM
         xfer->data_received = false;
-        xact_out_dma(epnum);
+        dma_request(dma_job_out(epnum));
       } else {
         // nRF auto accept next Bulk/Interrupt OUT packet
         // nothing to do
@@ -473,7 +544,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
     }
   } else {
     // Start DMA to copy data from RAM -> Endpoint
-    xact_in_dma(epnum);
+    dma_request(epnum);
   }
 
   return true;
@@ -496,7 +567,7 @@ void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
     // There maybe data in endpoint fifo already, we need to pull it out
     if ((dir == TUSB_DIR_OUT) && xfer->data_received) {
       xfer->data_received = false;
-      xact_out_dma(epnum);
+      dma_request(dma_job_out(epnum));
     }
   }
 
@@ -601,7 +672,7 @@ void dcd_int_handler(uint8_t rhport) {
       // Transfer from endpoint to RAM only if data is not corrupted
       if ((int_status & USBD_INTEN_USBEVENT_Msk) == 0 ||
           (NRF_USBD->EVENTCAUSE & USBD_EVENTCAUSE_ISOOUTCRC_Msk) == 0) {
-        xact_out_dma(EP_ISO_NUM);
+        dma_request(dma_job_out(EP_ISO_NUM));
       }
     }
 
@@ -734,7 +805,7 @@ void dcd_int_handler(uint8_t rhport) {
       if ((epnum != EP_ISO_NUM) && (xact_len == xfer->mps) && (xfer->actual_len < xfer->total_len)) {
         if (epnum == 0) {
           // Accept next Control Out packet. TASKS_EP0RCVOUT also require EasyDMA
-          edpt_dma_start(&NRF_USBD->TASKS_EP0RCVOUT);
+          dma_request(DMA_JOB_EP0RCVOUT);
         } else {
           // nRF auto accept next Bulk/Interrupt OUT packet
           // nothing to do
@@ -776,7 +847,7 @@ void dcd_int_handler(uint8_t rhport) {
 
         if (xfer->actual_len < xfer->total_len) {
           // Start DMA to copy next data packet
-          xact_in_dma(epnum);
+          dma_request(epnum);
         } else {
           // CBI IN complete
           dcd_event_xfer_complete(0, epnum | TUSB_DIR_IN_MASK, xfer->actual_len, XFER_RESULT_SUCCESS, true);
@@ -790,7 +861,7 @@ void dcd_int_handler(uint8_t rhport) {
         xfer_td_t* xfer = get_td(epnum, TUSB_DIR_OUT);
 
         if (xfer->started && xfer->actual_len < xfer->total_len) {
-          xact_out_dma(epnum);
+          dma_request(dma_job_out(epnum));
         } else {
           // Data overflow !!! Nah, nRF will auto accept next Bulk/Interrupt OUT packet
           // Mark this endpoint with data received
@@ -309,7 +309,7 @@ void dcd_edpt_close_all (uint8_t rhport)
   // TODO implement dcd_edpt_close_all()
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint32_t total_bytes)
 {
   (void) rhport;
 
@@ -321,8 +321,8 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
   /* store away the information we'll needing now and later */
   xfer->data_ptr = buffer;
   // xfer->ff       = NULL; // TODO support dcd_edpt_xfer_fifo API
-  xfer->in_remaining_bytes = total_bytes;
-  xfer->total_bytes = total_bytes;
+  xfer->in_remaining_bytes = (uint16_t) total_bytes;
+  xfer->total_bytes = (uint16_t) total_bytes;
 
   /* for the first of one or more EP0_IN packets in a message, the first must be DATA1 */
   if ( (0x80 == ep_addr) && !active_ep0_xfer ) ep->CFG |= USBD_CFG_DSQSYNC_Msk;
@@ -363,7 +363,7 @@ void dcd_edpt_close_all (uint8_t rhport)
   // TODO implement dcd_edpt_close_all()
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint32_t total_bytes)
 {
   (void) rhport;
 
@@ -373,8 +373,8 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
     {
       USBD->CEPCTL = USBD_CEPCTL_FLUSH_Msk;
       ctrl_in_xfer.data_ptr = buffer;
-      ctrl_in_xfer.in_remaining_bytes = total_bytes;
-      ctrl_in_xfer.total_bytes = total_bytes;
+      ctrl_in_xfer.in_remaining_bytes = (uint16_t) total_bytes;
+      ctrl_in_xfer.total_bytes = (uint16_t) total_bytes;
       USBD->CEPINTSTS = USBD_CEPINTSTS_INTKIF_Msk;
       USBD->CEPINTEN = USBD_CEPINTEN_INTKIEN_Msk;
     }
@@ -389,7 +389,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
     {
       /* if TinyUSB is asking for EP0 OUT data, it is almost certainly already in the buffer */
       while (total_bytes < USBD->CEPRXCNT);
-      for (int count = 0; count < total_bytes; count++)
+      for (uint32_t count = 0; count < total_bytes; count++)
         *buffer++ = USBD->CEPDAT_BYTE;
 
       dcd_event_xfer_complete(0, ep_addr, total_bytes, XFER_RESULT_SUCCESS, true);
@@ -406,8 +406,8 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
     /* store away the information we'll needing now and later */
     xfer->data_ptr = buffer;
     // xfer->ff       = NULL; // TODO support dcd_edpt_xfer_fifo API
-    xfer->in_remaining_bytes = total_bytes;
-    xfer->total_bytes = total_bytes;
+    xfer->in_remaining_bytes = (uint16_t) total_bytes;
+    xfer->total_bytes = (uint16_t) total_bytes;
 
     if (TUSB_DIR_IN == dir)
     {
@@ -399,7 +399,7 @@ static bool control_xact(uint8_t rhport, uint8_t dir, uint8_t * buffer, uint8_t
   return true;
 }
 
-bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes)
 {
   // Control transfer is not DMA support, and must be done in slave mode
   if ( tu_edpt_number(ep_addr) == 0 )
@@ -420,7 +420,7 @@ bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t t
     dd->isochronous = is_iso;
     dd->max_packet_size = ep_size;
     dd->buffer = (uint32_t) buffer;
-    dd->buflen = total_bytes;
+    dd->buflen = (uint16_t) total_bytes;
 
     _dcd.udca[ep_id] = dd;
 
@@ -464,7 +464,7 @@ static void prepare_ep_xfer(uint8_t rhport, uint8_t ep_id, uint16_t buf_offset,
   ep_cs[0].cmd_sts.active = 1;
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
   uint8_t const ep_id = ep_addr2id(ep_addr);
 
   if (!buffer || total_bytes == 0) {
@@ -474,9 +474,9 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
   }
 
   tu_memclr(&_dcd.dma[ep_id], sizeof(xfer_dma_t));
-  _dcd.dma[ep_id].total_bytes = total_bytes;
+  _dcd.dma[ep_id].total_bytes = (uint16_t) total_bytes;
 
-  prepare_ep_xfer(rhport, ep_id, get_buf_offset(buffer), total_bytes);
+  prepare_ep_xfer(rhport, ep_id, get_buf_offset(buffer), (uint16_t) total_bytes);
 
   return true;
 }
@@ -70,7 +70,7 @@ static void hw_endpoint_alloc(struct hw_endpoint* ep, size_t size) {
   // round up size to multiple of 64
   size = tu_round_up(ep->wMaxPacketSize, 64);
 
-  // double buffered Bulk endpoint
+  // double buffered Bulk endpoint: room for two max packets
   if (ep->transfer_type == TUSB_XFER_BULK) {
     size *= 2u;
   }
@@ -114,6 +114,7 @@ static void hw_endpoint_init(uint8_t ep_addr, uint16_t wMaxPacketSize, uint8_t t
 
   // Clear existing buffer control state
   *ep->buffer_control = 0;
+  hw_endpoint_dbuf_reset(ep);
 
   if (num == 0) {
     // EP0 has no endpoint control register because the buffer offsets are fixed
@@ -145,7 +146,18 @@ static void hw_endpoint_open(uint8_t ep_addr, uint16_t wMaxPacketSize, uint8_t t
 
 static void hw_endpoint_xfer(uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
   struct hw_endpoint* ep = hw_endpoint_get_by_addr(ep_addr);
-  hw_endpoint_xfer_start(ep, buffer, total_bytes);
+
+  // bulk endpoint buffers are serviced by the IRQ while the transfer is started
+  bool const irq_enabled = irq_is_enabled(USBCTRL_IRQ);
+  irq_set_enabled(USBCTRL_IRQ, false);
+
+  if (hw_endpoint_xfer_start(ep, buffer, total_bytes)) {
+    // complete with packet received ahead of this transfer
+    dcd_event_xfer_complete(0, ep->ep_addr, ep->xferred_len, XFER_RESULT_SUCCESS, false);
+    hw_endpoint_reset_transfer(ep);
+  }
+
+  irq_set_enabled(USBCTRL_IRQ, irq_enabled);
 }
 
 static void __tusb_irq_path_func(hw_handle_buff_status)(void) {
@@ -512,9 +524,9 @@ void dcd_edpt_close_all(uint8_t rhport) {
   reset_non_control_endpoints();
 }
 
-bool dcd_edpt_xfer(__unused uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+bool dcd_edpt_xfer(__unused uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
   assert(rhport == 0);
-  hw_endpoint_xfer(ep_addr, buffer, total_bytes);
+  hw_endpoint_xfer(ep_addr, buffer, (uint16_t) total_bytes);
   return true;
 }
 
@@ -532,6 +544,7 @@ void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
   // stall and clear current pending buffer
   // may need to use EP_ABORT
   _hw_endpoint_buffer_control_set_value32(ep, USB_BUF_CTRL_STALL);
+  hw_endpoint_dbuf_reset(ep);
 }
 
 void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
@@ -543,6 +556,7 @@ void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
     // clear stall also reset toggle to DATA0, ready for next transfer
     ep->next_pid = 0;
     _hw_endpoint_buffer_control_clear_mask32(ep, USB_BUF_CTRL_STALL);
+    hw_endpoint_dbuf_reset(ep);
   }
 }
 
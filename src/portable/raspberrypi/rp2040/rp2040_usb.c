@@ -36,6 +36,9 @@
 // MACRO CONSTANT TYPEDEF PROTOTYPE
 //--------------------------------------------------------------------+
 static void _hw_endpoint_xfer_sync(struct hw_endpoint* ep);
+static void dbuf_arm_idle(struct hw_endpoint* ep);
+static bool dbuf_sync(struct hw_endpoint* ep, uint8_t buf_id, uint16_t buf_ctrl);
+static bool dbuf_xfer_continue(struct hw_endpoint* ep);
 
 #if TUD_OPT_RP2040_USB_DEVICE_UFRAME_FIX
   static bool e15_is_bulkin_ep(struct hw_endpoint* ep);
@@ -50,6 +53,11 @@ TU_ATTR_ALWAYS_INLINE static inline bool is_host_mode(void) {
   return (usb_hw->main_ctrl & USB_MAIN_CTRL_HOST_NDEVICE_BITS) ? true : false;
 }
 
+// device bulk endpoint is continuously double buffered
+TU_ATTR_ALWAYS_INLINE static inline bool is_dbuf_ep(struct hw_endpoint* ep) {
+  return !is_host_mode() && ep->transfer_type == TUSB_XFER_BULK;
+}
+
 //--------------------------------------------------------------------+
 // Implementation
 //--------------------------------------------------------------------+
@@ -153,12 +161,17 @@ static uint32_t __tusb_irq_path_func(prepare_ep_buffer)(struct hw_endpoint* ep,
 
 // Prepare buffer control register value
 void __tusb_irq_path_func(hw_endpoint_start_next_buffer)(struct hw_endpoint* ep) {
+  if (is_dbuf_ep(ep)) {
+    dbuf_arm_idle(ep);
+    return;
+  }
+
   uint32_t ep_ctrl = *ep->endpoint_control;
 
   // always compute and start with buffer 0
   uint32_t buf_ctrl = prepare_ep_buffer(ep, 0) | USB_BUF_CTRL_SEL;
 
-  // For now: skip double buffered for OUT endpoint in Device mode, since
+  // Skip double buffered for OUT endpoint in Device mode (bulk is handled above), since
   // host could send < 64 bytes and cause short packet on buffer0
   // NOTE: this could happen to Host mode IN endpoint
   // Also, Host mode "interrupt" endpoint hardware is only single buffered,
@@ -191,7 +204,8 @@ void __tusb_irq_path_func(hw_endpoint_start_next_buffer)(struct hw_endpoint* ep)
   _hw_endpoint_buffer_control_set_value32(ep, buf_ctrl);
 }
 
-void hw_endpoint_xfer_start(struct hw_endpoint* ep, uint8_t* buffer, uint16_t total_len) {
+// Returns true if transfer is already complete with a packet received ahead of it
+bool hw_endpoint_xfer_start(struct hw_endpoint* ep, uint8_t* buffer, uint16_t total_len) {
   hw_endpoint_lock_update(ep, 1);
 
   if (ep->active) {
@@ -206,6 +220,21 @@ void hw_endpoint_xfer_start(struct hw_endpoint* ep, uint8_t* buffer, uint16_t to
   ep->active = true;
   ep->user_buf = buffer;
 
+  if (is_dbuf_ep(ep)) {
+    ep->dbuf_loaded = false;
+
+    if (ep->dbuf_full) {
+      uint8_t const buf_id = (ep->dbuf_full & 0x02u) ? 1 : 0;
+      uint16_t const buf_ctrl = (uint16_t) (*ep->buffer_control >> (16u * buf_id));
+      ep->dbuf_full = 0;
+
+      if (dbuf_sync(ep, buf_id, buf_ctrl)) {
+        hw_endpoint_lock_update(ep, -1);
+        return true;
+      }
+    }
+  }
+
   if (e15_is_bulkin_ep(ep)) {
     usb_hw_set->inte = USB_INTS_DEV_SOF_BITS;
   }
@@ -217,6 +246,7 @@ void hw_endpoint_xfer_start(struct hw_endpoint* ep, uint8_t* buffer, uint16_t to
   }
 
   hw_endpoint_lock_update(ep, -1);
+  return false;
 }
 
 // sync endpoint buffer and return transferred bytes
@@ -302,6 +332,12 @@ static void __tusb_irq_path_func(_hw_endpoint_xfer_sync)(struct hw_endpoint* ep)
 bool __tusb_irq_path_func(hw_endpoint_xfer_continue)(struct hw_endpoint* ep) {
   hw_endpoint_lock_update(ep, 1);
 
+  if (is_dbuf_ep(ep)) {
+    bool const complete = dbuf_xfer_continue(ep);
+    hw_endpoint_lock_update(ep, -1);
+    return complete;
+  }
+
   // Part way through a transfer
   if (!ep->active) {
     panic("Can't continue xfer on inactive ep %02X", ep->ep_addr);
@@ -330,6 +366,146 @@ bool __tusb_irq_path_func(hw_endpoint_xfer_continue)(struct hw_endpoint* ep) {
   return false;
 }
 
+//--------------------------------------------------------------------+
+// Device Bulk Double Buffered
+//--------------------------------------------------------------------+
+// Device bulk endpoint keeps both buffers busy: each buffer is handed back to hardware as soon as it completes
+// while the other one is on the bus, and completes in the order hardware alternates between them. A short OUT
+// packet can leave the other buffer armed, its packet belongs to the next transfer and is kept until queued.
+
+void hw_endpoint_dbuf_reset(struct hw_endpoint* ep) {
+  ep->dbuf_armed = 0;
+  ep->dbuf_next = 0;
+  ep->dbuf_full = 0;
+}
+
+// Hand one buffer to hardware. Each half of buffer control is written on its own so that the other buffer,
+// which may be on the bus, is never touched
+static void __tusb_irq_path_func(dbuf_arm)(struct hw_endpoint* ep, uint8_t buf_id) {
+  uint32_t buf_ctrl;
+
+  if (ep->rx) {
+    // always receive a full packet, bytes beyond the transfer length are dropped when copied out
+    buf_ctrl = ep->wMaxPacketSize;
+  } else {
+    uint16_t const buflen = tu_min16(ep->remaining_len, ep->wMaxPacketSize);
+    ep->remaining_len = (uint16_t) (ep->remaining_len - buflen);
+
+    unaligned_memcpy(ep->hw_data_buf + buf_id * 64, ep->user_buf, buflen);
+    ep->user_buf += buflen;
+    ep->dbuf_loaded = true;
+
+    buf_ctrl = buflen | USB_BUF_CTRL_FULL;
+  }
+
+  buf_ctrl |= ep->next_pid ? USB_BUF_CTRL_DATA1_PID : USB_BUF_CTRL_DATA0_PID;
+  ep->next_pid ^= 1u;
+
+  // both buffers idle: restart hardware from buffer 0
+  if (ep->dbuf_armed == 0) {
+    buf_ctrl |= USB_BUF_CTRL_SEL;
+  }
+
+  io_rw_16* buf_ctrl16 = ((io_rw_16*) (uintptr_t) ep->buffer_control) + buf_id;
+  *buf_ctrl16 = (uint16_t) buf_ctrl;
+  // 4.1.2.5.1 Con-current access: 12 cycles after write to buffer control
+  busy_wait_at_least_cycles(12);
+  *buf_ctrl16 = (uint16_t) (buf_ctrl | USB_BUF_CTRL_AVAIL);
+
+  ep->dbuf_armed |= (uint8_t) TU_BIT(buf_id);
+}
+
+static bool __tusb_irq_path_func(dbuf_need_buffer)(struct hw_endpoint* ep) {
+  if (!ep->active) {
+    return false;
+  }
+
+  if (ep->rx) {
+    // don't arm more buffers than the transfer can take, at least one for zero-length transfer
+    uint8_t const armed_count = (uint8_t) ((ep->dbuf_armed & 0x01u) + (ep->dbuf_armed >> 1));
+    return (armed_count == 0) || (armed_count * ep->wMaxPacketSize < ep->remaining_len);
+  } else {
+    return (ep->remaining_len > 0) || !ep->dbuf_loaded;
+  }
+}
+
+static void __tusb_irq_path_func(dbuf_arm_idle)(struct hw_endpoint* ep) {
+  uint32_t ep_ctrl = *ep->endpoint_control;
+  uint32_t const ep_ctrl_dbuf = (ep_ctrl & ~EP_CTRL_INTERRUPT_PER_DOUBLE_BUFFER) |
+                                EP_CTRL_DOUBLE_BUFFERED_BITS | EP_CTRL_INTERRUPT_PER_BUFFER;
+  if (ep_ctrl != ep_ctrl_dbuf) {
+    *ep->endpoint_control = ep_ctrl_dbuf;
+  }
+
+  while (ep->dbuf_armed != 0x03u && dbuf_need_buffer(ep)) {
+    uint8_t buf_id;
+    if (ep->dbuf_armed == 0) {
+      ep->dbuf_next = 0;
+      buf_id = 0;
+    } else {
+      // the armed buffer completes first, the other one follows
+      buf_id = (uint8_t) (ep->dbuf_next ^ 1u);
+    }
+    dbuf_arm(ep, buf_id);
+  }
+}
+
+// Account a buffer returned by hardware, return true if transfer is complete
+static bool __tusb_irq_path_func(dbuf_sync)(struct hw_endpoint* ep, uint8_t buf_id, uint16_t buf_ctrl) {
+  uint16_t const len = (uint16_t) (buf_ctrl & USB_BUF_CTRL_LEN_MASK);
+
+  if (ep->rx) {
+    uint16_t const count = tu_min16(len, ep->remaining_len);
+    unaligned_memcpy(ep->user_buf, ep->hw_data_buf + buf_id * 64, count);
+    ep->user_buf += count;
+    ep->xferred_len = (uint16_t) (ep->xferred_len + count);
+    ep->remaining_len = (uint16_t) (ep->remaining_len - count);
+
+    // Short packet
+    if (len < ep->wMaxPacketSize) {
+      ep->remaining_len = 0;
+    }
+
+    return ep->remaining_len == 0;
+  } else {
+    ep->xferred_len = (uint16_t) (ep->xferred_len + len);
+    return (ep->remaining_len == 0) && (ep->dbuf_armed == 0);
+  }
+}
+
+static bool __tusb_irq_path_func(dbuf_xfer_continue)(struct hw_endpoint* ep) {
+  bool complete = false;
+
+  // both buffers may have completed by the time the interrupt is serviced
+  while (ep->dbuf_armed & TU_BIT(ep->dbuf_next)) {
+    uint8_t const buf_id = ep->dbuf_next;
+    uint16_t const buf_ctrl = (uint16_t) (*ep->buffer_control >> (16u * buf_id));
+    if (buf_ctrl & USB_BUF_CTRL_AVAIL) {
+      break; // still owned by hardware
+    }
+
+    ep->dbuf_armed &= (uint8_t) ~TU_BIT(buf_id);
+    ep->dbuf_next ^= 1u;
+
+    if (!ep->active || complete) {
+      // OUT packet of the next transfer
+      ep->dbuf_full |= (uint8_t) TU_BIT(buf_id);
+    } else {
+      complete = dbuf_sync(ep, buf_id, buf_ctrl);
+    }
+  }
+
+  if (!complete) {
+    if (e15_is_critical_frame_period(ep)) {
+      ep->pending = 1;
+    } else {
+      dbuf_arm_idle(ep);
+    }
+  }
+
+  return complete;
+}
+
 //--------------------------------------------------------------------+
 // Errata 15
 //--------------------------------------------------------------------+
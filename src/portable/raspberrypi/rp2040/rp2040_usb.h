@@ -83,6 +83,13 @@ typedef struct hw_endpoint
     // Transfer scheduled but not active
     uint8_t pending;
 
+    // Device bulk endpoint double buffering: bitmap of buffers owned by hardware, buffer that
+    // completes next, OUT buffer received ahead of the next transfer, first IN buffer is loaded
+    uint8_t dbuf_armed;
+    uint8_t dbuf_next;
+    uint8_t dbuf_full;
+    bool dbuf_loaded;
+
 #if CFG_TUH_ENABLED
     // Only needed for host
     uint8_t dev_addr;
@@ -99,9 +106,10 @@ extern volatile uint32_t e15_last_sof;
 
 void rp2040_usb_init(void);
 
-void hw_endpoint_xfer_start(struct hw_endpoint *ep, uint8_t *buffer, uint16_t total_len);
+bool hw_endpoint_xfer_start(struct hw_endpoint *ep, uint8_t *buffer, uint16_t total_len);
 bool hw_endpoint_xfer_continue(struct hw_endpoint *ep);
 void hw_endpoint_reset_transfer(struct hw_endpoint *ep);
+void hw_endpoint_dbuf_reset(struct hw_endpoint *ep);
 void hw_endpoint_start_next_buffer(struct hw_endpoint *ep);
 
 TU_ATTR_ALWAYS_INLINE static inline void hw_endpoint_lock_update(__unused struct hw_endpoint * ep, __unused int delta) {
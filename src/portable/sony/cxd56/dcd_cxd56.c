@@ -345,7 +345,7 @@ void dcd_edpt_close_all (uint8_t rhport)
   // TODO implement dcd_edpt_close_all()
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint32_t total_bytes)
 {
   (void) rhport;
 
@@ -372,7 +372,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
     }
     else
     {
-      usbdcd_driver.req[epnum]->len = total_bytes;
+      usbdcd_driver.req[epnum]->len = (uint16_t) total_bytes;
       usbdcd_driver.req[epnum]->priv = (void *)((uint32_t)ep_addr);
       usbdcd_driver.req[epnum]->flags = total_bytes < usbdcd_driver.ep[epnum]->maxpacket ? USBDEV_REQFLAGS_NULLPKT : 0;
       usbdcd_driver.req[epnum]->buf = buffer;
@@ -396,7 +396,7 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t to
   }
   else
   {
-    usbdcd_driver.req[epnum]->len = total_bytes;
+    usbdcd_driver.req[epnum]->len = (uint16_t) total_bytes;
     usbdcd_driver.req[epnum]->priv = (void *)((uint32_t)ep_addr);
     usbdcd_driver.req[epnum]->flags = total_bytes < usbdcd_driver.ep[epnum]->maxpacket ? USBDEV_REQFLAGS_NULLPKT : 0;
     usbdcd_driver.req[epnum]->buf = buffer;
@@ -76,7 +76,7 @@
  * - Packet buffer memory is copied in the interrupt.
  *   - This is better for performance, but means interrupts are disabled for longer
  *   - DMA may be the best choice, but it could also be pushed to the USBD task.
- * - No double-buffering
+ * - Double-buffering only for isochronous, and for bulk with CFG_TUD_FSDEV_DOUBLE_BUFFER
  * - No DMA
  * - Minimal error handling
  *   - Perhaps error interrupts should be reported to the stack, or cause a device reset?
@@ -101,9 +101,9 @@
  * - Tiny (saves RAM, assumes a single USB peripheral)
  *
  * Notes:
- * - The buffer table is allocated as endpoints are opened. The allocation is only
- *   cleared when the device is reset. This may be bad if the USB device needs
- *   to be reconfigured.
+ * - Packet buffers are allocated first-fit as endpoints are opened, and kept per hardware endpoint buffer. An endpoint
+ *   re-opened by an alternate setting keeps its buffer if large enough, otherwise it is reclaimed and allocated again.
+ *   All buffers but EP0 are released on bus reset or configuration change.
  */
 
 #include "tusb_option.h"
@@ -136,6 +136,8 @@ typedef struct {
   uint16_t max_packet_size;
   uint8_t ep_idx;   // index for USB_EPnR register
   bool iso_in_sending; // Workaround for ISO IN EP doesn't have interrupt mask
+  bool dbuf;           // double-buffered bulk
+  bool dbuf_busy;      // double-buffered OUT: transfer active, IN: next packet is prepared in application buffer
 } xfer_ctl_t;
 
 // EP allocator
@@ -143,10 +145,18 @@ typedef struct {
   uint8_t ep_num;
   uint8_t ep_type;
   bool allocated[2];
+  bool exclusive; // used by a single direction (isochronous or double-buffered)
 } ep_alloc_t;
 
+// Packet buffer allocated to each BTABLE entry, size is 0 if not owned
+typedef struct {
+  uint16_t addr;
+  uint16_t size;
+} pma_block_t;
+
 static xfer_ctl_t xfer_status[CFG_TUD_ENDPPOINT_MAX][2];
 static ep_alloc_t ep_alloc_status[FSDEV_EP_COUNT];
+static pma_block_t pma_block[FSDEV_EP_COUNT][2];
 static uint8_t remoteWakeCountdown; // When wake is requested
 
 //--------------------------------------------------------------------+
@@ -159,9 +169,9 @@ static void dcd_transmit_packet(xfer_ctl_t *xfer, uint16_t ep_ix);
 static bool edpt_xfer(uint8_t rhport, uint8_t ep_num, tusb_dir_t dir);
 
 // PMA allocation/access
-static uint16_t ep_buf_ptr; ///< Points to first free memory location
-static uint32_t dcd_pma_alloc(uint16_t len, bool dbuf);
-static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type);
+static bool dcd_pma_alloc(uint8_t ep_idx, uint8_t buf_id, uint16_t len);
+static void dcd_pma_free(uint8_t ep_idx);
+static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type, bool exclusive);
 static bool dcd_write_packet_memory(uint16_t dst, const void *__restrict src, uint16_t nbytes);
 static bool dcd_read_packet_memory(void *__restrict dst, uint16_t src, uint16_t nbytes);
 
@@ -266,16 +276,101 @@ static void handle_bus_reset(uint8_t rhport) {
     ep_alloc_status[i].ep_type = 0xFF;
     ep_alloc_status[i].allocated[0] = false;
     ep_alloc_status[i].allocated[1] = false;
-  }
+    ep_alloc_status[i].exclusive = false;
 
-  // Reset PMA allocation
-  ep_buf_ptr = FSDEV_BTABLE_BASE + 8 * FSDEV_EP_COUNT;
+    // Reset PMA allocation
+    dcd_pma_free((uint8_t) i);
+  }
 
   edpt0_open(rhport); // open control endpoint (both IN & OUT)
 
   FSDEV_REG->DADDR = USB_DADDR_EF; // Enable USB Function
 }
 
+//--------------------------------------------------------------------+
+// Double-buffered bulk
+// Hardware uses the buffer pointed by DTOG while application holds the one pointed by SW_BUF, which is the DTOG bit
+// of the unused direction. Application hands its buffer over by toggling SW_BUF, hardware NAKs while both bits are equal.
+// - OUT: starts with SW_BUF != DTOG. Equal means a received packet is waiting, which is taken by toggling SW_BUF
+//   then copied while hardware receives the next one into the other buffer.
+// - IN: starts with SW_BUF == DTOG. Next packet is copied into the held buffer while current one is transmitted, then
+//   released as soon as hardware completes the current one.
+//--------------------------------------------------------------------+
+
+TU_ATTR_ALWAYS_INLINE static inline void dbuf_toggle_swbuf(uint32_t ep_id, tusb_dir_t dir) {
+  uint32_t ep_reg = ep_read(ep_id) | USB_EP_CTR_TX | USB_EP_CTR_RX; // reserve CTR
+  ep_reg &= USB_EPREG_MASK;
+  ep_reg |= EP_DTOG_MASK(1 - dir); // write 1 to toggle SW_BUF
+  ep_write(ep_id, ep_reg, false);
+}
+
+// Copy received packets to active transfer, return true if transfer is complete
+static bool dbuf_rx_drain(xfer_ctl_t* xfer, uint32_t ep_id) {
+  while (xfer->dbuf_busy) {
+    uint32_t const ep_reg = ep_read(ep_id);
+    uint8_t const sw_buf = (ep_reg & USB_EP_DTOG_TX) ? 1 : 0;
+    if (sw_buf != ((ep_reg & USB_EP_DTOG_RX) ? 1 : 0)) {
+      break; // no packet waiting
+    }
+
+    // Take the filled buffer, hardware can receive into the other one meanwhile
+    dbuf_toggle_swbuf(ep_id, TUSB_DIR_OUT);
+    uint8_t const buf_id = sw_buf ^ 1;
+
+    uint16_t const rx_count = btable_get_count(ep_id, buf_id);
+    uint16_t const len = tu_min16(rx_count, xfer->total_len - xfer->queued_len);
+    uint16_t const pma_addr = (uint16_t) btable_get_addr(ep_id, buf_id);
+    if (xfer->ff) {
+      dcd_read_packet_memory_ff(xfer->ff, pma_addr, len);
+    } else {
+      dcd_read_packet_memory(xfer->buffer + xfer->queued_len, pma_addr, len);
+    }
+    xfer->queued_len += len;
+
+    if ((rx_count < xfer->max_packet_size) || (xfer->queued_len >= xfer->total_len)) {
+      xfer->dbuf_busy = false;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Copy next packet into the buffer held by application
+static void dbuf_tx_prepare(xfer_ctl_t* xfer, uint32_t ep_id) {
+  uint16_t const len = tu_min16(xfer->total_len - xfer->queued_len, xfer->max_packet_size);
+  uint8_t const buf_id = (ep_read(ep_id) & USB_EP_DTOG_RX) ? 1 : 0;
+  uint16_t const pma_addr = (uint16_t) btable_get_addr(ep_id, buf_id);
+
+  if (xfer->ff) {
+    dcd_write_packet_memory_ff(xfer->ff, pma_addr, len);
+  } else {
+    dcd_write_packet_memory(pma_addr, &(xfer->buffer[xfer->queued_len]), len);
+  }
+  xfer->queued_len += len;
+  btable_set_count(ep_id, buf_id, len);
+}
+
+// Continue transfer on IN completion, return true if transfer is complete
+static bool dbuf_tx_continue(xfer_ctl_t* xfer, uint32_t ep_id) {
+  uint32_t const ep_reg = ep_read(ep_id);
+  if (((ep_reg & USB_EP_DTOG_TX) ? 1 : 0) != ((ep_reg & USB_EP_DTOG_RX) ? 1 : 0)) {
+    return false; // released packet is not yet transmitted
+  }
+
+  if (!xfer->dbuf_busy) {
+    return true;
+  }
+
+  dbuf_toggle_swbuf(ep_id, TUSB_DIR_IN);
+  xfer->dbuf_busy = (xfer->queued_len < xfer->total_len);
+  if (xfer->dbuf_busy) {
+    dbuf_tx_prepare(xfer, ep_id);
+  }
+
+  return false;
+}
+
 // Handle CTR interrupt for the TX/IN direction
 static void handle_ctr_tx(uint32_t ep_id) {
   uint32_t ep_reg = ep_read(ep_id) | USB_EP_CTR_TX | USB_EP_CTR_RX;
@@ -283,6 +378,13 @@ static void handle_ctr_tx(uint32_t ep_id) {
   uint8_t const ep_num = ep_reg & USB_EPADDR_FIELD;
   xfer_ctl_t *xfer = xfer_ctl_ptr(ep_num, TUSB_DIR_IN);
 
+  if (xfer->dbuf) {
+    if (dbuf_tx_continue(xfer, ep_id)) {
+      dcd_event_xfer_complete(0, ep_num | TUSB_DIR_IN_MASK, xfer->queued_len, XFER_RESULT_SUCCESS, true);
+    }
+    return;
+  }
+
   if (ep_is_iso(ep_reg)) {
     // Ignore spurious interrupts that we don't schedule
     // host can send IN token while there is no data to send, since ISO does not have NAK
@@ -330,6 +432,14 @@ static void handle_ctr_rx(uint32_t ep_id) {
   bool const is_iso = ep_is_iso(ep_reg);
   xfer_ctl_t* xfer = xfer_ctl_ptr(ep_num, TUSB_DIR_OUT);
 
+  if (xfer->dbuf) {
+    // packet stays in its buffer until a transfer is active
+    if (dbuf_rx_drain(xfer, ep_id)) {
+      dcd_event_xfer_complete(0, ep_num, xfer->queued_len, XFER_RESULT_SUCCESS, true);
+    }
+    return;
+  }
+
   uint8_t buf_id;
   if (is_iso) {
     buf_id = (ep_reg & USB_EP_DTOG_RX) ? 0 : 1; // ISO are double buffered
@@ -486,35 +596,61 @@ void dcd_edpt0_status_complete(uint8_t rhport, tusb_control_request_t const *req
 }
 
 /***
- * Allocate a section of PMA
- * In case of double buffering, high 16bit is the address of 2nd buffer
- * During failure, TU_ASSERT is used. If this happens, rework/reallocate memory manually.
+ * Allocate a section of PMA for a BTABLE entry, first-fit in gaps between allocated buffers.
+ * A buffer already owned by the entry is kept if large enough, otherwise it is released and allocated again.
+ * Return false if PMA is full.
  */
-static uint32_t dcd_pma_alloc(uint16_t len, bool dbuf)
+static bool dcd_pma_alloc(uint8_t ep_idx, uint8_t buf_id, uint16_t len)
 {
   uint8_t blsize, num_block;
   uint16_t aligned_len = pma_align_buffer_size(len, &blsize, &num_block);
   (void) blsize;
   (void) num_block;
 
-  uint32_t addr = ep_buf_ptr;
-  ep_buf_ptr = (uint16_t)(ep_buf_ptr + aligned_len); // increment buffer pointer
+  // keep buffers aligned to bus width
+  aligned_len = (uint16_t) ((aligned_len + FSDEV_BUS_SIZE - 1) & ~(FSDEV_BUS_SIZE - 1));
+
+  pma_block_t* block = &pma_block[ep_idx][buf_id];
+  if (block->size < aligned_len) {
+    block->size = 0;
+
+    uint16_t addr = FSDEV_BTABLE_BASE + 8 * FSDEV_EP_COUNT;
+    bool overlapped;
+    do {
+      overlapped = false;
+      for (uint8_t i = 0; i < FSDEV_EP_COUNT; i++) {
+        for (uint8_t b = 0; b < 2; b++) {
+          pma_block_t const* other = &pma_block[i][b];
+          if (other->size && (addr < other->addr + other->size) && (other->addr < addr + aligned_len)) {
+            addr = (uint16_t) (other->addr + other->size);
+            overlapped = true;
+          }
+        }
+      }
+    } while (overlapped);
+
+    // Verify packet buffer is not overflowed
+    TU_VERIFY(addr + aligned_len <= FSDEV_PMA_SIZE);
 
-  if (dbuf) {
-    addr |= ((uint32_t)ep_buf_ptr) << 16;
-    ep_buf_ptr = (uint16_t)(ep_buf_ptr + aligned_len); // increment buffer pointer
+    block->addr = addr;
+    block->size = aligned_len;
   }
 
-  // Verify packet buffer is not overflowed
-  TU_ASSERT(ep_buf_ptr <= FSDEV_PMA_SIZE, 0xFFFF);
+  btable_set_addr(ep_idx, buf_id, block->addr);
+  return true;
+}
 
-  return addr;
+// Release PMA buffers of a hardware endpoint
+static void dcd_pma_free(uint8_t ep_idx)
+{
+  pma_block[ep_idx][0].size = 0;
+  pma_block[ep_idx][1].size = 0;
 }
 
 /***
- * Allocate hardware endpoint
+ * Allocate hardware endpoint. Exclusive endpoint (ISO or double-buffered) requires both direction to be free
  */
-static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type)
+static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type, bool exclusive)
 {
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
@@ -527,10 +663,10 @@ static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type)
       return i;
     }
 
-    // If EP of current direction is not allocated
-    // Except for ISO endpoint, both direction should be free
-    if (!ep_alloc_status[i].allocated[dir] &&
-        (ep_type != TUSB_XFER_ISOCHRONOUS || !ep_alloc_status[i].allocated[dir ^ 1])) {
+    // If EP of current direction is not allocated, and not used exclusively by the other direction
+    // For exclusive endpoint, both direction should be free
+    if (!ep_alloc_status[i].allocated[dir] && !ep_alloc_status[i].exclusive &&
+        (!exclusive || !ep_alloc_status[i].allocated[dir ^ 1])) {
       // Check if EP number is the same
       if (ep_alloc_status[i].ep_num == 0xFF || ep_alloc_status[i].ep_num == epnum) {
         // One EP pair has to be the same type
@@ -538,6 +674,7 @@ static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type)
           ep_alloc_status[i].ep_num = epnum;
           ep_alloc_status[i].ep_type = ep_type;
           ep_alloc_status[i].allocated[dir] = true;
+          ep_alloc_status[i].exclusive = exclusive;
 
           return i;
         }
@@ -546,26 +683,25 @@ static uint8_t dcd_ep_alloc(uint8_t ep_addr, uint8_t ep_type)
   }
 
   // Allocation failed
-  TU_ASSERT(0);
+  return 0xFF;
 }
 
 void edpt0_open(uint8_t rhport) {
   (void) rhport;
 
-  dcd_ep_alloc(0x0, TUSB_XFER_CONTROL);
-  dcd_ep_alloc(0x80, TUSB_XFER_CONTROL);
+  dcd_ep_alloc(0x0, TUSB_XFER_CONTROL, false);
+  dcd_ep_alloc(0x80, TUSB_XFER_CONTROL, false);
 
   xfer_status[0][0].max_packet_size = CFG_TUD_ENDPOINT0_SIZE;
   xfer_status[0][0].ep_idx = 0;
+  xfer_status[0][0].dbuf = false;
 
   xfer_status[0][1].max_packet_size = CFG_TUD_ENDPOINT0_SIZE;
   xfer_status[0][1].ep_idx = 0;
+  xfer_status[0][1].dbuf = false;
 
-  uint16_t pma_addr0 = dcd_pma_alloc(CFG_TUD_ENDPOINT0_SIZE, false);
-  uint16_t pma_addr1 = dcd_pma_alloc(CFG_TUD_ENDPOINT0_SIZE, false);
-
-  btable_set_addr(0, BTABLE_BUF_RX, pma_addr0);
-  btable_set_addr(0, BTABLE_BUF_TX, pma_addr1);
+  dcd_pma_alloc(0, BTABLE_BUF_RX, CFG_TUD_ENDPOINT0_SIZE);
+  dcd_pma_alloc(0, BTABLE_BUF_TX, CFG_TUD_ENDPOINT0_SIZE);
 
   uint32_t ep_reg = ep_read(0) & ~USB_EPREG_MASK; // only get toggle bits
   ep_reg |= USB_EP_CONTROL;
@@ -583,7 +719,13 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep) {
   uint8_t const ep_num = tu_edpt_number(ep_addr);
   tusb_dir_t const dir = tu_edpt_dir(ep_addr);
   const uint16_t packet_size = tu_edpt_packet_size(desc_ep);
-  uint8_t const ep_idx = dcd_ep_alloc(ep_addr, desc_ep->bmAttributes.xfer);
+  uint8_t ep_idx = 0xFF;
+  if (CFG_TUD_FSDEV_DOUBLE_BUFFER && desc_ep->bmAttributes.xfer == TUSB_XFER_BULK) {
+    ep_idx = dcd_ep_alloc(ep_addr, TUSB_XFER_BULK, true);
+  }
+  if (ep_idx == 0xFF) {
+    ep_idx = dcd_ep_alloc(ep_addr, desc_ep->bmAttributes.xfer, false);
+  }
   TU_ASSERT(ep_idx < FSDEV_EP_COUNT);
 
   uint32_t ep_reg = ep_read(ep_idx) & ~USB_EPREG_MASK;
@@ -603,22 +745,48 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep) {
       TU_ASSERT(false);
   }
 
-  /* Create a packet memory buffer area. */
-  uint16_t pma_addr = dcd_pma_alloc(packet_size, false);
-  btable_set_addr(ep_idx, dir == TUSB_DIR_IN ? BTABLE_BUF_TX : BTABLE_BUF_RX, pma_addr);
+  /* Create a packet memory buffer area. Double-buffered endpoint uses both entries, fall back to single buffer
+     if there is not enough space for two. */
+  bool dbuf = ep_alloc_status[ep_idx].exclusive;
+  if (dbuf) {
+    dbuf = dcd_pma_alloc(ep_idx, 0, packet_size) && dcd_pma_alloc(ep_idx, 1, packet_size);
+    if (!dbuf) {
+      // roll back partial allocation and share hardware endpoint with the other direction again
+      dcd_pma_free(ep_idx);
+      ep_alloc_status[ep_idx].exclusive = false;
+    }
+  }
+  if (!dbuf) {
+    TU_ASSERT(dcd_pma_alloc(ep_idx, dir == TUSB_DIR_IN ? BTABLE_BUF_TX : BTABLE_BUF_RX, packet_size));
+  }
 
   xfer_ctl_t *xfer = xfer_ctl_ptr(ep_num, dir);
   xfer->max_packet_size = packet_size;
   xfer->ep_idx = ep_idx;
+  xfer->dbuf = dbuf;
+  xfer->dbuf_busy = false;
 
-  ep_change_status(&ep_reg, dir, EP_STAT_NAK);
-  ep_change_dtog(&ep_reg, dir, 0);
-
-  // reserve other direction toggle bits
-  if (dir == TUSB_DIR_IN) {
-    ep_reg &= ~(USB_EPRX_STAT | USB_EP_DTOG_RX);
+  if (dbuf) {
+    // Double-buffered endpoint stays valid, NAK is done by buffer ownership. OUT start with both buffers free
+    ep_reg |= USB_EP_KIND;
+    if (dir == TUSB_DIR_OUT) {
+      btable_set_rx_bufsize(ep_idx, 0, packet_size);
+      btable_set_rx_bufsize(ep_idx, 1, packet_size);
+    }
+    ep_change_status(&ep_reg, dir, EP_STAT_VALID);
+    ep_change_dtog(&ep_reg, dir, 0);
+    ep_change_dtog(&ep_reg, (tusb_dir_t) (1 - dir), dir == TUSB_DIR_OUT ? 1 : 0);
+    ep_reg &= ~EP_STAT_MASK(1 - dir);
   } else {
-    ep_reg &= ~(USB_EPTX_STAT | USB_EP_DTOG_TX);
+    ep_change_status(&ep_reg, dir, EP_STAT_NAK);
+    ep_change_dtog(&ep_reg, dir, 0);
+
+    // reserve other direction toggle bits
+    if (dir == TUSB_DIR_IN) {
+      ep_reg &= ~(USB_EPRX_STAT | USB_EP_DTOG_RX);
+    } else {
+      ep_reg &= ~(USB_EPTX_STAT | USB_EP_DTOG_TX);
+    }
   }
 
   ep_write(ep_idx, ep_reg, true);
@@ -637,12 +805,13 @@ void dcd_edpt_close_all(uint8_t rhport) {
     ep_alloc_status[i].ep_type = 0xFF;
     ep_alloc_status[i].allocated[0] = false;
     ep_alloc_status[i].allocated[1] = false;
+    ep_alloc_status[i].exclusive = false;
+
+    // Reset PMA allocation
+    dcd_pma_free((uint8_t) i);
   }
 
   dcd_int_enable(rhport);
-
-  // Reset PMA allocation
-  ep_buf_ptr = FSDEV_BTABLE_BASE + 8 * CFG_TUD_ENDPPOINT_MAX + 2 * CFG_TUD_ENDPOINT0_SIZE;
 }
 
 bool dcd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet_size) {
@@ -650,23 +819,21 @@ bool dcd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet
 
   uint8_t const ep_num = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
-  uint8_t const ep_idx = dcd_ep_alloc(ep_addr, TUSB_XFER_ISOCHRONOUS);
+  uint8_t const ep_idx = dcd_ep_alloc(ep_addr, TUSB_XFER_ISOCHRONOUS, true);
+  TU_ASSERT(ep_idx < FSDEV_EP_COUNT);
 
   /* Create a packet memory buffer area. Enable double buffering for devices with 2048 bytes PMA,
      for smaller devices double buffering occupy too much space. */
+  TU_ASSERT(dcd_pma_alloc(ep_idx, 0, largest_packet_size));
 #if FSDEV_PMA_SIZE > 1024u
-  uint32_t pma_addr = dcd_pma_alloc(largest_packet_size, true);
-  uint16_t pma_addr2 = pma_addr >> 16;
+  TU_ASSERT(dcd_pma_alloc(ep_idx, 1, largest_packet_size));
 #else
-  uint32_t pma_addr = dcd_pma_alloc(largest_packet_size, false);
-  uint16_t pma_addr2 = pma_addr;
+  btable_set_addr(ep_idx, 1, pma_block[ep_idx][0].addr);
 #endif
 
-  btable_set_addr(ep_idx, 0, pma_addr);
-  btable_set_addr(ep_idx, 1, pma_addr2);
-
   xfer_ctl_t* xfer = xfer_ctl_ptr(ep_num, dir);
   xfer->ep_idx = ep_idx;
+  xfer->dbuf = false;
 
   return true;
 }
@@ -732,6 +899,30 @@ static bool edpt_xfer(uint8_t rhport, uint8_t ep_num, tusb_dir_t dir) {
   xfer_ctl_t *xfer = xfer_ctl_ptr(ep_num, dir);
   uint8_t const ep_idx = xfer->ep_idx;
 
+  if (xfer->dbuf) {
+    bool complete = false;
+    dcd_int_disable(rhport);
+    if (dir == TUSB_DIR_IN) {
+      // endpoint is idle: fill and release first packet, then prepare the next one while it is transmitted
+      dbuf_tx_prepare(xfer, ep_idx);
+      dbuf_toggle_swbuf(ep_idx, TUSB_DIR_IN);
+      xfer->dbuf_busy = (xfer->queued_len < xfer->total_len);
+      if (xfer->dbuf_busy) {
+        dbuf_tx_prepare(xfer, ep_idx);
+      }
+    } else {
+      // packet may already be waiting in buffer
+      xfer->dbuf_busy = true;
+      complete = dbuf_rx_drain(xfer, ep_idx);
+    }
+    dcd_int_enable(rhport);
+
+    if (complete) {
+      dcd_event_xfer_complete(rhport, ep_num, xfer->queued_len, XFER_RESULT_SUCCESS, false);
+    }
+    return true;
+  }
+
   if (dir == TUSB_DIR_IN) {
     dcd_transmit_packet(xfer, ep_idx);
   } else {
@@ -754,14 +945,14 @@ static bool edpt_xfer(uint8_t rhport, uint8_t ep_num, tusb_dir_t dir) {
   return true;
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes) {
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint32_t total_bytes) {
   uint8_t const ep_num = tu_edpt_number(ep_addr);
   tusb_dir_t const dir = tu_edpt_dir(ep_addr);
   xfer_ctl_t *xfer = xfer_ctl_ptr(ep_num, dir);
 
   xfer->buffer = buffer;
   xfer->ff = NULL;
-  xfer->total_len = total_bytes;
+  xfer->total_len = (uint16_t) total_bytes;
   xfer->queued_len = 0;
 
   return edpt_xfer(rhport, ep_num, dir);
@@ -803,10 +994,18 @@ void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
   uint8_t const ep_idx = xfer->ep_idx;
 
   uint32_t ep_reg = ep_read(ep_idx) | USB_EP_CTR_TX | USB_EP_CTR_RX; // reserve CTR bits
-  ep_reg &= USB_EPREG_MASK | EP_STAT_MASK(dir) | EP_DTOG_MASK(dir);
 
-  if (!ep_is_iso(ep_reg)) {
-    ep_change_status(&ep_reg, dir, EP_STAT_NAK);
+  if (xfer->dbuf) {
+    // Drop any waiting/prepared packet: restart with both buffers free
+    ep_reg &= USB_EPREG_MASK | EP_STAT_MASK(dir) | EP_DTOG_MASK(dir) | EP_DTOG_MASK(1 - dir);
+    ep_change_status(&ep_reg, dir, EP_STAT_VALID);
+    ep_change_dtog(&ep_reg, (tusb_dir_t) (1 - dir), dir == TUSB_DIR_OUT ? 1 : 0);
+    xfer->dbuf_busy = false;
+  } else {
+    ep_reg &= USB_EPREG_MASK | EP_STAT_MASK(dir) | EP_DTOG_MASK(dir);
+    if (!ep_is_iso(ep_reg)) {
+      ep_change_status(&ep_reg, dir, EP_STAT_NAK);
+    }
   }
   ep_change_dtog(&ep_reg, dir, 0); // Reset to DATA0
   ep_write(ep_idx, ep_reg, true);
@@ -818,7 +1017,7 @@ void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
 
 // Write to packet memory area (PMA) from user memory
 // - Packet memory must be either strictly 16-bit or 32-bit depending on FSDEV_BUS_32BIT
-// - Uses unaligned for RAM (since M0 cannot access unaligned address)
+// - Uses bus width load for aligned RAM unrolled by 4, unaligned otherwise (since M0 cannot access unaligned address)
 static bool dcd_write_packet_memory(uint16_t dst, const void *__restrict src, uint16_t nbytes) {
   if (nbytes == 0) return true;
   uint32_t n_write = nbytes / FSDEV_BUS_SIZE;
@@ -826,6 +1025,19 @@ static bool dcd_write_packet_memory(uint16_t dst, const void *__restrict src, ui
   fsdev_pma_buf_t* pma_buf = PMA_BUF_AT(dst);
   const uint8_t *src8 = src;
 
+  if ((((uintptr_t) src8) & (FSDEV_BUS_SIZE - 1)) == 0) {
+    const fsdev_bus_t* src_bus = (const fsdev_bus_t*) (const void*) src8;
+    for (; n_write >= 4; n_write -= 4) {
+      pma_buf[0].value = src_bus[0];
+      pma_buf[1].value = src_bus[1];
+      pma_buf[2].value = src_bus[2];
+      pma_buf[3].value = src_bus[3];
+      src_bus += 4;
+      pma_buf += 4;
+    }
+    src8 = (const uint8_t*) src_bus;
+  }
+
   while (n_write--) {
     pma_buf->value = fsdevbus_unaligned_read(src8);
     src8 += FSDEV_BUS_SIZE;
@@ -847,7 +1059,7 @@ static bool dcd_write_packet_memory(uint16_t dst, const void *__restrict src, ui
 
 // Read from packet memory area (PMA) to user memory.
 // - Packet memory must be either strictly 16-bit or 32-bit depending on FSDEV_BUS_32BIT
-// - Uses unaligned for RAM (since M0 cannot access unaligned address)
+// - Uses bus width store for aligned RAM unrolled by 4, unaligned otherwise (since M0 cannot access unaligned address)
 static bool dcd_read_packet_memory(void *__restrict dst, uint16_t src, uint16_t nbytes) {
   if (nbytes == 0) return true;
   uint32_t n_read = nbytes / FSDEV_BUS_SIZE;
@@ -855,6 +1067,19 @@ static bool dcd_read_packet_memory(void *__restrict dst, uint16_t src, uint16_t
   fsdev_pma_buf_t* pma_buf = PMA_BUF_AT(src);
   uint8_t *dst8 = (uint8_t *)dst;
 
+  if ((((uintptr_t) dst8) & (FSDEV_BUS_SIZE - 1)) == 0) {
+    fsdev_bus_t* dst_bus = (fsdev_bus_t*) (void*) dst8;
+    for (; n_read >= 4; n_read -= 4) {
+      dst_bus[0] = (fsdev_bus_t) pma_buf[0].value;
+      dst_bus[1] = (fsdev_bus_t) pma_buf[1].value;
+      dst_bus[2] = (fsdev_bus_t) pma_buf[2].value;
+      dst_bus[3] = (fsdev_bus_t) pma_buf[3].value;
+      dst_bus += 4;
+      pma_buf += 4;
+    }
+    dst8 = (uint8_t*) dst_bus;
+  }
+
   while (n_read--) {
     fsdevbus_unaligned_write(dst8, (fsdev_bus_t ) pma_buf->value);
     dst8 += FSDEV_BUS_SIZE;
@@ -164,6 +164,10 @@ TU_VERIFY_STATIC(sizeof(fsdev_regs_t) == 0x5C, "Size is not correct");
 #define USB_EP_CTR_TX_Pos    7u
 #endif
 
+#ifndef USB_EP_KIND
+#define USB_EP_KIND          0x0100U
+#endif
+
 typedef enum {
   EP_STAT_DISABLED = 0,
   EP_STAT_STALL = 1,
@@ -1093,7 +1093,7 @@ void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr)
 }
 
 // Submit a transfer, When complete dcd_event_xfer_complete() is invoked to notify the stack
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes)
 {
   (void)rhport;
   bool ret;
@@ -1103,9 +1103,9 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t t
 
   if (epnum) {
     _dcd.pipe_buf_is_fifo[tu_edpt_dir(ep_addr)] &= ~TU_BIT(epnum - 1);
-    ret = edpt_n_xfer(rhport, ep_addr, buffer, total_bytes);
+    ret = edpt_n_xfer(rhport, ep_addr, buffer, (uint16_t) total_bytes);
   } else {
-    ret = edpt0_xfer(rhport, ep_addr, buffer, total_bytes);
+    ret = edpt0_xfer(rhport, ep_addr, buffer, (uint16_t) total_bytes);
   }
   musb_int_unmask();
   return ret;
@@ -43,8 +43,13 @@
 
 #if TU_CHECK_MCU(OPT_MCU_GD32VF103)
   #define DWC2_EP_COUNT(_dwc2)   DWC2_EP_MAX
+  // GHWCFG3 is not implemented, assume the minimum counter widths
+  #define DWC2_XFER_SIZE_BITS(_dwc2)  11u
+  #define DWC2_PKT_COUNT_BITS(_dwc2)  4u
 #else
   #define DWC2_EP_COUNT(_dwc2)  ((_dwc2)->ghwcfg2_bm.num_dev_ep + 1)
+  #define DWC2_XFER_SIZE_BITS(_dwc2)  (11u + (_dwc2)->ghwcfg3_bm.xfer_size_width)
+  #define DWC2_PKT_COUNT_BITS(_dwc2)  (4u + (_dwc2)->ghwcfg3_bm.packet_size_width)
 #endif
 
 //--------------------------------------------------------------------+
@@ -53,7 +58,11 @@
 typedef struct {
   uint8_t* buffer;
   tu_fifo_t* ff;
-  uint16_t total_len;
+  uint32_t total_len;
+#if CFG_TUD_DWC2_DMA_DESC_ENABLE
+  uint32_t desc_loaded; // OUT: bytes programmed into DMA descriptors
+  uint16_t bounce_len;  // OUT: final partial packet received into bounce buffer, 0 if not used
+#endif
   uint16_t max_size;
   uint8_t interval;
 } xfer_ctl_t;
@@ -66,6 +75,10 @@ typedef struct {
   uint16_t ep0_pending[2];  // Index determines direction as tusb_dir_t type
   uint16_t dfifo_top;      // top free location in DFIFO in words
 
+  // TX FIFO depth in words planned for each IN endpoint of current configuration, 0 if not planned
+  uint16_t txfifo_plan[DWC2_EP_MAX];
+  uint16_t txfifo_allocated; // bitmap of IN endpoints with allocated TX FIFO
+
   // Number of IN endpoints active
   uint8_t allocated_epin_count;
 
@@ -76,9 +89,30 @@ typedef struct {
 static dcd_data_t _dcd_data;
 
 CFG_TUD_MEM_SECTION static struct {
-  TUD_EPBUF_DEF(setup_packet, 8);
+  // Scatter/Gather DMA receives setup packet with a max packet size descriptor
+  TUD_EPBUF_DEF(setup_packet, CFG_TUD_DWC2_DMA_DESC_ENABLE ? 64 : 8);
 } _dcd_usbbuf;
 
+#if CFG_TUD_DWC2_DMA_DESC_ENABLE
+// Descriptor list of an endpoint direction, padded to cache line so that it can be cleaned/invalidated on its own
+typedef union {
+  CFG_TUD_MEM_ALIGN dwc2_dma_desc_t list[CFG_TUD_DWC2_DMA_DESC_COUNT];
+  uint8_t dcache_padding[TUD_EPBUF_DCACHE_SIZE(CFG_TUD_DWC2_DMA_DESC_COUNT * sizeof(dwc2_dma_desc_t))];
+} dma_desc_list_t;
+
+CFG_TUD_MEM_SECTION static dma_desc_list_t _dcd_dma_desc[DWC2_EP_MAX][2];
+
+// OUT descriptor must be a multiple of max packet size. Final partial packet of a transfer is received here instead of
+// rounding up application buffer, which could be overrun by a host sending more data than requested
+#define DMA_DESC_BOUNCE_SIZE  (TUD_OPT_HIGH_SPEED ? 512 : 64)
+
+typedef struct {
+  TUD_EPBUF_DEF(buf, DMA_DESC_BOUNCE_SIZE);
+} dma_desc_bounce_t;
+
+CFG_TUD_MEM_SECTION static dma_desc_bounce_t _dcd_dma_bounce[DWC2_EP_MAX];
+#endif
+
 //--------------------------------------------------------------------
 // DMA
 //--------------------------------------------------------------------
@@ -105,6 +139,223 @@ TU_ATTR_ALWAYS_INLINE static inline bool dma_device_enabled(const dwc2_regs_t* d
   return CFG_TUD_DWC2_DMA_ENABLE && dwc2->ghwcfg2_bm.arch == GHWCFG2_ARCH_INTERNAL_DMA;
 }
 
+TU_ATTR_ALWAYS_INLINE static inline bool dma_desc_enabled(const dwc2_regs_t* dwc2) {
+  // Scatter/Gather DMA, fall back to buffer DMA if core is not configured with it
+  return CFG_TUD_DWC2_DMA_DESC_ENABLE && dma_device_enabled(dwc2) && dwc2->ghwcfg4_bm.dma_desc_enabled;
+}
+
+#if CFG_TUD_DWC2_DMA_DESC_ENABLE
+TU_ATTR_ALWAYS_INLINE static inline bool edpt_is_iso(const dwc2_regs_t* dwc2, uint8_t epnum, uint8_t dir) {
+  return dwc2->ep[dir == TUSB_DIR_IN ? 0 : 1][epnum].ctl_bm.type == DEPCTL_EPTYPE_ISOCHRONOUS;
+}
+
+// Bytes per descriptor: isochronous is one packet per (micro)frame, others are kept to multiple of max packet size
+// so that only the last descriptor of a transfer can end with a short packet
+TU_ATTR_ALWAYS_INLINE static inline uint16_t dma_desc_max_bytes(uint16_t mps, bool is_iso) {
+  return is_iso ? mps : (uint16_t) (DMA_DESC_NONISO_BYTES_MAX - (DMA_DESC_NONISO_BYTES_MAX % mps));
+}
+
+// Add descriptors for a contiguous data segment
+static bool dma_desc_add(dwc2_dma_desc_t* list, uint8_t* count, uint8_t* buffer, uint32_t len, uint16_t desc_max) {
+  do {
+    TU_VERIFY(*count < CFG_TUD_DWC2_DMA_DESC_COUNT);
+
+    uint16_t bytes = (uint16_t) tu_min32(len, desc_max);
+    len -= bytes;
+
+    // Host ready, flags are set once the list is complete
+    dwc2_dma_desc_t* desc = &list[(*count)++];
+    desc->buffer = (uintptr_t) buffer;
+    desc->status = bytes;
+
+    buffer += bytes;
+  } while (len);
+
+  return true;
+}
+
+// Build descriptor list for the transfer of an endpoint direction, return false if it does not fit
+static bool dma_desc_prepare(dwc2_regs_t* dwc2, uint8_t epnum, uint8_t dir, uint32_t total_bytes) {
+  xfer_ctl_t* xfer = XFER_CTL_BASE(epnum, dir);
+  dwc2_dma_desc_t* list = _dcd_dma_desc[epnum][dir].list;
+  const bool is_iso = edpt_is_iso(dwc2, epnum, dir);
+  const uint16_t mps = xfer->max_size;
+  const uint16_t desc_max = dma_desc_max_bytes(mps, is_iso);
+  uint8_t count = 0;
+
+  xfer->bounce_len = 0;
+
+  if (xfer->ff) {
+    // Scatter to linear and wrapped part of the fifo. Wrapped part is only used if linear part ends on a packet boundary
+    // since a descriptor can only end with a short packet if it is the last one.
+    tu_fifo_buffer_info_t info;
+    if (dir == TUSB_DIR_IN) {
+      tu_fifo_get_read_info(xfer->ff, &info);
+    } else {
+      tu_fifo_get_write_info(xfer->ff, &info);
+    }
+
+    const uint32_t lin_len = tu_min32(total_bytes, info.len_lin);
+    uint32_t wrap_len = 0;
+
+    if (dir == TUSB_DIR_OUT && !is_iso) {
+      // OUT descriptor must be multiple of max packet size: each part is rounded down, final partial packet is
+      // received into bounce buffer and written to the fifo on completion
+      const uint32_t lin_aligned = lin_len - (lin_len % mps);
+      uint32_t wrap_aligned = 0;
+
+      if (lin_aligned) {
+        TU_VERIFY(dma_desc_add(list, &count, (uint8_t*) info.ptr_lin, lin_aligned, desc_max));
+      }
+
+      if (lin_aligned == lin_len) {
+        if (lin_len < total_bytes) {
+          wrap_len = tu_min32(total_bytes - lin_len, info.len_wrap);
+          wrap_aligned = wrap_len - (wrap_len % mps);
+          if (wrap_aligned) {
+            TU_VERIFY(dma_desc_add(list, &count, (uint8_t*) info.ptr_wrap, wrap_aligned, desc_max));
+          }
+        }
+        xfer->bounce_len = (uint16_t) (wrap_len - wrap_aligned);
+      } else {
+        // partial packet at the end of linear part continues into wrapped part
+        const uint32_t avail = lin_len - lin_aligned + info.len_wrap;
+        xfer->bounce_len = (uint16_t) tu_min32(tu_min32(total_bytes - lin_aligned, avail), mps);
+      }
+
+      if (xfer->bounce_len) {
+        TU_VERIFY(mps <= DMA_DESC_BOUNCE_SIZE);
+        TU_VERIFY(dma_desc_add(list, &count, _dcd_dma_bounce[epnum].buf, mps, desc_max));
+      } else if (count == 0) {
+        TU_VERIFY(dma_desc_add(list, &count, (uint8_t*) info.ptr_lin, 0, desc_max));
+      }
+
+      total_bytes = lin_aligned + wrap_aligned + xfer->bounce_len;
+    } else {
+      TU_VERIFY(dma_desc_add(list, &count, (uint8_t*) info.ptr_lin, lin_len, desc_max));
+
+      if (lin_len < total_bytes && (lin_len % mps) == 0) {
+        wrap_len = tu_min32(total_bytes - lin_len, info.len_wrap);
+        TU_VERIFY(dma_desc_add(list, &count, (uint8_t*) info.ptr_wrap, wrap_len, desc_max));
+      }
+
+      total_bytes = lin_len + wrap_len;
+    }
+
+    xfer->total_len = total_bytes;
+  } else {
+    uint8_t* buffer = xfer->buffer;
+
+    if (dir == TUSB_DIR_OUT) {
+      // Control status: make sure an unexpected data packet does not end up at address 0
+      if (epnum == 0 && buffer == NULL) {
+        buffer = _dcd_usbbuf.setup_packet;
+      }
+
+      // OUT descriptor must be multiple of max packet size, except isochronous
+      if (!is_iso) {
+        xfer->bounce_len = (uint16_t) (total_bytes % mps);
+      }
+    }
+
+    if (xfer->bounce_len) {
+      TU_VERIFY(mps <= DMA_DESC_BOUNCE_SIZE);
+      const uint32_t aligned_len = total_bytes - xfer->bounce_len;
+      if (aligned_len) {
+        TU_VERIFY(dma_desc_add(list, &count, buffer, aligned_len, desc_max));
+      }
+      TU_VERIFY(dma_desc_add(list, &count, _dcd_dma_bounce[epnum].buf, mps, desc_max));
+    } else {
+      TU_VERIFY(dma_desc_add(list, &count, buffer, total_bytes, desc_max));
+    }
+  }
+
+  xfer->desc_loaded = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    xfer->desc_loaded += list[i].status_bm.bytes;
+  }
+
+  // Isochronous IN is sent in (micro)frame given by descriptor, start from the next service interval
+  uint32_t frame = 0;
+  const uint32_t frame_step = (xfer->interval > 1) ? (1ul << (xfer->interval - 1)) : 1;
+  if (is_iso && dir == TUSB_DIR_IN) {
+    frame = dwc2->dsts_bm.frame_number + frame_step;
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    union {
+      uint32_t value;
+      dwc2_dma_desc_status_t bm;
+      dwc2_dma_desc_iso_status_t iso_bm;
+    } sts;
+    sts.value = list[i].status;
+
+    if (is_iso) {
+      if (dir == TUSB_DIR_IN) {
+        sts.iso_bm.frame_num = frame & 0x7FFu;
+        sts.iso_bm.pid = 1;
+        sts.iso_bm.short_packet = (sts.iso_bm.bytes < mps) ? 1 : 0;
+        frame += frame_step;
+      }
+    } else if (dir == TUSB_DIR_IN && i == count - 1) {
+      sts.bm.short_packet = (sts.bm.bytes == 0 || (sts.bm.bytes % mps)) ? 1 : 0;
+    }
+
+    if (i == count - 1) {
+      sts.bm.last = 1;
+      sts.bm.ioc = 1;
+    }
+
+    list[i].status = sts.value;
+  }
+
+  dcd_dcache_clean(list, sizeof(dma_desc_list_t));
+
+  return true;
+}
+
+// Number of bytes transferred by completed descriptor list of an OUT endpoint. Final partial packet is copied from
+// bounce buffer to application buffer, fifo write pointer is advanced past received data
+static uint32_t dma_desc_out_xferred(dwc2_regs_t* dwc2, uint8_t epnum) {
+  xfer_ctl_t* xfer = XFER_CTL_BASE(epnum, TUSB_DIR_OUT);
+  const dwc2_dma_desc_t* list = _dcd_dma_desc[epnum][TUSB_DIR_OUT].list;
+  const bool is_iso = edpt_is_iso(dwc2, epnum, TUSB_DIR_OUT);
+
+  dcd_dcache_invalidate(list, sizeof(dma_desc_list_t));
+
+  uint32_t remain = 0;
+  for (uint8_t i = 0; i < CFG_TUD_DWC2_DMA_DESC_COUNT; i++) {
+    remain += is_iso ? list[i].iso_bm.bytes : list[i].status_bm.bytes;
+    if (list[i].status_bm.last) {
+      break;
+    }
+  }
+
+  const uint32_t xferred = tu_min32(xfer->desc_loaded - remain, xfer->total_len);
+
+  const uint32_t aligned_len = xfer->total_len - xfer->bounce_len;
+  const uint32_t bounced = (xfer->bounce_len && xferred > aligned_len) ? (xferred - aligned_len) : 0;
+
+  if (bounced) {
+    dcd_dcache_invalidate(_dcd_dma_bounce[epnum].buf, bounced);
+  }
+
+  if (xfer->ff) {
+    tu_fifo_advance_write_pointer(xfer->ff, (uint16_t) (xferred - bounced));
+    if (bounced) {
+      tu_fifo_write_n(xfer->ff, _dcd_dma_bounce[epnum].buf, (uint16_t) bounced);
+    }
+  } else if (bounced) {
+    uint8_t* dst = xfer->buffer + aligned_len;
+    dcd_dcache_invalidate(xfer->buffer, aligned_len);
+    memcpy(dst, _dcd_dma_bounce[epnum].buf, bounced);
+    dcd_dcache_clean(dst, bounced);
+  }
+
+  return xferred;
+}
+#endif
+
 static void dma_setup_prepare(uint8_t rhport) {
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
 
@@ -114,6 +365,29 @@ static void dma_setup_prepare(uint8_t rhport) {
     }
   }
 
+#if CFG_TUD_DWC2_DMA_DESC_ENABLE
+  if (dma_desc_enabled(dwc2)) {
+    // Receive only 1 packet with descriptor which also reports if it was a setup
+    dwc2_dma_desc_t* desc = _dcd_dma_desc[0][TUSB_DIR_OUT].list;
+    union {
+      uint32_t value;
+      dwc2_dma_desc_status_t bm;
+    } sts;
+    sts.value = 0;
+    sts.bm.bytes = 64;
+    sts.bm.last = 1;
+    sts.bm.ioc = 1;
+
+    desc->buffer = (uintptr_t) _dcd_usbbuf.setup_packet;
+    desc->status = sts.value;
+    dcd_dcache_clean(desc, sizeof(dma_desc_list_t));
+
+    dwc2->epout[0].doepdma = (uintptr_t) desc;
+    dwc2->epout[0].doepctl |= DOEPCTL_EPENA | DOEPCTL_USBAEP;
+    return;
+  }
+#endif
+
   // Receive only 1 packet
   dwc2->epout[0].doeptsiz = (1 << DOEPTSIZ_STUPCNT_Pos) | (1 << DOEPTSIZ_PKTCNT_Pos) | (8 << DOEPTSIZ_XFRSIZ_Pos);
   dwc2->epout[0].doepdma = (uintptr_t) _dcd_usbbuf.setup_packet;
@@ -191,17 +465,30 @@ static bool dfifo_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t packet_size) {
       dwc2->grxfsiz = new_sz; // Enlarge RX FIFO
     }
   } else {
+    // If The TXFELVL is configured as half empty, the fifo must be twice the max_size.
+    if ((dwc2->gahbcfg & GAHBCFG_TX_FIFO_EPMTY_LVL) == 0) {
+      fifo_size *= 2;
+    }
+
+    if (epnum) {
+      // Endpoint re-opened by alternate setting keeps its fifo if large enough
+      if (_dcd_data.txfifo_allocated & TU_BIT(epnum)) {
+        const uint16_t cur_size = (uint16_t) (dwc2->dieptxf[epnum - 1] >> DIEPTXF_INEPTXFD_Pos);
+        if (fifo_size <= cur_size) {
+          return true;
+        }
+      }
+
+      // Use planned depth of current configuration if any
+      fifo_size = tu_max16(fifo_size, _dcd_data.txfifo_plan[epnum]);
+    }
+
     // Check IN endpoints concurrently active limit
     if(dwc2_controller->ep_in_count) {
       TU_ASSERT(_dcd_data.allocated_epin_count < dwc2_controller->ep_in_count);
       _dcd_data.allocated_epin_count++;
     }
 
-    // If The TXFELVL is configured as half empty, the fifo must be twice the max_size.
-    if ((dwc2->gahbcfg & GAHBCFG_TX_FIFO_EPMTY_LVL) == 0) {
-      fifo_size *= 2;
-    }
-
     // Check if free space is available
     TU_ASSERT(_dcd_data.dfifo_top >= fifo_size + dwc2->grxfsiz);
     _dcd_data.dfifo_top -= fifo_size;
@@ -213,25 +500,107 @@ static bool dfifo_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t packet_size) {
     } else {
       // DIEPTXF starts at FIFO #1.
       dwc2->dieptxf[epnum - 1] = (fifo_size << DIEPTXF_INEPTXFD_Pos) | _dcd_data.dfifo_top;
+      _dcd_data.txfifo_allocated |= TU_BIT(epnum);
     }
   }
 
   return true;
 }
 
+/* Plan FIFO partitioning for all endpoints of a configuration, endpoints of every alternate setting are included.
+  - Each IN endpoint is given its minimum: 1 packet (2 for isochronous), doubled if TXFELVL is half empty.
+  - RX FIFO is given its minimum by calc_device_grxfsiz() with the largest OUT packet.
+  - Remaining space is shared by bulk and isochronous endpoints (and RX FIFO for OUT) in proportion to their minimum,
+    i.e to packet size and depth. Each TX share is rounded down to whole packets, interrupt endpoints keep the minimum.
+  If minimums do not fit, nothing is planned and FIFO is allocated in opening order as before.
+*/
+static void dfifo_plan(uint8_t rhport, tusb_desc_configuration_t const* desc_cfg) {
+  dwc2_regs_t* dwc2 = DWC2_REG(rhport);
+  const uint8_t ep_count = _dwc2_controller[rhport].ep_count;
+  const uint16_t txfelvl_mul = ((dwc2->gahbcfg & GAHBCFG_TX_FIFO_EPMTY_LVL) == 0) ? 2 : 1;
+
+  uint16_t tx_min[DWC2_EP_MAX] = {0};
+  uint16_t tx_pkt[DWC2_EP_MAX] = {0};
+  uint16_t tx_weight[DWC2_EP_MAX] = {0};
+  uint16_t rx_largest = CFG_TUD_ENDPOINT0_SIZE;
+  uint16_t rx_weight = 0;
+
+  uint8_t const* p_desc = (uint8_t const*) desc_cfg;
+  uint8_t const* desc_end = p_desc + tu_le16toh(desc_cfg->wTotalLength);
+  while (p_desc < desc_end) {
+    if (tu_desc_type(p_desc) == TUSB_DESC_ENDPOINT) {
+      const tusb_desc_endpoint_t* desc_ep = (const tusb_desc_endpoint_t*) p_desc;
+      const uint8_t epnum = tu_edpt_number(desc_ep->bEndpointAddress);
+      const uint16_t pkt_words = (uint16_t) tu_div_ceil(tu_edpt_packet_size(desc_ep), 4);
+      const uint8_t xfer_type = desc_ep->bmAttributes.xfer;
+      const bool is_streaming = (xfer_type == TUSB_XFER_BULK || xfer_type == TUSB_XFER_ISOCHRONOUS);
+
+      if (0 < epnum && epnum < ep_count) {
+        if (tu_edpt_dir(desc_ep->bEndpointAddress) == TUSB_DIR_IN) {
+          const uint16_t min_words = (uint16_t) (pkt_words * txfelvl_mul * (xfer_type == TUSB_XFER_ISOCHRONOUS ? 2 : 1));
+          tx_min[epnum] = tu_max16(tx_min[epnum], min_words);
+          tx_pkt[epnum] = tu_max16(tx_pkt[epnum], pkt_words);
+          if (is_streaming) {
+            tx_weight[epnum] = tu_max16(tx_weight[epnum], min_words);
+          }
+        } else {
+          rx_largest = tu_max16(rx_largest, tu_edpt_packet_size(desc_ep));
+          if (is_streaming) {
+            rx_weight = tu_max16(rx_weight, (uint16_t) (2 * pkt_words));
+          }
+        }
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  uint16_t grxfsiz = calc_device_grxfsiz(rx_largest, ep_count);
+  uint32_t total_min = grxfsiz;
+  uint32_t total_weight = rx_weight;
+  for (uint8_t n = 1; n < ep_count; n++) {
+    total_min += tx_min[n];
+    total_weight += tx_weight[n];
+  }
+
+  // EP0 IN is already allocated at top
+  if (total_min > _dcd_data.dfifo_top) {
+    TU_LOG(DWC2_DEBUG, "  FIFO plan: %lu words needed, %u available\r\n", (unsigned long) total_min, _dcd_data.dfifo_top);
+    return;
+  }
+  const uint32_t extra = _dcd_data.dfifo_top - total_min;
+
+  for (uint8_t n = 1; n < ep_count; n++) {
+    uint32_t depth = tx_min[n];
+    if (total_weight && tx_weight[n]) {
+      const uint32_t share = extra * tx_weight[n] / total_weight;
+      depth += share - (share % tx_pkt[n]);
+    }
+    _dcd_data.txfifo_plan[n] = (uint16_t) tu_min32(depth, UINT16_MAX);
+  }
+
+  if (total_weight && rx_weight) {
+    grxfsiz = (uint16_t) (grxfsiz + extra * rx_weight / total_weight);
+  }
+  dwc2->grxfsiz = grxfsiz;
+}
+
 static void dfifo_device_init(uint8_t rhport) {
   const dwc2_controller_t* dwc2_controller = &_dwc2_controller[rhport];
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
   dwc2->grxfsiz = calc_device_grxfsiz(CFG_TUD_ENDPOINT0_SIZE, dwc2_controller->ep_count);
 
-  // Scatter/Gather DMA mode is not yet supported. Buffer DMA only need 1 words per endpoint direction
+  // Scatter/Gather DMA need 4 words per endpoint direction, Buffer DMA only need 1
   const bool is_dma = dma_device_enabled(dwc2);
   _dcd_data.dfifo_top = dwc2_controller->ep_fifo_size/4;
   if (is_dma) {
-    _dcd_data.dfifo_top -= 2 * dwc2_controller->ep_count;
+    _dcd_data.dfifo_top -= (dma_desc_enabled(dwc2) ? 8 : 2) * dwc2_controller->ep_count;
   }
   dwc2->gdfifocfg = (_dcd_data.dfifo_top << GDFIFOCFG_EPINFOBASE_SHIFT) | _dcd_data.dfifo_top;
 
+  // Drop plan of previous configuration
+  tu_memclr(_dcd_data.txfifo_plan, sizeof(_dcd_data.txfifo_plan));
+  _dcd_data.txfifo_allocated = 0;
+
   // Allocate FIFO for EP0 IN
   dfifo_alloc(rhport, 0x80, CFG_TUD_ENDPOINT0_SIZE);
 }
@@ -321,22 +690,22 @@ static void edpt_disable(uint8_t rhport, uint8_t ep_addr, bool stall) {
   }
 }
 
-static void edpt_schedule_packets(uint8_t rhport, const uint8_t epnum, const uint8_t dir) {
+static bool edpt_schedule_packets(uint8_t rhport, const uint8_t epnum, const uint8_t dir) {
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
   xfer_ctl_t* const xfer = XFER_CTL_BASE(epnum, dir);
   dwc2_dep_t* dep = &dwc2->ep[dir == TUSB_DIR_IN ? 0 : 1][epnum];
 
   uint16_t num_packets;
-  uint16_t total_bytes;
+  uint32_t total_bytes;
 
   // EP0 is limited to one packet per xfer
   if (epnum == 0) {
     total_bytes = tu_min16(_dcd_data.ep0_pending[dir], xfer->max_size);
-    _dcd_data.ep0_pending[dir] -= total_bytes;
+    _dcd_data.ep0_pending[dir] -= (uint16_t) total_bytes;
     num_packets = 1;
   } else {
     total_bytes = xfer->total_len;
-    num_packets = tu_div_ceil(total_bytes, xfer->max_size);
+    num_packets = (uint16_t) tu_div_ceil(total_bytes, xfer->max_size);
     if (num_packets == 0) {
       num_packets = 1; // zero length packet still count as 1
     }
@@ -376,7 +745,16 @@ static void edpt_schedule_packets(uint8_t rhport, const uint8_t epnum, const uin
     if (dir == TUSB_DIR_IN && total_bytes != 0) {
       dcd_dcache_clean(xfer->buffer, total_bytes);
     }
-    dep->diepdma = (uintptr_t) xfer->buffer;
+
+    if (dma_desc_enabled(dwc2)) {
+      #if CFG_TUD_DWC2_DMA_DESC_ENABLE
+      // Transfer size register is not used, whole transfer is described by the descriptor list
+      TU_VERIFY(dma_desc_prepare(dwc2, epnum, dir, total_bytes));
+      dep->diepdma = (uintptr_t) _dcd_dma_desc[epnum][dir].list;
+      #endif
+    } else {
+      dep->diepdma = (uintptr_t) xfer->buffer;
+    }
     dep->diepctl = depctl.value; // enable endpoint
   } else {
     dep->diepctl = depctl.value; // enable endpoint
@@ -386,6 +764,8 @@ static void edpt_schedule_packets(uint8_t rhport, const uint8_t epnum, const uin
       dwc2->diepempmsk |= (1 << epnum);
     }
   }
+
+  return true;
 }
 
 //--------------------------------------------------------------------
@@ -418,6 +798,9 @@ bool dcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
   }
 
   dcfg |= DCFG_NZLSOHSK; // send STALL back and discard if host send non-zlp during control status
+  if (dma_desc_enabled(dwc2)) {
+    dcfg |= DCFG_DESCDMA;
+  }
   dwc2->dcfg = dcfg;
 
   dcd_disconnect(rhport);
@@ -528,6 +911,10 @@ void dcd_sof_enable(uint8_t rhport, bool en) {
 /* DCD Endpoint port
  *------------------------------------------------------------------*/
 
+void dcd_edpt_config_plan(uint8_t rhport, tusb_desc_configuration_t const* desc_cfg) {
+  dfifo_plan(rhport, desc_cfg);
+}
+
 bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const* desc_edpt) {
   TU_ASSERT(dfifo_alloc(rhport, desc_edpt->bEndpointAddress, tu_edpt_packet_size(desc_edpt)));
   edpt_activate(rhport, desc_edpt);
@@ -572,7 +959,29 @@ bool dcd_edpt_iso_activate(uint8_t rhport,  tusb_desc_endpoint_t const * p_endpo
   return true;
 }
 
-bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+// Largest transfer that fits the DIEPTSIZ/DOEPTSIZ counters of this core, or the descriptor list with Scatter/Gather
+// DMA. EP0 is split into single packets by the driver and its pending count is kept 16-bit.
+uint32_t dcd_edpt_xfer_max(uint8_t rhport, uint8_t ep_addr) {
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir = tu_edpt_dir(ep_addr);
+  xfer_ctl_t* xfer = XFER_CTL_BASE(epnum, dir);
+  if (epnum == 0 || xfer->max_size == 0) {
+    return UINT16_MAX;
+  }
+
+  dwc2_regs_t* dwc2 = DWC2_REG(rhport);
+#if CFG_TUD_DWC2_DMA_DESC_ENABLE
+  if (dma_desc_enabled(dwc2)) {
+    return CFG_TUD_DWC2_DMA_DESC_COUNT * (uint32_t) dma_desc_max_bytes(xfer->max_size, edpt_is_iso(dwc2, epnum, dir));
+  }
+#endif
+
+  const uint32_t size_max = (1ul << DWC2_XFER_SIZE_BITS(dwc2)) - 1;
+  const uint32_t pkt_max = (1ul << DWC2_PKT_COUNT_BITS(dwc2)) - 1;
+  return tu_min32(size_max, pkt_max * xfer->max_size);
+}
+
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
 
@@ -583,13 +992,11 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t to
 
   // EP0 can only handle one packet
   if (epnum == 0) {
-    _dcd_data.ep0_pending[dir] = total_bytes;
+    _dcd_data.ep0_pending[dir] = (uint16_t) total_bytes;
   }
 
   // Schedule packets to be sent within interrupt
-  edpt_schedule_packets(rhport, epnum, dir);
-
-  return true;
+  return edpt_schedule_packets(rhport, epnum, dir);
 }
 
 // The number of bytes has to be given explicitly to allow more flexible control of how many
@@ -600,6 +1007,9 @@ bool dcd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t* ff, uint16_t
   // USB buffers always work in bytes so to avoid unnecessary divisions we demand item_size = 1
   TU_ASSERT(ff->item_size == 1);
 
+  // Scatter/Gather DMA works with fifo directly, but it is neither aligned nor padded to cache line
+  TU_VERIFY(!(CFG_TUD_MEM_DCACHE_ENABLE && dma_desc_enabled(DWC2_REG(rhport))));
+
   uint8_t const epnum = tu_edpt_number(ep_addr);
   uint8_t const dir = tu_edpt_dir(ep_addr);
 
@@ -610,9 +1020,7 @@ bool dcd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t* ff, uint16_t
 
   // Schedule packets to be sent within interrupt
   // TODO xfer fifo may only available for slave mode
-  edpt_schedule_packets(rhport, epnum, dir);
-
-  return true;
+  return edpt_schedule_packets(rhport, epnum, dir);
 }
 
 void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
@@ -844,8 +1252,8 @@ static void handle_epin_slave(uint8_t rhport, uint8_t epnum, dwc2_diepint_t diep
 
     // Process every single packet (only whole packets can be written to fifo)
     for (uint16_t i = 0; i < remain_packets; i++) {
-      const uint16_t remain_bytes = (uint16_t) epin->tsiz_bm.xfer_size;
-      const uint16_t xact_bytes = tu_min16(remain_bytes, xfer->max_size);
+      const uint32_t remain_bytes = epin->tsiz_bm.xfer_size;
+      const uint16_t xact_bytes = (uint16_t) tu_min32(remain_bytes, xfer->max_size);
 
       // Check if dtxfsts has enough space available
       if (xact_bytes > ((epin->dtxfsts & DTXFSTS_INEPTFSAV_Msk) << 2)) {
@@ -883,9 +1291,19 @@ static void handle_epout_dma(uint8_t rhport, uint8_t epnum, dwc2_doepint_t doepi
 
   // OUT XFER complete
   if (doepint_bm.xfer_complete) {
+    bool setup_rx = doepint_bm.setup_packet_rx;
+    #if CFG_TUD_DWC2_DMA_DESC_ENABLE
+    // Scatter/Gather DMA marks the descriptor that received a setup packet
+    if (epnum == 0 && dma_desc_enabled(dwc2)) {
+      const dwc2_dma_desc_t* desc = _dcd_dma_desc[0][TUSB_DIR_OUT].list;
+      dcd_dcache_invalidate(desc, sizeof(dma_desc_list_t));
+      setup_rx = setup_rx || desc->status_bm.setup_rx;
+    }
+    #endif
+
     // only handle data skip if it is setup or status related
     // Normal OUT transfer complete
-    if (!doepint_bm.status_phase_rx && !doepint_bm.setup_packet_rx) {
+    if (!doepint_bm.status_phase_rx && !setup_rx) {
       if ((epnum == 0) && _dcd_data.ep0_pending[TUSB_DIR_OUT]) {
         // EP0 can only handle one packet Schedule another packet to be received.
         edpt_schedule_packets(rhport, epnum, TUSB_DIR_OUT);
@@ -894,8 +1312,14 @@ static void handle_epout_dma(uint8_t rhport, uint8_t epnum, dwc2_doepint_t doepi
         xfer_ctl_t* xfer = XFER_CTL_BASE(epnum, TUSB_DIR_OUT);
 
         // determine actual received bytes
-        const uint16_t remain = epout->tsiz_bm.xfer_size;
-        xfer->total_len -= remain;
+        if (dma_desc_enabled(dwc2)) {
+          #if CFG_TUD_DWC2_DMA_DESC_ENABLE
+          xfer->total_len = dma_desc_out_xferred(dwc2, epnum);
+          #endif
+        } else {
+          const uint32_t remain = epout->tsiz_bm.xfer_size;
+          xfer->total_len -= remain;
+        }
 
         // this is ZLP, so prepare EP0 for next setup
         // TODO use status phase rx
@@ -921,6 +1345,11 @@ static void handle_epin_dma(uint8_t rhport, uint8_t epnum, dwc2_diepint_t diepin
       if(epnum == 0) {
         dma_setup_prepare(rhport);
       }
+      #if CFG_TUD_DWC2_DMA_DESC_ENABLE
+      if (xfer->ff && dma_desc_enabled(DWC2_REG(rhport))) {
+        tu_fifo_advance_read_pointer(xfer->ff, (uint16_t) xfer->total_len);
+      }
+      #endif
       dcd_event_xfer_complete(rhport, epnum | TUSB_DIR_IN_MASK, xfer->total_len, XFER_RESULT_SUCCESS, true);
     }
   }
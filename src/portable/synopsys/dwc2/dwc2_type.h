@@ -596,6 +596,64 @@ typedef struct TU_ATTR_PACKED {
 } dwc2_ep_tsize_t;
 TU_VERIFY_STATIC(sizeof(dwc2_ep_tsize_t) == 4, "incorrect size");
 
+//--------------------------------------------------------------------
+// Device Scatter/Gather DMA Descriptor
+//--------------------------------------------------------------------
+enum {
+  DMA_DESC_BS_HOST_READY = 0,
+  DMA_DESC_BS_DMA_BUSY   = 1,
+  DMA_DESC_BS_DMA_DONE   = 2,
+  DMA_DESC_BS_HOST_BUSY  = 3,
+};
+
+enum {
+  DMA_DESC_STS_SUCCESS    = 0,
+  DMA_DESC_STS_BUFF_FLUSH = 1,
+  DMA_DESC_STS_BUFF_ERR   = 3,
+};
+
+enum {
+  DMA_DESC_NONISO_BYTES_MAX = 0xFFFF,
+  DMA_DESC_ISO_BYTES_MAX    = 0x7FF, // OUT is 11-bit, IN is 12-bit
+};
+
+// Quadlet 0 for control, bulk and interrupt endpoint
+typedef struct TU_ATTR_PACKED {
+  uint32_t bytes        : 16; // 0..15 bytes to transfer, updated with remaining bytes when done
+  uint32_t rsv16_22     :  7; // 16..22 Reserved
+  uint32_t mtrf         :  1; // 23 OUT: Multiple transfer
+  uint32_t setup_rx     :  1; // 24 OUT: Setup packet received
+  uint32_t ioc          :  1; // 25 Interrupt on complete
+  uint32_t short_packet :  1; // 26 IN: last packet is short, OUT: short packet received
+  uint32_t last         :  1; // 27 Last descriptor of the transfer
+  uint32_t status       :  2; // 28..29 Rx/Tx status
+  uint32_t buf_status   :  2; // 30..31 Buffer status
+} dwc2_dma_desc_status_t;
+TU_VERIFY_STATIC(sizeof(dwc2_dma_desc_status_t) == 4, "incorrect size");
+
+// Quadlet 0 for isochronous endpoint
+typedef struct TU_ATTR_PACKED {
+  uint32_t bytes        : 12; // 0..11 bytes to transfer (OUT 0..10), updated with remaining bytes when done
+  uint32_t frame_num    : 11; // 12..22 IN: (micro)frame to transmit in
+  uint32_t pid          :  2; // 23..24 IN: number of packets in (micro)frame, OUT: received PID
+  uint32_t ioc          :  1; // 25 Interrupt on complete
+  uint32_t short_packet :  1; // 26 IN: packet is short
+  uint32_t last         :  1; // 27 Last descriptor of the transfer
+  uint32_t status       :  2; // 28..29 Rx/Tx status
+  uint32_t buf_status   :  2; // 30..31 Buffer status
+} dwc2_dma_desc_iso_status_t;
+TU_VERIFY_STATIC(sizeof(dwc2_dma_desc_iso_status_t) == 4, "incorrect size");
+
+typedef struct {
+  union {
+    volatile uint32_t status;
+    volatile dwc2_dma_desc_status_t status_bm;
+    volatile dwc2_dma_desc_iso_status_t iso_bm;
+  };
+  volatile uint32_t buffer;
+} dwc2_dma_desc_t;
+TU_VERIFY_STATIC(sizeof(dwc2_dma_desc_t) == 8, "incorrect size");
+
 // Device IN/OUT Endpoint
 typedef struct {
   union {
@@ -936,6 +994,10 @@ TU_VERIFY_STATIC(offsetof(dwc2_regs_t, fifo   ) == 0x1000, "incorrect size");
 #define DCFG_XCVRDLY_Msk                 (0x1UL << DCFG_XCVRDLY_Pos)             // 0x00004000
 #define DCFG_XCVRDLY                     DCFG_XCVRDLY_Msk                        // Enables delay between xcvr_sel and txvalid during device chirp
 
+#define DCFG_DESCDMA_Pos                 (23U)
+#define DCFG_DESCDMA_Msk                 (0x1UL << DCFG_DESCDMA_Pos)              // 0x00800000
+#define DCFG_DESCDMA                     DCFG_DESCDMA_Msk                         // Enable scatter/gather DMA descriptor
+
 #define DCFG_PERSCHIVL_Pos               (24U)
 #define DCFG_PERSCHIVL_Msk               (0x3UL << DCFG_PERSCHIVL_Pos)            // 0x03000000
 #define DCFG_PERSCHIVL                   DCFG_PERSCHIVL_Msk                       // Periodic scheduling interval
@@ -43,6 +43,13 @@
 #define CFG_TUH_DWC2_ENDPOINT_MAX 16
 #endif
 
+// Number of channels kept for periodic endpoints: when there is opened periodic endpoint, non-periodic transfers
+// can not take the last CFG_TUH_DWC2_PERIOD_CHANNEL_RESERVED free channels. Endpoints are multiplexed on channels
+// so application can open more endpoints than hardware channels.
+#ifndef CFG_TUH_DWC2_PERIOD_CHANNEL_RESERVED
+#define CFG_TUH_DWC2_PERIOD_CHANNEL_RESERVED 1
+#endif
+
 #define DWC2_CHANNEL_COUNT_MAX    16 // absolute max channel count
 #define DWC2_CHANNEL_COUNT(_dwc2) tu_min8((_dwc2)->ghwcfg2_bm.num_host_ch + 1, DWC2_CHANNEL_COUNT_MAX)
 
@@ -60,6 +67,15 @@ enum {
   HCD_XFER_PERIOD_SPLIT_NYET_MAX = 3
 };
 
+// Periodic bandwidth (bytes including protocol overhead) is reserved per SOF slot (micro-frame for highspeed root port,
+// frame for full/low speed) within a window of 8 slots: up to 80% of a micro-frame or 90% of a frame
+enum {
+  HCD_PERIOD_BW_SLOTS      = 8,
+  HCD_PERIOD_BW_UFRAME_MAX = 6000,
+  HCD_PERIOD_BW_FRAME_MAX  = 1350,
+  HCD_PERIOD_INTERVAL_MAX  = 1024, // in SOF slot
+};
+
 //--------------------------------------------------------------------
 //
 //--------------------------------------------------------------------
@@ -80,10 +96,15 @@ typedef struct {
     uint32_t speed    : 2;
     uint32_t next_pid : 2;
     uint32_t do_ping  : 1;
-    // uint32_t : 9;
+    uint32_t xfer_pending : 1; // transfer is submitted but waiting for a channel (or its periodic slot)
+    uint32_t period_due   : 1; // periodic slot has arrived, served before non-periodic transfers
+    // uint32_t : 7;
   };
 
-  uint32_t uframe_countdown; // micro-frame count down to transfer for periodic, only need 18-bit
+  uint16_t period_interval; // periodic interval in SOF slot (power of 2)
+  uint8_t  period_phase;    // reserved slot: transfer is scheduled when (frame number % period_interval) == phase
+  uint8_t  TU_RESERVED;
+  uint16_t period_bw;       // reserved bytes per slot, 0 if not periodic
 
   uint8_t* buffer;
   uint16_t buflen;
@@ -109,6 +130,10 @@ typedef struct {
 typedef struct {
   hcd_xfer_t xfer[DWC2_CHANNEL_COUNT_MAX];
   hcd_endpoint_t edpt[CFG_TUH_DWC2_ENDPOINT_MAX];
+
+  uint16_t period_bw[HCD_PERIOD_BW_SLOTS]; // reserved periodic bytes per SOF slot
+  uint8_t period_ep_count; // number of opened periodic endpoints
+  uint8_t np_rr_ep_id;     // round-robin start for non-periodic endpoints waiting for a channel
 } hcd_data_t;
 
 hcd_data_t _hcd_data;
@@ -258,6 +283,92 @@ TU_ATTR_ALWAYS_INLINE static inline uint8_t cal_next_pid(uint8_t pid, uint8_t pa
   }
 }
 
+// Check if there is non-periodic endpoint (other than ep_id) waiting for a channel
+TU_ATTR_ALWAYS_INLINE static inline bool edpt_nonperiod_waiting(uint8_t ep_id) {
+  for (uint8_t i = 0; i < (uint8_t) CFG_TUH_DWC2_ENDPOINT_MAX; i++) {
+    const hcd_endpoint_t* edpt = &_hcd_data.edpt[i];
+    if (i != ep_id && edpt->hcchar_bm.enable && edpt->xfer_pending && !edpt_is_periodic(edpt->hcchar_bm.ep_type)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------
+// Periodic Bandwidth
+//--------------------------------------------------------------------
+
+// Bytes on the bus including protocol overhead (bit stuffing, token, handshake) of a periodic transaction.
+// Low speed is 8 times slower than full speed
+static uint16_t period_xact_bytes(uint8_t speed, uint16_t packet_size) {
+  const uint32_t payload = (packet_size * 7u) / 6u;
+
+  switch (speed) {
+    case TUSB_SPEED_HIGH: return (uint16_t) (payload + 38);
+    case TUSB_SPEED_LOW: return (uint16_t) (8*(payload + 13));
+    case TUSB_SPEED_FULL:
+    default: return (uint16_t) (payload + 13);
+  }
+}
+
+// Most occupied slot among slots that are phase mod interval
+static uint16_t period_bw_peak(uint16_t interval, uint8_t phase) {
+  const uint16_t step = tu_min16(interval, HCD_PERIOD_BW_SLOTS);
+  uint16_t peak = 0;
+  for (uint16_t i = phase % step; i < HCD_PERIOD_BW_SLOTS; i += step) {
+    peak = tu_max16(peak, _hcd_data.period_bw[i]);
+  }
+  return peak;
+}
+
+static void period_bw_update(uint16_t interval, uint8_t phase, uint16_t bytes, bool reserve) {
+  const uint16_t step = tu_min16(interval, HCD_PERIOD_BW_SLOTS);
+  for (uint16_t i = phase % step; i < HCD_PERIOD_BW_SLOTS; i += step) {
+    uint16_t* bw = &_hcd_data.period_bw[i];
+    *bw = (uint16_t) (reserve ? (*bw + bytes) : (*bw - bytes));
+  }
+}
+
+// Reserve bandwidth for an opened periodic endpoint at the least occupied phase. Interval is rounded down to power
+// of 2 since polling more often than bInterval is allowed.
+static bool edpt_period_reserve(dwc2_regs_t* dwc2, hcd_endpoint_t* edpt) {
+  const bool is_highspeed = (hprt_speed_get(dwc2) == TUSB_SPEED_HIGH);
+  uint32_t interval = is_highspeed ? edpt->uframe_interval : (edpt->uframe_interval >> 3);
+  interval = tu_min32(tu_max32(interval, 1), HCD_PERIOD_INTERVAL_MAX);
+  interval = 1u << tu_log2(interval);
+
+  const uint16_t bytes = period_xact_bytes(is_highspeed ? TUSB_SPEED_HIGH : edpt->speed, edpt->hcchar_bm.ep_size);
+  const uint16_t budget = is_highspeed ? HCD_PERIOD_BW_UFRAME_MAX : HCD_PERIOD_BW_FRAME_MAX;
+
+  uint8_t best_phase = 0;
+  uint16_t best_peak = UINT16_MAX;
+  const uint8_t phase_count = (uint8_t) tu_min32(interval, HCD_PERIOD_BW_SLOTS);
+  for (uint8_t phase = 0; phase < phase_count; phase++) {
+    const uint16_t peak = period_bw_peak((uint16_t) interval, phase);
+    if (peak < best_peak) {
+      best_peak = peak;
+      best_phase = phase;
+    }
+  }
+  TU_VERIFY(best_peak + bytes <= budget);
+
+  edpt->period_interval = (uint16_t) interval;
+  edpt->period_phase = best_phase;
+  edpt->period_bw = bytes;
+  period_bw_update(edpt->period_interval, best_phase, bytes, true);
+  _hcd_data.period_ep_count++;
+
+  return true;
+}
+
+static void edpt_period_release(hcd_endpoint_t* edpt) {
+  if (edpt->period_bw) {
+    period_bw_update(edpt->period_interval, edpt->period_phase, edpt->period_bw, false);
+    edpt->period_bw = 0;
+    _hcd_data.period_ep_count--;
+  }
+}
+
 //--------------------------------------------------------------------
 //
 //--------------------------------------------------------------------
@@ -447,6 +558,7 @@ void hcd_device_close(uint8_t rhport, uint8_t dev_addr) {
   for (uint8_t i = 0; i < (uint8_t) CFG_TUH_DWC2_ENDPOINT_MAX; i++) {
     hcd_endpoint_t* edpt = &_hcd_data.edpt[i];
     if (edpt->hcchar_bm.enable && edpt->hcchar_bm.dev_addr == dev_addr) {
+      edpt_period_release(edpt);
       tu_memclr(edpt, sizeof(hcd_endpoint_t));
     }
   }
@@ -503,6 +615,12 @@ bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, const tusb_desc_endpoint_t*
     }
   }
 
+  if (edpt_is_periodic(hcchar_bm->ep_type) && !edpt_period_reserve(dwc2, edpt)) {
+    TU_LOG1("DWC2: not enough periodic bandwidth for ep 0x%02X\r\n", desc_ep->bEndpointAddress);
+    tu_memclr(edpt, sizeof(hcd_endpoint_t));
+    return false;
+  }
+
   return true;
 }
 
@@ -615,7 +733,11 @@ static bool channel_xfer_start(dwc2_regs_t* dwc2, uint8_t ch_id) {
 // kick-off transfer with an endpoint
 static bool edpt_xfer_kickoff(dwc2_regs_t* dwc2, uint8_t ep_id) {
   uint8_t ch_id = channel_alloc(dwc2);
-  TU_ASSERT(ch_id < 16); // all channel are in used
+  TU_VERIFY(ch_id < 16); // all channel are in used, transfer stays pending
+  hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+  edpt->xfer_pending = 0;
+  edpt->period_due = 0;
+
   hcd_xfer_t* xfer = &_hcd_data.xfer[ch_id];
   xfer->ep_id = ep_id;
   xfer->result = XFER_RESULT_INVALID;
@@ -623,6 +745,41 @@ static bool edpt_xfer_kickoff(dwc2_regs_t* dwc2, uint8_t ep_id) {
   return channel_xfer_start(dwc2, ch_id);
 }
 
+// Assign free channels to pending transfers: periodic endpoints whose slot has arrived are served first, then
+// non-periodic endpoints in round-robin order. Non-periodic can not take channels reserved for periodic.
+static void edpt_xfer_dispatch(dwc2_regs_t* dwc2) {
+  const uint8_t max_channel = DWC2_CHANNEL_COUNT(dwc2);
+  uint8_t free_count = 0;
+  for (uint8_t ch_id = 0; ch_id < max_channel; ch_id++) {
+    if (!_hcd_data.xfer[ch_id].allocated) {
+      free_count++;
+    }
+  }
+
+  for (uint8_t ep_id = 0; ep_id < (uint8_t) CFG_TUH_DWC2_ENDPOINT_MAX && free_count > 0; ep_id++) {
+    const hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+    if (edpt->hcchar_bm.enable && edpt->xfer_pending && edpt->period_due && edpt_xfer_kickoff(dwc2, ep_id)) {
+      free_count--;
+    }
+  }
+
+  uint8_t reserved = 0;
+  if (_hcd_data.period_ep_count > 0 && max_channel > CFG_TUH_DWC2_PERIOD_CHANNEL_RESERVED) {
+    reserved = CFG_TUH_DWC2_PERIOD_CHANNEL_RESERVED;
+  }
+
+  const uint8_t rr_start = _hcd_data.np_rr_ep_id;
+  for (uint8_t i = 0; i < (uint8_t) CFG_TUH_DWC2_ENDPOINT_MAX && free_count > reserved; i++) {
+    const uint8_t ep_id = (uint8_t) ((rr_start + i) % CFG_TUH_DWC2_ENDPOINT_MAX);
+    const hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+    if (edpt->hcchar_bm.enable && edpt->xfer_pending && !edpt_is_periodic(edpt->hcchar_bm.ep_type) &&
+        edpt_xfer_kickoff(dwc2, ep_id)) {
+      free_count--;
+      _hcd_data.np_rr_ep_id = (uint8_t) ((ep_id + 1) % CFG_TUH_DWC2_ENDPOINT_MAX);
+    }
+  }
+}
+
 // Submit a transfer, when complete hcd_event_xfer_complete() must be invoked
 bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t * buffer, uint16_t buflen) {
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
@@ -641,7 +798,17 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
     edpt->hcchar_bm.ep_dir = ep_dir;
   }
 
-  return edpt_xfer_kickoff(dwc2, ep_id);
+  hcd_int_disable(rhport);
+  edpt->xfer_pending = 1;
+  if (edpt_is_periodic(edpt->hcchar_bm.ep_type)) {
+    // wait for its reserved slot, kicked off in SOF interrupt
+    dwc2->gintmsk |= GINTSTS_SOF;
+  } else {
+    edpt_xfer_dispatch(dwc2);
+  }
+  hcd_int_enable(rhport);
+
+  return true;
 }
 
 // Abort a queued transfer. Note: it can only abort transfer that has not been started
@@ -652,8 +819,13 @@ bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
   const uint8_t ep_dir = tu_edpt_dir(ep_addr);
   const uint8_t ep_id = edpt_find_opened(dev_addr, ep_num, ep_dir);
   TU_VERIFY(ep_id < CFG_TUH_DWC2_ENDPOINT_MAX);
+  hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
+
+  hcd_int_disable(rhport);
 
-  // hcd_int_disable(rhport);
+  // transfer is not started yet
+  edpt->xfer_pending = 0;
+  edpt->period_due = 0;
 
   // Find enabled channeled and disable it, channel will be de-allocated in the interrupt handler
   const uint8_t ch_id = channel_find_enabled(dwc2, dev_addr, ep_num, ep_dir);
@@ -662,7 +834,7 @@ bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
     channel_disable(dwc2, channel);
   }
 
-  // hcd_int_enable(rhport);
+  hcd_int_enable(rhport);
 
   return true;
 }
@@ -714,19 +886,26 @@ static void channel_xfer_in_retry(dwc2_regs_t* dwc2, uint8_t ch_id, uint32_t hci
       }
     }
 
-    // for periodic, de-allocate channel, enable SOF set frame counter for later transfer
+    // for periodic, de-allocate channel, enable SOF to retry in its next reserved slot
     edpt->next_pid = channel->hctsiz_bm.pid; // save PID
-    edpt->uframe_countdown = edpt->uframe_interval;
     dwc2->gintmsk |= GINTSTS_SOF;
 
     if (hcint & HCINT_HALTED) {
       // already halted, de-allocate channel (called from DMA isr)
       channel_dealloc(dwc2, ch_id);
+      edpt->xfer_pending = 1;
     } else {
       // disable channel first if not halted (called slave isr)
       xfer->halted_sof_schedule = 1;
       channel_disable(dwc2, channel);
     }
+  } else if ((hcint & HCINT_HALTED) && xfer->xferred_bytes == 0 && channel->hctsiz_bm.xfer_size == edpt->buflen &&
+             !channel->hcsplt_bm.split_compl && edpt_nonperiod_waiting(xfer->ep_id)) {
+    // for control/bulk: NAKed with nothing received while other endpoints are waiting for a channel. Release the
+    // channel and put endpoint back into round-robin queue so that it does not hog the channel
+    edpt->next_pid = channel->hctsiz_bm.pid; // save PID
+    edpt->xfer_pending = 1;
+    channel_dealloc(dwc2, ch_id);
   } else {
     // for control/bulk: retry immediately
     channel_send_in_token(dwc2, channel);
@@ -902,6 +1081,7 @@ static bool handle_channel_in_slave(dwc2_regs_t* dwc2, uint8_t ch_id, uint32_t h
     if (xfer->halted_sof_schedule) {
       // de-allocate channel but does not complete xfer, we schedule it in the SOF interrupt
       channel_dealloc(dwc2, ch_id);
+      edpt->xfer_pending = 1;
     } else if (xfer->result != XFER_RESULT_INVALID) {
       is_done = true;
     } else if (xfer->err_count == HCD_XFER_ERROR_MAX) {
@@ -1171,32 +1351,32 @@ static void handle_channel_irq(uint8_t rhport, bool in_isr) {
       }
     }
   }
+
+  // freed channels are assigned to pending transfers
+  edpt_xfer_dispatch(dwc2);
 }
 
-// SOF is enabled for scheduled periodic transfer
+// SOF is enabled for scheduled periodic transfer. Frame number is in SOF unit: micro-frame for highspeed, frame for
+// full/low speed, which matches the slot unit of periodic bandwidth reservation.
 static bool handle_sof_irq(uint8_t rhport, bool in_isr) {
   (void) in_isr;
   dwc2_regs_t* dwc2 = DWC2_REG(rhport);
+  const uint32_t frnum = dwc2->hfnum & HFNUM_FRNUM_Msk;
 
   bool more_isr = false;
 
-  // If highspeed then SOF is 125us, else 1ms
-  const uint32_t ucount = (hprt_speed_get(dwc2) == TUSB_SPEED_HIGH ? 1 : 8);
-
   for(uint8_t ep_id = 0; ep_id < CFG_TUH_DWC2_ENDPOINT_MAX; ep_id++) {
     hcd_endpoint_t* edpt = &_hcd_data.edpt[ep_id];
-    if (edpt->hcchar_bm.enable && edpt_is_periodic(edpt->hcchar_bm.ep_type) && edpt->uframe_countdown > 0) {
-      edpt->uframe_countdown -= tu_min32(ucount, edpt->uframe_countdown);
-      if (edpt->uframe_countdown == 0) {
-        if (!edpt_xfer_kickoff(dwc2, ep_id)) {
-          edpt->uframe_countdown = ucount; // failed to start, try again next frame
-        }
+    if (edpt->hcchar_bm.enable && edpt_is_periodic(edpt->hcchar_bm.ep_type) && edpt->xfer_pending) {
+      if ((frnum & (edpt->period_interval - 1u)) == edpt->period_phase) {
+        edpt->period_due = 1; // stay due until a channel is available
       }
-
       more_isr = true;
     }
   }
 
+  edpt_xfer_dispatch(dwc2);
+
   return more_isr;
 }
 
@@ -113,7 +113,7 @@ void dcd_edpt_close_all (uint8_t rhport) {
 }
 
 // Submit a transfer, When complete dcd_event_xfer_complete() is invoked to notify the stack
-bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes) {
+bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint32_t total_bytes) {
   (void) rhport;
   (void) ep_addr;
   (void) buffer;
@@ -475,7 +475,7 @@ void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr)
   // IN endpoints will get un-stalled when more data is written.
 }
 
-bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes)
+bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes)
 {
   (void)rhport;
   uint8_t ep_num = tu_edpt_number(ep_addr);
@@ -507,7 +507,7 @@ bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t t
 
     TU_ASSERT(tx_buffer[ep_num] == NULL);
     tx_buffer_offset[ep_num] = 0;
-    tx_buffer_max[ep_num] = total_bytes;
+    tx_buffer_max[ep_num] = (uint16_t) total_bytes;
     tx_buffer[ep_num] = buffer;
 
     // If the current buffer is NULL, then that means the tx logic is idle.
@@ -533,7 +533,7 @@ bool dcd_edpt_xfer (uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t t
 #endif
     rx_buffer[ep_num] = buffer;
     rx_buffer_offset[ep_num] = 0;
-    rx_buffer_max[ep_num] = total_bytes;
+    rx_buffer_max[ep_num] = (uint16_t) total_bytes;
 
     // Enable receiving on this particular endpoint
     usb_out_ctrl_write((1 << CSR_USB_OUT_CTRL_ENABLE_OFFSET) | ep_num);
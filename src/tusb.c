@@ -468,6 +468,268 @@ uint32_t tu_edpt_stream_read(uint8_t hwid, tu_edpt_stream_t* s, void* buffer, ui
   return num_read;
 }
 
+//--------------------------------------------------------------------+
+// Framed Receive
+//--------------------------------------------------------------------+
+enum {
+  SLIP_END     = 0xC0,
+  SLIP_ESC     = 0xDB,
+  SLIP_ESC_END = 0xDC,
+  SLIP_ESC_ESC = 0xDD
+};
+
+uint32_t tu_mem_find_byte(void const* buf, uint32_t len, uint8_t byte) {
+  uint8_t const* p8 = (uint8_t const*) buf;
+  uint32_t i = 0;
+
+  // head until word aligned
+  while (i < len && (((uintptr_t) (p8 + i)) & 3u)) {
+    if (p8[i] == byte) {
+      return i;
+    }
+    i++;
+  }
+
+  // word at a time: a word has a zero byte if (v - 0x01..01) & ~v & 0x80..80 is not zero
+  uint32_t const pattern = 0x01010101u * byte;
+  while (i + 4 <= len) {
+    uint32_t v;
+    memcpy(&v, p8 + i, 4);
+    v ^= pattern;
+    if ((v - 0x01010101u) & ~v & 0x80808080u) {
+      break; // located within this word
+    }
+    i += 4;
+  }
+
+  while (i < len) {
+    if (p8[i] == byte) {
+      return i;
+    }
+    i++;
+  }
+
+  return len;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint8_t frame_terminator(tu_frame_t const* fr) {
+  switch (fr->mode) {
+    case TUSB_FRAME_COBS: return 0x00;
+    case TUSB_FRAME_SLIP: return SLIP_END;
+    default: return fr->delimiter;
+  }
+}
+
+// byte of fifo content at offset, caller makes sure it is within info
+TU_ATTR_ALWAYS_INLINE static inline uint8_t frame_byte(tu_fifo_buffer_info_t const* info, uint16_t offset) {
+  return (offset < info->len_lin) ? ((uint8_t const*) info->ptr_lin)[offset]
+                                  : ((uint8_t const*) info->ptr_wrap)[offset - info->len_lin];
+}
+
+// sub range [offset, offset+len) of fifo content
+static void frame_sub_info(tu_fifo_buffer_info_t* info, uint16_t offset, uint16_t len) {
+  if (offset >= info->len_lin) {
+    info->ptr_lin = ((uint8_t*) info->ptr_wrap) + (offset - info->len_lin);
+    info->len_lin = len;
+    info->ptr_wrap = NULL;
+    info->len_wrap = 0;
+  } else {
+    info->ptr_lin = ((uint8_t*) info->ptr_lin) + offset;
+    uint16_t const lin = (uint16_t) (info->len_lin - offset);
+    info->len_lin = tu_min16(lin, len);
+    info->len_wrap = (uint16_t) (len - info->len_lin);
+    if (info->len_wrap == 0) {
+      info->ptr_wrap = NULL;
+    }
+  }
+}
+
+// search terminator from where last search stopped, return raw length of frame ending with it or 0 if not found
+static uint16_t frame_scan_terminator(tu_frame_t* fr, tu_fifo_buffer_info_t const* info, uint16_t count) {
+  uint8_t const terminator = frame_terminator(fr);
+  uint16_t pos = fr->scanned;
+
+  if (pos < info->len_lin) {
+    pos = (uint16_t) (pos + tu_mem_find_byte((uint8_t const*) info->ptr_lin + pos, info->len_lin - pos, terminator));
+  }
+  if (pos >= info->len_lin && pos < count) {
+    uint16_t const wpos = (uint16_t) (pos - info->len_lin);
+    pos = (uint16_t) (pos + tu_mem_find_byte((uint8_t const*) info->ptr_wrap + wpos, info->len_wrap - wpos, terminator));
+  }
+
+  if (pos < count) {
+    fr->scanned = 0;
+    return (uint16_t) (pos + 1);
+  }
+
+  fr->scanned = count;
+  return 0;
+}
+
+uint16_t tu_frame_find(tu_frame_t* fr, tu_fifo_t* ff) {
+  if (fr->found_len) {
+    return fr->found_len;
+  }
+  TU_VERIFY(!fr->skipping, 0);
+
+  tu_fifo_buffer_info_t info;
+  tu_fifo_get_read_info(ff, &info);
+  uint16_t const count = (uint16_t) (info.len_lin + info.len_wrap);
+  if (fr->scanned > count) {
+    fr->scanned = 0;
+  }
+
+  if (fr->mode == TUSB_FRAME_LENGTH16) {
+    TU_VERIFY(count >= 2, 0);
+    uint32_t const raw_len = 2u + tu_u16(frame_byte(&info, 1), frame_byte(&info, 0));
+    TU_VERIFY(count >= raw_len, 0);
+    fr->found_len = (uint16_t) raw_len;
+    return fr->found_len;
+  }
+
+  fr->found_len = frame_scan_terminator(fr, &info, count);
+  return fr->found_len;
+}
+
+// drop received part of an oversized frame, stop skipping once its end is reached
+static void frame_skip(tu_frame_t* fr, tu_fifo_t* ff) {
+  tu_fifo_buffer_info_t info;
+  tu_fifo_get_read_info(ff, &info);
+  uint16_t const count = (uint16_t) (info.len_lin + info.len_wrap);
+  uint16_t drop;
+
+  if (fr->mode == TUSB_FRAME_LENGTH16) {
+    drop = (uint16_t) tu_min32(count, fr->skip_len);
+    fr->skip_len -= drop;
+    fr->skipping = (fr->skip_len > 0);
+  } else {
+    // bytes dropped before were already searched
+    fr->scanned = 0;
+    uint16_t const raw_len = frame_scan_terminator(fr, &info, count);
+    drop = raw_len ? raw_len : count;
+    fr->skipping = (raw_len == 0);
+  }
+
+  tu_fifo_advance_read_pointer(ff, drop);
+  fr->scanned = 0;
+  fr->found_len = 0;
+}
+
+bool tu_frame_received(tu_frame_t* fr, tu_fifo_t* ff, uint16_t rx_size) {
+  if (fr->skipping) {
+    frame_skip(fr, ff);
+    TU_VERIFY(!fr->skipping);
+  }
+
+  if (tu_frame_find(fr, ff)) {
+    return true;
+  }
+
+  if (tu_fifo_remaining(ff) < rx_size) {
+    // frame larger than fifo can hold
+    TU_LOG2("  Frame overflow, dropped\r\n");
+    if (fr->mode == TUSB_FRAME_LENGTH16) {
+      uint16_t const count = tu_fifo_count(ff);
+      uint8_t hdr[2] = {0, 0};
+      tu_fifo_peek_n(ff, hdr, 2);
+      // fifo can not even hold length prefix: framing can not be recovered, drop everything
+      fr->skip_len = (count >= 2) ? (2u + tu_u16(hdr[1], hdr[0])) : count;
+    }
+    fr->skipping = 1;
+    frame_skip(fr, ff);
+  }
+
+  return false;
+}
+
+bool tu_frame_peek(tu_frame_t* fr, tu_fifo_t* ff, tu_fifo_buffer_info_t* info) {
+  uint16_t const raw_len = tu_frame_find(fr, ff);
+  TU_VERIFY(raw_len);
+
+  tu_fifo_get_read_info(ff, info);
+  if (fr->mode == TUSB_FRAME_LENGTH16) {
+    frame_sub_info(info, 2, (uint16_t) (raw_len - 2));
+  } else {
+    frame_sub_info(info, 0, (uint16_t) (raw_len - 1));
+  }
+
+  return true;
+}
+
+uint32_t tu_frame_read(tu_frame_t* fr, tu_fifo_t* ff, void* buffer, uint32_t bufsize) {
+  uint16_t const raw_len = tu_frame_find(fr, ff);
+  TU_VERIFY(raw_len, 0);
+
+  tu_fifo_buffer_info_t info;
+  TU_ASSERT(tu_frame_peek(fr, ff, &info), 0);
+
+  uint8_t* out = (uint8_t*) buffer;
+  if (out == NULL) {
+    bufsize = 0;
+  }
+  uint32_t out_len = 0;
+
+  if (fr->mode == TUSB_FRAME_COBS || fr->mode == TUSB_FRAME_SLIP) {
+    // decode in a single pass over both linear parts
+    uint8_t cobs_code = 0;
+    uint8_t cobs_remain = 0;
+    bool slip_esc = false;
+
+    for (uint8_t part = 0; part < 2; part++) {
+      uint8_t const* p = (uint8_t const*) (part ? info.ptr_wrap : info.ptr_lin);
+      uint16_t const n = part ? info.len_wrap : info.len_lin;
+
+      for (uint16_t i = 0; i < n; i++) {
+        uint8_t const b = p[i];
+        int16_t ch = -1;
+
+        if (fr->mode == TUSB_FRAME_COBS) {
+          if (cobs_remain == 0) {
+            // new block: previous one not at max length ends with implicit zero
+            if (cobs_code && cobs_code != 0xFF) {
+              ch = 0;
+            }
+            cobs_code = b;
+            cobs_remain = (uint8_t) (b ? b - 1 : 0);
+          } else {
+            ch = b;
+            cobs_remain--;
+          }
+        } else {
+          if (slip_esc) {
+            ch = (b == SLIP_ESC_END) ? SLIP_END : (b == SLIP_ESC_ESC) ? SLIP_ESC : b;
+            slip_esc = false;
+          } else if (b == SLIP_ESC) {
+            slip_esc = true;
+          } else {
+            ch = b;
+          }
+        }
+
+        if (ch >= 0 && out_len < bufsize) {
+          out[out_len++] = (uint8_t) ch;
+        }
+      }
+    }
+  } else {
+    // plain payload
+    uint16_t const lin = (uint16_t) tu_min32(info.len_lin, bufsize);
+    if (lin) {
+      memcpy(out, info.ptr_lin, lin);
+    }
+    uint16_t const wrap = (uint16_t) tu_min32(info.len_wrap, bufsize - lin);
+    if (wrap) {
+      memcpy(out + lin, info.ptr_wrap, wrap);
+    }
+    out_len = (uint32_t) lin + wrap;
+  }
+
+  tu_fifo_advance_read_pointer(ff, raw_len);
+  tu_frame_reset(fr);
+
+  return out_len;
+}
+
 //--------------------------------------------------------------------+
 // Debug
 //--------------------------------------------------------------------+
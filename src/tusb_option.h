@@ -266,6 +266,30 @@
   #define CFG_TUD_DWC2_DMA_ENABLE CFG_TUD_DWC2_DMA_ENABLE_DEFAULT
 #endif
 
+// Use DWC2 Scatter/Gather (descriptor) DMA for device when CFG_TUD_DWC2_DMA_ENABLE is also set.
+// Buffer DMA is used instead if the core is not configured with it.
+#ifndef CFG_TUD_DWC2_DMA_DESC_ENABLE
+  #define CFG_TUD_DWC2_DMA_DESC_ENABLE 0
+#endif
+
+// Number of DMA descriptors for each endpoint direction
+#ifndef CFG_TUD_DWC2_DMA_DESC_COUNT
+  #define CFG_TUD_DWC2_DMA_DESC_COUNT 4
+#endif
+
+// Number of qTDs for each ChipIdea HS endpoint. A transfer takes one qTD per 16KB, a transfer can be linked
+// behind the active one as long as there are enough free qTDs.
+#ifndef CFG_TUD_CI_HS_QTD_PER_EP
+  #define CFG_TUD_CI_HS_QTD_PER_EP 4
+#endif
+
+// Use double buffering for bulk endpoints of STM32 FSDEV (and compatible) so that a packet can be received/transmitted
+// while the other is copied. Such endpoint takes 2 packet buffers and a hardware endpoint of its own, it falls back
+// to single buffer if either runs out.
+#ifndef CFG_TUD_FSDEV_DOUBLE_BUFFER
+  #define CFG_TUD_FSDEV_DOUBLE_BUFFER 0
+#endif
+
 // Enable DWC2 Slave mode for host
 #ifndef CFG_TUH_DWC2_SLAVE_ENABLE
   #ifndef CFG_TUH_DWC2_SLAVE_ENABLE_DEFAULT
@@ -470,6 +494,13 @@
   #error "CFG_TUD_ENDPPOINT_MAX must be less than or equal to TUP_DCD_ENDPOINT_MAX"
 #endif
 
+// Number of transfers per endpoint that can be queued with usbd_edpt_xfer_queue() in addition to the active one.
+// Queued transfers are started from the transfer complete interrupt (or linked in hardware by DCD) so that endpoint
+// does not idle while waiting for usbd task. 0 to disable
+#ifndef CFG_TUD_EDPT_XFER_QUEUE
+  #define CFG_TUD_EDPT_XFER_QUEUE 0
+#endif
+
 // USB 2.0 7.1.20: compliance test mode support
 #ifndef CFG_TUD_TEST_MODE
   #define CFG_TUD_TEST_MODE       0
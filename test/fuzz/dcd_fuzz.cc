@@ -160,7 +160,7 @@ void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
 // Submit a transfer, When complete dcd_event_xfer_complete() is invoked to
 // notify the stack
 bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer,
-                   uint16_t total_bytes) {
+                   uint32_t total_bytes) {
   UNUSED(rhport);
   UNUSED(buffer);
   UNUSED(total_bytes);
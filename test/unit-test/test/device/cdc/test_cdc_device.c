@@ -0,0 +1,228 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019, hathach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// CDC is not enabled by support tusb_config.h, enable it for this test only
+#define CFG_TUD_CDC            1
+#define CFG_TUD_CDC_RX_BUFSIZE 64
+#define CFG_TUD_CDC_TX_BUFSIZE 64
+#define CFG_TUD_CDC_EP_BUFSIZE 64
+
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+
+// File to test, included to access its static interface
+#include "cdc_device.c"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+enum {
+  EDPT_CDC_IN = 0x81,
+};
+
+static uint8_t const rhport = 0;
+static cdcd_interface_t* cdc = &_cdcd_itf[0];
+
+// usbd stub: transfers submitted and SOF interrupt state
+static uint8_t xfer_count;
+static uint32_t xfer_bytes;
+static bool sof_enabled;
+
+//--------------------------------------------------------------------+
+// usbd stub
+//--------------------------------------------------------------------+
+bool tud_mounted(void) {
+  return true;
+}
+
+bool tud_suspended(void) {
+  return false;
+}
+
+bool usbd_edpt_claim(uint8_t rhport_, uint8_t ep_addr) {
+  (void) rhport_; (void) ep_addr;
+  return true;
+}
+
+bool usbd_edpt_release(uint8_t rhport_, uint8_t ep_addr) {
+  (void) rhport_; (void) ep_addr;
+  return true;
+}
+
+bool usbd_edpt_xfer(uint8_t rhport_, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
+  (void) rhport_; (void) buffer;
+  TEST_ASSERT_EQUAL_HEX8(EDPT_CDC_IN, ep_addr);
+  xfer_count++;
+  xfer_bytes += total_bytes;
+  return true;
+}
+
+void usbd_sof_enable(uint8_t rhport_, sof_consumer_t consumer, bool en) {
+  (void) rhport_;
+  TEST_ASSERT_EQUAL(SOF_CONSUMER_CDC, consumer);
+  sof_enabled = en;
+}
+
+// run deferred function right away as usbd task would do
+void usbd_defer_func(osal_task_func_t func, void* param, bool in_isr) {
+  (void) in_isr;
+  func(param);
+}
+
+// Not used by these tests
+bool usbd_edpt_open(uint8_t rhport_, tusb_desc_endpoint_t const* desc_ep) {
+  (void) rhport_; (void) desc_ep;
+  return false;
+}
+
+bool usbd_open_edpt_pair(uint8_t rhport_, uint8_t const* p_desc, uint8_t ep_count, uint8_t xfer_type,
+                         uint8_t* ep_out, uint8_t* ep_in) {
+  (void) rhport_; (void) p_desc; (void) ep_count; (void) xfer_type; (void) ep_out; (void) ep_in;
+  return false;
+}
+
+void usbd_edpt_set_instance(uint8_t rhport_, uint8_t ep_addr, uint8_t instance) {
+  (void) rhport_; (void) ep_addr; (void) instance;
+}
+
+uint8_t usbd_edpt_get_instance(uint8_t rhport_, uint8_t ep_addr) {
+  (void) rhport_; (void) ep_addr;
+  return 0;
+}
+
+bool tud_control_xfer(uint8_t rhport_, tusb_control_request_t const* request, void* buffer, uint16_t len) {
+  (void) rhport_; (void) request; (void) buffer; (void) len;
+  return false;
+}
+
+bool tud_control_status(uint8_t rhport_, tusb_control_request_t const* request) {
+  (void) rhport_; (void) request;
+  return false;
+}
+
+uint16_t tu_frame_find(tu_frame_t* fr, tu_fifo_t* ff) {
+  (void) fr; (void) ff;
+  return 0;
+}
+
+bool tu_frame_received(tu_frame_t* fr, tu_fifo_t* ff, uint16_t rx_size) {
+  (void) fr; (void) ff; (void) rx_size;
+  return false;
+}
+
+uint32_t tu_frame_read(tu_frame_t* fr, tu_fifo_t* ff, void* buffer, uint32_t bufsize) {
+  (void) fr; (void) ff; (void) buffer; (void) bufsize;
+  return 0;
+}
+
+uint32_t tu_mem_find_byte(void const* buf, uint32_t len, uint8_t byte) {
+  (void) buf; (void) byte;
+  return len;
+}
+
+bool tu_frame_peek(tu_frame_t* fr, tu_fifo_t* ff, tu_fifo_buffer_info_t* info) {
+  (void) fr; (void) ff; (void) info;
+  return false;
+}
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+static void sof_run(uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) {
+    cdcd_sof_isr(rhport, 0); // frame count is not reported by some DCDs
+  }
+}
+
+//--------------------------------------------------------------------+
+// Test
+//--------------------------------------------------------------------+
+void setUp(void) {
+  cdcd_init();
+  cdcd_reset(rhport);
+  cdc->ep_in = EDPT_CDC_IN;
+
+  xfer_count = 0;
+  xfer_bytes = 0;
+  sof_enabled = false;
+}
+
+void tearDown(void) {
+}
+
+void test_flush_min_fill(void) {
+  TEST_ASSERT_TRUE(tud_cdc_n_set_tx_flush(0, 5, 16));
+
+  uint8_t const data[16] = { 0 };
+  tud_cdc_n_write(0, data, 15);
+  TEST_ASSERT_EQUAL(0, xfer_count);
+  TEST_ASSERT_TRUE(sof_enabled);
+
+  tud_cdc_n_write(0, data, 1);
+  TEST_ASSERT_EQUAL(1, xfer_count);
+  TEST_ASSERT_EQUAL(16, xfer_bytes);
+  TEST_ASSERT_FALSE(cdc->tx_pending);
+}
+
+void test_flush_delay_expired(void) {
+  TEST_ASSERT_TRUE(tud_cdc_n_set_tx_flush(0, 5, 16));
+
+  tud_cdc_n_write(0, "abc", 3);
+  TEST_ASSERT_TRUE(sof_enabled);
+
+  sof_run(4);
+  TEST_ASSERT_EQUAL(0, xfer_count);
+
+  // more data does not restart the delay
+  tud_cdc_n_write(0, "de", 2);
+  sof_run(1);
+  TEST_ASSERT_EQUAL(1, xfer_count);
+  TEST_ASSERT_EQUAL(5, xfer_bytes);
+
+  // SOF is no longer needed once nothing is pending
+  TEST_ASSERT_FALSE(sof_enabled);
+}
+
+void test_flush_delay_disabled(void) {
+  TEST_ASSERT_TRUE(tud_cdc_n_set_tx_flush(0, 0, 16));
+
+  tud_cdc_n_write(0, "abc", 3);
+  TEST_ASSERT_FALSE(sof_enabled);
+
+  sof_run(100);
+  TEST_ASSERT_EQUAL(0, xfer_count);
+
+  TEST_ASSERT_EQUAL(3, tud_cdc_n_write_flush(0));
+  TEST_ASSERT_EQUAL(1, xfer_count);
+}
+
+void test_flush_min_fill_default(void) {
+  // 0 means one bulk packet, limited to TX FIFO size
+  TEST_ASSERT_TRUE(tud_cdc_n_set_tx_flush(0, 5, 0));
+  TEST_ASSERT_EQUAL(CFG_TUD_CDC_TX_BUFSIZE, cdc->tx_min_fill);
+}
@@ -0,0 +1,332 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019, hathach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// MIDI is not enabled by support tusb_config.h, enable it for this test only
+#define CFG_TUD_MIDI            1
+#define CFG_TUD_MIDI_RX_BUFSIZE 64
+#define CFG_TUD_MIDI_TX_BUFSIZE 64
+
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+
+// File to test, included to access its static codec
+#include "midi_device.c"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+enum {
+  ITF_NUM_MIDI  = 0,
+  EDPT_MIDI_OUT = 0x01,
+  EDPT_MIDI_IN  = 0x81,
+};
+
+static uint8_t const desc_midi2[] = {
+  TUD_MIDI2_DESCRIPTOR(ITF_NUM_MIDI, 0, EDPT_MIDI_OUT, EDPT_MIDI_IN, 64)
+};
+
+static uint8_t const rhport = 0;
+static midid_interface_t* midi = &_midid_itf[0];
+
+// usbd stub: endpoints opened, closed and stall cleared
+static uint8_t open_count;
+static uint8_t close_count;
+static uint8_t clear_stall_count;
+
+//--------------------------------------------------------------------+
+// usbd stub
+//--------------------------------------------------------------------+
+
+// IN endpoint is never claimed so that written packets stay in TX FIFO to be checked
+bool usbd_edpt_claim(uint8_t rhport_, uint8_t ep_addr) {
+  (void) rhport_; (void) ep_addr;
+  return false;
+}
+
+bool usbd_edpt_release(uint8_t rhport_, uint8_t ep_addr) {
+  (void) rhport_; (void) ep_addr;
+  return true;
+}
+
+bool usbd_edpt_xfer(uint8_t rhport_, uint8_t ep_addr, uint8_t* buffer, uint32_t total_bytes) {
+  (void) rhport_; (void) ep_addr; (void) buffer; (void) total_bytes;
+  return true;
+}
+
+bool usbd_edpt_open(uint8_t rhport_, tusb_desc_endpoint_t const* desc_ep) {
+  (void) rhport_;
+  (void) desc_ep;
+  open_count++;
+  return true;
+}
+
+void usbd_edpt_close(uint8_t rhport_, uint8_t ep_addr) {
+  (void) rhport_; (void) ep_addr;
+  close_count++;
+}
+
+void usbd_edpt_stall(uint8_t rhport_, uint8_t ep_addr) {
+  (void) rhport_; (void) ep_addr;
+}
+
+void usbd_edpt_clear_stall(uint8_t rhport_, uint8_t ep_addr) {
+  (void) rhport_; (void) ep_addr;
+  clear_stall_count++;
+}
+
+void usbd_edpt_set_instance(uint8_t rhport_, uint8_t ep_addr, uint8_t instance) {
+  (void) rhport_; (void) ep_addr; (void) instance;
+}
+
+uint8_t usbd_edpt_get_instance(uint8_t rhport_, uint8_t ep_addr) {
+  (void) rhport_; (void) ep_addr;
+  return 0;
+}
+
+bool tud_control_xfer(uint8_t rhport_, tusb_control_request_t const* request, void* buffer, uint16_t len) {
+  (void) rhport_; (void) request; (void) buffer; (void) len;
+  return true;
+}
+
+bool tud_control_status(uint8_t rhport_, tusb_control_request_t const* request) {
+  (void) rhport_; (void) request;
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+// Move event packets sent to host into RX FIFO as if host sent them back
+static uint16_t loopback_packets(uint8_t packets[][4], uint16_t max_count) {
+  uint16_t const count = tu_fifo_read_n(&midi->tx_ff, packets, max_count);
+  tu_fifo_write_n(&midi->rx_ff, packets, count);
+  return count;
+}
+
+static void set_interface(uint8_t alt) {
+  tusb_control_request_t const request = {
+    .bmRequestType = 0x01,
+    .bRequest      = TUSB_REQ_SET_INTERFACE,
+    .wValue        = alt,
+    .wIndex        = ITF_NUM_MIDI + 1,
+    .wLength       = 0
+  };
+  TEST_ASSERT_TRUE(midid_control_xfer_cb(rhport, CONTROL_STAGE_SETUP, &request));
+}
+
+//--------------------------------------------------------------------+
+// Test
+//--------------------------------------------------------------------+
+void setUp(void) {
+  midid_init();
+  TEST_ASSERT_EQUAL(sizeof(desc_midi2), midid_open(rhport, (tusb_desc_interface_t const*) desc_midi2, sizeof(desc_midi2)));
+  TEST_ASSERT_TRUE(midi->ump_supported);
+  open_count = close_count = clear_stall_count = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_set_interface_reset_endpoints(void) {
+  tu_fifo_write(&midi->tx_ff, (uint8_t const[]) { 0x09, 0x90, 0x3C, 0x7F });
+
+  set_interface(1);
+  TEST_ASSERT_TRUE(tud_midi_n_ump_mode(0));
+  TEST_ASSERT_EQUAL(2, clear_stall_count);
+  TEST_ASSERT_TRUE(tu_fifo_empty(&midi->tx_ff));
+
+  set_interface(0);
+  TEST_ASSERT_FALSE(tud_midi_n_ump_mode(0));
+  TEST_ASSERT_EQUAL(4, clear_stall_count);
+
+  // endpoints stay open across alternate settings
+  TEST_ASSERT_EQUAL(0, open_count);
+  TEST_ASSERT_EQUAL(0, close_count);
+}
+
+void test_ump_channel_voice_roundtrip(void) {
+  uint32_t const ump[] = {
+    0x20903C7F, // note on
+    0x20803C00, // note off
+    0x20B00764, // control change
+    0x20C00500, // program change
+    0x20D04000, // channel pressure
+    0x20E00040, // pitch bend
+  };
+  uint8_t const count = TU_ARRAY_SIZE(ump);
+  TEST_ASSERT_EQUAL(count, tud_midi_n_ump_write(0, ump, count));
+
+  uint8_t packets[8][4];
+  TEST_ASSERT_EQUAL(count, loopback_packets(packets, 8));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(((uint8_t const[]) { MIDI_CIN_NOTE_ON, 0x90, 0x3C, 0x7F }), packets[0], 4);
+
+  uint32_t words[8];
+  TEST_ASSERT_EQUAL(count, tud_midi_n_ump_read(0, words, 8));
+  TEST_ASSERT_EQUAL_HEX32_ARRAY(ump, words, count);
+}
+
+void test_ump_group_to_cable_roundtrip(void) {
+  uint32_t const ump[] = { 0x20903C7F, 0x23913D7F, 0x2F9F3E7F, 0x1AF80000 };
+  uint8_t const count = TU_ARRAY_SIZE(ump);
+  TEST_ASSERT_EQUAL(count, tud_midi_n_ump_write(0, ump, count));
+
+  uint8_t packets[8][4];
+  TEST_ASSERT_EQUAL(count, loopback_packets(packets, 8));
+  TEST_ASSERT_EQUAL_HEX8(0x09, packets[0][0]);
+  TEST_ASSERT_EQUAL_HEX8(0x39, packets[1][0]);
+  TEST_ASSERT_EQUAL_HEX8(0xF9, packets[2][0]);
+  TEST_ASSERT_EQUAL_HEX8(0xAF, packets[3][0]); // real-time on cable 10
+
+  uint32_t words[8];
+  TEST_ASSERT_EQUAL(count, tud_midi_n_ump_read(0, words, 8));
+  TEST_ASSERT_EQUAL_HEX32_ARRAY(ump, words, count);
+}
+
+void test_ump_sysex7_split_and_reassembly(void) {
+  // group 2: 01 .. 06 in start packet, 07 08 in end packet
+  uint32_t const ump[] = {
+    0x32160102, 0x03040506,
+    0x32320708, 0x00000000
+  };
+  TEST_ASSERT_EQUAL(4, tud_midi_n_ump_write(0, ump, 4));
+
+  // split into MIDI 1.0 SysEx event packets on cable 2
+  uint8_t packets[8][4];
+  TEST_ASSERT_EQUAL(4, loopback_packets(packets, 8));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(((uint8_t const[]) { 0x24, 0xF0, 0x01, 0x02 }), packets[0], 4);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(((uint8_t const[]) { 0x24, 0x03, 0x04, 0x05 }), packets[1], 4);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(((uint8_t const[]) { 0x24, 0x06, 0x07, 0x08 }), packets[2], 4);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(((uint8_t const[]) { 0x25, 0xF7, 0x00, 0x00 }), packets[3], 4);
+
+  // back to UMP SysEx7, one per event packet
+  uint32_t words[16];
+  TEST_ASSERT_EQUAL(8, tud_midi_n_ump_read(0, words, 16));
+
+  uint8_t data[16];
+  uint8_t data_len = 0;
+  for (uint8_t i = 0; i < 8; i += 2) {
+    uint8_t const sx_status = (uint8_t) ((words[i] >> 20) & 0x0F);
+    uint8_t const n = (uint8_t) ((words[i] >> 16) & 0x0F);
+    uint8_t const bytes[3] = { (uint8_t) (words[i] >> 8), (uint8_t) words[i], (uint8_t) (words[i + 1] >> 24) };
+
+    TEST_ASSERT_EQUAL_HEX8(0x32, words[i] >> 24);
+    TEST_ASSERT_EQUAL(i == 0 ? MIDI_UMP_SYSEX_START : (i == 6 ? MIDI_UMP_SYSEX_END : MIDI_UMP_SYSEX_CONTINUE), sx_status);
+    TEST_ASSERT_LESS_OR_EQUAL(3, n);
+    for (uint8_t j = 0; j < n; j++) {
+      data[data_len++] = bytes[j];
+    }
+  }
+
+  TEST_ASSERT_EQUAL(8, data_len);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(((uint8_t const[]) { 1, 2, 3, 4, 5, 6, 7, 8 }), data, 8);
+}
+
+//--------------------------------------------------------------------+
+// MIDI 1.0 stream codec
+//--------------------------------------------------------------------+
+
+// Write stream bytes and compare event packets in TX FIFO
+static void stream_write_check(uint8_t const* bytes, uint32_t len, uint8_t const expected[][4], uint16_t count) {
+  TEST_ASSERT_EQUAL(len, tud_midi_n_stream_write(0, 0, bytes, len));
+
+  uint8_t packets[8][4];
+  TEST_ASSERT_EQUAL(count, tu_fifo_read_n(&midi->tx_ff, packets, 8));
+  if (count) {
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, packets, 4u * count);
+  }
+}
+
+void test_stream_write_running_status(void) {
+  // status is re-inserted for data bytes of next call
+  uint8_t const note_on[] = { 0x90, 0x3C, 0x7F };
+  uint8_t const running[] = { 0x3E, 0x7F, 0x40, 0x00 };
+  stream_write_check(note_on, sizeof(note_on), (uint8_t const[][4]) { { 0x09, 0x90, 0x3C, 0x7F } }, 1);
+  stream_write_check(running, sizeof(running),
+                     (uint8_t const[][4]) { { 0x09, 0x90, 0x3E, 0x7F }, { 0x09, 0x90, 0x40, 0x00 } }, 2);
+
+  // message split across calls
+  uint8_t const part1[] = { 0x3C };
+  uint8_t const part2[] = { 0x00 };
+  stream_write_check(part1, sizeof(part1), NULL, 0);
+  stream_write_check(part2, sizeof(part2), (uint8_t const[][4]) { { 0x09, 0x90, 0x3C, 0x00 } }, 1);
+
+  // system common cancels running status: data byte is sent on its own
+  uint8_t const song_select[] = { 0xF3, 0x01, 0x3C };
+  stream_write_check(song_select, sizeof(song_select),
+                     (uint8_t const[][4]) { { 0x02, 0xF3, 0x01, 0x00 }, { 0x0F, 0x3C, 0x00, 0x00 } }, 2);
+}
+
+void test_stream_write_sysex_length(void) {
+  // 0 mod 3: last packet ends with 3 bytes
+  uint8_t const sysex6[] = { 0xF0, 0x01, 0x02, 0x03, 0x04, 0xF7 };
+  stream_write_check(sysex6, sizeof(sysex6),
+                     (uint8_t const[][4]) { { 0x04, 0xF0, 0x01, 0x02 }, { 0x07, 0x03, 0x04, 0xF7 } }, 2);
+
+  // 1 mod 3: last packet ends with 1 byte
+  uint8_t const sysex4[] = { 0xF0, 0x01, 0x02, 0xF7 };
+  stream_write_check(sysex4, sizeof(sysex4),
+                     (uint8_t const[][4]) { { 0x04, 0xF0, 0x01, 0x02 }, { 0x05, 0xF7, 0x00, 0x00 } }, 2);
+
+  // 2 mod 3: last packet ends with 2 bytes
+  uint8_t const sysex5[] = { 0xF0, 0x01, 0x02, 0x03, 0xF7 };
+  stream_write_check(sysex5, sizeof(sysex5),
+                     (uint8_t const[][4]) { { 0x04, 0xF0, 0x01, 0x02 }, { 0x06, 0x03, 0xF7, 0x00 } }, 2);
+
+  // shortest SysEx in a single packet
+  uint8_t const sysex3[] = { 0xF0, 0x01, 0xF7 };
+  stream_write_check(sysex3, sizeof(sysex3), (uint8_t const[][4]) { { 0x07, 0xF0, 0x01, 0xF7 } }, 1);
+}
+
+void test_stream_write_realtime_in_sysex(void) {
+  // real-time is sent right away in its own packet without breaking SysEx
+  uint8_t const bytes[] = { 0xF0, 0x01, 0xF8, 0x02, 0x03, 0xFE, 0xF7 };
+  stream_write_check(bytes, sizeof(bytes),
+                     (uint8_t const[][4]) {
+                       { 0x0F, 0xF8, 0x00, 0x00 },
+                       { 0x04, 0xF0, 0x01, 0x02 },
+                       { 0x0F, 0xFE, 0x00, 0x00 },
+                       { 0x06, 0x03, 0xF7, 0x00 }
+                     }, 4);
+}
+
+void test_stream_read_sysex_and_realtime(void) {
+  uint8_t const packets[][4] = {
+    { 0x04, 0xF0, 0x01, 0x02 },
+    { 0x0F, 0xF8, 0x00, 0x00 },
+    { 0x06, 0x03, 0xF7, 0x00 },
+    { 0x09, 0x90, 0x3C, 0x7F },
+  };
+  tu_fifo_write_n(&midi->rx_ff, packets, TU_ARRAY_SIZE(packets));
+
+  // only valid bytes of each packet are read, across calls
+  uint8_t bytes[16];
+  TEST_ASSERT_EQUAL(2, tud_midi_n_stream_read(0, 0, bytes, 2));
+  TEST_ASSERT_EQUAL(7, tud_midi_n_stream_read(0, 0, bytes + 2, sizeof(bytes) - 2));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(((uint8_t const[]) { 0xF0, 0x01, 0x02, 0xF8, 0x03, 0xF7, 0x90, 0x3C, 0x7F }), bytes, 9);
+}
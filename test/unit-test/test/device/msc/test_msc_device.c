@@ -249,7 +249,8 @@ void test_msc(void)
 
   dcd_event_setup_received(rhport, (uint8_t*) &request_set_configuration, false);
 
-  // open endpoints
+  // plan packet memory, then open endpoints
+  dcd_edpt_config_plan_Expect(rhport, (tusb_desc_configuration_t const *) desc_configuration);
   dcd_edpt_open_ExpectAndReturn(rhport, (tusb_desc_endpoint_t const *) desc_ep, true);
   dcd_edpt_open_ExpectAndReturn(rhport, (tusb_desc_endpoint_t const *) tu_desc_next(desc_ep), true);
 
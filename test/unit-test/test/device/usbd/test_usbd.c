@@ -246,3 +246,171 @@ void test_usbd_control_in_zlp(void)
 
   tud_task();
 }
+
+//--------------------------------------------------------------------+
+// Transfer Queue
+//--------------------------------------------------------------------+
+// Endpoints are not opened, they map to the first driver (MSC) whose xfer_cb() is expected once per transfer
+
+static uint8_t xfer_buf[3][64];
+
+void test_usbd_xfer_queue_append(void)
+{
+  uint8_t const ep_addr = 0x81;
+
+  // idle endpoint is primed, next one is linked behind it
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, xfer_buf[0], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_queue(rhport, ep_addr, xfer_buf[0], 64));
+
+  dcd_edpt_xfer_append_ExpectAndReturn(rhport, ep_addr, xfer_buf[1], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_queue(rhport, ep_addr, xfer_buf[1], 64));
+  TEST_ASSERT_EQUAL(2, usbd_edpt_xfer_queue_count(rhport, ep_addr));
+
+  // first one completes, appended one is still active: endpoint stays busy and is not re-primed
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  tud_task();
+  TEST_ASSERT_TRUE(usbd_edpt_busy(rhport, ep_addr));
+  TEST_ASSERT_EQUAL(1, usbd_edpt_xfer_queue_count(rhport, ep_addr));
+
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+  TEST_ASSERT_EQUAL(0, usbd_edpt_xfer_queue_count(rhport, ep_addr));
+}
+
+void test_usbd_xfer_queue_append_behind_xfer(void)
+{
+  uint8_t const ep_addr = 0x82;
+
+  // active transfer is submitted with usbd_edpt_xfer(), queued ones must be linked behind it
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, xfer_buf[0], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, xfer_buf[0], 64));
+
+  dcd_edpt_xfer_append_ExpectAndReturn(rhport, ep_addr, xfer_buf[1], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_queue(rhport, ep_addr, xfer_buf[1], 64));
+
+  dcd_edpt_xfer_append_ExpectAndReturn(rhport, ep_addr, xfer_buf[2], 64, false);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_queue(rhport, ep_addr, xfer_buf[2], 64));
+  TEST_ASSERT_EQUAL(3, usbd_edpt_xfer_queue_count(rhport, ep_addr));
+
+  // second transfer is still outstanding on DCD: third is appended again, not re-primed
+  dcd_edpt_xfer_append_ExpectAndReturn(rhport, ep_addr, xfer_buf[2], 64, true);
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+  TEST_ASSERT_TRUE(usbd_edpt_busy(rhport, ep_addr));
+  for (uint8_t i = 0; i < 3; i++) {
+    mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  }
+  tud_task();
+
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+  TEST_ASSERT_EQUAL(0, usbd_edpt_xfer_queue_count(rhport, ep_addr));
+}
+
+void test_usbd_xfer_queue_fallback(void)
+{
+  uint8_t const ep_addr = 0x83;
+
+  // DCD can't link transfers: they are kept in software queue
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, xfer_buf[0], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_queue(rhport, ep_addr, xfer_buf[0], 64));
+
+  dcd_edpt_xfer_append_ExpectAndReturn(rhport, ep_addr, xfer_buf[1], 64, false);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_queue(rhport, ep_addr, xfer_buf[1], 64));
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_queue(rhport, ep_addr, xfer_buf[2], 64));
+
+  // queue is full
+  TEST_ASSERT_FALSE(usbd_edpt_xfer_queue(rhport, ep_addr, xfer_buf[0], 64));
+  TEST_ASSERT_EQUAL(3, usbd_edpt_xfer_queue_count(rhport, ep_addr));
+
+  // DCD is idle after each completion: next one is primed in submission order from ISR
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, xfer_buf[1], 64, true);
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, xfer_buf[2], 64, true);
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  tud_task();
+  TEST_ASSERT_TRUE(usbd_edpt_busy(rhport, ep_addr));
+  TEST_ASSERT_EQUAL(1, usbd_edpt_xfer_queue_count(rhport, ep_addr));
+
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+  TEST_ASSERT_EQUAL(0, usbd_edpt_xfer_queue_count(rhport, ep_addr));
+}
+
+void test_usbd_xfer_queue_failed_restart_from_task(void)
+{
+  uint8_t const ep_addr = 0x84;
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, xfer_buf[0], 64, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_queue(rhport, ep_addr, xfer_buf[0], 64));
+
+  dcd_edpt_xfer_append_ExpectAndReturn(rhport, ep_addr, xfer_buf[1], 64, false);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer_queue(rhport, ep_addr, xfer_buf[1], 64));
+
+  // failed transfer does not start the next one from ISR, usbd task does once it is counted off
+  dcd_event_xfer_complete(rhport, ep_addr, 0, XFER_RESULT_FAILED, true);
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, xfer_buf[1], 64, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_FAILED, 0, true);
+  tud_task();
+  TEST_ASSERT_TRUE(usbd_edpt_busy(rhport, ep_addr));
+
+  dcd_event_xfer_complete(rhport, ep_addr, 64, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, 64, true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+}
+
+//--------------------------------------------------------------------+
+// Transfer larger than 64KB
+//--------------------------------------------------------------------+
+// Endpoints are not opened, they map to the first driver (MSC) whose xfer_cb() is expected once per transfer
+
+static uint8_t large_buf[0x18000];
+
+void test_usbd_xfer_large_supported(void)
+{
+  uint8_t const ep_addr = 0x85;
+
+  // DCD is only queried for transfers that do not fit 64KB - 1
+  dcd_edpt_xfer_max_ExpectAndReturn(rhport, ep_addr, 0x20000);
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, large_buf, sizeof(large_buf), true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, large_buf, sizeof(large_buf)));
+  TEST_ASSERT_TRUE(usbd_edpt_busy(rhport, ep_addr));
+
+  dcd_event_xfer_complete(rhport, ep_addr, sizeof(large_buf), XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, sizeof(large_buf), true);
+  tud_task();
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, large_buf, UINT16_MAX, true);
+  TEST_ASSERT_TRUE(usbd_edpt_xfer(rhport, ep_addr, large_buf, UINT16_MAX));
+
+  dcd_event_xfer_complete(rhport, ep_addr, UINT16_MAX, XFER_RESULT_SUCCESS, true);
+  mscd_xfer_cb_ExpectAndReturn(rhport, ep_addr, XFER_RESULT_SUCCESS, UINT16_MAX, true);
+  tud_task();
+}
+
+void test_usbd_xfer_large_not_supported(void)
+{
+  uint8_t const ep_addr = 0x85;
+
+  // DCD limit is 64KB - 1: transfer is rejected without reaching DCD, endpoint stays idle
+  dcd_edpt_xfer_max_ExpectAndReturn(rhport, ep_addr, 0);
+  TEST_ASSERT_FALSE(usbd_edpt_xfer(rhport, ep_addr, large_buf, UINT16_MAX + 1u));
+  TEST_ASSERT_FALSE(usbd_edpt_busy(rhport, ep_addr));
+
+  dcd_edpt_xfer_max_ExpectAndReturn(rhport, ep_addr, 0x10000);
+  TEST_ASSERT_FALSE(usbd_edpt_xfer_queue(rhport, ep_addr, large_buf, 0x10001));
+  TEST_ASSERT_EQUAL(0, usbd_edpt_xfer_queue_count(rhport, ep_addr));
+}
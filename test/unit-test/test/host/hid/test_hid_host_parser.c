@@ -0,0 +1,339 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019, hathach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// support tusb_config.h is for device stack, enable host for this test only
+#define CFG_TUSB_RHPORT0_MODE   (OPT_MODE_HOST | OPT_MODE_HIGH_SPEED)
+#define CFG_TUH_HID             1
+
+// File to test
+#include "hid_host.c"
+
+//--------------------------------------------------------------------+
+// usbh stub: parser does not transfer, only needed for linking driver
+//--------------------------------------------------------------------+
+bool usbh_edpt_xfer_with_callback(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes,
+                                  tuh_xfer_cb_t complete_cb, uintptr_t user_data) {
+  (void) dev_addr; (void) ep_addr; (void) buffer; (void) total_bytes; (void) complete_cb; (void) user_data;
+  return false;
+}
+
+bool usbh_edpt_claim(uint8_t dev_addr, uint8_t ep_addr) {
+  (void) dev_addr; (void) ep_addr;
+  return false;
+}
+
+bool usbh_edpt_release(uint8_t dev_addr, uint8_t ep_addr) {
+  (void) dev_addr; (void) ep_addr;
+  return false;
+}
+
+bool usbh_edpt_busy(uint8_t dev_addr, uint8_t ep_addr) {
+  (void) dev_addr; (void) ep_addr;
+  return false;
+}
+
+bool tuh_edpt_open(uint8_t daddr, tusb_desc_endpoint_t const* desc_ep) {
+  (void) daddr; (void) desc_ep;
+  return false;
+}
+
+bool tuh_edpt_abort_xfer(uint8_t daddr, uint8_t ep_addr) {
+  (void) daddr; (void) ep_addr;
+  return false;
+}
+
+bool tuh_control_xfer(tuh_xfer_t* xfer) {
+  (void) xfer;
+  return false;
+}
+
+bool tuh_descriptor_get_hid_report(uint8_t daddr, uint8_t itf_num, uint8_t desc_type, uint8_t index, void* buffer,
+                                   uint16_t len, tuh_xfer_cb_t complete_cb, uintptr_t user_data) {
+  (void) daddr; (void) itf_num; (void) desc_type; (void) index; (void) buffer; (void) len;
+  (void) complete_cb; (void) user_data;
+  return false;
+}
+
+uint8_t* usbh_get_enum_buf(void) {
+  return NULL;
+}
+
+void usbh_driver_set_config_complete(uint8_t dev_addr, uint8_t itf_num) {
+  (void) dev_addr; (void) itf_num;
+}
+
+void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t idx, uint8_t const* report, uint16_t len) {
+  (void) dev_addr; (void) idx; (void) report; (void) len;
+}
+
+//--------------------------------------------------------------------+
+// Test
+//--------------------------------------------------------------------+
+static tuh_hid_report_field_t fields[16];
+static int32_t values[16];
+
+void setUp(void) {
+  tu_memclr(fields, sizeof(fields));
+  tu_memclr(values, sizeof(values));
+}
+
+void tearDown(void) {
+}
+
+void test_multiple_report_id(void) {
+  uint8_t const desc[] = {
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE(HID_USAGE_DESKTOP_MOUSE),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+      // report 1: 8 buttons
+      HID_REPORT_ID(1)
+      HID_USAGE_PAGE(HID_USAGE_PAGE_BUTTON),
+      HID_USAGE_MIN(1),
+      HID_USAGE_MAX(8),
+      HID_LOGICAL_MIN(0),
+      HID_LOGICAL_MAX(1),
+      HID_REPORT_SIZE(1),
+      HID_REPORT_COUNT(8),
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+
+      // report 2: X, Y starting again at offset 0
+      HID_REPORT_ID(2)
+      HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+      HID_USAGE_MIN(HID_USAGE_DESKTOP_X),
+      HID_USAGE_MAX(HID_USAGE_DESKTOP_Y),
+      HID_LOGICAL_MIN(0),
+      HID_LOGICAL_MAX_N(255, 2),
+      HID_REPORT_SIZE(8),
+      HID_REPORT_COUNT(2),
+      HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+    HID_COLLECTION_END
+  };
+
+  uint16_t const count = tuh_hid_parse_report_fields(fields, 16, desc, sizeof(desc));
+  TEST_ASSERT_EQUAL(2, count);
+
+  TEST_ASSERT_EQUAL(1, fields[0].report_id);
+  TEST_ASSERT_EQUAL(0, fields[0].bit_offset);
+  TEST_ASSERT_EQUAL(HID_USAGE_PAGE_BUTTON, fields[0].usage_page);
+
+  TEST_ASSERT_EQUAL(2, fields[1].report_id);
+  TEST_ASSERT_EQUAL(0, fields[1].bit_offset);
+  TEST_ASSERT_EQUAL(255, fields[1].logical_max);
+
+  // only fields of received report ID are extracted
+  uint8_t const report2[] = { 2, 0x10, 0xF0 };
+  TEST_ASSERT_EQUAL(2, tuh_hid_extract_report_fields(fields, count, HID_REPORT_TYPE_INPUT, report2, sizeof(report2), values, 16));
+  TEST_ASSERT_EQUAL(0x10, values[0]);
+  TEST_ASSERT_EQUAL(0xF0, values[1]);
+
+  uint8_t const report1[] = { 1, 0x05 };
+  TEST_ASSERT_EQUAL(8, tuh_hid_extract_report_fields(fields, count, HID_REPORT_TYPE_INPUT, report1, sizeof(report1), values, 16));
+  TEST_ASSERT_EQUAL(1, values[0]);
+  TEST_ASSERT_EQUAL(0, values[1]);
+  TEST_ASSERT_EQUAL(1, values[2]);
+  TEST_ASSERT_EQUAL(0, values[7]);
+}
+
+void test_field_cross_byte_boundary(void) {
+  uint8_t const desc[] = {
+    HID_USAGE_PAGE(HID_USAGE_PAGE_BUTTON),
+    HID_USAGE_MIN(1),
+    HID_USAGE_MAX(3),
+    HID_LOGICAL_MIN(0),
+    HID_LOGICAL_MAX(1),
+    HID_REPORT_SIZE(1),
+    HID_REPORT_COUNT(3),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+
+    // 12-bit X, Y right after 3 bits: both straddle bytes
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE_MIN(HID_USAGE_DESKTOP_X),
+    HID_USAGE_MAX(HID_USAGE_DESKTOP_Y),
+    HID_LOGICAL_MIN(0),
+    HID_LOGICAL_MAX_N(4095, 2),
+    HID_REPORT_SIZE(12),
+    HID_REPORT_COUNT(2),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+
+    // padding
+    HID_REPORT_SIZE(5),
+    HID_REPORT_COUNT(1),
+    HID_INPUT(HID_CONSTANT),
+  };
+
+  uint16_t const count = tuh_hid_parse_report_fields(fields, 16, desc, sizeof(desc));
+  TEST_ASSERT_EQUAL(3, count);
+  TEST_ASSERT_EQUAL(3, fields[1].bit_offset);
+  TEST_ASSERT_EQUAL(27, fields[2].bit_offset);
+
+  // buttons = 0b101, X = 0xABC, Y = 0x123
+  uint32_t const bits = 0x5u | (0xABCu << 3) | (0x123u << 15);
+  uint8_t const report[4] = { (uint8_t) bits, (uint8_t) (bits >> 8), (uint8_t) (bits >> 16), (uint8_t) (bits >> 24) };
+
+  // constant padding is not extracted
+  TEST_ASSERT_EQUAL(5, tuh_hid_extract_report_fields(fields, count, HID_REPORT_TYPE_INPUT, report, sizeof(report), values, 16));
+  TEST_ASSERT_EQUAL(1, values[0]);
+  TEST_ASSERT_EQUAL(0, values[1]);
+  TEST_ASSERT_EQUAL(1, values[2]);
+  TEST_ASSERT_EQUAL_HEX32(0xABC, values[3]);
+  TEST_ASSERT_EQUAL_HEX32(0x123, values[4]);
+
+  // short report: only elements within it
+  TEST_ASSERT_EQUAL(4, tuh_hid_extract_report_fields(fields, count, HID_REPORT_TYPE_INPUT, report, 2, values, 16));
+}
+
+void test_signed_logical_range(void) {
+  uint8_t const desc[] = {
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE(HID_USAGE_DESKTOP_X),
+    HID_LOGICAL_MIN(0x81), // -127
+    HID_LOGICAL_MAX(0x7F),
+    HID_REPORT_SIZE(8),
+    HID_REPORT_COUNT(1),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_RELATIVE),
+
+    HID_USAGE(HID_USAGE_DESKTOP_Y),
+    HID_LOGICAL_MIN_N(0xF800, 2), // -2048
+    HID_LOGICAL_MAX_N(0x07FF, 2),
+    HID_REPORT_SIZE(12),
+    HID_REPORT_COUNT(1),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_RELATIVE),
+
+    // unsigned: 0xFF is 255 when minimum is not negative
+    HID_USAGE(HID_USAGE_DESKTOP_WHEEL),
+    HID_LOGICAL_MIN(0),
+    HID_LOGICAL_MAX(0xFF),
+    HID_REPORT_SIZE(4),
+    HID_REPORT_COUNT(1),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+  };
+
+  uint16_t const count = tuh_hid_parse_report_fields(fields, 16, desc, sizeof(desc));
+  TEST_ASSERT_EQUAL(3, count);
+  TEST_ASSERT_EQUAL(-127, fields[0].logical_min);
+  TEST_ASSERT_EQUAL(127, fields[0].logical_max);
+  TEST_ASSERT_EQUAL(-2048, fields[1].logical_min);
+  TEST_ASSERT_EQUAL(2047, fields[1].logical_max);
+  TEST_ASSERT_EQUAL(0, fields[2].logical_min);
+  TEST_ASSERT_EQUAL(255, fields[2].logical_max);
+
+  // X = -2, Y = -2048 (0x800), wheel = 0xF stays positive
+  uint8_t const report[] = { 0xFE, 0x00, 0xF8 };
+  TEST_ASSERT_EQUAL(3, tuh_hid_extract_report_fields(fields, count, HID_REPORT_TYPE_INPUT, report, sizeof(report), values, 16));
+  TEST_ASSERT_EQUAL(-2, values[0]);
+  TEST_ASSERT_EQUAL(-2048, values[1]);
+  TEST_ASSERT_EQUAL(15, values[2]);
+}
+
+void test_usage_range_and_list(void) {
+  uint8_t const desc[] = {
+    // Array with usage range: keyboard keycodes
+    HID_USAGE_PAGE(HID_USAGE_PAGE_KEYBOARD),
+    HID_USAGE_MIN(0),
+    HID_USAGE_MAX_N(0xFF, 2),
+    HID_LOGICAL_MIN(0),
+    HID_LOGICAL_MAX_N(0xFF, 2),
+    HID_REPORT_SIZE(8),
+    HID_REPORT_COUNT(6),
+    HID_INPUT(HID_DATA | HID_ARRAY | HID_ABSOLUTE),
+
+    // Variable with usage list: split into one field per usage, last one takes the rest
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE(HID_USAGE_DESKTOP_X),
+    HID_USAGE(HID_USAGE_DESKTOP_Y),
+    HID_USAGE(HID_USAGE_DESKTOP_WHEEL),
+    HID_LOGICAL_MIN(0x81),
+    HID_LOGICAL_MAX(0x7F),
+    HID_REPORT_SIZE(8),
+    HID_REPORT_COUNT(4),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_RELATIVE),
+
+    // 4-byte usage with its own page
+    HID_USAGE_N(0x000C00E9, 3), // Consumer: Volume Increment
+    HID_LOGICAL_MIN(0),
+    HID_LOGICAL_MAX(1),
+    HID_REPORT_SIZE(1),
+    HID_REPORT_COUNT(1),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+  };
+
+  uint16_t const count = tuh_hid_parse_report_fields(fields, 16, desc, sizeof(desc));
+  TEST_ASSERT_EQUAL(5, count);
+
+  TEST_ASSERT_EQUAL(HID_USAGE_PAGE_KEYBOARD, fields[0].usage_page);
+  TEST_ASSERT_EQUAL(0, fields[0].usage_min);
+  TEST_ASSERT_EQUAL(0xFF, fields[0].usage_max);
+  TEST_ASSERT_EQUAL(6, fields[0].count);
+
+  TEST_ASSERT_EQUAL(HID_USAGE_DESKTOP_X, fields[1].usage_min);
+  TEST_ASSERT_EQUAL(1, fields[1].count);
+  TEST_ASSERT_EQUAL(48, fields[1].bit_offset);
+  TEST_ASSERT_EQUAL(HID_USAGE_DESKTOP_Y, fields[2].usage_min);
+  TEST_ASSERT_EQUAL(56, fields[2].bit_offset);
+  TEST_ASSERT_EQUAL(HID_USAGE_DESKTOP_WHEEL, fields[3].usage_min);
+  TEST_ASSERT_EQUAL(2, fields[3].count);
+  TEST_ASSERT_EQUAL(64, fields[3].bit_offset);
+
+  TEST_ASSERT_EQUAL(HID_USAGE_PAGE_CONSUMER, fields[4].usage_page);
+  TEST_ASSERT_EQUAL(0xE9, fields[4].usage_min);
+  TEST_ASSERT_EQUAL(80, fields[4].bit_offset);
+}
+
+void test_truncated_descriptor(void) {
+  uint8_t const desc[] = {
+    HID_USAGE_PAGE(HID_USAGE_PAGE_BUTTON),
+    HID_USAGE_MIN(1),
+    HID_USAGE_MAX(8),
+    HID_LOGICAL_MIN(0),
+    HID_LOGICAL_MAX(1),
+    HID_REPORT_SIZE(1),
+    HID_REPORT_COUNT(8),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE(HID_USAGE_DESKTOP_X),
+    HID_LOGICAL_MIN_N(0xF800, 2),
+    HID_LOGICAL_MAX_N(0x07FF, 2),
+    HID_REPORT_SIZE(16),
+    HID_REPORT_COUNT(1),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+  };
+
+  // complete descriptor
+  TEST_ASSERT_EQUAL(2, tuh_hid_parse_report_fields(fields, 16, desc, sizeof(desc)));
+
+  // cut in the middle of 2-byte Logical Maximum: only fields before it are returned
+  uint16_t const cut_len = 16 + 2 + 2 + 3 + 2;
+  TEST_ASSERT_EQUAL(1, tuh_hid_parse_report_fields(fields, 16, desc, cut_len));
+
+  // cut right before last Main item data
+  TEST_ASSERT_EQUAL(1, tuh_hid_parse_report_fields(fields, 16, desc, sizeof(desc) - 1));
+
+  // table is full: extra fields are dropped
+  TEST_ASSERT_EQUAL(1, tuh_hid_parse_report_fields(fields, 1, desc, sizeof(desc)));
+}
@@ -0,0 +1,400 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019, hathach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// support tusb_config.h is for device stack, enable host for this test only
+#define CFG_TUSB_RHPORT0_MODE   (OPT_MODE_HOST | OPT_MODE_HIGH_SPEED)
+#define CFG_TUH_MSC             1
+#define CFG_TUH_MSC_QUEUE_SIZE  4
+
+// File to test, included to access its static queue
+#include "msc_host.c"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+enum {
+  DADDR        = 1,
+  EDPT_MSC_OUT = 0x01,
+  EDPT_MSC_IN  = 0x81,
+  EDPT_SIZE    = 512,
+  BLOCK_SIZE   = 512,
+};
+
+static uint8_t buf[3][2*BLOCK_SIZE];
+
+// usbh stub: last transfer and result of next one
+static bool xfer_result;
+static uint8_t xfer_ep;
+static uint8_t* xfer_buffer;
+static uint16_t xfer_len;
+
+// usbh stub: transfers queued behind the active one and aborted
+static bool queue_supported;
+static uint8_t queue_count;
+static uint8_t* queue_buffer;
+static uint8_t abort_count;
+
+// complete callback log
+static uint8_t cb_count;
+static uint8_t cb_status[8];
+static void* cb_data_buf[8];
+
+//--------------------------------------------------------------------+
+// usbh stub
+//--------------------------------------------------------------------+
+bool usbh_edpt_xfer_with_callback(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes,
+                                  tuh_xfer_cb_t complete_cb, uintptr_t user_data) {
+  (void) dev_addr; (void) complete_cb; (void) user_data;
+  xfer_ep = ep_addr;
+  xfer_buffer = buffer;
+  xfer_len = total_bytes;
+  return xfer_result;
+}
+
+bool usbh_edpt_xfer_queue(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+  (void) dev_addr; (void) total_bytes;
+  TEST_ASSERT_EQUAL(EDPT_MSC_OUT, ep_addr);
+  if (!queue_supported) return false;
+  queue_count++;
+  queue_buffer = buffer;
+  return true;
+}
+
+bool tuh_edpt_abort_xfer(uint8_t daddr, uint8_t ep_addr) {
+  (void) daddr; (void) ep_addr;
+  abort_count++;
+  return true;
+}
+
+bool usbh_edpt_claim(uint8_t dev_addr, uint8_t ep_addr) {
+  (void) dev_addr; (void) ep_addr;
+  return true;
+}
+
+bool usbh_edpt_release(uint8_t dev_addr, uint8_t ep_addr) {
+  (void) dev_addr; (void) ep_addr;
+  return true;
+}
+
+bool usbh_edpt_busy(uint8_t dev_addr, uint8_t ep_addr) {
+  (void) dev_addr; (void) ep_addr;
+  return false;
+}
+
+bool tuh_edpt_open(uint8_t daddr, tusb_desc_endpoint_t const* desc_ep) {
+  (void) daddr; (void) desc_ep;
+  return true;
+}
+
+bool tuh_control_xfer(tuh_xfer_t* xfer) {
+  (void) xfer;
+  return true;
+}
+
+uint8_t* usbh_get_enum_buf(void) {
+  return NULL;
+}
+
+void usbh_driver_set_config_complete(uint8_t dev_addr, uint8_t itf_num) {
+  (void) dev_addr; (void) itf_num;
+}
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+static bool complete_cb(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data) {
+  (void) dev_addr;
+  cb_status[cb_count] = cb_data->csw->status;
+  cb_data_buf[cb_count] = cb_data->scsi_data;
+  cb_count++;
+  return true;
+}
+
+static bool read10(uint8_t lun, void* buffer, uint32_t lba, uint16_t block_count) {
+  return tuh_msc_read10(DADDR, lun, buffer, lba, block_count, complete_cb, 0);
+}
+
+static bool write10(void* buffer, uint32_t lba, uint16_t block_count) {
+  return tuh_msc_write10(DADDR, 0, buffer, lba, block_count, complete_cb, 0);
+}
+
+// first command is a single request, the following adjacent WRITE10 are merged into next command
+static void write10_merged_start(void) {
+  TEST_ASSERT_TRUE(write10(buf[0], 0, 1));
+  TEST_ASSERT_TRUE(write10(buf[1], 1, 1));
+  TEST_ASSERT_TRUE(write10(buf[2], 2, 1));
+
+  msch_xfer_cb(DADDR, EDPT_MSC_OUT, XFER_RESULT_SUCCESS, sizeof(msc_cbw_t));
+  TEST_ASSERT_EQUAL_PTR(buf[0], xfer_buffer);
+  msch_xfer_cb(DADDR, EDPT_MSC_OUT, XFER_RESULT_SUCCESS, BLOCK_SIZE);
+  get_epbuf(DADDR)->csw.status = MSC_CSW_STATUS_PASSED;
+  msch_xfer_cb(DADDR, EDPT_MSC_IN, XFER_RESULT_SUCCESS, sizeof(msc_csw_t));
+
+  TEST_ASSERT_EQUAL(2, get_itf(DADDR)->active_count);
+  msch_xfer_cb(DADDR, EDPT_MSC_OUT, XFER_RESULT_SUCCESS, sizeof(msc_cbw_t));
+  TEST_ASSERT_EQUAL_PTR(buf[1], xfer_buffer);
+}
+
+static uint16_t cbw_block_count(void) {
+  scsi_read10_t const* cmd = (scsi_read10_t const*) (uintptr_t) get_epbuf(DADDR)->cbw.command;
+  return tu_ntohs(cmd->block_count);
+}
+
+// carry out command, data and status stage of current command with passed status
+static void command_run(void) {
+  msch_interface_t* p_msc = get_itf(DADDR);
+  TEST_ASSERT_EQUAL(EDPT_MSC_OUT, xfer_ep);
+  TEST_ASSERT_EQUAL(sizeof(msc_cbw_t), xfer_len);
+  msch_xfer_cb(DADDR, EDPT_MSC_OUT, XFER_RESULT_SUCCESS, sizeof(msc_cbw_t));
+
+  for (uint8_t i = 0; i < p_msc->active_count; i++) {
+    TEST_ASSERT_EQUAL(EDPT_MSC_IN, xfer_ep);
+    TEST_ASSERT_EQUAL_PTR(queue_at(p_msc, i)->buffer, xfer_buffer);
+    msch_xfer_cb(DADDR, EDPT_MSC_IN, XFER_RESULT_SUCCESS, xfer_len);
+  }
+
+  TEST_ASSERT_EQUAL_PTR(&get_epbuf(DADDR)->csw, xfer_buffer);
+  get_epbuf(DADDR)->csw.status = MSC_CSW_STATUS_PASSED;
+  msch_xfer_cb(DADDR, EDPT_MSC_IN, XFER_RESULT_SUCCESS, sizeof(msc_csw_t));
+}
+
+//--------------------------------------------------------------------+
+// Test
+//--------------------------------------------------------------------+
+void setUp(void) {
+  msch_init();
+
+  msch_interface_t* p_msc = get_itf(DADDR);
+  p_msc->ep_out = EDPT_MSC_OUT;
+  p_msc->ep_in = EDPT_MSC_IN;
+  p_msc->ep_size = EDPT_SIZE;
+  p_msc->max_lun = 2;
+  p_msc->configured = true;
+  p_msc->mounted = true;
+  for (uint8_t lun = 0; lun < 2; lun++) {
+    p_msc->capacity[lun].block_size = BLOCK_SIZE;
+    p_msc->capacity[lun].block_count = 0x20000;
+  }
+
+  xfer_result = true;
+  xfer_ep = 0;
+  xfer_buffer = NULL;
+  xfer_len = 0;
+  queue_supported = true;
+  queue_count = 0;
+  queue_buffer = NULL;
+  abort_count = 0;
+  cb_count = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_merge_adjacent_read10(void) {
+  msch_interface_t* p_msc = get_itf(DADDR);
+
+  TEST_ASSERT_TRUE(read10(0, buf[0], 0, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[1], 1, 2));
+  TEST_ASSERT_TRUE(read10(0, buf[2], 3, 1));
+  TEST_ASSERT_EQUAL(1, p_msc->active_count);
+
+  command_run();
+  TEST_ASSERT_EQUAL(1, cb_count);
+
+  // queued requests are merged into one command
+  TEST_ASSERT_EQUAL(2, p_msc->active_count);
+  TEST_ASSERT_EQUAL(3, cbw_block_count());
+  TEST_ASSERT_EQUAL(3*BLOCK_SIZE, get_epbuf(DADDR)->cbw.total_bytes);
+
+  command_run();
+  TEST_ASSERT_EQUAL(3, cb_count);
+  TEST_ASSERT_EQUAL_PTR(buf[1], cb_data_buf[1]);
+  TEST_ASSERT_EQUAL_PTR(buf[2], cb_data_buf[2]);
+  TEST_ASSERT_EQUAL(0, p_msc->q_count);
+  TEST_ASSERT_EQUAL(MSC_STAGE_IDLE, p_msc->stage);
+}
+
+void test_no_merge_lun_mismatch(void) {
+  msch_interface_t* p_msc = get_itf(DADDR);
+
+  TEST_ASSERT_TRUE(read10(0, buf[0], 0, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[1], 1, 1));
+  TEST_ASSERT_TRUE(read10(1, buf[2], 2, 1));
+
+  command_run();
+  TEST_ASSERT_EQUAL(1, p_msc->active_count);
+  TEST_ASSERT_EQUAL(1, cbw_block_count());
+  TEST_ASSERT_EQUAL(0, get_epbuf(DADDR)->cbw.lun);
+
+  command_run();
+  TEST_ASSERT_EQUAL(1, p_msc->active_count);
+  TEST_ASSERT_EQUAL(1, get_epbuf(DADDR)->cbw.lun);
+}
+
+void test_no_merge_opcode_mismatch(void) {
+  msch_interface_t* p_msc = get_itf(DADDR);
+
+  TEST_ASSERT_TRUE(read10(0, buf[0], 0, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[1], 1, 1));
+  TEST_ASSERT_TRUE(tuh_msc_write10(DADDR, 0, buf[2], 2, 1, complete_cb, 0));
+
+  command_run();
+  TEST_ASSERT_EQUAL(1, p_msc->active_count);
+  TEST_ASSERT_EQUAL(SCSI_CMD_READ_10, get_epbuf(DADDR)->cbw.command[0]);
+}
+
+void test_no_merge_above_uint16_max_blocks(void) {
+  msch_interface_t* p_msc = get_itf(DADDR);
+
+  TEST_ASSERT_TRUE(read10(0, buf[0], 0, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[1], 1, 0xFFF0));
+  TEST_ASSERT_TRUE(read10(0, buf[2], 1 + 0xFFF0, 0x10));
+
+  command_run();
+  TEST_ASSERT_EQUAL(1, p_msc->active_count);
+  TEST_ASSERT_EQUAL(0xFFF0, cbw_block_count());
+}
+
+void test_merge_up_to_uint16_max_blocks(void) {
+  msch_interface_t* p_msc = get_itf(DADDR);
+
+  TEST_ASSERT_TRUE(read10(0, buf[0], 0, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[1], 1, 0xFFF0));
+  TEST_ASSERT_TRUE(read10(0, buf[2], 1 + 0xFFF0, 0x0F));
+
+  command_run();
+  TEST_ASSERT_EQUAL(2, p_msc->active_count);
+  TEST_ASSERT_EQUAL(UINT16_MAX, cbw_block_count());
+}
+
+void test_no_merge_buffer_not_multiple_of_packet_size(void) {
+  msch_interface_t* p_msc = get_itf(DADDR);
+  p_msc->capacity[0].block_size = 100;
+
+  TEST_ASSERT_TRUE(read10(0, buf[0], 0, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[1], 1, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[2], 2, 1));
+
+  command_run();
+  TEST_ASSERT_EQUAL(1, p_msc->active_count);
+  TEST_ASSERT_EQUAL(100, get_epbuf(DADDR)->cbw.total_bytes);
+}
+
+void test_restart_failure_fails_queued_requests(void) {
+  msch_interface_t* p_msc = get_itf(DADDR);
+
+  TEST_ASSERT_TRUE(read10(0, buf[0], 0, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[1], 10, 1));
+  TEST_ASSERT_TRUE(read10(1, buf[2], 20, 1));
+
+  // CBW of next command can not be sent
+  TEST_ASSERT_EQUAL(sizeof(msc_cbw_t), xfer_len);
+  msch_xfer_cb(DADDR, EDPT_MSC_OUT, XFER_RESULT_SUCCESS, sizeof(msc_cbw_t));
+  msch_xfer_cb(DADDR, EDPT_MSC_IN, XFER_RESULT_SUCCESS, BLOCK_SIZE);
+  get_epbuf(DADDR)->csw.status = MSC_CSW_STATUS_PASSED;
+  xfer_result = false;
+  msch_xfer_cb(DADDR, EDPT_MSC_IN, XFER_RESULT_SUCCESS, sizeof(msc_csw_t));
+
+  // every request gets its callback
+  TEST_ASSERT_EQUAL(3, cb_count);
+  TEST_ASSERT_EQUAL(MSC_CSW_STATUS_PASSED, cb_status[0]);
+  TEST_ASSERT_EQUAL(MSC_CSW_STATUS_FAILED, cb_status[1]);
+  TEST_ASSERT_EQUAL(MSC_CSW_STATUS_FAILED, cb_status[2]);
+  TEST_ASSERT_EQUAL_PTR(buf[2], cb_data_buf[2]);
+  TEST_ASSERT_EQUAL(0, p_msc->q_count);
+  TEST_ASSERT_EQUAL(MSC_STAGE_IDLE, p_msc->stage);
+}
+
+void test_close_fails_pending_requests(void) {
+  msch_interface_t* p_msc = get_itf(DADDR);
+
+  TEST_ASSERT_TRUE(read10(0, buf[0], 0, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[1], 10, 1));
+  TEST_ASSERT_TRUE(read10(1, buf[2], 20, 1));
+
+  msch_close(DADDR);
+
+  // every request gets its callback, no new one is accepted
+  TEST_ASSERT_EQUAL(3, cb_count);
+  TEST_ASSERT_EQUAL(MSC_CSW_STATUS_FAILED, cb_status[0]);
+  TEST_ASSERT_EQUAL(MSC_CSW_STATUS_FAILED, cb_status[1]);
+  TEST_ASSERT_EQUAL(MSC_CSW_STATUS_FAILED, cb_status[2]);
+  TEST_ASSERT_EQUAL_PTR(buf[2], cb_data_buf[2]);
+  TEST_ASSERT_EQUAL(0, p_msc->q_count);
+  TEST_ASSERT_FALSE(read10(0, buf[0], 0, 1));
+}
+
+void test_write10_merged_data_queued(void) {
+  write10_merged_start();
+
+  // second buffer is linked behind the first one right away
+  TEST_ASSERT_EQUAL(1, queue_count);
+  TEST_ASSERT_EQUAL_PTR(buf[2], queue_buffer);
+
+  // nothing to submit when first buffer completes
+  xfer_buffer = NULL;
+  msch_xfer_cb(DADDR, EDPT_MSC_OUT, XFER_RESULT_SUCCESS, BLOCK_SIZE);
+  TEST_ASSERT_NULL(xfer_buffer);
+
+  msch_xfer_cb(DADDR, EDPT_MSC_OUT, XFER_RESULT_SUCCESS, BLOCK_SIZE);
+  TEST_ASSERT_EQUAL_PTR(&get_epbuf(DADDR)->csw, xfer_buffer);
+  TEST_ASSERT_EQUAL(0, abort_count);
+}
+
+void test_write10_merged_data_queue_not_supported(void) {
+  queue_supported = false;
+  write10_merged_start();
+  TEST_ASSERT_EQUAL(0, queue_count);
+
+  // second buffer is submitted once the first completes
+  msch_xfer_cb(DADDR, EDPT_MSC_OUT, XFER_RESULT_SUCCESS, BLOCK_SIZE);
+  TEST_ASSERT_EQUAL_PTR(buf[2], xfer_buffer);
+
+  msch_xfer_cb(DADDR, EDPT_MSC_OUT, XFER_RESULT_SUCCESS, BLOCK_SIZE);
+  TEST_ASSERT_EQUAL_PTR(&get_epbuf(DADDR)->csw, xfer_buffer);
+}
+
+void test_write10_merged_data_ended_early(void) {
+  write10_merged_start();
+
+  // queued buffer is aborted, status stage follows
+  msch_xfer_cb(DADDR, EDPT_MSC_OUT, XFER_RESULT_STALLED, 0);
+  TEST_ASSERT_EQUAL(1, abort_count);
+  TEST_ASSERT_EQUAL_PTR(&get_epbuf(DADDR)->csw, xfer_buffer);
+}
+
+void test_read10_merged_data_not_queued(void) {
+  TEST_ASSERT_TRUE(read10(0, buf[0], 0, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[1], 1, 1));
+  TEST_ASSERT_TRUE(read10(0, buf[2], 2, 1));
+
+  command_run();
+  command_run();
+  TEST_ASSERT_EQUAL(0, queue_count);
+  TEST_ASSERT_EQUAL(3, cb_count);
+}
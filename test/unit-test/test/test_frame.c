@@ -0,0 +1,264 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include <string.h>
+#include "unity.h"
+
+// support tusb_config.h is for device stack, use host since it needs fewer stubs
+#define CFG_TUSB_RHPORT0_MODE   (OPT_MODE_HOST | OPT_MODE_HIGH_SPEED)
+
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+
+// File to test, only its common functions are used
+#include "tusb.c"
+
+#define FIFO_SIZE   32
+static uint8_t ff_buf[FIFO_SIZE];
+static tu_fifo_t ff;
+static tu_frame_t fr;
+
+static uint8_t rd_buf[FIFO_SIZE];
+
+//--------------------------------------------------------------------+
+// usbh stub: not used by these tests
+//--------------------------------------------------------------------+
+uint32_t tusb_time_millis_api(void) {
+  return 0;
+}
+
+bool tuh_inited(void) {
+  return false;
+}
+
+bool tuh_rhport_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
+  (void) rhport; (void) rh_init;
+  return false;
+}
+
+void hcd_int_handler(uint8_t rhport, bool in_isr) {
+  (void) rhport; (void) in_isr;
+}
+
+bool usbh_edpt_claim(uint8_t dev_addr, uint8_t ep_addr) {
+  (void) dev_addr; (void) ep_addr;
+  return false;
+}
+
+bool usbh_edpt_release(uint8_t dev_addr, uint8_t ep_addr) {
+  (void) dev_addr; (void) ep_addr;
+  return false;
+}
+
+bool usbh_edpt_busy(uint8_t dev_addr, uint8_t ep_addr) {
+  (void) dev_addr; (void) ep_addr;
+  return false;
+}
+
+bool usbh_edpt_xfer_with_callback(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes,
+                                  tuh_xfer_cb_t complete_cb, uintptr_t user_data) {
+  (void) dev_addr; (void) ep_addr; (void) buffer; (void) total_bytes; (void) complete_cb; (void) user_data;
+  return false;
+}
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+static void ff_write(void const* data, uint16_t len) {
+  TEST_ASSERT_EQUAL(len, tu_fifo_write_n(&ff, data, len));
+}
+
+// move fifo content to start at offset so that following writes wrap around
+static void ff_offset(uint16_t offset) {
+  uint8_t dummy[FIFO_SIZE] = { 0 };
+  ff_write(dummy, offset);
+  tu_fifo_advance_read_pointer(&ff, offset);
+}
+
+typedef struct {
+  uint8_t mode;
+  uint8_t raw_len;
+  uint8_t raw[12];
+  uint8_t payload_len;
+  uint8_t payload[8];
+} frame_vector_t;
+
+// payload 0x11 0x00 0xC0 0xDB 0x22 0x0A in each frame mode
+static frame_vector_t const vectors[] = {
+  { TUSB_FRAME_DELIMITER, 5, { 0x11, 0x00, 0xC0, 0x22, '\n' }, 4, { 0x11, 0x00, 0xC0, 0x22 } },
+  { TUSB_FRAME_COBS, 8, { 0x02, 0x11, 0x05, 0xC0, 0xDB, 0x22, 0x0A, 0x00 }, 6, { 0x11, 0x00, 0xC0, 0xDB, 0x22, 0x0A } },
+  { TUSB_FRAME_SLIP, 9, { 0x11, 0x00, 0xDB, 0xDC, 0xDB, 0xDD, 0x22, 0x0A, 0xC0 }, 6, { 0x11, 0x00, 0xC0, 0xDB, 0x22, 0x0A } },
+  { TUSB_FRAME_LENGTH16, 8, { 0x06, 0x00, 0x11, 0x00, 0xC0, 0xDB, 0x22, 0x0A }, 6, { 0x11, 0x00, 0xC0, 0xDB, 0x22, 0x0A } },
+};
+
+// write frame at fifo offset, check it is found, peeked and decoded
+static void frame_check(frame_vector_t const* v, uint16_t offset) {
+  tu_fifo_clear(&ff);
+  tu_frame_config(&fr, v->mode, '\n');
+  ff_offset(offset);
+
+  // all but last byte: frame is incomplete
+  ff_write(v->raw, (uint16_t) (v->raw_len - 1));
+  TEST_ASSERT_FALSE(tu_frame_received(&fr, &ff, 8));
+  TEST_ASSERT_EQUAL(0, tu_frame_find(&fr, &ff));
+
+  ff_write(v->raw + v->raw_len - 1, 1);
+  TEST_ASSERT_TRUE(tu_frame_received(&fr, &ff, 8));
+  TEST_ASSERT_EQUAL(v->raw_len, tu_frame_find(&fr, &ff));
+
+  // raw payload without terminator or length prefix
+  tu_fifo_buffer_info_t info;
+  TEST_ASSERT_TRUE(tu_frame_peek(&fr, &ff, &info));
+  uint16_t const raw_payload = (uint16_t) (v->mode == TUSB_FRAME_LENGTH16 ? v->raw_len - 2 : v->raw_len - 1);
+  TEST_ASSERT_EQUAL(raw_payload, info.len_lin + info.len_wrap);
+
+  memset(rd_buf, 0xEE, sizeof(rd_buf));
+  TEST_ASSERT_EQUAL(v->payload_len, tu_frame_read(&fr, &ff, rd_buf, sizeof(rd_buf)));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(v->payload, rd_buf, v->payload_len);
+  TEST_ASSERT_EQUAL(0, tu_fifo_count(&ff));
+}
+
+//--------------------------------------------------------------------+
+// Test
+//--------------------------------------------------------------------+
+void setUp(void) {
+  tu_fifo_config(&ff, ff_buf, FIFO_SIZE, 1, false);
+  tu_fifo_clear(&ff);
+  tu_frame_config(&fr, TUSB_FRAME_DELIMITER, '\n');
+}
+
+void tearDown(void) {
+}
+
+void test_mem_find_byte(void) {
+  uint8_t buf[40];
+  memset(buf, 0x55, sizeof(buf));
+
+  // every alignment, position and length
+  for (uint32_t start = 0; start < 4; start++) {
+    for (uint32_t len = 0; len < 32; len++) {
+      TEST_ASSERT_EQUAL(len, tu_mem_find_byte(buf + start, len, 0xAA));
+      for (uint32_t pos = 0; pos < len; pos++) {
+        buf[start + pos] = 0xAA;
+        TEST_ASSERT_EQUAL(pos, tu_mem_find_byte(buf + start, len, 0xAA));
+        buf[start + pos] = 0x55;
+      }
+    }
+  }
+
+  // first occurrence, including byte values with high bit set and zero
+  uint8_t const data[] = { 1, 0x80, 0, 0xFF, 0x80, 0, 0xFF };
+  TEST_ASSERT_EQUAL(1, tu_mem_find_byte(data, sizeof(data), 0x80));
+  TEST_ASSERT_EQUAL(2, tu_mem_find_byte(data, sizeof(data), 0));
+  TEST_ASSERT_EQUAL(3, tu_mem_find_byte(data, sizeof(data), 0xFF));
+}
+
+void test_frame_modes(void) {
+  for (uint8_t i = 0; i < TU_ARRAY_SIZE(vectors); i++) {
+    frame_check(&vectors[i], 0);
+  }
+}
+
+void test_frame_across_wrap(void) {
+  // frame starts at every offset near the end of fifo, including terminator and length prefix across wrap
+  for (uint8_t i = 0; i < TU_ARRAY_SIZE(vectors); i++) {
+    for (uint16_t offset = FIFO_SIZE - vectors[i].raw_len; offset < FIFO_SIZE; offset++) {
+      frame_check(&vectors[i], offset);
+    }
+  }
+}
+
+void test_frame_back_to_back(void) {
+  ff_write("ab\ncd\n", 6);
+  TEST_ASSERT_TRUE(tu_frame_received(&fr, &ff, 8));
+
+  TEST_ASSERT_EQUAL(2, tu_frame_read(&fr, &ff, rd_buf, sizeof(rd_buf)));
+  TEST_ASSERT_EQUAL_MEMORY("ab", rd_buf, 2);
+  TEST_ASSERT_EQUAL(3, tu_frame_find(&fr, &ff));
+  TEST_ASSERT_EQUAL(2, tu_frame_read(&fr, &ff, rd_buf, sizeof(rd_buf)));
+  TEST_ASSERT_EQUAL_MEMORY("cd", rd_buf, 2);
+  TEST_ASSERT_EQUAL(0, tu_frame_find(&fr, &ff));
+}
+
+void test_frame_read_truncated(void) {
+  ff_write("abcdef\n", 7);
+  TEST_ASSERT_EQUAL(3, tu_frame_read(&fr, &ff, rd_buf, 3));
+  TEST_ASSERT_EQUAL_MEMORY("abc", rd_buf, 3);
+
+  // rest of frame is discarded
+  TEST_ASSERT_EQUAL(0, tu_fifo_count(&ff));
+}
+
+void test_frame_oversize_dropped_delimiter(void) {
+  uint8_t data[FIFO_SIZE];
+  memset(data, 'x', sizeof(data));
+
+  // no room for next receive: received part is dropped
+  ff_write(data, FIFO_SIZE - 4);
+  TEST_ASSERT_FALSE(tu_frame_received(&fr, &ff, 8));
+  TEST_ASSERT_EQUAL(0, tu_fifo_count(&ff));
+
+  // rest of oversized frame is dropped as it arrives, next frame is kept
+  ff_write(data, 10);
+  TEST_ASSERT_FALSE(tu_frame_received(&fr, &ff, 8));
+  TEST_ASSERT_EQUAL(0, tu_fifo_count(&ff));
+
+  ff_write("yz\nok\n", 6);
+  TEST_ASSERT_TRUE(tu_frame_received(&fr, &ff, 8));
+  TEST_ASSERT_EQUAL(2, tu_frame_read(&fr, &ff, rd_buf, sizeof(rd_buf)));
+  TEST_ASSERT_EQUAL_MEMORY("ok", rd_buf, 2);
+}
+
+void test_frame_oversize_dropped_length16(void) {
+  tu_frame_config(&fr, TUSB_FRAME_LENGTH16, 0);
+
+  // 40 byte payload does not fit
+  uint8_t data[FIFO_SIZE];
+  memset(data, 'x', sizeof(data));
+  data[0] = 40;
+  data[1] = 0;
+  ff_write(data, 26);
+  TEST_ASSERT_FALSE(tu_frame_received(&fr, &ff, 8));
+  TEST_ASSERT_EQUAL(0, tu_fifo_count(&ff));
+
+  // remaining 16 bytes then next frame
+  ff_write(data + 2, 16);
+  ff_write("\x02\x00ok", 4);
+  TEST_ASSERT_TRUE(tu_frame_received(&fr, &ff, 8));
+  TEST_ASSERT_EQUAL(2, tu_frame_read(&fr, &ff, rd_buf, sizeof(rd_buf)));
+  TEST_ASSERT_EQUAL_MEMORY("ok", rd_buf, 2);
+}
+
+void test_frame_reset_after_clear(void) {
+  ff_write("abc", 3);
+  TEST_ASSERT_EQUAL(0, tu_frame_find(&fr, &ff));
+
+  // searched position is forgotten
+  tu_fifo_clear(&ff);
+  tu_frame_reset(&fr);
+  ff_write("d\n", 2);
+  TEST_ASSERT_EQUAL(2, tu_frame_find(&fr, &ff));
+}